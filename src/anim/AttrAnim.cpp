@@ -25,6 +25,8 @@
 #include "../player/Player.h"
 #include "../player/Node.h"
 
+#include <boost/functional/hash.hpp>
+
 using namespace boost;
 using namespace boost::python;
 using namespace std;
@@ -33,19 +35,28 @@ namespace avg {
 
 AttrAnim::AttrAnimationMap AttrAnim::s_ActiveAnimations;
 
-bool ObjAttrID::operator < (const ObjAttrID& other) const
+ObjAttrID::ObjAttrID(const object& obj, const string& sAttrName)
+    : m_ObjHash(PyObject_Hash(obj.ptr())),
+      m_sAttrName(sAttrName)
 {
-    if (m_ObjHash < other.m_ObjHash) {
-        return true;
-    } else if (m_ObjHash > other.m_ObjHash) {
-        return false;
-    } else if (m_sAttrName < other.m_sAttrName) {
-        return true;
-    } else {
-        return false;
+    if (m_ObjHash == -1) {
+        throw_error_already_set();
     }
 }
 
+bool ObjAttrID::operator ==(const ObjAttrID& other) const
+{
+    return m_ObjHash == other.m_ObjHash && m_sAttrName == other.m_sAttrName;
+}
+
+size_t hash_value(const ObjAttrID& id)
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, id.m_ObjHash);
+    boost::hash_combine(seed, id.m_sAttrName);
+    return seed;
+}
+
 int AttrAnim::getNumRunningAnims()
 {
     return s_ActiveAnimations.size();
@@ -58,6 +69,7 @@ AttrAnim::AttrAnim(const object& node, const string& sAttrName,
       m_sAttrName(sAttrName)
 {
     object obj = getValue();
+    m_pAccessor = NodeAttrAccessor::create(node, sAttrName);
 }
 
 AttrAnim::~AttrAnim()
@@ -81,6 +93,15 @@ void AttrAnim::setValue(const object& val)
     m_Node.attr(m_sAttrName.c_str()) = val;
 }
 
+NodeAttrAccessor* AttrAnim::getAccessor(NodeAttrAccessor::ValueType type) const
+{
+    if (m_pAccessor && m_pAccessor->getType() == type) {
+        return m_pAccessor.get();
+    } else {
+        return 0;
+    }
+}
+
 void AttrAnim::addToMap()
 {
     s_ActiveAnimations[ObjAttrID(m_Node, m_sAttrName)] = 
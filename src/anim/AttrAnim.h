@@ -23,6 +23,7 @@
 #define _AttrAnim_H_
 
 #include "Anim.h"
+#include "NodeAttrAccessor.h"
 
 #include "../api.h"
 // Python docs say python.h should be included before any standard headers (!)
@@ -31,23 +32,21 @@
 #include <boost/python.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <string>
-#include <map>
 
 namespace avg {
 
 struct ObjAttrID {
-    ObjAttrID(const boost::python::object& obj, const std::string& sAttrName)
-        : m_ObjHash(boost::python::extract<long>(obj.attr("__hash__")())),
-          m_sAttrName(sAttrName)
-    {
-    }
+    ObjAttrID(const boost::python::object& obj, const std::string& sAttrName);
     long m_ObjHash;
     std::string m_sAttrName;
-    bool operator < (const ObjAttrID& other) const;
+    bool operator ==(const ObjAttrID& other) const;
 };
 
+std::size_t hash_value(const ObjAttrID& id);
+
 class AttrAnim;
 
 typedef boost::shared_ptr<class Anim> AttrAnimPtr;
@@ -68,6 +67,9 @@ public:
 protected:
     boost::python::object getValue() const;
     void setValue(const boost::python::object& val);
+    // Returns an accessor that bypasses python if the attribute is a known node
+    // attribute of the given type, 0 otherwise.
+    NodeAttrAccessor* getAccessor(NodeAttrAccessor::ValueType type) const;
 
     void addToMap();
     void removeFromMap();
@@ -79,8 +81,9 @@ private:
 
     boost::python::object m_Node;
     std::string m_sAttrName;
+    NodeAttrAccessorPtr m_pAccessor;
 
-    typedef std::map<ObjAttrID, AttrAnimPtr> AttrAnimationMap;
+    typedef boost::unordered_map<ObjAttrID, AttrAnimPtr> AttrAnimationMap;
     static AttrAnimationMap s_ActiveAnimations;
 };
 
@@ -0,0 +1,219 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "NodeAttrAccessor.h"
+
+#include "../base/Exception.h"
+#include "../player/AreaNode.h"
+#include "../player/RectNode.h"
+#include "../player/CircleNode.h"
+#include "../player/FilledVectorNode.h"
+#include "../player/WordsNode.h"
+
+#include <boost/bind.hpp>
+#include <boost/python/object/class_detail.hpp>
+
+using namespace boost;
+using namespace boost::python;
+using namespace std;
+
+namespace avg {
+
+NodeAttrAccessorPtr NodeAttrAccessor::create(const object& obj, const string& sAttrName)
+{
+    extract<Node*> nodeExtractor(obj);
+    if (!nodeExtractor.check() || !isNativeAttr(obj, sAttrName)) {
+        return NodeAttrAccessorPtr();
+    }
+    // The raw pointers bound here stay valid because the animation keeps a reference
+    // to the python node object.
+    Node* pNode = nodeExtractor();
+    if (!pNode) {
+        return NodeAttrAccessorPtr();
+    }
+    AreaNode* pAreaNode = dynamic_cast<AreaNode*>(pNode);
+    RectNode* pRectNode = dynamic_cast<RectNode*>(pNode);
+    CircleNode* pCircleNode = dynamic_cast<CircleNode*>(pNode);
+    VectorNode* pVectorNode = dynamic_cast<VectorNode*>(pNode);
+    FilledVectorNode* pFilledNode = dynamic_cast<FilledVectorNode*>(pNode);
+    WordsNode* pWordsNode = dynamic_cast<WordsNode*>(pNode);
+
+    NodeAttrAccessor* pAccessor = 0;
+    if (sAttrName == "opacity") {
+        pAccessor = createFloat(boost::bind(&Node::getOpacity, pNode),
+                boost::bind(&Node::setOpacity, pNode, _1));
+    } else if (pWordsNode && sAttrName == "color") {
+        pAccessor = createColor(boost::bind(&WordsNode::getColor, pWordsNode),
+                boost::bind(&WordsNode::setColor, pWordsNode, _1));
+    } else if (pWordsNode && sAttrName == "fontsize") {
+        pAccessor = createFloat(boost::bind(&WordsNode::getFontSize, pWordsNode),
+                boost::bind(&WordsNode::setFontSize, pWordsNode, _1));
+    } else if (pAreaNode && sAttrName == "pos") {
+        pAccessor = createVec2(boost::bind(&AreaNode::getPos, pAreaNode),
+                boost::bind(&AreaNode::setPos, pAreaNode, _1));
+    } else if (pAreaNode && sAttrName == "x") {
+        pAccessor = createFloat(boost::bind(&AreaNode::getX, pAreaNode),
+                boost::bind(&AreaNode::setX, pAreaNode, _1));
+    } else if (pAreaNode && sAttrName == "y") {
+        pAccessor = createFloat(boost::bind(&AreaNode::getY, pAreaNode),
+                boost::bind(&AreaNode::setY, pAreaNode, _1));
+    } else if (pAreaNode && sAttrName == "size") {
+        pAccessor = createVec2(boost::bind(&AreaNode::getSize, pAreaNode),
+                boost::bind(&AreaNode::setSize, pAreaNode, _1));
+    } else if (pAreaNode && sAttrName == "width") {
+        pAccessor = createFloat(boost::bind(&AreaNode::getWidth, pAreaNode),
+                boost::bind(&AreaNode::setWidth, pAreaNode, _1));
+    } else if (pAreaNode && sAttrName == "height") {
+        pAccessor = createFloat(boost::bind(&AreaNode::getHeight, pAreaNode),
+                boost::bind(&AreaNode::setHeight, pAreaNode, _1));
+    } else if (pAreaNode && sAttrName == "angle") {
+        pAccessor = createFloat(boost::bind(&AreaNode::getAngle, pAreaNode),
+                boost::bind(&AreaNode::setAngle, pAreaNode, _1));
+    } else if (pAreaNode && sAttrName == "pivot") {
+        pAccessor = createVec2(boost::bind(&AreaNode::getPivot, pAreaNode),
+                boost::bind(&AreaNode::setPivot, pAreaNode, _1));
+    } else if (pRectNode && sAttrName == "pos") {
+        pAccessor = createVec2(boost::bind(&RectNode::getPos, pRectNode),
+                boost::bind(&RectNode::setPos, pRectNode, _1));
+    } else if (pRectNode && sAttrName == "size") {
+        pAccessor = createVec2(boost::bind(&RectNode::getSize, pRectNode),
+                boost::bind(&RectNode::setSize, pRectNode, _1));
+    } else if (pRectNode && sAttrName == "angle") {
+        pAccessor = createFloat(boost::bind(&RectNode::getAngle, pRectNode),
+                boost::bind(&RectNode::setAngle, pRectNode, _1));
+    } else if (pCircleNode && sAttrName == "pos") {
+        pAccessor = createVec2(boost::bind(&CircleNode::getPos, pCircleNode),
+                boost::bind(&CircleNode::setPos, pCircleNode, _1));
+    } else if (pCircleNode && sAttrName == "r") {
+        pAccessor = createFloat(boost::bind(&CircleNode::getR, pCircleNode),
+                boost::bind(&CircleNode::setR, pCircleNode, _1));
+    } else if (pVectorNode && sAttrName == "color") {
+        pAccessor = createColor(boost::bind(&VectorNode::getColor, pVectorNode),
+                boost::bind(&VectorNode::setColor, pVectorNode, _1));
+    } else if (pVectorNode && sAttrName == "strokewidth") {
+        pAccessor = createFloat(boost::bind(&VectorNode::getStrokeWidth, pVectorNode),
+                boost::bind(&VectorNode::setStrokeWidth, pVectorNode, _1));
+    } else if (pFilledNode && sAttrName == "fillcolor") {
+        pAccessor = createColor(
+                boost::bind(&FilledVectorNode::getFillColor, pFilledNode),
+                boost::bind(&FilledVectorNode::setFillColor, pFilledNode, _1));
+    } else if (pFilledNode && sAttrName == "fillopacity") {
+        pAccessor = createFloat(
+                boost::bind(&FilledVectorNode::getFillOpacity, pFilledNode),
+                boost::bind(&FilledVectorNode::setFillOpacity, pFilledNode, _1));
+    }
+    return NodeAttrAccessorPtr(pAccessor);
+}
+
+NodeAttrAccessor::~NodeAttrAccessor()
+{
+}
+
+NodeAttrAccessor::ValueType NodeAttrAccessor::getType() const
+{
+    return m_Type;
+}
+
+float NodeAttrAccessor::getFloat() const
+{
+    AVG_ASSERT(m_Type == FLOAT);
+    return m_GetFloat();
+}
+
+void NodeAttrAccessor::setFloat(float val)
+{
+    AVG_ASSERT(m_Type == FLOAT);
+    m_SetFloat(val);
+}
+
+glm::vec2 NodeAttrAccessor::getVec2() const
+{
+    AVG_ASSERT(m_Type == VEC2);
+    return m_GetVec2();
+}
+
+void NodeAttrAccessor::setVec2(const glm::vec2& val)
+{
+    AVG_ASSERT(m_Type == VEC2);
+    m_SetVec2(val);
+}
+
+Color NodeAttrAccessor::getColor() const
+{
+    AVG_ASSERT(m_Type == COLOR);
+    return m_GetColor();
+}
+
+void NodeAttrAccessor::setColor(const Color& val)
+{
+    AVG_ASSERT(m_Type == COLOR);
+    m_SetColor(val);
+}
+
+NodeAttrAccessor::NodeAttrAccessor(ValueType type)
+    : m_Type(type)
+{
+}
+
+NodeAttrAccessor* NodeAttrAccessor::createFloat(const FloatGetter& getter,
+        const FloatSetter& setter)
+{
+    NodeAttrAccessor* pAccessor = new NodeAttrAccessor(FLOAT);
+    pAccessor->m_GetFloat = getter;
+    pAccessor->m_SetFloat = setter;
+    return pAccessor;
+}
+
+NodeAttrAccessor* NodeAttrAccessor::createVec2(const Vec2Getter& getter,
+        const Vec2Setter& setter)
+{
+    NodeAttrAccessor* pAccessor = new NodeAttrAccessor(VEC2);
+    pAccessor->m_GetVec2 = getter;
+    pAccessor->m_SetVec2 = setter;
+    return pAccessor;
+}
+
+NodeAttrAccessor* NodeAttrAccessor::createColor(const ColorGetter& getter,
+        const ColorSetter& setter)
+{
+    NodeAttrAccessor* pAccessor = new NodeAttrAccessor(COLOR);
+    pAccessor->m_GetColor = getter;
+    pAccessor->m_SetColor = setter;
+    return pAccessor;
+}
+
+bool NodeAttrAccessor::isNativeAttr(const object& obj, const string& sAttrName)
+{
+    // The attribute is handled in C++ if the first class in the mro that defines it
+    // is a wrapped C++ class. Python subclasses can replace node properties, and
+    // these replacements need to be called.
+    object mro = obj.attr("__class__").attr("__mro__");
+    PyObject* pMetaType = (PyObject*)(objects::class_metatype().get());
+    for (int i = 0; i < len(mro); ++i) {
+        PyTypeObject* pType = (PyTypeObject*)(object(mro[i]).ptr());
+        if (pType->tp_dict && PyDict_GetItemString(pType->tp_dict, sAttrName.c_str())) {
+            return PyObject_IsInstance((PyObject*)pType, pMetaType) == 1;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,96 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _NodeAttrAccessor_H_
+#define _NodeAttrAccessor_H_
+
+#include "../api.h"
+// Python docs say python.h should be included before any standard headers (!)
+#include "../player/WrapPython.h"
+
+#include "../base/GLMHelper.h"
+#include "../graphics/Color.h"
+
+#include <boost/python.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+
+#include <string>
+
+namespace avg {
+
+class NodeAttrAccessor;
+typedef boost::shared_ptr<NodeAttrAccessor> NodeAttrAccessorPtr;
+
+// Reads and writes a node attribute by calling the C++ getter and setter directly
+// instead of going through python attribute access. Used by animations to avoid the
+// interpreter in every frame.
+class AVG_API NodeAttrAccessor
+{
+public:
+    enum ValueType {FLOAT, VEC2, COLOR};
+
+    // Returns an empty pointer if obj isn't a libavg node, if the attribute isn't
+    // known or if it is overridden by a python subclass.
+    static NodeAttrAccessorPtr create(const boost::python::object& obj,
+            const std::string& sAttrName);
+    virtual ~NodeAttrAccessor();
+
+    ValueType getType() const;
+
+    float getFloat() const;
+    void setFloat(float val);
+    glm::vec2 getVec2() const;
+    void setVec2(const glm::vec2& val);
+    Color getColor() const;
+    void setColor(const Color& val);
+
+private:
+    typedef boost::function<float()> FloatGetter;
+    typedef boost::function<void(float)> FloatSetter;
+    typedef boost::function<glm::vec2()> Vec2Getter;
+    typedef boost::function<void(const glm::vec2&)> Vec2Setter;
+    typedef boost::function<Color()> ColorGetter;
+    typedef boost::function<void(const Color&)> ColorSetter;
+
+    NodeAttrAccessor(ValueType type);
+    static NodeAttrAccessor* createFloat(const FloatGetter& getter,
+            const FloatSetter& setter);
+    static NodeAttrAccessor* createVec2(const Vec2Getter& getter,
+            const Vec2Setter& setter);
+    static NodeAttrAccessor* createColor(const ColorGetter& getter,
+            const ColorSetter& setter);
+
+    static bool isNativeAttr(const boost::python::object& obj,
+            const std::string& sAttrName);
+
+    ValueType m_Type;
+    FloatGetter m_GetFloat;
+    FloatSetter m_SetFloat;
+    Vec2Getter m_GetVec2;
+    Vec2Setter m_SetVec2;
+    ColorGetter m_GetColor;
+    ColorSetter m_SetColor;
+};
+
+}
+
+#endif
@@ -39,7 +39,9 @@ SimpleAnim::SimpleAnim(const object& node, const string& sAttrName, long long du
       m_Duration(duration),
       m_StartValue(startValue),
       m_EndValue(endValue),
-      m_bUseInt(bUseInt)
+      m_bUseInt(bUseInt),
+      m_bValidType(false),
+      m_ValueType(NodeAttrAccessor::FLOAT)
 {
 }
 
@@ -53,6 +55,7 @@ SimpleAnim::~SimpleAnim()
 void SimpleAnim::start(bool bKeepAttr)
 {
     AttrAnim::start();
+    initNativeValues();
     if (bKeepAttr) {
         m_StartTime = calcStartTime();
     } else {
@@ -73,15 +76,6 @@ void SimpleAnim::abort()
     }
 }
 
-template<class T>
-object typedLERP(const object& startValue, const object& endValue, float part)
-{
-    T start = extract<T>(startValue);
-    T end = extract<T>(endValue);
-    T cur = start+(end-start)*part;
-    return object(cur);
-}
-
 bool SimpleAnim::step()
 {
     AVG_ASSERT(isRunning());
@@ -92,30 +86,40 @@ bool SimpleAnim::step()
         remove();
         return true;
     } else {
-        object curValue;
+        if (!m_bValidType) {
+            throw (Exception(AVG_ERR_TYPE,
+                    "Animated attributes must be numbers, Point2D or Colors."));
+        }
         float part = interpolate(t);
-        if (isPythonType<float>(m_StartValue)) {
-            curValue = typedLERP<float>(m_StartValue, m_EndValue, part);
+        NodeAttrAccessor* pAccessor = getAccessor(m_ValueType);
+        if (m_ValueType == NodeAttrAccessor::FLOAT) {
+            float cur = m_NativeStart.x+(m_NativeEnd.x-m_NativeStart.x)*part;
             if (m_bUseInt) {
-                float d = extract<float>(curValue);
-                curValue = object(round(d));
+                cur = round(cur);
+            }
+            if (pAccessor) {
+                pAccessor->setFloat(cur);
+            } else {
+                setValue(object(cur));
             }
-        } else if (isPythonType<glm::vec2>(m_StartValue)) {
-            curValue = typedLERP<glm::vec2>(m_StartValue, m_EndValue, part);
+        } else if (m_ValueType == NodeAttrAccessor::VEC2) {
+            glm::vec2 cur = m_NativeStart+(m_NativeEnd-m_NativeStart)*part;
             if (m_bUseInt) {
-                glm::vec2 pt = extract<glm::vec2>(curValue);
-                curValue = object(glm::vec2(round(pt.x), round(pt.y)));
+                cur = glm::vec2(round(cur.x), round(cur.y));
+            }
+            if (pAccessor) {
+                pAccessor->setVec2(cur);
+            } else {
+                setValue(object(cur));
             }
-        } else if (isPythonType<Color>(m_StartValue)) {
-            Color start = extract<Color>(m_StartValue);
-            Color end = extract<Color>(m_EndValue);
-            Color curColor = Color::mix(start, end, 1-part);
-            curValue = object(curColor);
         } else {
-            throw (Exception(AVG_ERR_TYPE, 
-                    "Animated attributes must be numbers, Point2D or Colors."));
+            Color cur = Color::mix(m_StartColor, m_EndColor, 1-part);
+            if (pAccessor) {
+                pAccessor->setColor(cur);
+            } else {
+                setValue(object(cur));
+            }
         }
-        setValue(curValue);
         return false;
     }
 }
@@ -179,6 +183,26 @@ float SimpleAnim::getStartPart(float start, float end, float cur)
     return (tend+tstart)/2;
 }
 
+void SimpleAnim::initNativeValues()
+{
+    m_bValidType = true;
+    if (isPythonType<float>(m_StartValue)) {
+        m_ValueType = NodeAttrAccessor::FLOAT;
+        m_NativeStart = glm::vec2(extract<float>(m_StartValue), 0);
+        m_NativeEnd = glm::vec2(extract<float>(m_EndValue), 0);
+    } else if (isPythonType<glm::vec2>(m_StartValue)) {
+        m_ValueType = NodeAttrAccessor::VEC2;
+        m_NativeStart = extract<glm::vec2>(m_StartValue);
+        m_NativeEnd = extract<glm::vec2>(m_EndValue);
+    } else if (isPythonType<Color>(m_StartValue)) {
+        m_ValueType = NodeAttrAccessor::COLOR;
+        m_StartColor = extract<Color>(m_StartValue);
+        m_EndColor = extract<Color>(m_EndValue);
+    } else {
+        m_bValidType = false;
+    }
+}
+
 void SimpleAnim::remove() 
 {
     AnimPtr tempThis = shared_from_this();
@@ -63,12 +63,22 @@ private:
     long long getDuration() const;
     long long calcStartTime();
     virtual float getStartPart(float start, float end, float cur);
+    void initNativeValues();
 
     long long m_Duration;
     boost::python::object m_StartValue;
     boost::python::object m_EndValue;
     bool m_bUseInt;
     long long m_StartTime;
+
+    // Start and end values converted once in start() so step() doesn't need to
+    // extract them from python objects.
+    bool m_bValidType;
+    NodeAttrAccessor::ValueType m_ValueType;
+    glm::vec2 m_NativeStart;
+    glm::vec2 m_NativeEnd;
+    Color m_StartColor;
+    Color m_EndColor;
 };
 
 }
@@ -24,12 +24,16 @@
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
 
+#include <boost/make_shared.hpp>
+
 #include <iostream>
 
 using namespace std;
 
 namespace avg {
 
+static BlockPoolPtr s_pAudioMsgPool(new BlockPool("AudioMsg"));
+
 AudioMsg::AudioMsg()
     : m_MsgType(NONE)
 {
@@ -41,6 +45,16 @@ AudioMsg::~AudioMsg()
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
+AudioMsgPtr AudioMsg::create()
+{
+    return boost::allocate_shared<AudioMsg>(PoolAllocator<AudioMsg>(s_pAudioMsgPool));
+}
+
+const BlockPoolPtr& AudioMsg::getPool()
+{
+    return s_pAudioMsgPool;
+}
+
 void AudioMsg::setAudio(AudioBufferPtr pAudioBuffer, float audioTime)
 {
     AVG_ASSERT(pAudioBuffer);
@@ -25,6 +25,7 @@
 #include "../api.h"
 #include "../base/Queue.h"
 #include "../base/Exception.h"
+#include "../base/BlockPool.h"
 
 #include "AudioBuffer.h"
 
@@ -37,6 +38,11 @@ public:
     enum MsgType {NONE, AUDIO, AUDIO_TIME, END_OF_FILE, ERROR, FRAME, SEEK_DONE, PACKET,
             CLOSED};
     AudioMsg();
+    // Messages are allocated from a pool, so passing them between threads doesn't
+    // touch the heap once the pool has grown large enough.
+    static boost::shared_ptr<AudioMsg> create();
+    static const BlockPoolPtr& getPool();
+
     void setAudio(AudioBufferPtr pAudioBuffer, float audioTime);
     void setAudioTime(float audioTime);
     void setEOF();
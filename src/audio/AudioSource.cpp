@@ -108,7 +108,7 @@ void AudioSource::fillAudioBuffer(AudioBufferPtr pBuffer)
         pBuffer->volumize(m_LastVolume, m_Volume);
         m_LastVolume = m_Volume;
 
-        AudioMsgPtr pStatusMsg(new AudioMsg);
+        AudioMsgPtr pStatusMsg = AudioMsg::create();
         pStatusMsg->setAudioTime(m_LastTime);
         m_StatusQ.push(pStatusMsg);
     }
@@ -134,7 +134,7 @@ bool AudioSource::processNextMsg(bool bWait)
             case AudioMsg::END_OF_FILE: {
 //                cerr << "        AudioSource: EOF" << endl;
                 m_bSeeking = false;
-                AudioMsgPtr pStatusMsg(new AudioMsg);
+                AudioMsgPtr pStatusMsg = AudioMsg::create();
                 pStatusMsg->setEOF();
                 m_StatusQ.push(pStatusMsg);
                 return false;
@@ -144,7 +144,7 @@ bool AudioSource::processNextMsg(bool bWait)
                 m_bSeeking = false;
                 m_pInputAudioBuffer = AudioBufferPtr();
                 m_LastTime = pMsg->getSeekTime();
-                AudioMsgPtr pStatusMsg(new AudioMsg);
+                AudioMsgPtr pStatusMsg = AudioMsg::create();
                 pStatusMsg->setSeekDone(pMsg->getSeekSeqNum(), m_LastTime);
                 m_StatusQ.push(pStatusMsg);
                 return true;
@@ -0,0 +1,97 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "BlockPool.h"
+
+#include "Exception.h"
+#include "ThreadHelper.h"
+
+using namespace std;
+
+namespace avg {
+
+BlockPool::BlockPool(const string& sName)
+    : m_sName(sName),
+      m_BlockSize(0),
+      m_NumBlocksInUse(0),
+      m_HighWaterMark(0)
+{
+}
+
+BlockPool::~BlockPool()
+{
+    AVG_ASSERT(m_NumBlocksInUse == 0);
+    for (unsigned i = 0; i < m_pFreeBlocks.size(); ++i) {
+        ::operator delete(m_pFreeBlocks[i]);
+    }
+}
+
+void* BlockPool::alloc(size_t size)
+{
+    {
+        lock_guard lock(m_Mutex);
+        if (m_BlockSize == 0) {
+            m_BlockSize = size;
+        }
+        if (size == m_BlockSize) {
+            m_NumBlocksInUse++;
+            m_HighWaterMark = max(m_HighWaterMark, m_NumBlocksInUse);
+            if (!m_pFreeBlocks.empty()) {
+                void* pBlock = m_pFreeBlocks.back();
+                m_pFreeBlocks.pop_back();
+                return pBlock;
+            }
+        }
+    }
+    return ::operator new(size);
+}
+
+void BlockPool::release(void* pBlock, size_t size)
+{
+    {
+        lock_guard lock(m_Mutex);
+        if (size == m_BlockSize) {
+            m_NumBlocksInUse--;
+            m_pFreeBlocks.push_back(pBlock);
+            return;
+        }
+    }
+    ::operator delete(pBlock);
+}
+
+const string& BlockPool::getName() const
+{
+    return m_sName;
+}
+
+int BlockPool::getNumBlocksInUse() const
+{
+    lock_guard lock(m_Mutex);
+    return m_NumBlocksInUse;
+}
+
+int BlockPool::getHighWaterMark() const
+{
+    lock_guard lock(m_Mutex);
+    return m_HighWaterMark;
+}
+
+}
@@ -0,0 +1,153 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _BlockPool_H_
+#define _BlockPool_H_
+
+#include "../api.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <new>
+
+namespace avg {
+
+// Thread-safe pool of memory blocks of one size. Freed blocks are kept for reuse, so
+// once the number of blocks in use stops growing, the pool doesn't touch the heap
+// anymore. Used with PoolAllocator to create objects that are passed between threads
+// in large numbers, e.g. decoder messages.
+class AVG_API BlockPool
+{
+public:
+    BlockPool(const std::string& sName);
+    virtual ~BlockPool();
+
+    // The block size is set by the first allocation. Requests for other sizes are
+    // passed on to the heap.
+    void* alloc(size_t size);
+    void release(void* pBlock, size_t size);
+
+    const std::string& getName() const;
+    int getNumBlocksInUse() const;
+    // Maximum number of blocks that were in use at the same time. Since blocks are
+    // never returned to the heap, this is also the number of blocks the pool owns.
+    int getHighWaterMark() const;
+
+private:
+    std::string m_sName;
+    size_t m_BlockSize;
+    std::vector<void*> m_pFreeBlocks;
+    int m_NumBlocksInUse;
+    int m_HighWaterMark;
+    mutable boost::mutex m_Mutex;
+};
+
+typedef boost::shared_ptr<BlockPool> BlockPoolPtr;
+
+// Standard allocator that takes its memory from a BlockPool. Intended for
+// boost::allocate_shared(), which places the object and its reference count in a
+// single block:
+//
+//   VideoMsgPtr pMsg = boost::allocate_shared<VideoMsg>(
+//           PoolAllocator<VideoMsg>(pPool));
+//
+// The allocator keeps the pool alive until the last object allocated from it is gone.
+template<class T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<class U>
+    struct rebind {
+        typedef PoolAllocator<U> other;
+    };
+
+    PoolAllocator(const BlockPoolPtr& pPool)
+        : m_pPool(pPool)
+    {
+    }
+
+    template<class U>
+    PoolAllocator(const PoolAllocator<U>& other)
+        : m_pPool(other.getPool())
+    {
+    }
+
+    pointer allocate(size_type n, const void* = 0)
+    {
+        return static_cast<pointer>(m_pPool->alloc(n*sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        m_pPool->release(p, n*sizeof(T));
+    }
+
+    void construct(pointer p, const T& val)
+    {
+        new(p) T(val);
+    }
+
+    void destroy(pointer p)
+    {
+        p->~T();
+    }
+
+    size_type max_size() const
+    {
+        return size_type(-1)/sizeof(T);
+    }
+
+    const BlockPoolPtr& getPool() const
+    {
+        return m_pPool;
+    }
+
+private:
+    BlockPoolPtr m_pPool;
+};
+
+template<class T, class U>
+bool operator==(const PoolAllocator<T>& a1, const PoolAllocator<U>& a2)
+{
+    return a1.getPool() == a2.getPool();
+}
+
+template<class T, class U>
+bool operator!=(const PoolAllocator<T>& a1, const PoolAllocator<U>& a2)
+{
+    return a1.getPool() != a2.getPool();
+}
+
+}
+
+#endif
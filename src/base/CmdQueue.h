@@ -23,25 +23,27 @@
 #define _CmdQueue_H_
 
 #include "Command.h"
-#include "Queue.h"
+#include "LockFreeQueue.h"
 
 #include "../api.h"
 
 namespace avg {
 
+// Commands are usually pushed by one thread and executed by one worker thread, so
+// pushing a command shouldn't need to wait for the worker.
 template<class RECEIVER>
-class AVG_TEMPLATE_API CmdQueue: public Queue<Command<RECEIVER> >
+class AVG_TEMPLATE_API CmdQueue: public LockFreeQueue<Command<RECEIVER> >
 {
 public:
     CmdQueue(int maxSize=-1);
-    typedef typename Queue<Command<RECEIVER> >::QElementPtr CmdPtr;
+    typedef typename LockFreeQueue<Command<RECEIVER> >::QElementPtr CmdPtr;
     void pushCmd(typename Command<RECEIVER>::CmdFunc func);
     
 };
 
 template<class RECEIVER>
 CmdQueue<RECEIVER>::CmdQueue(int maxSize)
-    : Queue<Command<RECEIVER> >(maxSize)
+    : LockFreeQueue<Command<RECEIVER> >(maxSize)
 {
 }
 
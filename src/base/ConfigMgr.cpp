@@ -79,12 +79,17 @@ ConfigMgr::ConfigMgr()
     addOption("scr", "shaderusage", "auto");
     addOption("scr", "gamma", "-1,-1,-1");
     addOption("scr", "imgcachesize", "-1,-1");
+    addOption("scr", "imgcachepolicy", "lru");
+    addOption("scr", "imgdiskcachedir", "");
 
     addSubsys("aud");
     addOption("aud", "channels", "2");
     addOption("aud", "samplerate", "44100");
     addOption("aud", "outputbuffersamples", "1024");
 
+    addSubsys("vid");
+    addOption("vid", "decoderthreads", "-1");
+
     addSubsys("gesture");
     addOption("gesture", "maxtapdist", "15");
     addOption("gesture", "maxdoubletaptime", "300");
@@ -0,0 +1,248 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _LockFreeQueue_H_
+#define _LockFreeQueue_H_
+
+#include "../api.h"
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <assert.h>
+
+namespace avg {
+
+// Drop-in replacement for Queue with the same interface. push() never takes a lock,
+// so any number of producers can push without contending. The consumer side is a
+// linked list that's only modified by pop(). A mutex serializes pop(), peek() and
+// clear() in case several threads consume; with a single consumer it is never
+// contended. Threads only block on a condition if they actually need to wait, i.e.
+// a consumer on an empty queue or a producer on a full one.
+//
+// The list is the multi-producer single-consumer queue by Dmitry Vyukov: producers
+// atomically swap themselves in as the new head and then link the previous head to
+// the new node.
+template<class QElement>
+class AVG_TEMPLATE_API LockFreeQueue
+{
+public:
+    typedef boost::shared_ptr<QElement> QElementPtr;
+
+    // With several producers, the queue can exceed maxSize by at most the number of
+    // producers minus one.
+    LockFreeQueue(int maxSize=-1);
+    virtual ~LockFreeQueue();
+
+    bool empty() const;
+    QElementPtr pop(bool bBlock = true);
+    void clear();
+    void push(const QElementPtr& pElem);
+    QElementPtr peek(bool bBlock = true) const;
+    int size() const;
+    int getMaxSize() const;
+
+private:
+    struct Node {
+        Node()
+            : m_pNext(0)
+        {
+        }
+
+        boost::atomic<Node*> m_pNext;
+        QElementPtr m_pElem;
+    };
+
+    // Number of times pop() polls an empty queue before going to sleep. Elements
+    // often arrive in quick succession, and sleeping and waking up is expensive.
+    static const int SPIN_COUNT = 200;
+
+    LockFreeQueue(const LockFreeQueue&);
+    LockFreeQueue& operator=(const LockFreeQueue&);
+
+    QElementPtr tryPop();
+    QElementPtr tryPeek() const;
+    void waitForElement() const;
+    void notifyWaiters() const;
+
+    boost::atomic<Node*> m_pHead;
+    Node* m_pTail;
+    boost::atomic<int> m_Size;
+    int m_MaxSize;
+    mutable boost::mutex m_ConsumerMutex;
+
+    mutable boost::atomic<int> m_NumWaiting;
+    mutable boost::mutex m_WaitMutex;
+    mutable boost::condition m_WaitCond;
+};
+
+template<class QElement>
+LockFreeQueue<QElement>::LockFreeQueue(int maxSize)
+    : m_Size(0),
+      m_MaxSize(maxSize),
+      m_NumWaiting(0)
+{
+    Node* pStub = new Node;
+    m_pHead.store(pStub);
+    m_pTail = pStub;
+}
+
+template<class QElement>
+LockFreeQueue<QElement>::~LockFreeQueue()
+{
+    clear();
+    delete m_pTail;
+}
+
+template<class QElement>
+bool LockFreeQueue<QElement>::empty() const
+{
+    return m_Size.load() == 0;
+}
+
+template<class QElement>
+typename LockFreeQueue<QElement>::QElementPtr LockFreeQueue<QElement>::pop(bool bBlock)
+{
+    QElementPtr pElem = tryPop();
+    for (int i = 0; i < SPIN_COUNT && !pElem && bBlock; ++i) {
+        pElem = tryPop();
+    }
+    while (!pElem && bBlock) {
+        waitForElement();
+        pElem = tryPop();
+    }
+    if (pElem && m_MaxSize > 0) {
+        // Wake up producers waiting for space.
+        notifyWaiters();
+    }
+    return pElem;
+}
+
+template<class QElement>
+void LockFreeQueue<QElement>::clear()
+{
+    QElementPtr pElem;
+    do {
+        pElem = pop(false);
+    } while (pElem);
+}
+
+template<class QElement>
+void LockFreeQueue<QElement>::push(const QElementPtr& pElem)
+{
+    assert(pElem);
+    if (m_MaxSize > 0) {
+        while (m_Size.load() >= m_MaxSize) {
+            boost::unique_lock<boost::mutex> lock(m_WaitMutex);
+            m_NumWaiting++;
+            if (m_Size.load() >= m_MaxSize) {
+                m_WaitCond.wait(lock);
+            }
+            m_NumWaiting--;
+        }
+    }
+    Node* pNode = new Node;
+    pNode->m_pElem = pElem;
+    m_Size++;
+    Node* pPrevHead = m_pHead.exchange(pNode);
+    pPrevHead->m_pNext.store(pNode);
+    notifyWaiters();
+}
+
+template<class QElement>
+typename LockFreeQueue<QElement>::QElementPtr LockFreeQueue<QElement>::peek(bool bBlock)
+        const
+{
+    QElementPtr pElem = tryPeek();
+    while (!pElem && bBlock) {
+        waitForElement();
+        pElem = tryPeek();
+    }
+    return pElem;
+}
+
+template<class QElement>
+int LockFreeQueue<QElement>::size() const
+{
+    return m_Size.load();
+}
+
+template<class QElement>
+int LockFreeQueue<QElement>::getMaxSize() const
+{
+    return m_MaxSize;
+}
+
+template<class QElement>
+typename LockFreeQueue<QElement>::QElementPtr LockFreeQueue<QElement>::tryPop()
+{
+    boost::mutex::scoped_lock lock(m_ConsumerMutex);
+    // m_pTail is a dummy node; the first element is in its successor.
+    Node* pNext = m_pTail->m_pNext.load();
+    if (!pNext) {
+        return QElementPtr();
+    }
+    QElementPtr pElem = pNext->m_pElem;
+    pNext->m_pElem = QElementPtr();
+    delete m_pTail;
+    m_pTail = pNext;
+    m_Size--;
+    return pElem;
+}
+
+template<class QElement>
+typename LockFreeQueue<QElement>::QElementPtr LockFreeQueue<QElement>::tryPeek() const
+{
+    boost::mutex::scoped_lock lock(m_ConsumerMutex);
+    Node* pNext = m_pTail->m_pNext.load();
+    if (!pNext) {
+        return QElementPtr();
+    }
+    return pNext->m_pElem;
+}
+
+template<class QElement>
+void LockFreeQueue<QElement>::waitForElement() const
+{
+    boost::unique_lock<boost::mutex> lock(m_WaitMutex);
+    m_NumWaiting++;
+    // Check again after registering as waiter: a producer that links an element from
+    // now on sees the waiter and notifies.
+    if (!tryPeek()) {
+        m_WaitCond.wait(lock);
+    }
+    m_NumWaiting--;
+}
+
+template<class QElement>
+void LockFreeQueue<QElement>::notifyWaiters() const
+{
+    if (m_NumWaiting.load() > 0) {
+        boost::mutex::scoped_lock lock(m_WaitMutex);
+        m_WaitCond.notify_all();
+    }
+}
+
+}
+
+#endif
@@ -26,11 +26,13 @@
 
 #include <boost/thread.hpp>
 #include <boost/thread/locks.hpp>
+#include <boost/shared_ptr.hpp>
 
 namespace avg {
 
 void AVG_API setAffinityMask(bool bIsMainThread);
 typedef boost::lock_guard<boost::mutex> lock_guard;
+typedef boost::shared_ptr<boost::mutex> MutexPtr;
 unsigned getLowestBitSet(unsigned val);
 void AVG_API yield();
 
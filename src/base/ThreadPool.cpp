@@ -0,0 +1,228 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ThreadPool.h"
+
+#include "ThreadHelper.h"
+#include "Exception.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+// More ranges than threads so uneven per-row cost still balances out.
+static const int RANGES_PER_THREAD = 4;
+
+ThreadPool* ThreadPool::s_pInstance = 0;
+boost::mutex ThreadPool::s_InstanceMutex;
+
+ThreadPool* ThreadPool::get()
+{
+    lock_guard lock(s_InstanceMutex);
+    if (!s_pInstance) {
+        // The calling thread works too, so one core is left for it.
+        int numCores = max(int(boost::thread::hardware_concurrency()), 1);
+        s_pInstance = new ThreadPool(numCores-1);
+    }
+    return s_pInstance;
+}
+
+bool ThreadPool::exists()
+{
+    lock_guard lock(s_InstanceMutex);
+    return s_pInstance != 0;
+}
+
+ThreadPool::ThreadPool(int numThreads)
+    : m_bStopping(false),
+      m_NumThreads(numThreads)
+{
+    for (int i = 0; i < m_NumThreads; ++i) {
+        m_Threads.create_thread(boost::bind(&ThreadPool::workerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard lock(m_Mutex);
+        AVG_ASSERT(m_Jobs.empty());
+        m_bStopping = true;
+    }
+    m_WorkCond.notify_all();
+    m_Threads.join_all();
+
+    lock_guard lock(s_InstanceMutex);
+    if (s_pInstance == this) {
+        s_pInstance = 0;
+    }
+}
+
+void ThreadPool::parallelFor(int numItems, const RangeFunc& func, int minItemsPerRange)
+{
+    if (numItems <= 0) {
+        return;
+    }
+    AVG_ASSERT(minItemsPerRange > 0);
+    int numRanges = min(numItems/minItemsPerRange, (m_NumThreads+1)*RANGES_PER_THREAD);
+    if (m_NumThreads == 0 || numRanges <= 1) {
+        func(0, numItems);
+        return;
+    }
+
+    Job job;
+    job.m_pFunc = &func;
+    job.m_NumItems = numItems;
+    job.m_NumRanges = numRanges;
+    job.m_NextRange = 0;
+    job.m_NumRangesDone = 0;
+    job.m_pException = 0;
+    {
+        lock_guard lock(m_Mutex);
+        m_Jobs.push_back(&job);
+    }
+    m_WorkCond.notify_all();
+
+    int start;
+    int end;
+    while (true) {
+        {
+            lock_guard lock(m_Mutex);
+            if (!claimRange(&job, start, end)) {
+                break;
+            }
+        }
+        runRange(&job, start, end);
+    }
+
+    // Workers may still be running ranges that reference job, so it can't go out of
+    // scope before they are done - even if there is an exception to pass on.
+    boost::unique_lock<boost::mutex> lock(m_Mutex);
+    while (job.m_NumRangesDone < job.m_NumRanges) {
+        m_DoneCond.wait(lock);
+    }
+    if (job.m_pException) {
+        Exception ex(*job.m_pException);
+        delete job.m_pException;
+        throw ex;
+    }
+}
+
+int ThreadPool::getNumThreads() const
+{
+    return m_NumThreads;
+}
+
+void ThreadPool::workerLoop()
+{
+    setAffinityMask(false);
+    while (true) {
+        // A job is only guaranteed to be alive while it is in the queue, so every
+        // range is claimed through the queue.
+        Job* pJob;
+        int start;
+        int end;
+        {
+            boost::unique_lock<boost::mutex> lock(m_Mutex);
+            while (m_Jobs.empty() && !m_bStopping) {
+                m_WorkCond.wait(lock);
+            }
+            if (m_bStopping) {
+                return;
+            }
+            pJob = m_Jobs.front();
+            claimRange(pJob, start, end);
+        }
+        runRange(pJob, start, end);
+    }
+}
+
+void ThreadPool::runRange(Job* pJob, int start, int end)
+{
+    // Exceptions can't be allowed to escape a worker thread, so they are stored in
+    // the job and rethrown by parallelFor() in the calling thread.
+    Exception* pException = 0;
+    try {
+        (*pJob->m_pFunc)(start, end);
+    } catch (const Exception& ex) {
+        pException = new Exception(ex);
+    } catch (const std::exception& ex) {
+        pException = new Exception(AVG_ERR_UNKNOWN, ex.what());
+    } catch (...) {
+        pException = new Exception(AVG_ERR_UNKNOWN,
+                "Unknown exception in ThreadPool::parallelFor().");
+    }
+    if (pException) {
+        lock_guard lock(m_Mutex);
+        if (pJob->m_pException) {
+            delete pException;
+        } else {
+            pJob->m_pException = pException;
+        }
+        cancelJob(pJob);
+    }
+    finishRange(pJob);
+}
+
+bool ThreadPool::claimRange(Job* pJob, int& start, int& end)
+{
+    // Must be called with m_Mutex held.
+    if (pJob->m_NextRange >= pJob->m_NumRanges) {
+        return false;
+    }
+    int i = pJob->m_NextRange++;
+    if (pJob->m_NextRange == pJob->m_NumRanges) {
+        // Last range handed out: nobody else needs to see this job.
+        m_Jobs.erase(find(m_Jobs.begin(), m_Jobs.end(), pJob));
+    }
+    start = int((long long)(pJob->m_NumItems)*i/pJob->m_NumRanges);
+    end = int((long long)(pJob->m_NumItems)*(i+1)/pJob->m_NumRanges);
+    return true;
+}
+
+void ThreadPool::cancelJob(Job* pJob)
+{
+    // Must be called with m_Mutex held. Ranges that haven't been claimed yet are
+    // dropped.
+    if (pJob->m_NextRange < pJob->m_NumRanges) {
+        m_Jobs.erase(find(m_Jobs.begin(), m_Jobs.end(), pJob));
+        pJob->m_NumRanges = pJob->m_NextRange;
+    }
+}
+
+void ThreadPool::finishRange(Job* pJob)
+{
+    bool bJobDone;
+    {
+        lock_guard lock(m_Mutex);
+        pJob->m_NumRangesDone++;
+        bJobDone = (pJob->m_NumRangesDone == pJob->m_NumRanges);
+    }
+    if (bJobDone) {
+        m_DoneCond.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,89 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ThreadPool_H_
+#define _ThreadPool_H_
+
+#include "../api.h"
+#include "Exception.h"
+
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+
+#include <deque>
+
+namespace avg {
+
+// Process-wide pool of worker threads used to split data-parallel work (typically
+// bands of bitmap rows) across all cores. The calling thread always takes part in
+// the work, so parallelFor() can safely be called from anywhere, including from
+// inside another parallelFor().
+class AVG_API ThreadPool
+{
+public:
+    typedef boost::function<void (int, int)> RangeFunc;
+
+    static ThreadPool* get();
+    static bool exists();
+    // Stops and joins the worker threads. Must not be called while parallelFor() is
+    // running. A new pool is created by the next call to get().
+    virtual ~ThreadPool();
+
+    // Splits [0, numItems) into contiguous ranges of at least minItemsPerRange items
+    // and calls func(start, end) for each of them. Returns when all ranges are done.
+    // If func throws, the remaining ranges are skipped and the first exception is
+    // rethrown here as an avg::Exception.
+    void parallelFor(int numItems, const RangeFunc& func, int minItemsPerRange=1);
+
+    int getNumThreads() const;
+
+private:
+    struct Job {
+        const RangeFunc* m_pFunc;
+        int m_NumItems;
+        int m_NumRanges;
+        int m_NextRange;
+        int m_NumRangesDone;
+        Exception* m_pException;
+    };
+
+    ThreadPool(int numThreads);
+    void workerLoop();
+    bool claimRange(Job* pJob, int& start, int& end);
+    void runRange(Job* pJob, int start, int end);
+    void cancelJob(Job* pJob);
+    void finishRange(Job* pJob);
+
+    boost::thread_group m_Threads;
+    std::deque<Job*> m_Jobs;
+    boost::mutex m_Mutex;
+    boost::condition_variable m_WorkCond;
+    boost::condition_variable m_DoneCond;
+    bool m_bStopping;
+    int m_NumThreads;
+
+    static ThreadPool* s_pInstance;
+    static boost::mutex s_InstanceMutex;
+};
+
+}
+
+#endif
@@ -53,6 +53,14 @@ public:
     void waitForCommand();
     void stop();
 
+    // Alternative to operator()() for workers run by a thread pool: poolInit() once,
+    // then poolStep() until it returns false, then poolDeinit(). poolStep() only calls
+    // work() if bCanWork is set, i.e. if work() can run without blocking.
+    bool poolInit();
+    bool poolStep(bool bCanWork);
+    void poolDeinit();
+    bool hasCmds() const;
+
 protected:
     int getNumCmdsInQueue() const;
 
@@ -138,6 +146,39 @@ void WorkerThread<DERIVED_THREAD>::stop()
     m_bShouldStop = true;
 }
 
+template<class DERIVED_THREAD>
+bool WorkerThread<DERIVED_THREAD>::poolInit()
+{
+    return init();
+}
+
+template<class DERIVED_THREAD>
+bool WorkerThread<DERIVED_THREAD>::poolStep(bool bCanWork)
+{
+    if (bCanWork) {
+        bool bOK = work();
+        if (!bOK) {
+            m_bShouldStop = true;
+        }
+    }
+    if (!m_bShouldStop) {
+        processCommands();
+    }
+    return !m_bShouldStop;
+}
+
+template<class DERIVED_THREAD>
+void WorkerThread<DERIVED_THREAD>::poolDeinit()
+{
+    deinit();
+}
+
+template<class DERIVED_THREAD>
+bool WorkerThread<DERIVED_THREAD>::hasCmds() const
+{
+    return !m_CmdQ.empty();
+}
+
 template<class DERIVED_THREAD>
 int WorkerThread<DERIVED_THREAD>::getNumCmdsInQueue() const
 {
@@ -0,0 +1,152 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "Queue.h"
+#include "LockFreeQueue.h"
+#include "TimeSource.h"
+
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace avg;
+using namespace std;
+
+static const int NUM_MSGS = 1000000;
+static const int NUM_LATENCY_MSGS = 10000;
+
+// Pushes NUM_MSGS messages from numProducers threads and pops them in the main thread.
+// Every message carries the time it was pushed so the latency between push and pop
+// can be reported as well.
+template<template<class> class QUEUE>
+class QueuePerfTest {
+public:
+    typedef QUEUE<long long> Q;
+    typedef typename Q::QElementPtr ElemPtr;
+
+    QueuePerfTest(const string& sName, int numProducers, int maxSize)
+        : m_sName(sName),
+          m_NumProducers(numProducers),
+          m_MaxSize(maxSize)
+    {
+    }
+
+    void runThroughput()
+    {
+        Q q(m_MaxSize);
+        int msgsPerProducer = NUM_MSGS/m_NumProducers;
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        vector<boost::thread*> pThreads;
+        for (int i = 0; i < m_NumProducers; ++i) {
+            pThreads.push_back(new boost::thread(
+                    boost::bind(&pushThread, &q, msgsPerProducer, 0)));
+        }
+        long long latencySum = 0;
+        for (int i = 0; i < msgsPerProducer*m_NumProducers; ++i) {
+            ElemPtr pElem = q.pop();
+            latencySum += TimeSource::get()->getCurrentMicrosecs()-*pElem;
+        }
+        long long activeTime = TimeSource::get()->getCurrentMicrosecs()-startTime;
+        joinThreads(pThreads);
+        int numMsgs = msgsPerProducer*m_NumProducers;
+        cerr << m_sName << " throughput (" << getParamString() << "): "
+                << numMsgs/(activeTime/1000000.) << " msgs/sec, "
+                << float(latencySum)/numMsgs << " us average latency" << endl;
+    }
+
+    // Messages are pushed with a pause in between, so the consumer waits on an empty
+    // queue most of the time. This measures how long it takes to wake the consumer.
+    void runWakeupLatency()
+    {
+        Q q(m_MaxSize);
+        int msgsPerProducer = NUM_LATENCY_MSGS/m_NumProducers;
+        vector<boost::thread*> pThreads;
+        for (int i = 0; i < m_NumProducers; ++i) {
+            pThreads.push_back(new boost::thread(
+                    boost::bind(&pushThread, &q, msgsPerProducer, 50)));
+        }
+        long long latencySum = 0;
+        long long maxLatency = 0;
+        for (int i = 0; i < msgsPerProducer*m_NumProducers; ++i) {
+            ElemPtr pElem = q.pop();
+            long long latency = TimeSource::get()->getCurrentMicrosecs()-*pElem;
+            latencySum += latency;
+            maxLatency = max(maxLatency, latency);
+        }
+        joinThreads(pThreads);
+        cerr << m_sName << " wakeup latency (" << getParamString() << "): "
+                << float(latencySum)/(msgsPerProducer*m_NumProducers)
+                << " us average, " << maxLatency << " us max" << endl;
+    }
+
+private:
+    static void pushThread(Q* pQ, int numMsgs, int delay)
+    {
+        for (int i = 0; i < numMsgs; ++i) {
+            if (delay > 0) {
+                boost::this_thread::sleep(boost::posix_time::microseconds(delay));
+            }
+            pQ->push(ElemPtr(new long long(TimeSource::get()->getCurrentMicrosecs())));
+        }
+    }
+
+    static void joinThreads(vector<boost::thread*>& pThreads)
+    {
+        for (unsigned i = 0; i < pThreads.size(); ++i) {
+            pThreads[i]->join();
+            delete pThreads[i];
+        }
+    }
+
+    string getParamString() const
+    {
+        stringstream ss;
+        ss << m_NumProducers << " producers, maxSize=" << m_MaxSize;
+        return ss.str();
+    }
+
+    string m_sName;
+    int m_NumProducers;
+    int m_MaxSize;
+};
+
+template<template<class> class QUEUE>
+void runQueuePerfTests(const string& sName)
+{
+    int producerCounts[] = {1, 4};
+    for (int i = 0; i < 2; ++i) {
+        QueuePerfTest<QUEUE> perfTest(sName, producerCounts[i], -1);
+        perfTest.runThroughput();
+        perfTest.runWakeupLatency();
+    }
+    QueuePerfTest<QUEUE> perfTest(sName, 1, 64);
+    perfTest.runThroughput();
+}
+
+int main(int nargs, char** args)
+{
+    runQueuePerfTests<Queue>("Queue");
+    runQueuePerfTests<LockFreeQueue>("LockFreeQueue");
+}
@@ -21,8 +21,11 @@
 
 #include "DAG.h"
 #include "Queue.h"
+#include "LockFreeQueue.h"
+#include "BlockPool.h"
 #include "Command.h"
 #include "WorkerThread.h"
+#include "ThreadPool.h"
 #include "ObjectCounter.h"
 #include "Polygon.h"
 #include "GLMHelper.h"
@@ -46,6 +49,7 @@
 #include <boost/thread/thread.hpp>
 
 #include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
 
 #include <iostream>
 #include <sstream>
@@ -152,11 +156,13 @@ private:
     }
 };
 
+// Runs the same tests on Queue and LockFreeQueue.
+template<template<class> class QUEUE>
 class QueueTest: public Test
 {
 public:
-    QueueTest()
-        : Test("QueueTest", 2)
+    QueueTest(const string& sName)
+        : Test(sName, 2)
     {
     }
 
@@ -167,12 +173,12 @@ public:
     }
 
 private:
-    typedef Queue<int>::QElementPtr ElemPtr;
-    
+    typedef typename QUEUE<int>::QElementPtr ElemPtr;
+
     void runSingleThreadTests()
     {
-        Queue<string> q;
-        typedef Queue<string>::QElementPtr ElemPtr;
+        QUEUE<string> q;
+        typedef typename QUEUE<string>::QElementPtr ElemPtr;
         TEST(q.empty());
         q.push(ElemPtr(new string("1")));
         TEST(q.size() == 1);
@@ -194,7 +200,7 @@ private:
     void runMultiThreadTests()
     {
         {
-            Queue<int> q(10);
+            QUEUE<int> q(10);
             thread pusher(boost::bind(&pushThread, &q, 100));
             thread popper(boost::bind(&popThread, &q, 100));
             pusher.join();
@@ -202,7 +208,7 @@ private:
             TEST(q.empty());
         }
         {
-            Queue<int> q(10);
+            QUEUE<int> q(10);
             thread pusher1(boost::bind(&pushThread, &q, 100));
             thread pusher2(boost::bind(&pushThread, &q, 100));
             thread popper(boost::bind(&popThread, &q, 200));
@@ -212,7 +218,7 @@ private:
             TEST(q.empty());
         }
         {
-            Queue<int> q(10);
+            QUEUE<int> q(10);
             thread pusher(boost::bind(&pushClearThread, &q, 100));
             thread popper(boost::bind(&popClearThread, &q));
             pusher.join();
@@ -221,7 +227,7 @@ private:
         }
     }
 
-    static void pushThread(Queue<int>* pq, int numPushes)
+    static void pushThread(QUEUE<int>* pq, int numPushes)
     {
         for (int i=0; i<numPushes; ++i) {
             pq->push(ElemPtr(new int(i)));
@@ -229,7 +235,7 @@ private:
         }
     }
 
-    static void popThread(Queue<int>* pq, int numPops)
+    static void popThread(QUEUE<int>* pq, int numPops)
     {
         for (int i=0; i<numPops; ++i) {
             pq->peek();
@@ -238,9 +244,8 @@ private:
         }
     }
 
-    static void pushClearThread(Queue<int>* pq, int numPushes)
+    static void pushClearThread(QUEUE<int>* pq, int numPushes)
     {
-        typedef Queue<int>::QElementPtr ElemPtr;
         for (int i=0; i<numPushes; ++i) {
             pq->push(ElemPtr(new int(i)));
             if (i%7 == 0) {
@@ -251,7 +256,7 @@ private:
         pq->push(ElemPtr(new int(-1)));
     }
 
-    static void popClearThread(Queue<int>* pq)
+    static void popClearThread(QUEUE<int>* pq)
     {
         ElemPtr pElem;
         do {
@@ -260,6 +265,77 @@ private:
     }
 };
 
+class BlockPoolTest: public Test
+{
+public:
+    BlockPoolTest()
+        : Test("BlockPoolTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        BlockPoolPtr pPool(new BlockPool("Test"));
+        TEST(pPool->getName() == "Test");
+        {
+            vector<ElemPtr> pElems;
+            for (int i = 0; i < 10; ++i) {
+                pElems.push_back(createElem(pPool, i));
+            }
+            TEST(pPool->getNumBlocksInUse() == 10);
+            TEST(pPool->getHighWaterMark() == 10);
+            TEST(*pElems[9] == "9");
+            pElems.erase(pElems.begin(), pElems.begin()+5);
+            TEST(pPool->getNumBlocksInUse() == 5);
+            // Freed blocks are reused.
+            for (int i = 0; i < 5; ++i) {
+                pElems.push_back(createElem(pPool, i));
+            }
+            TEST(pPool->getNumBlocksInUse() == 10);
+            TEST(pPool->getHighWaterMark() == 10);
+        }
+        TEST(pPool->getNumBlocksInUse() == 0);
+        TEST(pPool->getHighWaterMark() == 10);
+        {
+            // Elements allocated in one thread and freed in another, as in the
+            // decoder message queues.
+            Queue<string> q(4);
+            thread pusher(boost::bind(&pushThread, &q, pPool, 100));
+            for (int i = 0; i < 100; ++i) {
+                ElemPtr pElem = q.pop();
+                QUIET_TEST(*pElem == toString(i));
+            }
+            pusher.join();
+            TEST(pPool->getNumBlocksInUse() == 0);
+            TEST(pPool->getHighWaterMark() <= 10);
+        }
+        {
+            // The pool stays alive as long as elements allocated from it exist.
+            ElemPtr pElem = createElem(pPool, 42);
+            BlockPool* pRawPool = pPool.get();
+            pPool = BlockPoolPtr();
+            TEST(pRawPool->getNumBlocksInUse() == 1);
+            TEST(*pElem == "42");
+        }
+    }
+
+private:
+    typedef boost::shared_ptr<string> ElemPtr;
+
+    static ElemPtr createElem(const BlockPoolPtr& pPool, int i)
+    {
+        return boost::allocate_shared<string>(PoolAllocator<string>(pPool),
+                toString(i));
+    }
+
+    static void pushThread(Queue<string>* pq, BlockPoolPtr pPool, int numPushes)
+    {
+        for (int i = 0; i < numPushes; ++i) {
+            pq->push(createElem(pPool, i));
+        }
+    }
+};
+
 class TestWorkerThread: public WorkerThread<TestWorkerThread>
 {
 public:
@@ -331,6 +407,95 @@ public:
 };
 
 
+class ThreadPoolTest: public Test
+{
+public:
+    ThreadPoolTest()
+        : Test("ThreadPoolTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        ThreadPool* pPool = ThreadPool::get();
+        TEST(pPool->getNumThreads() >= 0);
+        {
+            // Every item must be visited exactly once.
+            vector<int> items(1000, 0);
+            pPool->parallelFor(1000, boost::bind(&ThreadPoolTest::incItems, 
+                    boost::ref(items), 0, _1, _2));
+            TEST(count(items.begin(), items.end(), 1) == 1000);
+        }
+        {
+            // Ranges nested inside ranges.
+            vector<int> items(1000, 0);
+            pPool->parallelFor(10, boost::bind(&ThreadPoolTest::incItemsNested, 
+                    boost::ref(items), _1, _2));
+            TEST(count(items.begin(), items.end(), 1) == 1000);
+        }
+        {
+            vector<int> items(3, 0);
+            pPool->parallelFor(3, boost::bind(&ThreadPoolTest::incItems, 
+                    boost::ref(items), 0, _1, _2), 16);
+            TEST(count(items.begin(), items.end(), 1) == 3);
+            pPool->parallelFor(0, boost::bind(&ThreadPoolTest::incItems, 
+                    boost::ref(items), 0, _1, _2));
+            TEST(count(items.begin(), items.end(), 1) == 3);
+        }
+        {
+            // An exception in one range is passed on to the caller and leaves the
+            // pool usable.
+            bool bExceptionCaught = false;
+            try {
+                pPool->parallelFor(1000, boost::bind(&ThreadPoolTest::throwInRange,
+                        500, _1, _2));
+            } catch (const Exception& ex) {
+                bExceptionCaught = true;
+                TEST(ex.getCode() == AVG_ERR_OUT_OF_RANGE);
+            }
+            TEST(bExceptionCaught);
+            vector<int> items(1000, 0);
+            pPool->parallelFor(1000, boost::bind(&ThreadPoolTest::incItems, 
+                    boost::ref(items), 0, _1, _2));
+            TEST(count(items.begin(), items.end(), 1) == 1000);
+        }
+        {
+            // Deleting the pool stops its threads; the next get() creates a new one.
+            delete ThreadPool::get();
+            TEST(!ThreadPool::exists());
+            vector<int> items(1000, 0);
+            ThreadPool::get()->parallelFor(1000, boost::bind(&ThreadPoolTest::incItems,
+                    boost::ref(items), 0, _1, _2));
+            TEST(count(items.begin(), items.end(), 1) == 1000);
+            TEST(ThreadPool::exists());
+        }
+    }
+
+private:
+    static void throwInRange(int throwItem, int start, int end)
+    {
+        if (throwItem >= start && throwItem < end) {
+            throw Exception(AVG_ERR_OUT_OF_RANGE, "ThreadPoolTest");
+        }
+    }
+
+    static void incItems(vector<int>& items, int offset, int start, int end)
+    {
+        for (int i = start; i < end; ++i) {
+            items[offset+i]++;
+        }
+    }
+
+    static void incItemsNested(vector<int>& items, int start, int end)
+    {
+        for (int i = start; i < end; ++i) {
+            ThreadPool::get()->parallelFor(100, boost::bind(&ThreadPoolTest::incItems, 
+                    boost::ref(items), i*100, _1, _2));
+        }
+    }
+};
+
+
 class DummyClass
 {
 public:
@@ -982,8 +1147,11 @@ public:
         : TestSuite("BaseTestSuite")
     {
         addTest(TestPtr(new DAGTest));
-        addTest(TestPtr(new QueueTest));
+        addTest(TestPtr(new QueueTest<Queue>("QueueTest")));
+        addTest(TestPtr(new QueueTest<LockFreeQueue>("LockFreeQueueTest")));
+        addTest(TestPtr(new BlockPoolTest));
         addTest(TestPtr(new WorkerThreadTest));
+        addTest(TestPtr(new ThreadPoolTest));
         addTest(TestPtr(new ObjectCounterTest));
         addTest(TestPtr(new GeomTest));
         addTest(TestPtr(new TriangleTest));
@@ -30,9 +30,16 @@
 #include "../base/ObjectCounter.h"
 #include "../base/MathHelper.h"
 #include "../base/FileHelper.h"
+#include "../base/ThreadPool.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+#include <boost/bind.hpp>
+
+#if defined(__SSE2__) || defined(_WIN32)
+#include <emmintrin.h>
+#endif
+
 #include <cstring>
 #include <iostream>
 #include <iomanip>
@@ -43,7 +50,12 @@ using namespace std;
 namespace avg {
 
 template<class Pixel>
-void createTrueColorCopy(Bitmap& destBmp, const Bitmap & srcBmp);
+void createTrueColorCopy(Bitmap& destBmp, const Bitmap & srcBmp, int startY, int endY);
+static void copyLines(Bitmap& destBmp, const Bitmap& srcBmp, int startY, int endY);
+static void convertLines(int width, int height, const ThreadPool::RangeFunc& func);
+void YUV420toRGB32Line(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, bool bInterleavedUV, unsigned char* pDest, int width,
+        bool bJPEG, bool bRedFirst);
 
 Bitmap::Bitmap(glm::vec2 size, PixelFormat pf, const UTF8String& sName, int stride)
     : m_Size(size),
@@ -158,17 +170,11 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
     if (&origBmp == this || origBmp.getPixels() == m_pBits) {
         return;
     }
+    int height = min(origBmp.getSize().y, m_Size.y);
+    int width = min(origBmp.getSize().x, m_Size.x);
     if (origBmp.getPixelFormat() == m_PF) {
-        const unsigned char * pSrc = origBmp.getPixels();
-        unsigned char * pDest = m_pBits;
-        int height = min(origBmp.getSize().y, m_Size.y);
-        int lineLen = min(origBmp.getLineLen(), getLineLen());
-        int srcStride = origBmp.getStride();
-        for (int y = 0; y < height; ++y) {
-            memcpy(pDest, pSrc, lineLen);
-            pDest += m_Stride;
-            pSrc += srcStride;
-        }
+        convertLines(width, height, boost::bind(&copyLines, boost::ref(*this), 
+                boost::cref(origBmp), _1, _2));
     } else {
         switch (origBmp.getPixelFormat()) {
             case YCbCr422:
@@ -176,14 +182,17 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
             case YCbCr411:
                 switch(m_PF) {
                     case B8G8R8X8:
-                        YCbCrtoBGR(origBmp);
+                        convertLines(width, height, boost::bind(&Bitmap::YCbCrtoBGR, 
+                                this, boost::cref(origBmp), _1, _2));
                         break;
                     case I8:
                     case A8:
-                        YCbCrtoI8(origBmp);
+                        convertLines(width, height, boost::bind(&Bitmap::YCbCrtoI8, 
+                                this, boost::cref(origBmp), _1, _2));
+                        break;
                     default: {
                             Bitmap TempBmp(getSize(), B8G8R8X8, "TempColorConversion");
-                            TempBmp.YCbCrtoBGR(origBmp);
+                            TempBmp.copyPixels(origBmp);
                             copyPixels(TempBmp);
                         }
                         break;
@@ -191,10 +200,11 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
                 break;
             case I16:
                 if (m_PF == I8 || m_PF == A8) {
-                    I16toI8(origBmp);
+                    convertLines(width, height, boost::bind(&Bitmap::I16toI8, 
+                            this, boost::cref(origBmp), _1, _2));
                 } else {
                     Bitmap TempBmp(getSize(), I8, "TempColorConversion");
-                    TempBmp.I16toI8(origBmp);
+                    TempBmp.copyPixels(origBmp);
                     copyPixels(TempBmp);
                 }
                 break;
@@ -202,7 +212,8 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
             case A8:
                 switch(m_PF) {
                     case I16:
-                        I8toI16(origBmp);
+                        convertLines(width, height, boost::bind(&Bitmap::I8toI16, 
+                                this, boost::cref(origBmp), _1, _2));
                         break;
                     case B8G8R8X8:
                     case B8G8R8A8:
@@ -210,7 +221,8 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
                     case R8G8B8A8:
                     case B8G8R8:
                     case R8G8B8:
-                        I8toRGB(origBmp);
+                        convertLines(width, height, boost::bind(&Bitmap::I8toRGB, 
+                                this, boost::cref(origBmp), _1, _2));
                         break;
                     default: 
                         // Unimplemented conversion.
@@ -224,26 +236,20 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
                 switch(m_PF) {
                     case I8:
                     case A8:
-                        {
-                            // Bayer patterns are saved as I8 bitmaps. 
-                            // So simply copy that.
-                            const unsigned char * pSrc = origBmp.getPixels();
-                            unsigned char * pDest = m_pBits;
-                            int height = min(origBmp.getSize().y, m_Size.y);
-                            int lineLen = min(origBmp.getLineLen(), getLineLen());
-                            int srcStride = origBmp.getStride();
-                            for (int y = 0; y < height; ++y) {
-                                memcpy(pDest, pSrc, lineLen);
-                                pDest += m_Stride;
-                                pSrc += srcStride;
-                            }
-                        }
+                        // Bayer patterns are saved as I8 bitmaps. 
+                        // So simply copy that.
+                        convertLines(width, height, boost::bind(&copyLines, 
+                                boost::ref(*this), boost::cref(origBmp), _1, _2));
                         break;
                     case B8G8R8X8:
                     case B8G8R8A8:
                     case R8G8B8X8:
                     case R8G8B8A8:
-                        BY8toRGBBilinear(origBmp);
+                        // The demosaicing kernel needs the lines above and below, so
+                        // the outermost lines are left alone.
+                        convertLines(width, height-2, boost::bind(
+                                &Bitmap::BY8toRGBBilinear, this, boost::cref(origBmp), 
+                                _1, _2));
                         break;
                     default: 
                         // Unimplemented conversion.
@@ -252,7 +258,9 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
                 break;
             case R32G32B32A32F:
                 if (getBytesPerPixel() == 4) {
-                    FloatRGBAtoByteRGBA(origBmp);
+                    convertLines(width, height, boost::bind(
+                            &Bitmap::FloatRGBAtoByteRGBA, this, boost::cref(origBmp), 
+                            _1, _2));
                 } else {
                     cerr << "Can't convert " << origBmp.getPixelFormat() << " to " 
                             << getPixelFormat() << endl;
@@ -263,7 +271,9 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
                 switch(m_PF) {
                     case R32G32B32A32F:
                         if (origBmp.getBytesPerPixel() == 4) {
-                            ByteRGBAtoFloatRGBA(origBmp);
+                            convertLines(width, height, boost::bind(
+                                    &Bitmap::ByteRGBAtoFloatRGBA, this, 
+                                    boost::cref(origBmp), _1, _2));
                         } else {
                             cerr << "Can't convert " << origBmp.getPixelFormat() <<
                                     " to " << getPixelFormat() << endl;
@@ -278,19 +288,27 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
                     case R8G8B8X8:
                     case A8R8G8B8:
                     case X8R8G8B8:
-                        createTrueColorCopy<Pixel32>(*this, origBmp);
+                        convertLines(width, height, boost::bind(
+                                &createTrueColorCopy<Pixel32>, boost::ref(*this), 
+                                boost::cref(origBmp), _1, _2));
                         break;
                     case B8G8R8:
                     case R8G8B8:
-                        createTrueColorCopy<Pixel24>(*this, origBmp);
+                        convertLines(width, height, boost::bind(
+                                &createTrueColorCopy<Pixel24>, boost::ref(*this), 
+                                boost::cref(origBmp), _1, _2));
                         break;
                     case B5G6R5:
                     case R5G6B5:
-                        createTrueColorCopy<Pixel16>(*this, origBmp);
+                        convertLines(width, height, boost::bind(
+                                &createTrueColorCopy<Pixel16>, boost::ref(*this), 
+                                boost::cref(origBmp), _1, _2));
                         break;
                     case I8:
                     case A8:
-                        createTrueColorCopy<Pixel8>(*this, origBmp);
+                        convertLines(width, height, boost::bind(
+                                &createTrueColorCopy<Pixel8>, boost::ref(*this), 
+                                boost::cref(origBmp), _1, _2));
                         break;
                     default:
                         // Unimplemented conversion.
@@ -319,197 +337,23 @@ ostream& operator<<(ostream& os, const __m64 &val)
 }
 #endif
 
-#define YUV_TO_RGB_UNPACK    \
-    /* Input: r, g, b contain 4 words each of the u and v inputs for the color */    \
-    /* channels. ylo and yhi contain 4 words each of the y input. */    \
-\
-    /* duplicate u and v channels and add y    \
-     * each of r,g, b in the form [s1(16), s2(16), s3(16), s4(16)]    \
-     * first interleave, so tmp is [s1(16), s1(16), s2(16), s2(16)]    \
-     * then add y, then interleave again    \
-     * then pack with saturation, to get the desired output of    \
-     *   [s1(8), s1(8), s2(8), s2(8), s3(8), s3(8), s4(8), s4(8)]    \
-     */    \
-    tmp = _m_punpckhwd(r, r);    \
-    tmp = _m_paddsw(tmp, yhi);    \
-    tmp2 = _m_punpcklwd(r, r);    \
-    tmp2 = _m_paddsw(tmp2, ylo);    \
-    r = _m_packuswb(tmp2, tmp);    \
-    \
-    tmp = _m_punpckhwd(g, g);    \
-    tmp2 = _m_punpcklwd(g, g);    \
-    tmp = _m_paddsw(tmp, yhi);    \
-    tmp2 = _m_paddsw(tmp2, ylo);    \
-    g = _m_packuswb(tmp2, tmp);    \
-    \
-    tmp = _m_punpckhwd(b, b);    \
-    tmp2 = _m_punpcklwd(b, b);    \
-    tmp = _m_paddsw(tmp, yhi);    \
-    tmp2 = _m_paddsw(tmp2, ylo);    \
-    b = _m_packuswb(tmp2, tmp);    \
-    \
-    /* now we have 8 8-bit r, g and b samples.  we want these to be packed    \
-     * into 32-bit values.    \
-     */    \
-    imm = _mm_set1_pi32(0xFFFFFFFF);    \
-    tmp = _m_punpcklbw(b, r);    \
-    tmp2 = _m_punpcklbw(g, imm);    \
-    *o++ = _m_punpcklbw(tmp, tmp2);    \
-    *o++ = _m_punpckhbw(tmp, tmp2);    \
-    tmp = _m_punpckhbw(b, r);    \
-    tmp2 = _m_punpckhbw(g, imm);    \
-    *o++ = _m_punpcklbw(tmp, tmp2);    \
-    *o++ = _m_punpckhbw(tmp, tmp2);
-
-
 void Bitmap::copyYUVPixels(const Bitmap& yBmp, const Bitmap& uBmp, const Bitmap& vBmp,
         bool bJPEG)
 {
     int height = min(yBmp.getSize().y, m_Size.y);
     int width = min(yBmp.getSize().x, m_Size.x);
+    convertLines(width, height, boost::bind(&Bitmap::YUV420toRGB32, this,
+            boost::cref(yBmp), boost::cref(uBmp), boost::cref(vBmp), false, bJPEG,
+            _1, _2));
+}
 
-    int yStride = yBmp.getStride();
-    int uStride = uBmp.getStride();
-    int vStride = vBmp.getStride();
-    int destStride = m_Stride/getBytesPerPixel();
-    Pixel32 * pDestLine = (Pixel32*)m_pBits;
-
-#if defined(__SSE__) || defined(_WIN32)
-#pragma pack(16)
-    // Original SSE conversion code taken from liboggplay: oggplay_sse_x86.c
-    int               i;     
-    const unsigned char   * ptry;
-    const unsigned char   * ptru;
-    const unsigned char   * ptrv;
-
-    __m64    *o;
-    __m64    y, ylo, yhi;
-    __m64    zero, ut, vt, imm;
-    __m64    r, g, b;
-    __m64    tmp, tmp2;
-
-    zero = _mm_setzero_si64(); 
-
-    ptry = yBmp.getPixels();
-    ptru = uBmp.getPixels();
-    ptrv = vBmp.getPixels();
-
-    for (i = 0; i < height; i++) {
-        int j;
-        o = (__m64*)pDestLine;
-        pDestLine += destStride;
-        if (bJPEG) {
-            for (j = 0; j < width; j += 8) {
-                // ylo and yhi contain 4 pixels each
-                y = *(__m64*)(&(ptry[j]));
-                ylo = _m_punpcklbw(y, zero);
-               
-                yhi = _m_punpckhbw(y, zero);
-
-                ut = _m_from_int(*(int *)(ptru + j/2));
-                vt = _m_from_int(*(int *)(ptrv + j/2));
-
-                ut = _m_punpcklbw(ut, zero);
-                vt = _m_punpcklbw(vt, zero);
-
-                /* subtract 128 from u and v */ 
-                imm = _mm_set1_pi16(128);
-                ut = _m_psubw(ut, imm);
-                vt = _m_psubw(vt, imm);
-
-                /* transfer and multiply into r, g, b registers */
-                imm = _mm_set1_pi16(-44);
-                g = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(113);
-                b = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(179);
-                r = _m_pmullw(vt, imm);
-                imm = _mm_set1_pi16(-91);
-                imm = _m_pmullw(vt, imm);
-                g = _m_paddsw(g, imm);
-
-                /* shift r, g and b registers to the right */
-                r = _m_psrawi(r, 7);
-                g = _m_psrawi(g, 7);
-                b = _m_psrawi(b, 6);
-                YUV_TO_RGB_UNPACK
-
-            }
-        } else {
-            for (j = 0; j < width; j += 8) {
-
-                // y' = (298*(y-16))
-                // ylo and yhi contain 4 pixels each
-                y = *(__m64*)(&(ptry[j]));
-                ylo = _m_punpcklbw(y, zero);
-                imm = _mm_set1_pi16(16);
-                ylo = _m_psubusw(ylo, imm);
-                imm = _mm_set1_pi16(149);
-                ylo = _m_pmullw(ylo, imm);
-                ylo = _mm_srli_pi16(ylo, 7);
-               
-                yhi = _m_punpckhbw(y, zero);
-                imm = _mm_set1_pi16(16);
-                yhi = _m_psubusw(yhi, imm);
-                imm = _mm_set1_pi16(149);
-                yhi = _m_pmullw(yhi, imm);
-                yhi = _mm_srli_pi16(yhi, 7);
-
-                ut = _m_from_int(*(int *)(ptru + j/2));
-                vt = _m_from_int(*(int *)(ptrv + j/2));
-
-                ut = _m_punpcklbw(ut, zero);
-                vt = _m_punpcklbw(vt, zero);
-
-                /* subtract 128 from u and v */ 
-                imm = _mm_set1_pi16(128);
-                ut = _m_psubw(ut, imm);
-                vt = _m_psubw(vt, imm);
-
-                /* transfer and multiply into r, g, b registers */
-                imm = _mm_set1_pi16(-50);
-                g = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(129);
-                b = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(204);
-                r = _m_pmullw(vt, imm);
-                imm = _mm_set1_pi16(-104);
-                imm = _m_pmullw(vt, imm);
-                g = _m_paddsw(g, imm);
-
-                /* shift r, g and b registers to the right */
-                r = _m_psrawi(r, 7);
-                g = _m_psrawi(g, 7);
-                b = _m_psrawi(b, 6);
-                YUV_TO_RGB_UNPACK
-            }
-        }
-        if (i & 0x1) {
-            ptru += uStride;
-            ptrv += vStride;
-        }
-        ptry += yStride;
-    }
-    _m_empty();
-#pragma pack()
-#else
-    AVG_ASSERT(m_PF==B8G8R8X8);
-    const unsigned char * pYSrc = yBmp.getPixels();
-    const unsigned char * pUSrc = uBmp.getPixels();
-    const unsigned char * pVSrc = vBmp.getPixels();
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            YUVtoBGR32Pixel(pDestLine + x, pYSrc[x], pUSrc[x/2], pVSrc[x/2]);
-        }
-        pDestLine += destStride;
-        pYSrc += yStride;
-        if (y % 2 == 1) {
-            pUSrc += uStride;
-            pVSrc += vStride;
-        }
-    }
-#endif
+void Bitmap::copyNV12Pixels(const Bitmap& yBmp, const Bitmap& uvBmp, bool bJPEG)
+{
+    int height = min(yBmp.getSize().y, m_Size.y);
+    int width = min(yBmp.getSize().x, m_Size.x);
+    convertLines(width, height, boost::bind(&Bitmap::YUV420toRGB32, this,
+            boost::cref(yBmp), boost::cref(uvBmp), boost::cref(uvBmp), true, bJPEG,
+            _1, _2));
 }
 
 void Bitmap::save(const UTF8String& sFilename)
@@ -1274,31 +1118,50 @@ void YUV411toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int wi
     }
 }
 
-void Bitmap::YCbCrtoBGR(const Bitmap& origBmp)
+void Bitmap::YUV420toRGB32(const Bitmap& yBmp, const Bitmap& uBmp, const Bitmap& vBmp,
+        bool bInterleavedUV, bool bJPEG, int startY, int endY)
+{
+    AVG_ASSERT(getBytesPerPixel() == 4);
+    bool bRedFirst = (m_PF == R8G8B8X8 || m_PF == R8G8B8A8);
+    int width = min(yBmp.getSize().x, m_Size.x);
+    for (int y = startY; y < endY; ++y) {
+        const unsigned char * pYLine = yBmp.getPixels()+y*yBmp.getStride();
+        const unsigned char * pULine = uBmp.getPixels()+(y/2)*uBmp.getStride();
+        const unsigned char * pVLine;
+        if (bInterleavedUV) {
+            pVLine = pULine+1;
+        } else {
+            pVLine = vBmp.getPixels()+(y/2)*vBmp.getStride();
+        }
+        YUV420toRGB32Line(pYLine, pULine, pVLine, bInterleavedUV,
+                m_pBits+y*m_Stride, width, bJPEG, bRedFirst);
+    }
+}
+
+void Bitmap::YCbCrtoBGR(const Bitmap& origBmp, int startY, int endY)
 {
     AVG_ASSERT(m_PF==B8G8R8X8);
-    const unsigned char * pSrc = origBmp.getPixels();
-    Pixel32 * pDest = (Pixel32*)m_pBits;
-    int height = min(origBmp.getSize().y, m_Size.y);
+    const unsigned char * pSrc = origBmp.getPixels()+startY*origBmp.getStride();
+    Pixel32 * pDest = (Pixel32*)(m_pBits+startY*m_Stride);
     int width = min(origBmp.getSize().x, m_Size.x);
     int StrideInPixels = m_Stride/getBytesPerPixel();
     switch(origBmp.m_PF) {
         case YCbCr422:
-            for (int y = 0; y < height; ++y) {
+            for (int y = startY; y < endY; ++y) {
                 UYVY422toBGR32Line(pSrc, pDest, width);
                 pDest += StrideInPixels;
                 pSrc += origBmp.getStride();
             }
             break;
         case YUYV422:
-            for (int y = 0; y < height; ++y) {
+            for (int y = startY; y < endY; ++y) {
                 YUYV422toBGR32Line(pSrc, pDest, width);
                 pDest += StrideInPixels;
                 pSrc += origBmp.getStride();
             }
             break;
         case YCbCr411:
-            for (int y = 0; y < height; ++y) {
+            for (int y = startY; y < endY; ++y) {
                 YUV411toBGR32Line(pSrc, pDest, width);
                 pDest += StrideInPixels;
                 pSrc += origBmp.getStride();
@@ -1332,16 +1195,15 @@ void YUV411toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine, int
     }
 }
  
-void Bitmap::YCbCrtoI8(const Bitmap& origBmp)
+void Bitmap::YCbCrtoI8(const Bitmap& origBmp, int startY, int endY)
 {
-    AVG_ASSERT(origBmp.getBytesPerPixel() == 1);
-    const unsigned char * pSrc = origBmp.getPixels();
-    unsigned char * pDest = m_pBits;
-    int height = min(origBmp.getSize().y, m_Size.y);
+    AVG_ASSERT(getBytesPerPixel() == 1);
+    const unsigned char * pSrc = origBmp.getPixels()+startY*origBmp.getStride();
+    unsigned char * pDest = m_pBits+startY*m_Stride;
     int width = min(origBmp.getSize().x, m_Size.x);
     switch(origBmp.m_PF) {
         case YCbCr422:
-            for (int y = 0; y < height; ++y) {
+            for (int y = startY; y < endY; ++y) {
                 // src shifted by one byte to account for UYVY to YUYV 
                 // difference in pixel order.
                 YUYV422toI8Line(pSrc+1, pDest, width);
@@ -1350,14 +1212,14 @@ void Bitmap::YCbCrtoI8(const Bitmap& origBmp)
             }
             break;
         case YUYV422:
-            for (int y = 0; y < height; ++y) {
+            for (int y = startY; y < endY; ++y) {
                 YUYV422toI8Line(pSrc, pDest, width);
                 pDest += m_Stride;
                 pSrc += origBmp.getStride();
             }
             break;
         case YCbCr411:
-            for (int y = 0; y < height; ++y) {
+            for (int y = startY; y < endY; ++y) {
                 YUV411toI8Line(pSrc, pDest, width);
                 pDest += m_Stride;
                 pSrc += origBmp.getStride();
@@ -1369,71 +1231,316 @@ void Bitmap::YCbCrtoI8(const Bitmap& origBmp)
     }
 }
 
-void Bitmap::I16toI8(const Bitmap& origBmp)
+// The line converters below handle as many pixels as possible using SSE2 and finish
+// the rest of the line in plain C. They return nothing and don't require any alignment.
+
+void I16toI8Line(const unsigned short* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    for (; x < width-15; x += 16) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(pSrc+x));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(pSrc+x+8));
+        lo = _mm_srli_epi16(lo, 8);
+        hi = _mm_srli_epi16(hi, 8);
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; x < width; ++x) {
+        pDest[x] = pSrc[x] >> 8;
+    }
+}
+
+void I8toI16Line(const unsigned char* pSrc, unsigned short* pDest, int width)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    __m128i zero = _mm_setzero_si128();
+    for (; x < width-15; x += 16) {
+        __m128i src = _mm_loadu_si128((const __m128i*)(pSrc+x));
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_unpacklo_epi8(zero, src));
+        _mm_storeu_si128((__m128i*)(pDest+x+8), _mm_unpackhi_epi8(zero, src));
+    }
+#endif
+    for (; x < width; ++x) {
+        pDest[x] = pSrc[x] << 8;
+    }
+}
+
+void I8toRGB32Line(const unsigned char* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    __m128i alpha = _mm_set1_epi8(char(0xFF));
+    for (; x < width-15; x += 16) {
+        __m128i src = _mm_loadu_si128((const __m128i*)(pSrc+x));
+        __m128i gg = _mm_unpacklo_epi8(src, src);
+        __m128i ga = _mm_unpacklo_epi8(src, alpha);
+        _mm_storeu_si128((__m128i*)(pDest+x*4), _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128((__m128i*)(pDest+x*4+16), _mm_unpackhi_epi16(gg, ga));
+        gg = _mm_unpackhi_epi8(src, src);
+        ga = _mm_unpackhi_epi8(src, alpha);
+        _mm_storeu_si128((__m128i*)(pDest+x*4+32), _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128((__m128i*)(pDest+x*4+48), _mm_unpackhi_epi16(gg, ga));
+    }
+#endif
+    for (; x < width; ++x) {
+        unsigned char * pDestPixel = pDest+x*4;
+        pDestPixel[0] = pDestPixel[1] = pDestPixel[2] = pSrc[x];
+        pDestPixel[3] = 255;
+    }
+}
+
+// Same fixed point arithmetic as the SSE2 code below, so both produce identical results.
+static inline void YUV420toRGB32Pixel(unsigned char* pDest, int y, int u, int v,
+        bool bJPEG, bool bRedFirst)
+{
+    int u1 = u-128;
+    int v1 = v-128;
+    int r, g, b;
+    if (bJPEG) {
+        b = y + ((u1*113) >> 6);
+        g = y + ((u1*-44 + v1*-91) >> 7);
+        r = y + ((v1*179) >> 7);
+    } else {
+        y = (max(y-16, 0)*149) >> 7;
+        b = y + ((u1*129) >> 6);
+        g = y + ((u1*-50 + v1*-104) >> 7);
+        r = y + ((v1*204) >> 7);
+    }
+    b = max(0, min(b, 255));
+    g = max(0, min(g, 255));
+    r = max(0, min(r, 255));
+    if (bRedFirst) {
+        pDest[0] = r;
+        pDest[2] = b;
+    } else {
+        pDest[0] = b;
+        pDest[2] = r;
+    }
+    pDest[1] = g;
+    pDest[3] = 255;
+}
+
+// Converts one line of 4:2:0 YUV to 32 bit RGB with opaque alpha. If bInterleavedUV is
+// set, pU points to interleaved UV pairs (NV12) and pV is ignored.
+void YUV420toRGB32Line(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, bool bInterleavedUV, unsigned char* pDest, int width,
+        bool bJPEG, bool bRedFirst)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    __m128i zero = _mm_setzero_si128();
+    __m128i alpha = _mm_set1_epi8(char(0xFF));
+    __m128i offset128 = _mm_set1_epi16(128);
+    __m128i lowByteMask = _mm_set1_epi16(0xFF);
+    __m128i offset16 = _mm_set1_epi16(16);
+    __m128i yFactor = _mm_set1_epi16(149);
+    __m128i ubFactor = _mm_set1_epi16(bJPEG ? 113 : 129);
+    __m128i ugFactor = _mm_set1_epi16(bJPEG ? -44 : -50);
+    __m128i vgFactor = _mm_set1_epi16(bJPEG ? -91 : -104);
+    __m128i vrFactor = _mm_set1_epi16(bJPEG ? 179 : 204);
+    for (; x < width-15; x += 16) {
+        // 16 luma samples, 8 chroma samples per channel.
+        __m128i y = _mm_loadu_si128((const __m128i*)(pY+x));
+        __m128i ylo = _mm_unpacklo_epi8(y, zero);
+        __m128i yhi = _mm_unpackhi_epi8(y, zero);
+        if (!bJPEG) {
+            ylo = _mm_srli_epi16(_mm_mullo_epi16(_mm_subs_epu16(ylo, offset16), 
+                    yFactor), 7);
+            yhi = _mm_srli_epi16(_mm_mullo_epi16(_mm_subs_epu16(yhi, offset16), 
+                    yFactor), 7);
+        }
+        __m128i u;
+        __m128i v;
+        if (bInterleavedUV) {
+            __m128i uv = _mm_loadu_si128((const __m128i*)(pU+x));
+            u = _mm_and_si128(uv, lowByteMask);
+            v = _mm_srli_epi16(uv, 8);
+        } else {
+            u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pU+x/2)), zero);
+            v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pV+x/2)), zero);
+        }
+        u = _mm_sub_epi16(u, offset128);
+        v = _mm_sub_epi16(v, offset128);
+        __m128i b = _mm_srai_epi16(_mm_mullo_epi16(u, ubFactor), 6);
+        __m128i g = _mm_srai_epi16(_mm_adds_epi16(_mm_mullo_epi16(u, ugFactor),
+                _mm_mullo_epi16(v, vgFactor)), 7);
+        __m128i r = _mm_srai_epi16(_mm_mullo_epi16(v, vrFactor), 7);
+
+        // Each chroma value is used for two neighbouring pixels.
+        b = _mm_packus_epi16(_mm_adds_epi16(_mm_unpacklo_epi16(b, b), ylo),
+                _mm_adds_epi16(_mm_unpackhi_epi16(b, b), yhi));
+        g = _mm_packus_epi16(_mm_adds_epi16(_mm_unpacklo_epi16(g, g), ylo),
+                _mm_adds_epi16(_mm_unpackhi_epi16(g, g), yhi));
+        r = _mm_packus_epi16(_mm_adds_epi16(_mm_unpacklo_epi16(r, r), ylo),
+                _mm_adds_epi16(_mm_unpackhi_epi16(r, r), yhi));
+        if (bRedFirst) {
+            __m128i tmp = b;
+            b = r;
+            r = tmp;
+        }
+        __m128i bg = _mm_unpacklo_epi8(b, g);
+        __m128i ra = _mm_unpacklo_epi8(r, alpha);
+        _mm_storeu_si128((__m128i*)(pDest+x*4), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i*)(pDest+x*4+16), _mm_unpackhi_epi16(bg, ra));
+        bg = _mm_unpackhi_epi8(b, g);
+        ra = _mm_unpackhi_epi8(r, alpha);
+        _mm_storeu_si128((__m128i*)(pDest+x*4+32), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i*)(pDest+x*4+48), _mm_unpackhi_epi16(bg, ra));
+    }
+#endif
+    for (; x < width; ++x) {
+        int u;
+        int v;
+        if (bInterleavedUV) {
+            u = pU[(x/2)*2];
+            v = pU[(x/2)*2+1];
+        } else {
+            u = pU[x/2];
+            v = pV[x/2];
+        }
+        YUV420toRGB32Pixel(pDest+x*4, pY[x], u, v, bJPEG, bRedFirst);
+    }
+}
+
+void ByteRGBAtoFloatRGBALine(const unsigned char* pSrc, float* pDest, int width)
+{
+    int numComponents = width*4;
+    int i = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    __m128i zero = _mm_setzero_si128();
+    __m128 divisor = _mm_set1_ps(255.f);
+    for (; i < numComponents-15; i += 16) {
+        __m128i src = _mm_loadu_si128((const __m128i*)(pSrc+i));
+        __m128i lo = _mm_unpacklo_epi8(src, zero);
+        __m128i hi = _mm_unpackhi_epi8(src, zero);
+        _mm_storeu_ps(pDest+i, 
+                _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), divisor));
+        _mm_storeu_ps(pDest+i+4, 
+                _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), divisor));
+        _mm_storeu_ps(pDest+i+8, 
+                _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), divisor));
+        _mm_storeu_ps(pDest+i+12, 
+                _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), divisor));
+    }
+#endif
+    for (; i < numComponents; ++i) {
+        pDest[i] = float(pSrc[i])/255;
+    }
+}
+
+void FloatRGBAtoByteRGBALine(const float* pSrc, unsigned char* pDest, int width)
+{
+    int numComponents = width*4;
+    int i = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    __m128 factor = _mm_set1_ps(255.f);
+    __m128 half = _mm_set1_ps(0.5f);
+    for (; i < numComponents-15; i += 16) {
+        __m128i c0 = _mm_cvttps_epi32(_mm_add_ps(
+                _mm_mul_ps(_mm_loadu_ps(pSrc+i), factor), half));
+        __m128i c1 = _mm_cvttps_epi32(_mm_add_ps(
+                _mm_mul_ps(_mm_loadu_ps(pSrc+i+4), factor), half));
+        __m128i c2 = _mm_cvttps_epi32(_mm_add_ps(
+                _mm_mul_ps(_mm_loadu_ps(pSrc+i+8), factor), half));
+        __m128i c3 = _mm_cvttps_epi32(_mm_add_ps(
+                _mm_mul_ps(_mm_loadu_ps(pSrc+i+12), factor), half));
+        _mm_storeu_si128((__m128i*)(pDest+i), _mm_packus_epi16(
+                _mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3)));
+    }
+#endif
+    for (; i < numComponents; ++i) {
+        pDest[i] = (unsigned char)(pSrc[i]*255+0.5);
+    }
+}
+
+void RGB32toI8Line(const unsigned char* pSrc, unsigned char* pDest, int width, 
+        bool bRedFirst)
+{
+    int w0, w1, w2;
+    if (bRedFirst) {
+        w0 = 54;
+        w1 = 183;
+        w2 = 19;
+    } else {
+        w0 = 19;
+        w1 = 183;
+        w2 = 54;
+    }
+    int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    // The weighted sum is at most 255*256, so it fits into the low 16 bits of each
+    // 32-bit pixel lane.
+    __m128i weight0 = _mm_set1_epi32(w0);
+    __m128i weight1 = _mm_set1_epi32(w1);
+    __m128i weight2 = _mm_set1_epi32(w2);
+    __m128i mask = _mm_set1_epi32(0xFF);
+    __m128i sums[4];
+    for (; x < width-15; x += 16) {
+        for (int i = 0; i < 4; ++i) {
+            __m128i src = _mm_loadu_si128((const __m128i*)(pSrc+x*4+i*16));
+            __m128i c0 = _mm_and_si128(src, mask);
+            __m128i c1 = _mm_and_si128(_mm_srli_epi32(src, 8), mask);
+            __m128i c2 = _mm_and_si128(_mm_srli_epi32(src, 16), mask);
+            __m128i sum = _mm_add_epi16(_mm_mullo_epi16(c0, weight0), 
+                    _mm_mullo_epi16(c1, weight1));
+            sum = _mm_add_epi16(sum, _mm_mullo_epi16(c2, weight2));
+            sums[i] = _mm_srli_epi32(sum, 8);
+        }
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_packus_epi16(
+                _mm_packs_epi32(sums[0], sums[1]), _mm_packs_epi32(sums[2], sums[3])));
+    }
+#endif
+    for (; x < width; ++x) {
+        const unsigned char * pSrcPixel = pSrc+x*4;
+        pDest[x] = (pSrcPixel[0]*w0+pSrcPixel[1]*w1+pSrcPixel[2]*w2)/256;
+    }
+}
+
+void Bitmap::I16toI8(const Bitmap& origBmp, int startY, int endY)
 {
     AVG_ASSERT(getBytesPerPixel() == 1);
     AVG_ASSERT(origBmp.getPixelFormat() == I16);
-    const unsigned short * pSrc = (const unsigned short *)origBmp.getPixels();
-    unsigned char * pDest = m_pBits;
-    int height = min(origBmp.getSize().y, m_Size.y);
+    const unsigned char * pSrc = origBmp.getPixels()+startY*origBmp.getStride();
+    unsigned char * pDest = m_pBits+startY*m_Stride;
     int width = min(origBmp.getSize().x, m_Size.x);
-    int srcStrideInPixels = origBmp.getStride()/origBmp.getBytesPerPixel();
-    for (int y = 0; y < height; ++y) {
-        const unsigned short * pSrcPixel = pSrc;
-        unsigned char * pDestPixel = pDest;
-        for (int x=0; x<width; ++x) {
-            *pDestPixel++ = *pSrcPixel++ >> 8;
-        }
+    for (int y = startY; y < endY; ++y) {
+        I16toI8Line((const unsigned short *)pSrc, pDest, width);
         pDest += m_Stride;
-        pSrc += srcStrideInPixels;
+        pSrc += origBmp.getStride();
     }
 }
 
-void Bitmap::I8toI16(const Bitmap& origBmp)
+void Bitmap::I8toI16(const Bitmap& origBmp, int startY, int endY)
 {
     AVG_ASSERT(m_PF == I16);
     AVG_ASSERT(origBmp.getBytesPerPixel() == 1);
-    const unsigned char * pSrc = origBmp.getPixels();
-    unsigned short * pDest = (unsigned short *)m_pBits;
-    int height = min(origBmp.getSize().y, m_Size.y);
+    const unsigned char * pSrc = origBmp.getPixels()+startY*origBmp.getStride();
+    unsigned char * pDest = m_pBits+startY*m_Stride;
     int width = min(origBmp.getSize().x, m_Size.x);
-    int destStrideInPixels = m_Stride/getBytesPerPixel();
-    for (int y=0; y<height; ++y) {
-        const unsigned char * pSrcPixel = pSrc;
-        unsigned short * pDestPixel = pDest;
-        for (int x=0; x<width; ++x) {
-            *pDestPixel++ = *pSrcPixel++ << 8;
-        }
-        pDest += destStrideInPixels;
+    for (int y = startY; y < endY; ++y) {
+        I8toI16Line(pSrc, (unsigned short *)pDest, width);
+        pDest += m_Stride;
         pSrc += origBmp.getStride();
     }
 }
 
-void Bitmap::I8toRGB(const Bitmap& origBmp)
+void Bitmap::I8toRGB(const Bitmap& origBmp, int startY, int endY)
 {
     AVG_ASSERT(getBytesPerPixel() == 4 || getBytesPerPixel() == 3);
     AVG_ASSERT(origBmp.getBytesPerPixel() == 1);
-    const unsigned char * pSrc = origBmp.getPixels();
-    int height = min(origBmp.getSize().y, m_Size.y);
+    const unsigned char * pSrc = origBmp.getPixels()+startY*origBmp.getStride();
+    unsigned char * pDest = m_pBits+startY*m_Stride;
     int width = min(origBmp.getSize().x, m_Size.x);
     if (getBytesPerPixel() == 4) {
-        unsigned int * pDest = (unsigned int *)m_pBits;
-        int destStrideInPixels = m_Stride/getBytesPerPixel();
-        for (int y = 0; y < height; ++y) {
-            const unsigned char * pSrcPixel = pSrc;
-            unsigned int * pDestPixel = pDest;
-            for (int x = 0; x < width; ++x) {
-                *pDestPixel = (((((255 << 8)+(*pSrcPixel)) << 8)+
-                        *pSrcPixel) << 8) +(*pSrcPixel);
-                pDestPixel ++;
-                pSrcPixel++;
-            }
-            pDest += destStrideInPixels;
+        for (int y = startY; y < endY; ++y) {
+            I8toRGB32Line(pSrc, pDest, width);
+            pDest += m_Stride;
             pSrc += origBmp.getStride();
         }
     } else {
-        unsigned char * pDest = m_pBits;
-        for (int y = 0; y < height; ++y) {
+        for (int y = startY; y < endY; ++y) {
             const unsigned char * pSrcPixel = pSrc;
             unsigned char * pDestPixel = pDest;
             for (int x = 0; x < width; ++x) {
@@ -1448,45 +1555,31 @@ void Bitmap::I8toRGB(const Bitmap& origBmp)
     }
 }
 
-void Bitmap::ByteRGBAtoFloatRGBA(const Bitmap& origBmp)
+void Bitmap::ByteRGBAtoFloatRGBA(const Bitmap& origBmp, int startY, int endY)
 {
     AVG_ASSERT(getPixelFormat() == R32G32B32A32F);
     AVG_ASSERT(origBmp.getBytesPerPixel() == 4);
-    const unsigned char * pSrc = origBmp.getPixels();
-    int height = min(origBmp.getSize().y, m_Size.y);
+    const unsigned char * pSrc = origBmp.getPixels()+startY*origBmp.getStride();
+    unsigned char * pDest = m_pBits+startY*m_Stride;
     int width = min(origBmp.getSize().x, m_Size.x);
-    float * pDest = (float *)m_pBits;
-    for (int y = 0; y < height; ++y) {
-        const unsigned char * pSrcPixel = pSrc;
-        float * pDestPixel = pDest;
-        for (int x = 0; x < width*4; ++x) {
-            *pDestPixel = float(*pSrcPixel)/255;
-            pDestPixel ++;
-            pSrcPixel++;
-        }
-        pDest += m_Stride/sizeof(float);
+    for (int y = startY; y < endY; ++y) {
+        ByteRGBAtoFloatRGBALine(pSrc, (float *)pDest, width);
+        pDest += m_Stride;
         pSrc += origBmp.getStride();
     }
 }
 
-void Bitmap::FloatRGBAtoByteRGBA(const Bitmap& origBmp)
+void Bitmap::FloatRGBAtoByteRGBA(const Bitmap& origBmp, int startY, int endY)
 {
     AVG_ASSERT(getBytesPerPixel() == 4);
     AVG_ASSERT(origBmp.getPixelFormat() == R32G32B32A32F);
-    const float * pSrc = (const float *)origBmp.getPixels();
-    int height = min(origBmp.getSize().y, m_Size.y);
+    const unsigned char * pSrc = origBmp.getPixels()+startY*origBmp.getStride();
+    unsigned char * pDest = m_pBits+startY*m_Stride;
     int width = min(origBmp.getSize().x, m_Size.x);
-    unsigned char * pDest = m_pBits;
-    for (int y = 0; y < height; ++y) {
-        const float * pSrcPixel = pSrc;
-        unsigned char * pDestPixel = pDest;
-        for (int x = 0; x < width*4; ++x) {
-            *pDestPixel = (unsigned char)(*pSrcPixel*255+0.5);
-            pDestPixel++;
-            pSrcPixel++;
-        }
+    for (int y = startY; y < endY; ++y) {
+        FloatRGBAtoByteRGBALine((const float *)pSrc, pDest, width);
         pDest += m_Stride;
-        pSrc += origBmp.getStride()/sizeof(float);
+        pSrc += origBmp.getStride();
     }
 }
 
@@ -1590,17 +1683,18 @@ void Bitmap::BY8toRGBNearest(const Bitmap& origBmp)
 // Code has been taken and adapted from libdc1394 Bayer conversion
 // Original source is OpenCV Bayer pattern decoding
 // TODO: adapt it for RGB24, not just for RGB32
-void Bitmap::BY8toRGBBilinear(const Bitmap& origBmp)
+// Each line of the destination is interpolated from three source lines, so the
+// range passed in refers to lines 1..height-2 of the destination, offset by -1.
+void Bitmap::BY8toRGBBilinear(const Bitmap& origBmp, int startY, int endY)
 {
     AVG_ASSERT(getBytesPerPixel() == 4);
     AVG_ASSERT(pixelFormatIsBayer(origBmp.getPixelFormat()));
 
-    int height = min(origBmp.getSize().y, m_Size.y);
     int width = min(origBmp.getSize().x, m_Size.x);
 
-    const int srcStride = width;
+    const int srcStride = origBmp.getStride();
     const int doubleSrcStride = srcStride * 2;
-    const int destStride = 4 * width;
+    const int destStride = m_Stride;
 
     // CFA Pattern selection
     PixelFormat pf = origBmp.getPixelFormat();
@@ -1617,12 +1711,17 @@ void Bitmap::BY8toRGBBilinear(const Bitmap& origBmp)
     } else {
         greenFirst = 0;
     }
+    // The pattern alternates with every line.
+    if (startY % 2 == 1) {
+        blue = -blue;
+        greenFirst = !greenFirst;
+    }
 
-    const unsigned char *pSrcPixel = origBmp.getPixels();
-    unsigned char *pDestPixel = (unsigned char *) getPixels();
+    const unsigned char *pSrcPixel = origBmp.getPixels() + startY*srcStride;
+    unsigned char *pDestPixel = (unsigned char *) getPixels() + startY*destStride;
 
     pDestPixel += destStride + 4 + 1;
-    height -= 2;
+    int height = endY-startY;
     width -= 2;
 
     while (height--) {
@@ -1713,14 +1812,38 @@ void Bitmap::BY8toRGBBilinear(const Bitmap& origBmp)
     }
 }
 
+static void copyLines(Bitmap& destBmp, const Bitmap& srcBmp, int startY, int endY)
+{
+    const unsigned char * pSrc = srcBmp.getPixels()+startY*srcBmp.getStride();
+    unsigned char * pDest = destBmp.getPixels()+startY*destBmp.getStride();
+    int lineLen = min(srcBmp.getLineLen(), destBmp.getLineLen());
+    for (int y = startY; y < endY; ++y) {
+        memcpy(pDest, pSrc, lineLen);
+        pDest += destBmp.getStride();
+        pSrc += srcBmp.getStride();
+    }
+}
+
+// Below this size, handing bands to other threads costs more than it saves.
+static const int MIN_PARALLEL_CONVERSION_PIXELS = 256*256;
+static const int MIN_LINES_PER_BAND = 16;
+
+static void convertLines(int width, int height, const ThreadPool::RangeFunc& func)
+{
+    if (width*height < MIN_PARALLEL_CONVERSION_PIXELS) {
+        func(0, height);
+    } else {
+        ThreadPool::get()->parallelFor(height, func, MIN_LINES_PER_BAND);
+    }
+}
+
 template<class DESTPIXEL, class SRCPIXEL>
-void createTrueColorCopy(Bitmap& destBmp, const Bitmap& srcBmp)
+void createTrueColorCopy(Bitmap& destBmp, const Bitmap& srcBmp, int startY, int endY)
 {
-    SRCPIXEL * pSrcLine = (SRCPIXEL*) srcBmp.getPixels();
-    DESTPIXEL * pDestLine = (DESTPIXEL*) destBmp.getPixels();
-    int height = min(srcBmp.getSize().y, destBmp.getSize().y);
+    SRCPIXEL * pSrcLine = (SRCPIXEL*)(srcBmp.getPixels()+startY*srcBmp.getStride());
+    DESTPIXEL * pDestLine = (DESTPIXEL*)(destBmp.getPixels()+startY*destBmp.getStride());
     int width = min(srcBmp.getSize().x, destBmp.getSize().x);
-    for (int y = 0; y < height; ++y) {
+    for (int y = startY; y < endY; ++y) {
         SRCPIXEL * pSrcPixel = pSrcLine;
         DESTPIXEL * pDestPixel = pDestLine;
         for (int x = 0; x < width; ++x) {
@@ -1734,57 +1857,42 @@ void createTrueColorCopy(Bitmap& destBmp, const Bitmap& srcBmp)
 }
 
 template<>
-void createTrueColorCopy<Pixel32, Pixel8>(Bitmap& destBmp, const Bitmap& srcBmp)
+void createTrueColorCopy<Pixel32, Pixel32>(Bitmap& destBmp, const Bitmap& srcBmp, 
+        int startY, int endY)
 {
-    const unsigned char * pSrcLine = srcBmp.getPixels();
-    unsigned char * pDestLine = destBmp.getPixels();
-    int height = min(srcBmp.getSize().y, destBmp.getSize().y);
+    // 32 bit formats are copied without swizzling channels.
+    copyLines(destBmp, srcBmp, startY, endY);
+}
+
+template<>
+void createTrueColorCopy<Pixel32, Pixel8>(Bitmap& destBmp, const Bitmap& srcBmp,
+        int startY, int endY)
+{
+    const unsigned char * pSrcLine = srcBmp.getPixels()+startY*srcBmp.getStride();
+    unsigned char * pDestLine = destBmp.getPixels()+startY*destBmp.getStride();
     int width = min(srcBmp.getSize().x, destBmp.getSize().x);
     int srcStride = srcBmp.getStride();
     int destStride = destBmp.getStride();
-    for (int y = 0; y < height; ++y) {
-        const unsigned char * pSrcPixel = pSrcLine;
-        unsigned char * pDestPixel = pDestLine;
-        for (int x = 0; x < width; ++x) {
-            pDestPixel[0] =
-            pDestPixel[1] =
-            pDestPixel[2] = *pSrcPixel;
-            pDestPixel[3] = 255;
-            ++pSrcPixel;
-            pDestPixel+=4;
-        }
+    for (int y = startY; y < endY; ++y) {
+        I8toRGB32Line(pSrcLine, pDestLine, width);
         pSrcLine = pSrcLine + srcStride;
         pDestLine = pDestLine + destStride;
     }
 }
 
 template<>
-void createTrueColorCopy<Pixel8, Pixel32>(Bitmap& destBmp, const Bitmap& srcBmp)
+void createTrueColorCopy<Pixel8, Pixel32>(Bitmap& destBmp, const Bitmap& srcBmp,
+        int startY, int endY)
 {
-    const unsigned char * pSrcLine = srcBmp.getPixels();
-    unsigned char * pDestLine = destBmp.getPixels();
-    int height = min(srcBmp.getSize().y, destBmp.getSize().y);
+    const unsigned char * pSrcLine = srcBmp.getPixels()+startY*srcBmp.getStride();
+    unsigned char * pDestLine = destBmp.getPixels()+startY*destBmp.getStride();
     int width = min(srcBmp.getSize().x, destBmp.getSize().x);
     int srcStride = srcBmp.getStride();
     int destStride = destBmp.getStride();
     bool bRedFirst = (srcBmp.getPixelFormat() == R8G8B8A8) || 
             (srcBmp.getPixelFormat() == R8G8B8X8);
-    for (int y = 0; y<height; ++y) {
-        const unsigned char * pSrcPixel = pSrcLine;
-        unsigned char * pDestPixel = pDestLine;
-        if (bRedFirst) {
-            for (int x = 0; x < width; ++x) {
-                *pDestPixel = ((pSrcPixel[0]*54+pSrcPixel[1]*183+pSrcPixel[2]*19)/256);
-                pSrcPixel+=4;
-                ++pDestPixel;
-            }
-        } else {
-            for (int x = 0; x < width; ++x) {
-                *pDestPixel = ((pSrcPixel[0]*19+pSrcPixel[1]*183+pSrcPixel[2]*54)/256);
-                pSrcPixel+=4;
-                ++pDestPixel;
-            }
-        }
+    for (int y = startY; y < endY; ++y) {
+        RGB32toI8Line(pSrcLine, pDestLine, width, bRedFirst);
         pSrcLine = pSrcLine + srcStride;
         pDestLine = pDestLine + destStride;
     }
@@ -1792,7 +1900,7 @@ void createTrueColorCopy<Pixel8, Pixel32>(Bitmap& destBmp, const Bitmap& srcBmp)
 
 
 template<class PIXEL>
-void createTrueColorCopy(Bitmap& destBmp, const Bitmap& srcBmp)
+void createTrueColorCopy(Bitmap& destBmp, const Bitmap& srcBmp, int startY, int endY)
 {
     switch(srcBmp.getPixelFormat()) {
         case B8G8R8A8:
@@ -1803,15 +1911,15 @@ void createTrueColorCopy(Bitmap& destBmp, const Bitmap& srcBmp)
         case R8G8B8X8:
         case A8R8G8B8:
         case X8R8G8B8:
-            createTrueColorCopy<PIXEL, Pixel32>(destBmp, srcBmp);
+            createTrueColorCopy<PIXEL, Pixel32>(destBmp, srcBmp, startY, endY);
             break;
         case B8G8R8:
         case R8G8B8:
-            createTrueColorCopy<PIXEL, Pixel24>(destBmp, srcBmp);
+            createTrueColorCopy<PIXEL, Pixel24>(destBmp, srcBmp, startY, endY);
             break;
         case B5G6R5:
         case R5G6B5:
-            createTrueColorCopy<PIXEL, Pixel16>(destBmp, srcBmp);
+            createTrueColorCopy<PIXEL, Pixel16>(destBmp, srcBmp, startY, endY);
             break;
         case I8:
         case A8:
@@ -1819,7 +1927,7 @@ void createTrueColorCopy(Bitmap& destBmp, const Bitmap& srcBmp)
         case BAYER8_GBRG:
         case BAYER8_GRBG:
         case BAYER8_BGGR:
-            createTrueColorCopy<PIXEL, Pixel8>(destBmp, srcBmp);
+            createTrueColorCopy<PIXEL, Pixel8>(destBmp, srcBmp, startY, endY);
             break;
         default:
             // Unimplemented conversion.
@@ -64,8 +64,12 @@ public:
     
     // Does pixel format conversion if nessesary.
     void copyPixels(const Bitmap& origBmp);
+    // Convert 4:2:0 YCbCr to 32 bit RGB (B8G8R8X8 or R8G8B8X8 and the corresponding
+    // alpha formats). The chroma planes have half the size of the luma plane.
     void copyYUVPixels(const Bitmap& yBmp, const Bitmap& uBmp, const Bitmap& vBmp,
             bool bJPEG);
+    // uvBmp holds interleaved Cb/Cr pairs.
+    void copyNV12Pixels(const Bitmap& yBmp, const Bitmap& uvBmp, bool bJPEG);
     void save(const UTF8String& sName);
     
     IntPoint getSize() const;
@@ -103,16 +107,20 @@ public:
 private:
     void initWithData(unsigned char* pBits, int stride, bool bCopyBits);
     void allocBits(int stride=0);
-    void YCbCrtoBGR(const Bitmap& origBmp);
-    void YCbCrtoI8(const Bitmap& origBmp);
-    void I8toI16(const Bitmap& origBmp);
-    void I8toRGB(const Bitmap& origBmp);
-    void I16toI8(const Bitmap& origBmp);
+    // Format converters. Each one converts the lines [startY, endY), so a conversion
+    // can be split into bands that run in parallel.
+    void YUV420toRGB32(const Bitmap& yBmp, const Bitmap& uBmp, const Bitmap& vBmp,
+            bool bInterleavedUV, bool bJPEG, int startY, int endY);
+    void YCbCrtoBGR(const Bitmap& origBmp, int startY, int endY);
+    void YCbCrtoI8(const Bitmap& origBmp, int startY, int endY);
+    void I8toI16(const Bitmap& origBmp, int startY, int endY);
+    void I8toRGB(const Bitmap& origBmp, int startY, int endY);
+    void I16toI8(const Bitmap& origBmp, int startY, int endY);
     void BGRtoB5G6R5(const Bitmap& origBmp);
-    void ByteRGBAtoFloatRGBA(const Bitmap& origBmp);
-    void FloatRGBAtoByteRGBA(const Bitmap& origBmp);
+    void ByteRGBAtoFloatRGBA(const Bitmap& origBmp, int startY, int endY);
+    void FloatRGBAtoByteRGBA(const Bitmap& origBmp, int startY, int endY);
     void BY8toRGBNearest(const Bitmap& origBmp);
-    void BY8toRGBBilinear(const Bitmap& origBmp);
+    void BY8toRGBBilinear(const Bitmap& origBmp, int startY, int endY);
 
     IntPoint m_Size;
     int m_Stride;
@@ -23,12 +23,15 @@
 
 #include "PixelFormat.h"
 #include "Filterfliprgb.h"
+#include "FilterResample.h"
 
 #include "../base/Exception.h"
 #include "../base/ScopeTimer.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <iostream>
+#include <sstream>
+#include <math.h>
 
 using namespace std;
 using namespace boost;
@@ -89,6 +92,7 @@ PixelFormat BitmapLoader::getDefaultPixelFormat(bool bAlpha)
 static ProfilingZoneID GDKPixbufProfilingZone("gdk_pixbuf load", true);
 static ProfilingZoneID ConvertProfilingZone("Format conversion", true);
 static ProfilingZoneID RGBFlipProfilingZone("RGB<->BGR flip", true);
+static ProfilingZoneID ResampleProfilingZone("Resample", true);
 
 BitmapPtr BitmapLoader::load(const UTF8String& sFName, PixelFormat pf) const
 {
@@ -104,6 +108,85 @@ BitmapPtr BitmapLoader::load(const UTF8String& sFName, PixelFormat pf) const
         g_error_free(pError);
         throw Exception(AVG_ERR_FILEIO, sErr);
     }
+    BitmapPtr pBmp = pixBufToBitmap(pPixBuf, sFName, pf);
+    g_object_unref(pPixBuf);
+    return pBmp;
+}
+
+static ProfilingZoneID GDKPixbufScaledProfilingZone("gdk_pixbuf load scaled", true);
+
+BitmapPtr BitmapLoader::load(const UTF8String& sFName, const IntPoint& size,
+        const IntRect& srcRect, PixelFormat pf) const
+{
+    AVG_ASSERT(s_pBitmapLoader != 0);
+    IntPoint fileSize;
+    if (!gdk_pixbuf_get_file_info(sFName.c_str(), &fileSize.x, &fileSize.y)) {
+        // Let gdk_pixbuf generate a proper error message.
+        return load(sFName, pf);
+    }
+    IntRect rect = srcRect;
+    if (rect.width() <= 0 || rect.height() <= 0) {
+        rect = IntRect(IntPoint(0,0), fileSize);
+    }
+    if (rect.tl.x < 0 || rect.tl.y < 0 || rect.br.x > fileSize.x || 
+            rect.br.y > fileSize.y)
+    {
+        stringstream ss;
+        ss << sFName << ": Source rectangle " << rect << " is outside of the image.";
+        throw Exception(AVG_ERR_OUT_OF_RANGE, ss.str());
+    }
+    IntPoint destSize = size;
+    if (destSize.x <= 0 && destSize.y <= 0) {
+        destSize = rect.size();
+    } else if (destSize.x <= 0) {
+        destSize.x = max(1, int(float(destSize.y)*rect.width()/rect.height()+0.5f));
+    } else if (destSize.y <= 0) {
+        destSize.y = max(1, int(float(destSize.x)*rect.height()/rect.width()+0.5f));
+    }
+    if (rect.size() == fileSize && destSize == fileSize) {
+        return load(sFName, pf);
+    }
+
+    // Decode the whole file at twice the resolution the rectangle needs. Loaders that
+    // support it (e.g. jpeg via DCT scaling) decode at reduced resolution directly;
+    // gdk_pixbuf downscales the rest with an area filter. The last step to the
+    // final size is done by FilterResample, which gives sharper results.
+    glm::vec2 scale(float(destSize.x)/rect.width(), float(destSize.y)/rect.height());
+    glm::vec2 decodeScale(min(1.f, 2*scale.x), min(1.f, 2*scale.y));
+    IntPoint decodeSize(max(1, int(ceil(fileSize.x*decodeScale.x))),
+            max(1, int(ceil(fileSize.y*decodeScale.y))));
+    GError* pError = 0;
+    GdkPixbuf* pPixBuf;
+    {
+        ScopeTimer timer(GDKPixbufScaledProfilingZone);
+        pPixBuf = gdk_pixbuf_new_from_file_at_scale(sFName.c_str(), decodeSize.x,
+                decodeSize.y, FALSE, &pError);
+    }
+    if (!pPixBuf) {
+        string sErr = pError->message;
+        g_error_free(pError);
+        throw Exception(AVG_ERR_FILEIO, sErr);
+    }
+    decodeSize = IntPoint(gdk_pixbuf_get_width(pPixBuf), gdk_pixbuf_get_height(pPixBuf));
+    if (rect.size() != fileSize) {
+        decodeScale = glm::vec2(float(decodeSize.x)/fileSize.x,
+                float(decodeSize.y)/fileSize.y);
+        IntPoint tl(int(rect.tl.x*decodeScale.x), int(rect.tl.y*decodeScale.y));
+        IntPoint br(min(int(ceil(rect.br.x*decodeScale.x)), decodeSize.x),
+                min(int(ceil(rect.br.y*decodeScale.y)), decodeSize.y));
+        GdkPixbuf* pSubPixBuf = gdk_pixbuf_new_subpixbuf(pPixBuf, tl.x, tl.y, 
+                br.x-tl.x, br.y-tl.y);
+        g_object_unref(pPixBuf);
+        pPixBuf = pSubPixBuf;
+    }
+    BitmapPtr pBmp = pixBufToBitmap(pPixBuf, sFName, pf, destSize);
+    g_object_unref(pPixBuf);
+    return pBmp;
+}
+
+BitmapPtr BitmapLoader::pixBufToBitmap(GdkPixbuf* pPixBuf, const UTF8String& sFName,
+        PixelFormat pf, const IntPoint& destSize) const
+{
     IntPoint size = IntPoint(gdk_pixbuf_get_width(pPixBuf), 
             gdk_pixbuf_get_height(pPixBuf));
     
@@ -128,13 +211,17 @@ BitmapPtr BitmapLoader::load(const UTF8String& sFName, PixelFormat pf) const
             }
         }
     }
+    int stride = gdk_pixbuf_get_rowstride(pPixBuf);
+    guchar* pSrc = gdk_pixbuf_get_pixels(pPixBuf);
+    BitmapPtr pSrcBmp(new Bitmap(size, srcPF, pSrc, stride, false));
+    if (destSize != IntPoint(0,0) && destSize != size) {
+        ScopeTimer timer(ResampleProfilingZone);
+        pSrcBmp = FilterResample(destSize).apply(pSrcBmp);
+        size = destSize;
+    }
     BitmapPtr pBmp(new Bitmap(size, pf, sFName));
     {
         ScopeTimer timer(ConvertProfilingZone);
-
-        int stride = gdk_pixbuf_get_rowstride(pPixBuf);
-        guchar* pSrc = gdk_pixbuf_get_pixels(pPixBuf);
-        BitmapPtr pSrcBmp(new Bitmap(size, srcPF, pSrc, stride, false));
         {
             ScopeTimer timer(RGBFlipProfilingZone);
             if (pixelFormatIsBlueFirst(pf) != pixelFormatIsBlueFirst(srcPF)) {
@@ -143,7 +230,6 @@ BitmapPtr BitmapLoader::load(const UTF8String& sFName, PixelFormat pf) const
         }
         pBmp->copyPixels(*pSrcBmp);
     }
-    g_object_unref(pPixBuf);
     return pBmp;
 }
 
@@ -152,5 +238,11 @@ BitmapPtr loadBitmap(const UTF8String& sFName, PixelFormat pf)
     return BitmapLoader::get()->load(sFName, pf);
 }
 
+BitmapPtr loadBitmap(const UTF8String& sFName, const IntPoint& size,
+        const IntRect& srcRect, PixelFormat pf)
+{
+    return BitmapLoader::get()->load(sFName, size, srcRect, pf);
+}
+
 }
 
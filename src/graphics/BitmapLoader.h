@@ -28,8 +28,12 @@
 #include "Bitmap.h"
 #include "PixelFormat.h"
 
+#include "../base/Rect.h"
+
 #include <string>
 
+typedef struct _GdkPixbuf GdkPixbuf;
+
 namespace avg {
 
 class AVG_API BitmapLoader {
@@ -39,16 +43,29 @@ public:
     bool isBlueFirst() const;
     PixelFormat getDefaultPixelFormat(bool bAlpha);
     BitmapPtr load(const UTF8String& sFName, PixelFormat pf=NO_PIXELFORMAT) const;
+    // Loads srcRect (the whole image if srcRect is empty) scaled to size. If one
+    // component of size is 0, it is calculated from the aspect ratio of srcRect. The
+    // codec is asked to decode at reduced resolution directly where possible; the
+    // rest of the scaling is done using FilterResample.
+    BitmapPtr load(const UTF8String& sFName, const IntPoint& size,
+            const IntRect& srcRect=IntRect(0,0,0,0), PixelFormat pf=NO_PIXELFORMAT)
+            const;
 
 private:
     BitmapLoader(bool bBlueFirst);
     virtual ~BitmapLoader();
 
+    // Scales the pixbuf to destSize if destSize isn't (0,0).
+    BitmapPtr pixBufToBitmap(GdkPixbuf* pPixBuf, const UTF8String& sFName,
+            PixelFormat pf, const IntPoint& destSize=IntPoint(0,0)) const;
+
     bool m_bBlueFirst;
     static BitmapLoader * s_pBitmapLoader;
 };
 
 BitmapPtr AVG_API loadBitmap(const UTF8String& sFName, PixelFormat pf=NO_PIXELFORMAT);
+BitmapPtr AVG_API loadBitmap(const UTF8String& sFName, const IntPoint& size,
+        const IntRect& srcRect=IntRect(0,0,0,0), PixelFormat pf=NO_PIXELFORMAT);
 
 }
 
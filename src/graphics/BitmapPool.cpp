@@ -0,0 +1,121 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "BitmapPool.h"
+
+#include "Bitmap.h"
+
+#include "../base/ObjectCounter.h"
+#include "../base/ThreadHelper.h"
+
+#include <boost/weak_ptr.hpp>
+
+using namespace std;
+
+namespace avg {
+
+class BitmapPool::PooledBmpDeleter
+{
+public:
+    PooledBmpDeleter(const boost::weak_ptr<BitmapPool>& pPool)
+        : m_pPool(pPool)
+    {
+    }
+
+    void operator()(Bitmap* pBmp)
+    {
+        BitmapPoolPtr pPool = m_pPool.lock();
+        if (pPool) {
+            pPool->returnBmp(pBmp);
+        } else {
+            delete pBmp;
+        }
+    }
+
+private:
+    boost::weak_ptr<BitmapPool> m_pPool;
+};
+
+
+BitmapPool::BitmapPool(unsigned maxFreeBmps, const string& sBmpName)
+    : m_MaxFreeBmps(maxFreeBmps),
+      m_sBmpName(sBmpName),
+      m_NumBmpsAllocated(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+BitmapPool::~BitmapPool()
+{
+    for (unsigned i = 0; i < m_pFreeBmps.size(); ++i) {
+        delete m_pFreeBmps[i];
+    }
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+BitmapPtr BitmapPool::getBmp(const IntPoint& size, PixelFormat pf)
+{
+    Bitmap* pBmp = 0;
+    {
+        lock_guard lock(m_Mutex);
+        for (unsigned i = 0; i < m_pFreeBmps.size() && !pBmp; ++i) {
+            if (m_pFreeBmps[i]->getSize() == size &&
+                    m_pFreeBmps[i]->getPixelFormat() == pf)
+            {
+                pBmp = m_pFreeBmps[i];
+                m_pFreeBmps.erase(m_pFreeBmps.begin()+i);
+            }
+        }
+        if (!pBmp) {
+            m_NumBmpsAllocated++;
+        }
+    }
+    if (!pBmp) {
+        pBmp = new Bitmap(size, pf, m_sBmpName);
+    }
+    return BitmapPtr(pBmp, PooledBmpDeleter(shared_from_this()));
+}
+
+long long BitmapPool::getNumBmpsAllocated() const
+{
+    lock_guard lock(m_Mutex);
+    return m_NumBmpsAllocated;
+}
+
+int BitmapPool::getNumFreeBmps() const
+{
+    lock_guard lock(m_Mutex);
+    return int(m_pFreeBmps.size());
+}
+
+void BitmapPool::returnBmp(Bitmap* pBmp)
+{
+    {
+        lock_guard lock(m_Mutex);
+        if (m_pFreeBmps.size() < m_MaxFreeBmps) {
+            m_pFreeBmps.push_back(pBmp);
+            return;
+        }
+    }
+    delete pBmp;
+}
+
+}
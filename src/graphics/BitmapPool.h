@@ -0,0 +1,77 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _BitmapPool_H_
+#define _BitmapPool_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+
+#include "PixelFormat.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <string>
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// Recycles bitmaps that are produced once per frame (e.g. decoded video frames or
+// camera images). A bitmap handed out by the pool returns to it by itself when the
+// last reference is released. Can be used from several threads concurrently.
+class AVG_API BitmapPool: public boost::enable_shared_from_this<BitmapPool>
+{
+public:
+    // Returned bitmaps beyond maxFreeBmps are deleted, so the pool stays small after
+    // the frame size or the number of frames in flight changes.
+    BitmapPool(unsigned maxFreeBmps, const std::string& sBmpName);
+    virtual ~BitmapPool();
+
+    // Returns a recycled bitmap if one of the right size and format is available.
+    BitmapPtr getBmp(const IntPoint& size, PixelFormat pf);
+
+    long long getNumBmpsAllocated() const;
+    int getNumFreeBmps() const;
+
+private:
+    class PooledBmpDeleter;
+
+    void returnBmp(Bitmap* pBmp);
+
+    unsigned m_MaxFreeBmps;
+    std::string m_sBmpName;
+
+    mutable boost::mutex m_Mutex;
+    std::vector<Bitmap*> m_pFreeBmps;
+    long long m_NumBmpsAllocated;
+};
+
+typedef boost::shared_ptr<BitmapPool> BitmapPoolPtr;
+
+}
+
+#endif
@@ -42,7 +42,6 @@ namespace avg {
 BmpTextureMover::BmpTextureMover(const IntPoint& size, PixelFormat pf)
     : TextureMover(size, pf)
 {
-    m_pBmp = BitmapPtr(new Bitmap(size, pf));
 }
 
 BmpTextureMover::~BmpTextureMover()
@@ -50,17 +49,53 @@ BmpTextureMover::~BmpTextureMover()
 }
 
 void BmpTextureMover::moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex)
+{
+    moveBmpRectToTexture(pBmp, tex, IntRect(IntPoint(0,0), pBmp->getSize()));
+}
+
+void BmpTextureMover::moveBmpRectToTexture(BitmapPtr pBmp, GLTexture& tex,
+        const IntRect& rect)
 {
     AVG_ASSERT(pBmp->getSize() == tex.getSize());
     AVG_ASSERT(getSize() == pBmp->getSize());
     AVG_ASSERT(pBmp->getPixelFormat() == getPF());
+    AVG_ASSERT(rect.tl.x >= 0 && rect.tl.y >= 0 && rect.br.x <= getSize().x &&
+            rect.br.y <= getSize().y && rect.width() > 0 && rect.height() > 0);
     tex.activate(WrapMode());
-    unsigned char * pStartPos = pBmp->getPixels();
     IntPoint size = tex.getSize();
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y,
-            tex.getGLFormat(getPF()), tex.getGLType(getPF()), 
-            pStartPos);
-    tex.generateMipmaps();
+    int bpp = pBmp->getBytesPerPixel();
+    const unsigned char* pPixels = pBmp->getPixels() + rect.tl.y*pBmp->getStride() +
+            rect.tl.x*bpp;
+    // Bitmaps that reference foreign memory (e.g. decoded video planes) and parts of
+    // bitmaps can have longer lines than GL_UNPACK_ALIGNMENT implies.
+    BitmapPtr pSrcBmp;
+    bool bSetRowLength = false;
+    int stride = pBmp->getStride();
+    if (stride != Bitmap::getPreferredStride(rect.width(), getPF())) {
+#ifndef AVG_ENABLE_EGL
+        if (!GLContext::getCurrent()->isGLES() && stride%bpp == 0) {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, stride/bpp);
+            bSetRowLength = true;
+        }
+#endif
+        if (!bSetRowLength) {
+            // GLES 2 has no GL_UNPACK_ROW_LENGTH.
+            Bitmap rectBmp(*pBmp, rect);
+            pSrcBmp = BitmapPtr(new Bitmap(rect.size(), getPF()));
+            pSrcBmp->copyPixels(rectBmp);
+            pPixels = pSrcBmp->getPixels();
+        }
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.tl.x, rect.tl.y, rect.width(), rect.height(),
+            tex.getGLFormat(getPF()), tex.getGLType(getPF()), pPixels);
+#ifndef AVG_ENABLE_EGL
+    if (bSetRowLength) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+#endif
+    if (rect.br.y == size.y) {
+        tex.generateMipmaps();
+    }
     GLContext::checkError("BmpTextureMover::moveBmpToTexture: glTexSubImage2D()");
 }
 
@@ -25,6 +25,8 @@
 #include "../api.h"
 #include "TextureMover.h"
 
+#include "../base/Rect.h"
+
 #include <boost/shared_ptr.hpp>
 
 namespace avg {
@@ -35,10 +37,10 @@ public:
     virtual ~BmpTextureMover();
 
     virtual void moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex);
+    // Uploads the part of the bitmap in rect to the same position in the texture.
+    // Mipmaps are generated when the rect includes the last line.
+    void moveBmpRectToTexture(BitmapPtr pBmp, GLTexture& tex, const IntRect& rect);
     virtual BitmapPtr moveTextureToBmp(GLTexture& tex, int mipmapLevel=0);
-
-private:
-    BitmapPtr m_pBmp;
 };
 
 typedef boost::shared_ptr<BmpTextureMover> BmpTextureMoverPtr;
@@ -31,14 +31,20 @@
 #include "GLContextManager.h"
 #include "MCTexture.h"
 #include "ImageCache.h"
+#include "TextureAtlas.h"
 #include "Filterfliprgb.h"
 
+#include <sstream>
+
 using namespace std;
 
 namespace avg {
 
-CachedImage::CachedImage(const std::string& sFilename, TexCompression compression)
-    : m_bUseMipmaps(false),
+CachedImage::CachedImage(const std::string& sFilename, TexCompression compression,
+        const IntPoint& decodeSize, const IntRect& srcRect)
+    : m_DecodeSize(decodeSize),
+      m_SrcRect(srcRect),
+      m_bUseMipmaps(false),
       m_Compression(compression),
       m_BmpRefCount(0),
       m_TexRefCount(0)
@@ -46,9 +52,24 @@ CachedImage::CachedImage(const std::string& sFilename, TexCompression compressio
     ObjectCounter::get()->incRef(&typeid(*this));
     m_sFilename = sFilename;
     AVG_TRACE(Logger::category::MEMORY, Logger::severity::INFO, "Loading " << sFilename);
-    BitmapPtr pBmp = loadBitmap(m_sFilename);
-    m_pBmp = applyCompression(pBmp);
-    incBmpRef(m_Compression);
+    m_pBmp = loadBmp();
+    incBmpRef();
+}
+
+CachedImage::CachedImage(const std::string& sFilename, TexCompression compression,
+        const IntPoint& decodeSize, const IntRect& srcRect, BitmapPtr pBmp)
+    : m_sFilename(sFilename),
+      m_DecodeSize(decodeSize),
+      m_SrcRect(srcRect),
+      m_pBmp(pBmp),
+      m_bUseMipmaps(false),
+      m_Compression(compression),
+      m_BmpRefCount(0),
+      m_TexRefCount(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    AVG_ASSERT(m_pBmp);
+    incBmpRef();
 }
 
 CachedImage::~CachedImage()
@@ -58,23 +79,32 @@ CachedImage::~CachedImage()
     AVG_ASSERT(m_TexRefCount == 0);
 }
 
+std::string CachedImage::getKey(const std::string& sFilename,
+        TexCompression compression, const IntPoint& decodeSize, const IntRect& srcRect)
+{
+    if (compression == TEXCOMPRESSION_NONE && isNativeSize(decodeSize, srcRect)) {
+        return sFilename;
+    } else {
+        stringstream ss;
+        ss << sFilename << "|" << texCompression2String(compression) << "|"
+                << decodeSize << "|" << srcRect;
+        return ss.str();
+    }
+}
+
+std::string CachedImage::getKey() const
+{
+    return getKey(m_sFilename, m_Compression, m_DecodeSize, m_SrcRect);
+}
+
 std::string CachedImage::getFilename() const
 {
     return m_sFilename;
 }
 
-void CachedImage::incBmpRef(TexCompression compression)
+void CachedImage::incBmpRef()
 {
     m_BmpRefCount++;
-    if (compression == TEXCOMPRESSION_NONE && m_Compression == TEXCOMPRESSION_B5G6R5)
-    {
-        // Reload from disk, making sure the cache knows about the size change
-        int oldSize = m_pBmp->getMemNeeded();
-        m_Compression = compression;
-        BitmapPtr pBmp = loadBitmap(m_sFilename);
-        m_pBmp = applyCompression(pBmp);
-        ImageCache::get()->onSizeChange(pBmp->getMemNeeded()-oldSize, STORAGE_CPU);
-    }
 }
 
 void CachedImage::decBmpRef()
@@ -83,26 +113,31 @@ void CachedImage::decBmpRef()
     m_BmpRefCount--;
     AVG_ASSERT(m_TexRefCount <= m_BmpRefCount);
     if (m_BmpRefCount == 0 && m_TexRefCount == 0) {
-        ImageCache::get()->onImageUnused(m_sFilename, STORAGE_CPU);
+        ImageCache::get()->onImageUnused(getKey(), STORAGE_CPU);
     }
 }
 
-void CachedImage::incTexRef(bool bUseMipmaps)
+void CachedImage::incTexRef(bool bUseMipmaps, TexUploadPriority priority)
 {
     m_TexRefCount++;
     AVG_ASSERT(m_TexRefCount <= m_BmpRefCount);
     if (m_TexRefCount == 1) {
         m_bUseMipmaps = bUseMipmaps;
         if (!m_pTex) {
-            createTexture();
-            ImageCache::get()->onTexLoad(m_sFilename);
+            createTexture(priority);
+            ImageCache::get()->onTexLoad(getKey());
+            return;
         }
+        ImageCache::get()->onTexUse(getKey());
     } else if (bUseMipmaps && !m_bUseMipmaps) {
         m_bUseMipmaps = true;
-        int oldSize = m_pTex->getMemNeeded();
-        createTexture();
-        ImageCache::get()->onSizeChange(m_pTex->getMemNeeded()-oldSize, STORAGE_GPU);
+        int oldSize = getMemUsed(STORAGE_GPU);
+        createTexture(priority);
+        ImageCache::get()->onSizeChange(getMemUsed(STORAGE_GPU)-oldSize, STORAGE_GPU);
+        return;
     }
+    // The texture might still be waiting for a deferred upload.
+    GLContextManager::get()->raiseTexUploadPriority(m_pTex, priority);
 }
 
 void CachedImage::decTexRef()
@@ -110,7 +145,7 @@ void CachedImage::decTexRef()
     AVG_ASSERT(m_TexRefCount >= 1);
     m_TexRefCount--;
     if (m_TexRefCount == 0) {
-        ImageCache::get()->onImageUnused(m_sFilename, STORAGE_GPU);
+        ImageCache::get()->onImageUnused(getKey(), STORAGE_GPU);
     }
 }
 
@@ -119,6 +154,7 @@ void CachedImage::unloadTex()
     AVG_ASSERT(m_TexRefCount == 0);
     AVG_ASSERT(m_pTex);
     m_pTex = MCTexturePtr();
+    m_pAtlasRegion = TextureAtlasRegionPtr();
 }
 
 BitmapPtr CachedImage::getBmp()
@@ -133,6 +169,12 @@ MCTexturePtr CachedImage::getTex()
     return m_pTex;
 }
 
+TextureAtlasRegionPtr CachedImage::getAtlasRegion()
+{
+    AVG_ASSERT(m_TexRefCount >= 1);
+    return m_pAtlasRegion;
+}
+
 bool CachedImage::hasTex() const
 {
     return m_pTex != MCTexturePtr();
@@ -144,7 +186,10 @@ int CachedImage::getMemUsed(StorageType st) const
         case CachedImage::STORAGE_CPU:
             return m_pBmp->getMemNeeded();
         case CachedImage::STORAGE_GPU:
-            if (m_pTex) {
+            if (m_pAtlasRegion) {
+                IntPoint size = m_pAtlasRegion->getRect().size();
+                return size.x*size.y*m_pBmp->getBytesPerPixel();
+            } else if (m_pTex) {
                 return m_pTex->getMemNeeded();
             } else {
                 return 0;
@@ -171,15 +216,51 @@ int CachedImage::getRefCount(StorageType st) const
 
 void CachedImage::dump() const
 {
-    cerr << "  " << m_sFilename << ": " << m_BmpRefCount << ", " << m_TexRefCount
+    cerr << "  " << getKey() << ": " << m_BmpRefCount << ", " << m_TexRefCount
             << ", " << hasTex() << endl;
 }
 
-BitmapPtr CachedImage::applyCompression(BitmapPtr pBmp)
+BitmapPtr CachedImage::decodeBmp(const std::string& sFilename,
+        TexCompression compression, const IntPoint& decodeSize, const IntRect& srcRect,
+        ImageDiskCachePtr pDiskCache)
+{
+    string sKey = getKey(sFilename, compression, decodeSize, srcRect);
+    if (pDiskCache) {
+        BitmapPtr pBmp = pDiskCache->load(sFilename, sKey, compression);
+        if (pBmp) {
+            return pBmp;
+        }
+    }
+    BitmapPtr pBmp;
+    if (isNativeSize(decodeSize, srcRect)) {
+        pBmp = loadBitmap(sFilename);
+    } else {
+        pBmp = loadBitmap(sFilename, decodeSize, srcRect);
+    }
+    pBmp = applyCompression(pBmp, compression, sFilename);
+    if (pDiskCache) {
+        pDiskCache->save(sFilename, sKey, compression, pBmp);
+    }
+    return pBmp;
+}
+
+bool CachedImage::isNativeSize(const IntPoint& decodeSize, const IntRect& srcRect)
+{
+    return decodeSize == IntPoint(0,0) && srcRect.size() == IntPoint(0,0);
+}
+
+BitmapPtr CachedImage::loadBmp()
+{
+    return decodeBmp(m_sFilename, m_Compression, m_DecodeSize, m_SrcRect,
+            ImageCache::get()->getDiskCache());
+}
+
+BitmapPtr CachedImage::applyCompression(BitmapPtr pBmp, TexCompression compression,
+        const std::string& sFilename)
 {
     // Duplicated code with GPUImage::setBitmap()
-    if (m_Compression == TEXCOMPRESSION_B5G6R5) {
-        BitmapPtr pDestBmp = BitmapPtr(new Bitmap(pBmp->getSize(), B5G6R5, m_sFilename));
+    if (compression == TEXCOMPRESSION_B5G6R5) {
+        BitmapPtr pDestBmp = BitmapPtr(new Bitmap(pBmp->getSize(), B5G6R5, sFilename));
         if (!BitmapLoader::get()->isBlueFirst()) {
             FilterFlipRGB().applyInPlace(pBmp);
         }
@@ -190,9 +271,17 @@ BitmapPtr CachedImage::applyCompression(BitmapPtr pBmp)
     }
 }
 
-void CachedImage::createTexture()
+void CachedImage::createTexture(TexUploadPriority priority)
 {
-    m_pTex = GLContextManager::get()->createTextureFromBmp(m_pBmp, m_bUseMipmaps);
+    TextureAtlas* pAtlas = TextureAtlas::get();
+    if (!m_bUseMipmaps && pAtlas->canAdd(m_pBmp->getSize(), m_pBmp->getPixelFormat())) {
+        m_pAtlasRegion = pAtlas->add(m_pBmp, priority);
+        m_pTex = m_pAtlasRegion->getTex();
+    } else {
+        m_pAtlasRegion = TextureAtlasRegionPtr();
+        m_pTex = GLContextManager::get()->createTextureFromBmp(m_pBmp, m_bUseMipmaps,
+                false, 0, priority);
+    }
 }
 
 }
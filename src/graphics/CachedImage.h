@@ -25,6 +25,10 @@
 #include "../api.h"
 
 #include "TexInfo.h"
+#include "ImageDiskCache.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 
 #include <boost/shared_ptr.hpp>
 #include <string>
@@ -35,6 +39,8 @@ class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 class MCTexture;
 typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+class TextureAtlasRegion;
+typedef boost::shared_ptr<TextureAtlasRegion> TextureAtlasRegionPtr;
 
 class AVG_API CachedImage
 {
@@ -44,19 +50,42 @@ class AVG_API CachedImage
             STORAGE_GPU
         };
 
-        CachedImage(const std::string& sFilename, TexCompression compression);
+        // A decodeSize of (0,0) and an empty srcRect load the file at native
+        // resolution. Otherwise, see BitmapLoader::load().
+        CachedImage(const std::string& sFilename, TexCompression compression,
+                const IntPoint& decodeSize=IntPoint(0,0),
+                const IntRect& srcRect=IntRect(0,0,0,0));
+        // Uses a bitmap that has already been loaded using decodeBmp().
+        CachedImage(const std::string& sFilename, TexCompression compression,
+                const IntPoint& decodeSize, const IntRect& srcRect, BitmapPtr pBmp);
         virtual ~CachedImage();
 
+        // Loads and compresses the bitmap as the constructor does. Doesn't touch the
+        // ImageCache, so it can be called from other threads.
+        static BitmapPtr decodeBmp(const std::string& sFilename,
+                TexCompression compression, const IntPoint& decodeSize,
+                const IntRect& srcRect, ImageDiskCachePtr pDiskCache);
+
+        // Identifies the image variant in the cache.
+        static std::string getKey(const std::string& sFilename,
+                TexCompression compression, const IntPoint& decodeSize,
+                const IntRect& srcRect);
+        std::string getKey() const;
         std::string getFilename() const;
 
-        void incBmpRef(TexCompression compression);
+        void incBmpRef();
         void decBmpRef();
-        void incTexRef(bool bUseMipmaps);
+        // Texture uploads with a priority other than UPLOADPRIORITY_IMMEDIATE can
+        // be deferred by the GLContextManager.
+        void incTexRef(bool bUseMipmaps,
+                TexUploadPriority priority=UPLOADPRIORITY_IMMEDIATE);
         void decTexRef();
         void unloadTex();
 
         BitmapPtr getBmp();
         MCTexturePtr getTex();
+        // Non-empty if the texture is part of a TextureAtlas page.
+        TextureAtlasRegionPtr getAtlasRegion();
         bool hasTex() const;
         int getMemUsed(StorageType st) const;
         int getRefCount(StorageType st) const;
@@ -64,13 +93,19 @@ class AVG_API CachedImage
         void dump() const;
 
     private:
-        BitmapPtr applyCompression(BitmapPtr pBmp);
-        void createTexture();
+        static bool isNativeSize(const IntPoint& decodeSize, const IntRect& srcRect);
+        BitmapPtr loadBmp();
+        static BitmapPtr applyCompression(BitmapPtr pBmp, TexCompression compression,
+                const std::string& sFilename);
+        void createTexture(TexUploadPriority priority);
         void testDelete();
 
         std::string m_sFilename;
+        IntPoint m_DecodeSize;
+        IntRect m_SrcRect;
         BitmapPtr m_pBmp;
         MCTexturePtr m_pTex;
+        TextureAtlasRegionPtr m_pAtlasRegion;
 
         bool m_bUseMipmaps;
         TexCompression m_Compression;
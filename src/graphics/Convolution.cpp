@@ -0,0 +1,253 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "Convolution.h"
+
+#include "Bitmap.h"
+#include "Pixeldefs.h"
+
+#include "../base/Exception.h"
+
+#if defined(__SSE2__) || defined(_WIN32)
+#include <emmintrin.h>
+#endif
+
+#include <cstring>
+
+using namespace std;
+
+namespace avg {
+
+// Convolutions do more work per pixel than format conversions, so smaller bitmaps
+// are worth splitting.
+static const int MIN_PARALLEL_CONVOLUTION_PIXELS = 128*128;
+static const int MIN_LINES_PER_BAND = 16;
+
+void processLineBands(const IntPoint& size, const ThreadPool::RangeFunc& func)
+{
+    if (size.x*size.y < MIN_PARALLEL_CONVOLUTION_PIXELS) {
+        func(0, size.y);
+    } else {
+        ThreadPool::get()->parallelFor(size.y, func, MIN_LINES_PER_BAND);
+    }
+}
+
+#if defined(__SSE2__) || defined(_WIN32)
+static inline __m128i loadFourBytes(const unsigned char* pSrc)
+{
+    int bytes;
+    memcpy(&bytes, pSrc, 4);
+    return _mm_cvtsi32_si128(bytes);
+}
+
+static inline __m128 bytesToFloats(__m128i bytes)
+{
+    __m128i zero = _mm_setzero_si128();
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+
+// Truncates to int and keeps the lowest byte of each value, like a cast to
+// unsigned char does.
+static inline void storeFourBytes(__m128 values, unsigned char* pDest)
+{
+    __m128i ints = _mm_and_si128(_mm_cvttps_epi32(values), _mm_set1_epi32(0xFF));
+    ints = _mm_packs_epi32(ints, ints);
+    int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(ints, ints));
+    memcpy(pDest, &bytes, 4);
+}
+#endif
+
+static void convolveFixedPointLine(const unsigned char* pSrc, unsigned char* pDest,
+        int lineLen, int tapOffset, const int* pKernel, int kernelWidth, bool bSIMD)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    if (bSIMD) {
+        __m128i zero = _mm_setzero_si128();
+        __m128i mask = _mm_set1_epi32(0xFF);
+        for (; x < lineLen-15; x += 16) {
+            __m128i sum0 = zero;
+            __m128i sum1 = zero;
+            __m128i sum2 = zero;
+            __m128i sum3 = zero;
+            const unsigned char* pTap = pSrc+x;
+            for (int i = 0; i < kernelWidth; ++i) {
+                __m128i weight = _mm_set1_epi16(short(pKernel[i]));
+                __m128i src = _mm_loadu_si128((const __m128i*)pTap);
+                // Weights are at most 256, so the products fit into 16 unsigned bits.
+                __m128i prodLo = _mm_mullo_epi16(_mm_unpacklo_epi8(src, zero), weight);
+                __m128i prodHi = _mm_mullo_epi16(_mm_unpackhi_epi8(src, zero), weight);
+                sum0 = _mm_add_epi32(sum0, _mm_unpacklo_epi16(prodLo, zero));
+                sum1 = _mm_add_epi32(sum1, _mm_unpackhi_epi16(prodLo, zero));
+                sum2 = _mm_add_epi32(sum2, _mm_unpacklo_epi16(prodHi, zero));
+                sum3 = _mm_add_epi32(sum3, _mm_unpackhi_epi16(prodHi, zero));
+                pTap += tapOffset;
+            }
+            sum0 = _mm_and_si128(_mm_srli_epi32(sum0, 8), mask);
+            sum1 = _mm_and_si128(_mm_srli_epi32(sum1, 8), mask);
+            sum2 = _mm_and_si128(_mm_srli_epi32(sum2, 8), mask);
+            sum3 = _mm_and_si128(_mm_srli_epi32(sum3, 8), mask);
+            __m128i result = _mm_packus_epi16(_mm_packs_epi32(sum0, sum1),
+                    _mm_packs_epi32(sum2, sum3));
+            _mm_storeu_si128((__m128i*)(pDest+x), result);
+        }
+    }
+#endif
+    for (; x < lineLen; ++x) {
+        int sum = 0;
+        const unsigned char* pTap = pSrc+x;
+        for (int i = 0; i < kernelWidth; ++i) {
+            sum += *pTap*pKernel[i];
+            pTap += tapOffset;
+        }
+        pDest[x] = (unsigned char)(sum/256);
+    }
+}
+
+void convolveFixedPointLines(const Bitmap& srcBmp, Bitmap& destBmp,
+        const int* pKernel, int kernelWidth, bool bVertical, int startY, int endY)
+{
+    int bpp = srcBmp.getBytesPerPixel();
+    AVG_ASSERT(destBmp.getBytesPerPixel() == bpp);
+    bool bSIMD = true;
+    for (int i = 0; i < kernelWidth; ++i) {
+        if (pKernel[i] < 0 || pKernel[i] > 256) {
+            bSIMD = false;
+        }
+    }
+    int srcStride = srcBmp.getStride();
+    int destStride = destBmp.getStride();
+    int tapOffset = bVertical ? srcStride : bpp;
+    int lineLen = destBmp.getSize().x*bpp;
+    const unsigned char* pSrcLine = srcBmp.getPixels()+startY*srcStride;
+    unsigned char* pDestLine = destBmp.getPixels()+startY*destStride;
+    for (int y = startY; y < endY; ++y) {
+        convolveFixedPointLine(pSrcLine, pDestLine, lineLen, tapOffset, pKernel,
+                kernelWidth, bSIMD);
+        pSrcLine += srcStride;
+        pDestLine += destStride;
+    }
+}
+
+// Processes four pixels at a time.
+static void convolveFloatLineI8(const unsigned char* pSrc, unsigned char* pDest,
+        int width, int stride, const float* pMat, int matWidth, int matHeight,
+        float offset)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    __m128 offsetVec = _mm_set1_ps(offset);
+    for (; x < width-3; x += 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (int i = 0; i < matHeight; ++i) {
+            const unsigned char* pLine = pSrc+i*stride+x;
+            for (int j = 0; j < matWidth; ++j) {
+                __m128 src = bytesToFloats(loadFourBytes(pLine+j));
+                sum = _mm_add_ps(sum, _mm_mul_ps(src, _mm_set1_ps(pMat[matWidth*i+j])));
+            }
+        }
+        storeFourBytes(_mm_add_ps(sum, offsetVec), pDest+x);
+    }
+#endif
+    for (; x < width; ++x) {
+        float sum = 0;
+        for (int i = 0; i < matHeight; ++i) {
+            const unsigned char* pLine = pSrc+i*stride+x;
+            for (int j = 0; j < matWidth; ++j) {
+                sum += pLine[j]*pMat[matWidth*i+j];
+            }
+        }
+        pDest[x] = (unsigned char)(int)(sum+offset);
+    }
+}
+
+// Processes the channels of a 32-bit pixel at once.
+static void convolveFloatLineRGB(const unsigned char* pSrc, unsigned char* pDest,
+        int width, int stride, int bpp, const float* pMat, int matWidth, int matHeight,
+        float offset)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    if (bpp == 4) {
+        __m128 offsetVec = _mm_set1_ps(offset);
+        for (; x < width; ++x) {
+            __m128 sum = _mm_setzero_ps();
+            for (int i = 0; i < matHeight; ++i) {
+                const unsigned char* pLine = pSrc+i*stride+x*4;
+                for (int j = 0; j < matWidth; ++j) {
+                    __m128 src = bytesToFloats(loadFourBytes(pLine+j*4));
+                    sum = _mm_add_ps(sum,
+                            _mm_mul_ps(src, _mm_set1_ps(pMat[matWidth*i+j])));
+                }
+            }
+            storeFourBytes(_mm_add_ps(sum, offsetVec), pDest+x*4);
+            pDest[x*4+ALPHAPOS] = 255;
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        for (int c = 0; c < 3; ++c) {
+            float sum = 0;
+            for (int i = 0; i < matHeight; ++i) {
+                const unsigned char* pLine = pSrc+i*stride+x*bpp+c;
+                for (int j = 0; j < matWidth; ++j) {
+                    sum += pLine[j*bpp]*pMat[matWidth*i+j];
+                }
+            }
+            pDest[x*bpp+c] = (unsigned char)(int)(sum+offset);
+        }
+        if (bpp == 4) {
+            pDest[x*4+ALPHAPOS] = 255;
+        }
+    }
+}
+
+void convolveFloatLines(const Bitmap& srcBmp, Bitmap& destBmp, const float* pMat,
+        int matWidth, int matHeight, float offset, int startY, int endY)
+{
+    int bpp = srcBmp.getBytesPerPixel();
+    AVG_ASSERT(destBmp.getBytesPerPixel() == bpp);
+    int srcStride = srcBmp.getStride();
+    int destStride = destBmp.getStride();
+    int width = destBmp.getSize().x;
+    const unsigned char* pSrcLine = srcBmp.getPixels()+startY*srcStride;
+    unsigned char* pDestLine = destBmp.getPixels()+startY*destStride;
+    for (int y = startY; y < endY; ++y) {
+        switch (bpp) {
+            case 1:
+                convolveFloatLineI8(pSrcLine, pDestLine, width, srcStride, pMat,
+                        matWidth, matHeight, offset);
+                break;
+            case 3:
+            case 4:
+                convolveFloatLineRGB(pSrcLine, pDestLine, width, srcStride, bpp, pMat,
+                        matWidth, matHeight, offset);
+                break;
+            default:
+                AVG_ASSERT(false);
+        }
+        pSrcLine += srcStride;
+        pDestLine += destStride;
+    }
+}
+
+}
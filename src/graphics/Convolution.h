@@ -0,0 +1,61 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _Convolution_H_
+#define _Convolution_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/ThreadPool.h"
+
+namespace avg {
+
+class Bitmap;
+
+// Building blocks for the convolution filters. The functions work on a range of
+// destination lines so filters can hand them to the ThreadPool using
+// processLineBands(). Bitmaps with one and four bytes per pixel are processed using
+// SSE2 where available; the results are identical to the plain C versions.
+
+// Calls func(startY, endY) for bands of lines. Small bitmaps are processed inline.
+void AVG_API processLineBands(const IntPoint& size, const ThreadPool::RangeFunc& func);
+
+// Convolves with an integer kernel along one axis: Every byte of the destination
+// bitmap is set to sum(src*kernel)/256, so the kernel weights should sum up to
+// about 256. Every byte is treated as a separate channel, so this works for all
+// pixel formats without padding. The destination is kernelWidth-1 pixels smaller
+// than the source along the axis, and line y of the destination corresponds to
+// line y of the source.
+void AVG_API convolveFixedPointLines(const Bitmap& srcBmp, Bitmap& destBmp,
+        const int* pKernel, int kernelWidth, bool bVertical, int startY, int endY);
+
+// Applies a matWidth x matHeight float matrix to the color channels of each
+// pixel. The result is cast to unsigned char after adding offset; alpha is set to
+// 255. Line y of the destination corresponds to source lines y to y+matHeight-1.
+void AVG_API convolveFloatLines(const Bitmap& srcBmp, Bitmap& destBmp,
+        const float* pMat, int matWidth, int matHeight, float offset, int startY,
+        int endY);
+
+}
+
+#endif
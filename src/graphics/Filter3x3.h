@@ -25,15 +25,10 @@
 #include "../api.h"
 #include "Filter.h"
 
-#include "Pixel8.h"
-#include "Pixel24.h"
-#include "Pixel32.h"
-
-#include <iostream>
-
 namespace avg {
 
-// Filter that applies a 3x3 kernel to the bitmap.
+// Applies a 3x3 matrix to the color channels of an I8, 24- or 32-bit bitmap. The
+// result is two pixels smaller than the source in both dimensions.
 class AVG_API Filter3x3 : public Filter
 {
 public:
@@ -42,40 +37,9 @@ public:
     virtual BitmapPtr apply(BitmapPtr pBmpSource);
 
 private:
-    template<class PIXEL>
-    void convolveLine(const unsigned char * pSrc, unsigned char * pDest,
-            int lineLen, int stride) const;
     float m_Mat[3][3];
 };
 
-template<class PIXEL>
-void Filter3x3::convolveLine(const unsigned char * pSrc, unsigned char * pDest,
-        int lineLen, int stride) const
-{
-    PIXEL * pSrcPixel = (PIXEL *)pSrc;
-    PIXEL * pDestPixel = (PIXEL *)pDest;
-    for (int x = 0; x < lineLen; ++x) {
-        float newR = 0;
-        float newG = 0;
-        float newB = 0;
-
-        for (int i = 0; i < 3; i++) {
-            unsigned char * pLineStart = (unsigned char *)pSrcPixel+i*stride;
-            for (int j = 0; j < 3; j++) {
-                PIXEL SrcPixel = *((PIXEL *)pLineStart+j);
-                newR += SrcPixel.getR()*m_Mat[i][j];
-                newG += SrcPixel.getG()*m_Mat[i][j];
-                newB += SrcPixel.getB()*m_Mat[i][j];
-            }
-        }
-        *pDestPixel = PIXEL((unsigned char)newR, (unsigned char)newG,
-                (unsigned char)newB);
-
-        pSrcPixel++;
-        pDestPixel++;
-    }
-}
-
 }
 
 #endif
@@ -20,10 +20,15 @@
 //
 
 #include "FilterBandpass.h"
-#include "Filterfill.h"
-#include "Pixel8.h"
+#include "Convolution.h"
 #include "Bitmap.h"
 
+#include <boost/bind.hpp>
+
+#if defined(__SSE2__) || defined(_WIN32)
+#include <emmintrin.h>
+#endif
+
 #include <iostream>
 #include <math.h>
 
@@ -31,6 +36,46 @@ using namespace std;
 
 namespace avg {
     
+// Computes lowpass-highpass+128, modulo 256.
+static void subtractLines(const Bitmap& lpBmp, const Bitmap& hpBmp, Bitmap& destBmp,
+        int widthDiff, int startY, int endY)
+{
+    int lpStride = lpBmp.getStride();
+    int hpStride = hpBmp.getStride();
+    int destStride = destBmp.getStride();
+    int width = destBmp.getSize().x;
+    const unsigned char * pLPLine = lpBmp.getPixels()+(startY+widthDiff)*lpStride;
+    const unsigned char * pHPLine = hpBmp.getPixels()+startY*hpStride;
+    unsigned char * pDestLine = destBmp.getPixels()+startY*destStride;
+    for (int y = startY; y < endY; ++y) {
+        const unsigned char * pLPPixel = pLPLine+widthDiff;
+        const unsigned char * pHPPixel = pHPLine;
+        unsigned char * pDestPixel = pDestLine;
+        int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+        __m128i offset = _mm_set1_epi8(char(128));
+        for (; x < width-15; x += 16) {
+            __m128i lp = _mm_loadu_si128((const __m128i*)pLPPixel);
+            __m128i hp = _mm_loadu_si128((const __m128i*)pHPPixel);
+            _mm_storeu_si128((__m128i*)pDestPixel,
+                    _mm_add_epi8(_mm_sub_epi8(lp, hp), offset));
+            pLPPixel += 16;
+            pHPPixel += 16;
+            pDestPixel += 16;
+        }
+#endif
+        for (; x < width; ++x) {
+            *pDestPixel = (int(*pLPPixel)-*pHPPixel)+128;
+            ++pLPPixel;
+            ++pHPPixel;
+            ++pDestPixel;
+        }
+        pLPLine += lpStride;
+        pHPLine += hpStride;
+        pDestLine += destStride;
+    }
+}
+
 FilterBandpass::FilterBandpass(float lowWidth, float highWidth)
     : m_HighpassFilter(highWidth),
       m_LowpassFilter(lowWidth)
@@ -49,27 +94,8 @@ BitmapPtr FilterBandpass::apply(BitmapPtr pBmpSrc)
 
     IntPoint Size = pHPBmp->getSize();
     BitmapPtr pDestBmp = BitmapPtr(new Bitmap(Size, I8, pBmpSrc->getName()));
-
-    int lpStride = pLPBmp->getStride();
-    int hpStride = pHPBmp->getStride();
-    int destStride = pDestBmp->getStride();
-    unsigned char * pLPLine = pLPBmp->getPixels()+m_FilterWidthDiff*lpStride;
-    unsigned char * pHPLine = pHPBmp->getPixels();
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < Size.y; ++y) {
-        unsigned char * pLPPixel = pLPLine+m_FilterWidthDiff;
-        unsigned char * pHPPixel = pHPLine;
-        unsigned char * pDestPixel = pDestLine;
-        for (int x = 0; x < Size.x; ++x) {
-            *pDestPixel = (int(*pLPPixel)-*pHPPixel)+128;
-            ++pLPPixel;
-            ++pHPPixel;
-            ++pDestPixel;
-        }
-        pLPLine += lpStride;
-        pHPLine += hpStride;
-        pDestLine += destStride;
-    }
+    processLineBands(Size, boost::bind(&subtractLines, boost::cref(*pLPBmp),
+            boost::cref(*pHPBmp), boost::ref(*pDestBmp), m_FilterWidthDiff, _1, _2));
     return pDestBmp;
 }
 
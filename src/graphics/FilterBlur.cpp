@@ -20,12 +20,17 @@
 //
 
 #include "FilterBlur.h"
-#include "Filterfill.h"
-#include "Pixel8.h"
+#include "Convolution.h"
 #include "Bitmap.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
+#if defined(__SSE2__) || defined(_WIN32)
+#include <emmintrin.h>
+#endif
+
 #include <iostream>
 #include <math.h>
 
@@ -33,6 +38,56 @@ using namespace std;
 
 namespace avg {
     
+static void blurLines(const Bitmap& srcBmp, Bitmap& destBmp, int startY, int endY)
+{
+    int srcStride = srcBmp.getStride();
+    int destStride = destBmp.getStride();
+    int width = destBmp.getSize().x;
+    const unsigned char * pSrcLine = srcBmp.getPixels()+(startY+1)*srcStride+1;
+    unsigned char * pDestLine = destBmp.getPixels()+startY*destStride;
+    for (int y = startY; y < endY; ++y) {
+        const unsigned char * pSrcPixel = pSrcLine;
+        unsigned char * pDestPixel = pDestLine;
+        int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+        __m128i zero = _mm_setzero_si128();
+        __m128i round = _mm_set1_epi16(4);
+        for (; x < width-15; x += 16) {
+            __m128i center = _mm_loadu_si128((const __m128i*)pSrcPixel);
+            __m128i left = _mm_loadu_si128((const __m128i*)(pSrcPixel-1));
+            __m128i right = _mm_loadu_si128((const __m128i*)(pSrcPixel+1));
+            __m128i top = _mm_loadu_si128((const __m128i*)(pSrcPixel-srcStride));
+            __m128i bottom = _mm_loadu_si128((const __m128i*)(pSrcPixel+srcStride));
+            __m128i sumLo = _mm_add_epi16(_mm_slli_epi16(
+                    _mm_unpacklo_epi8(center, zero), 2), round);
+            __m128i sumHi = _mm_add_epi16(_mm_slli_epi16(
+                    _mm_unpackhi_epi8(center, zero), 2), round);
+            sumLo = _mm_add_epi16(sumLo, _mm_unpacklo_epi8(left, zero));
+            sumHi = _mm_add_epi16(sumHi, _mm_unpackhi_epi8(left, zero));
+            sumLo = _mm_add_epi16(sumLo, _mm_unpacklo_epi8(right, zero));
+            sumHi = _mm_add_epi16(sumHi, _mm_unpackhi_epi8(right, zero));
+            sumLo = _mm_add_epi16(sumLo, _mm_unpacklo_epi8(top, zero));
+            sumHi = _mm_add_epi16(sumHi, _mm_unpackhi_epi8(top, zero));
+            sumLo = _mm_add_epi16(sumLo, _mm_unpacklo_epi8(bottom, zero));
+            sumHi = _mm_add_epi16(sumHi, _mm_unpackhi_epi8(bottom, zero));
+            __m128i result = _mm_packus_epi16(_mm_srli_epi16(sumLo, 3),
+                    _mm_srli_epi16(sumHi, 3));
+            _mm_storeu_si128((__m128i*)pDestPixel, result);
+            pSrcPixel += 16;
+            pDestPixel += 16;
+        }
+#endif
+        for (; x < width; ++x) {
+            *pDestPixel = (*(pSrcPixel-1) + *(pSrcPixel)*4 + *(pSrcPixel+1)
+                    +*(pSrcPixel-srcStride)+*(pSrcPixel+srcStride)+4)/8;
+            ++pSrcPixel;
+            ++pDestPixel;
+        }
+        pSrcLine += srcStride;
+        pDestLine += destStride;
+    }
+}
+
 FilterBlur::FilterBlur()
 {
 }
@@ -47,22 +102,8 @@ BitmapPtr FilterBlur::apply(BitmapPtr pBmpSrc)
     
     IntPoint Size(pBmpSrc->getSize().x-2, pBmpSrc->getSize().y-2);
     BitmapPtr pDestBmp = BitmapPtr(new Bitmap(Size, I8, pBmpSrc->getName()));
-    int srcStride = pBmpSrc->getStride();
-    int destStride = pDestBmp->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels()+srcStride+1;
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < Size.y; ++y) {
-        unsigned char * pSrcPixel = pSrcLine;
-        unsigned char * pDestPixel = pDestLine;
-        for (int x = 0; x < Size.x; ++x) {
-            *pDestPixel = (*(pSrcPixel-1) + *(pSrcPixel)*4 + *(pSrcPixel+1)
-                    +*(pSrcPixel-srcStride)+*(pSrcPixel+srcStride)+4)/8;
-            ++pSrcPixel;
-            ++pDestPixel;
-        }
-        pSrcLine += srcStride;
-        pDestLine += destStride;
-    }
+    processLineBands(Size, boost::bind(&blurLines, boost::cref(*pBmpSrc),
+            boost::ref(*pDestBmp), _1, _2));
     return pDestBmp;
 }
 
@@ -24,16 +24,22 @@
 
 #include "../api.h"
 #include "Filter.h"
+#include "Convolution.h"
 
 #include "Pixel8.h"
 #include "Pixel24.h"
 #include "Pixel32.h"
 
+#include "../base/Exception.h"
+
+#include <boost/bind.hpp>
+
 #include <iostream>
 
 namespace avg {
 
-// Filter that applies a 3x3 kernel to the bitmap.
+// Filter that applies an n x n matrix to the color channels of the bitmap. Pixel
+// must match the pixel format of the bitmaps: Pixel8, Pixel24 or Pixel32.
 template<class Pixel>
 class AVG_API FilterConvol : public Filter
 {
@@ -43,62 +49,12 @@ public:
     virtual BitmapPtr apply(BitmapPtr pBmpSource);
 
 private:
-    void convolveLine(const unsigned char* pSrc, unsigned char* pDest, 
-            int lineLen, int stride, int offset = 0) const;
     int m_N;
     int m_M;
     int m_Offset;
     float *m_Mat;
 };
-template <class Pixel>
-void FilterConvol<Pixel>::convolveLine(const unsigned char* pSrc, unsigned char* pDest, 
-        int lineLen, int stride, int offset) const 
-{
-    Pixel * pSrcPixel = (Pixel *)pSrc;
-    Pixel * pDestPixel = (Pixel *)pDest;
-    for (int x=0; x<lineLen; ++x) {
-        float NewR = 0;
-        float NewG = 0;
-        float NewB = 0;
-
-        for (int i=0; i<m_N; i++) {
-            for (int j=0; j<m_N; j++) {
-                unsigned char * pLineStart = (unsigned char *)pSrcPixel+i*stride;
-                Pixel SrcPixel = *((Pixel *)pLineStart+j);
-                NewR += SrcPixel.getR()*m_Mat[m_N*i+j];
-                NewG += SrcPixel.getG()*m_Mat[m_N*i+j];
-                NewB += SrcPixel.getB()*m_Mat[m_N*i+j];
-            }
-        }
-        *pDestPixel = Pixel((unsigned char)(NewR+offset), (unsigned char)(NewG+offset), 
-                (unsigned char)(NewB+offset));
-        
-        pSrcPixel++;
-        pDestPixel++;
-    }
-}
-template <>
-void FilterConvol<Pixel8>::convolveLine(const unsigned char* pSrc, unsigned char* pDest, 
-        int lineLen, int stride, int offset) const 
-{
-    Pixel8 * pSrcPixel = (Pixel8 *)pSrc;
-    Pixel8 * pDestPixel = (Pixel8 *)pDest;
-    for (int x=0; x<lineLen; ++x) {
-        float New = 0;
 
-        for (int i=0; i<m_N; i++) {
-            for (int j=0; j<m_N; j++) {
-                unsigned char * pLineStart = (unsigned char *)pSrcPixel+i*stride;
-                Pixel8 SrcPixel = *((Pixel8 *)pLineStart+j);
-                New += SrcPixel.get()*m_Mat[m_N*i+j];
-            }
-        }
-        *pDestPixel = Pixel8((unsigned char)(New+offset));
-        
-        pSrcPixel++;
-        pDestPixel++;
-    }
-}
 template <class Pixel>
 FilterConvol<Pixel>::FilterConvol(float *Mat, int n, int m, int offset)
   : Filter(),
@@ -122,19 +78,16 @@ FilterConvol<Pixel>::~FilterConvol()
 template <class Pixel>
 BitmapPtr FilterConvol<Pixel>::apply(BitmapPtr pBmpSource) 
 {
+    AVG_ASSERT(pBmpSource->getBytesPerPixel() == sizeof(Pixel));
     IntPoint NewSize(pBmpSource->getSize().x-m_N+1, pBmpSource->getSize().y-m_M+1);
     BitmapPtr pNewBmp(new Bitmap(NewSize, pBmpSource->getPixelFormat(),
             pBmpSource->getName()+"_filtered"));
-            
-    for (int y = 0; y < NewSize.y; y++) {
-        const unsigned char * pSrc = pBmpSource->getPixels()+y*pBmpSource->getStride();
-        unsigned char * pDest = pNewBmp->getPixels()+y*pNewBmp->getStride();
-        convolveLine(pSrc, pDest, NewSize.x, pBmpSource->getStride(), m_Offset);
-    }
+    processLineBands(NewSize, boost::bind(&convolveFloatLines,
+            boost::cref(*pBmpSource), boost::ref(*pNewBmp), m_Mat, m_N, m_N,
+            float(m_Offset), _1, _2));
     return pNewBmp;
 }
 
-
 }
 
 #endif
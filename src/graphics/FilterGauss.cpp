@@ -20,13 +20,14 @@
 //
 
 #include "FilterGauss.h"
-#include "Filterfill.h"
-#include "Pixel8.h"
+#include "Convolution.h"
 #include "Bitmap.h"
 
 #include "../base/MathHelper.h"
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <iostream>
 #include <math.h>
 
@@ -46,129 +47,23 @@ FilterGauss::~FilterGauss()
 
 BitmapPtr FilterGauss::apply(BitmapPtr pBmpSrc)
 {
-    AVG_ASSERT(pBmpSrc->getPixelFormat() == I8);
-    int intRadius = int(ceil(m_Radius));
+    PixelFormat pf = pBmpSrc->getPixelFormat();
+    AVG_ASSERT(pf == I8 || pBmpSrc->getBytesPerPixel() == 4);
+    int intRadius = m_KernelWidth/2;
 
     // Convolve in x-direction
     IntPoint tempSize(pBmpSrc->getSize().x-2*intRadius, pBmpSrc->getSize().y);
-    BitmapPtr pTempBmp = BitmapPtr(new Bitmap(tempSize, I8, pBmpSrc->getName()));
-    int srcStride = pBmpSrc->getStride();
-    int tempStride = pTempBmp->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels();
-    unsigned char * pTempLine = pTempBmp->getPixels();
-    for (int y = 0; y < tempSize.y; ++y) {
-        unsigned char * pSrcPixel = pSrcLine+intRadius;
-        unsigned char * pTempPixel = pTempLine;
-        switch (intRadius) {
-            case 3:
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pTempPixel = (*(pSrcPixel-3)*m_Kernel[0] +
-                            *(pSrcPixel-2)*m_Kernel[1] +
-                            *(pSrcPixel-1)*m_Kernel[2] +
-                            *(pSrcPixel)*m_Kernel[3] +
-                            *(pSrcPixel+1)*m_Kernel[4] +
-                            *(pSrcPixel+2)*m_Kernel[5] +
-                            *(pSrcPixel+3)*m_Kernel[6])/256;
-                    ++pSrcPixel;
-                    ++pTempPixel;
-                }
-                break;
-            case 2:
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pTempPixel = (*(pSrcPixel-2)*m_Kernel[0] +
-                            *(pSrcPixel-1)*m_Kernel[1] +
-                            *(pSrcPixel)*m_Kernel[2] +
-                            *(pSrcPixel+1)*m_Kernel[3] +
-                            *(pSrcPixel+2)*m_Kernel[4])/256;
-                    ++pSrcPixel;
-                    ++pTempPixel;
-                }
-                break;
-            case 1:
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pTempPixel = (*(pSrcPixel-1)*m_Kernel[0] +
-                            *(pSrcPixel)*m_Kernel[1] +
-                            *(pSrcPixel+1)*m_Kernel[2])/256;
-                    ++pSrcPixel;
-                    ++pTempPixel;
-                }
-                break;
-            default:
-                // This is _really_ slow!
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pTempPixel = 0;
-                    unsigned char * pKernelPixel = pSrcPixel-intRadius;
-                    for (int w=0; w <= intRadius*2; ++w) {
-                        *pTempPixel += ((*pKernelPixel)*m_Kernel[w])/256;
-                        pKernelPixel++;
-                    }
-                    ++pSrcPixel;
-                    ++pTempPixel;
-                }
-        }
-        pSrcLine += srcStride;
-        pTempLine += tempStride;
-    }
+    BitmapPtr pTempBmp = BitmapPtr(new Bitmap(tempSize, pf, pBmpSrc->getName()));
+    processLineBands(tempSize, boost::bind(&convolveFixedPointLines,
+            boost::cref(*pBmpSrc), boost::ref(*pTempBmp), &m_Kernel[0], m_KernelWidth,
+            false, _1, _2));
 
     // Convolve in y-direction
     IntPoint destSize(tempSize.x, tempSize.y-2*intRadius);
-    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(destSize, I8, pBmpSrc->getName()));
-    int destStride = pDestBmp->getStride();
-    pTempLine = pTempBmp->getPixels()+intRadius*tempStride;
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < destSize.y; ++y) {
-        unsigned char * pTempPixel = pTempLine;
-        unsigned char * pDestPixel = pDestLine;
-        switch (intRadius) {
-            case 3:
-                for (int x = 0; x < destSize.x; ++x) {
-                    *pDestPixel = (*(pTempPixel-3*tempStride)*m_Kernel[0] +
-                            *(pTempPixel-2*tempStride)*m_Kernel[1] +
-                            *(pTempPixel-1*tempStride)*m_Kernel[2] +
-                            *(pTempPixel)*m_Kernel[3] +
-                            *(pTempPixel+1*tempStride)*m_Kernel[4] +
-                            *(pTempPixel+2*tempStride)*m_Kernel[5] +
-                            *(pTempPixel+3*tempStride)*m_Kernel[6])/256;
-                    ++pTempPixel;
-                    ++pDestPixel;
-                }
-                break;
-            case 2:
-                for (int x = 0; x < destSize.x; ++x) {
-                    *pDestPixel = (*(pTempPixel-2*tempStride)*m_Kernel[0] +
-                            *(pTempPixel-1*tempStride)*m_Kernel[1] +
-                            *(pTempPixel)*m_Kernel[2] +
-                            *(pTempPixel+1*tempStride)*m_Kernel[3] +
-                            *(pTempPixel+2*tempStride)*m_Kernel[4])/256;
-                    ++pTempPixel;
-                    ++pDestPixel;
-                }
-                break;
-            case 1:
-                for (int x = 0; x < destSize.x; ++x) {
-                    *pDestPixel = (*(pTempPixel-1*tempStride)*m_Kernel[0] +
-                            *(pTempPixel)*m_Kernel[1] +
-                            *(pTempPixel+1*tempStride)*m_Kernel[2])/256;
-                    ++pTempPixel;
-                    ++pDestPixel;
-                }
-                break;
-            default:
-                // This is _really_ slow!
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pDestPixel = 0;
-                    unsigned char * pKernelPixel = pTempPixel-intRadius*tempStride;
-                    for (int w = 0; w <= intRadius*2; ++w) {
-                        *pDestPixel += (*pKernelPixel*m_Kernel[w])/256;
-                        pKernelPixel += tempStride;
-                    }
-                    ++pTempPixel;
-                    ++pDestPixel;
-                }
-        }
-        pTempLine += tempStride;
-        pDestLine += destStride;
-    }
+    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(destSize, pf, pBmpSrc->getName()));
+    processLineBands(destSize, boost::bind(&convolveFixedPointLines,
+            boost::cref(*pTempBmp), boost::ref(*pDestBmp), &m_Kernel[0], m_KernelWidth,
+            true, _1, _2));
     return pDestBmp;
 }
 
@@ -183,10 +78,11 @@ void FilterGauss::dumpKernel()
 
 void FilterGauss::calcKernel()
 {
-    float FloatKernel[15];
     float Sum = 0;
     int intRadius = int(ceil(m_Radius));
     m_KernelWidth = intRadius*2+1;
+    vector<float> FloatKernel(m_KernelWidth);
+    m_Kernel.resize(m_KernelWidth);
     for (int i = 0; i <= intRadius; ++i) {
         FloatKernel[intRadius+i] = float(exp(-i*i/m_Radius-1)/sqrt(2*M_PI));
         FloatKernel[intRadius-i] = FloatKernel[intRadius+i];
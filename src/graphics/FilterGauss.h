@@ -28,8 +28,12 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <vector>
+
 namespace avg {
 
+// Separable gaussian blur for I8 and 32-bit bitmaps. The result is smaller than the
+// source by 2*ceil(radius) pixels in both dimensions.
 class AVG_API FilterGauss: public Filter{
     public:
         FilterGauss(float Radius);
@@ -44,7 +48,7 @@ class AVG_API FilterGauss: public Filter{
 
         float m_Radius;
         int m_KernelWidth;
-        int m_Kernel[15];
+        std::vector<int> m_Kernel;
 };
 
 typedef boost::shared_ptr<FilterGauss> FilterGaussPtr;
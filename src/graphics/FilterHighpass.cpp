@@ -20,12 +20,17 @@
 //
 
 #include "FilterHighpass.h"
-#include "Filterfill.h"
-#include "Pixel8.h"
+#include "Convolution.h"
 #include "Bitmap.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
+#if defined(__SSE2__) || defined(_WIN32)
+#include <emmintrin.h>
+#endif
+
 #include <cstring>
 #include <iostream>
 #include <sstream>
@@ -34,31 +39,66 @@ using namespace std;
 
 namespace avg {
     
-FilterHighpass::FilterHighpass()
+// Processes the lines startY+3 to endY+3, leaving out the three pixel border.
+static void highpassLines(const Bitmap& srcBmp, Bitmap& destBmp, int startY, int endY)
 {
-}
-
-FilterHighpass::~FilterHighpass()
-{
-}
-
-BitmapPtr FilterHighpass::apply(BitmapPtr pBmpSrc)
-{
-    AVG_ASSERT(pBmpSrc->getPixelFormat() == I8);
-    BitmapPtr pBmpDest = BitmapPtr(new Bitmap(pBmpSrc->getSize(), I8,
-            pBmpSrc->getName()));
-    int srcStride = pBmpSrc->getStride();
-    int destStride = pBmpDest->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels()+3*srcStride;
-    unsigned char * pDestLine = pBmpDest->getPixels()+3*destStride;
-    IntPoint size = pBmpDest->getSize();
-    for (int y = 3; y < size.y-3; ++y) {
-        unsigned char * pSrcPixel = pSrcLine+3;
+    int srcStride = srcBmp.getStride();
+    int destStride = destBmp.getStride();
+    int width = destBmp.getSize().x-6;
+    const unsigned char * pSrcLine = srcBmp.getPixels()+(startY+3)*srcStride;
+    unsigned char * pDestLine = destBmp.getPixels()+(startY+3)*destStride;
+    for (int y = startY; y < endY; ++y) {
+        const unsigned char * pSrcPixel = pSrcLine+3;
         unsigned char * pDstPixel = pDestLine;
         *pDstPixel++ = 128;
         *pDstPixel++ = 128;
         *pDstPixel++ = 128;
-        for (int x = 3; x < size.x-3; ++x) {
+        int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+        // Same arithmetic as below, modulo 256.
+        __m128i zero = _mm_setzero_si128();
+        __m128i mask = _mm_set1_epi16(0xFF);
+        __m128i offset = _mm_set1_epi16(128);
+        const int outerOffsets[] = {-3*srcStride-3, -3*srcStride+3, 3*srcStride-3,
+                3*srcStride+3};
+        const int innerOffsets[] = {-2*srcStride-2, -2*srcStride+2, -srcStride-1,
+                -srcStride+1, srcStride-1, srcStride+1, 2*srcStride-2, 2*srcStride+2};
+        for (; x < width-15; x += 16) {
+            __m128i outerLo = zero;
+            __m128i outerHi = zero;
+            for (int i = 0; i < 4; ++i) {
+                __m128i src = _mm_loadu_si128(
+                        (const __m128i*)(pSrcPixel+outerOffsets[i]));
+                outerLo = _mm_add_epi16(outerLo, _mm_unpacklo_epi8(src, zero));
+                outerHi = _mm_add_epi16(outerHi, _mm_unpackhi_epi8(src, zero));
+            }
+            __m128i innerLo = zero;
+            __m128i innerHi = zero;
+            for (int i = 0; i < 8; ++i) {
+                __m128i src = _mm_loadu_si128(
+                        (const __m128i*)(pSrcPixel+innerOffsets[i]));
+                innerLo = _mm_add_epi16(innerLo, _mm_unpacklo_epi8(src, zero));
+                innerHi = _mm_add_epi16(innerHi, _mm_unpackhi_epi8(src, zero));
+            }
+            __m128i center = _mm_loadu_si128((const __m128i*)pSrcPixel);
+            __m128i centerLo = _mm_unpacklo_epi8(center, zero);
+            __m128i centerHi = _mm_unpackhi_epi8(center, zero);
+            centerLo = _mm_srli_epi16(_mm_add_epi16(centerLo,
+                    _mm_slli_epi16(centerLo, 1)), 2);
+            centerHi = _mm_srli_epi16(_mm_add_epi16(centerHi,
+                    _mm_slli_epi16(centerHi, 1)), 2);
+            __m128i resultLo = _mm_sub_epi16(_mm_sub_epi16(offset,
+                    _mm_srli_epi16(outerLo, 4)), _mm_srli_epi16(innerLo, 4));
+            __m128i resultHi = _mm_sub_epi16(_mm_sub_epi16(offset,
+                    _mm_srli_epi16(outerHi, 4)), _mm_srli_epi16(innerHi, 4));
+            resultLo = _mm_and_si128(_mm_add_epi16(resultLo, centerLo), mask);
+            resultHi = _mm_and_si128(_mm_add_epi16(resultHi, centerHi), mask);
+            _mm_storeu_si128((__m128i*)pDstPixel, _mm_packus_epi16(resultLo, resultHi));
+            pSrcPixel += 16;
+            pDstPixel += 16;
+        }
+#endif
+        for (; x < width; ++x) {
             // Convolution Matrix is
             // -1  0  0   0  -1
             //  0 -1  0  -1   0
@@ -85,6 +125,25 @@ BitmapPtr FilterHighpass::apply(BitmapPtr pBmpSrc)
         pSrcLine += srcStride;
         pDestLine += destStride;
     }
+}
+
+FilterHighpass::FilterHighpass()
+{
+}
+
+FilterHighpass::~FilterHighpass()
+{
+}
+
+BitmapPtr FilterHighpass::apply(BitmapPtr pBmpSrc)
+{
+    AVG_ASSERT(pBmpSrc->getPixelFormat() == I8);
+    BitmapPtr pBmpDest = BitmapPtr(new Bitmap(pBmpSrc->getSize(), I8,
+            pBmpSrc->getName()));
+    int destStride = pBmpDest->getStride();
+    IntPoint size = pBmpDest->getSize();
+    processLineBands(IntPoint(size.x, size.y-6), boost::bind(&highpassLines,
+            boost::cref(*pBmpSrc), boost::ref(*pBmpDest), _1, _2));
     // Set top and bottom borders.
     memset(pBmpDest->getPixels(), 128, destStride*3);
     memset(pBmpDest->getPixels()+destStride*(size.y-3), 128, destStride*3);
@@ -0,0 +1,168 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "FilterResample.h"
+
+#include "Bitmap.h"
+#include "Convolution.h"
+
+#include "../base/Exception.h"
+#include "../base/ScopeTimer.h"
+
+#include <boost/bind.hpp>
+
+#if defined(__SSE2__) || defined(_WIN32)
+#include <emmintrin.h>
+#endif
+
+#include <sstream>
+
+using namespace std;
+
+namespace avg {
+
+FilterResample::FilterResample(const IntPoint& newSize, ResampleFilter filter)
+    : m_NewSize(newSize),
+      m_Filter(filter)
+{
+    if (newSize.x <= 0 || newSize.y <= 0) {
+        stringstream ss;
+        ss << "FilterResample: Invalid size " << newSize << ".";
+        throw Exception(AVG_ERR_OUT_OF_RANGE, ss.str());
+    }
+}
+
+FilterResample::~FilterResample()
+{
+}
+
+// Rounds c*alpha/255 to the nearest integer.
+static inline unsigned char premultiply(int c, int alpha)
+{
+    int t = c*alpha+128;
+    return (unsigned char)((t+(t>>8))>>8);
+}
+
+static void premultiplyLines(const Bitmap& srcBmp, Bitmap& destBmp, int alphaPos,
+        int startY, int endY)
+{
+    int width = srcBmp.getSize().x;
+#if defined(__SSE2__) || defined(_WIN32)
+    __m128i zero = _mm_setzero_si128();
+    __m128i round = _mm_set1_epi16(128);
+    __m128i alphaMask = _mm_set1_epi32(0xFF << (alphaPos*8));
+#endif
+    for (int y = startY; y < endY; ++y) {
+        const unsigned char* pSrc = srcBmp.getPixels()+y*srcBmp.getStride();
+        unsigned char* pDest = destBmp.getPixels()+y*destBmp.getStride();
+        int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+        // Four pixels per step.
+        for (; x < width-3; x += 4) {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(pSrc+x*4));
+            __m128i alpha = _mm_and_si128(pixels, alphaMask);
+            alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+            alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+            alpha = _mm_or_si128(alpha, _mm_srli_epi32(alpha, 8));
+            alpha = _mm_or_si128(alpha, _mm_srli_epi32(alpha, 16));
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero),
+                    _mm_unpacklo_epi8(alpha, zero)), round);
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero),
+                    _mm_unpackhi_epi8(alpha, zero)), round);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            __m128i result = _mm_packus_epi16(lo, hi);
+            result = _mm_or_si128(_mm_andnot_si128(alphaMask, result),
+                    _mm_and_si128(alphaMask, pixels));
+            _mm_storeu_si128((__m128i*)(pDest+x*4), result);
+        }
+#endif
+        for (; x < width; ++x) {
+            const unsigned char* pSrcPixel = pSrc+x*4;
+            unsigned char* pDestPixel = pDest+x*4;
+            int alpha = pSrcPixel[alphaPos];
+            for (int c = 0; c < 4; ++c) {
+                pDestPixel[c] = premultiply(pSrcPixel[c], alpha);
+            }
+            pDestPixel[alphaPos] = (unsigned char)alpha;
+        }
+    }
+}
+
+static void unmultiplyLines(Bitmap& bmp, int alphaPos, int startY, int endY)
+{
+    // 16.16 fixed-point factors replace the division by alpha.
+    unsigned factors[256];
+    factors[0] = 0;
+    for (unsigned alpha = 1; alpha < 256; ++alpha) {
+        factors[alpha] = (255*65536+alpha/2)/alpha;
+    }
+    int width = bmp.getSize().x;
+    for (int y = startY; y < endY; ++y) {
+        unsigned char* pPixel = bmp.getPixels()+y*bmp.getStride();
+        for (int x = 0; x < width; ++x) {
+            int alpha = pPixel[alphaPos];
+            unsigned factor = factors[alpha];
+            for (int c = 0; c < 4; ++c) {
+                if (c != alphaPos) {
+                    pPixel[c] = (unsigned char)min(255u, (pPixel[c]*factor+32768) >> 16);
+                }
+            }
+            pPixel += 4;
+        }
+    }
+}
+
+static ProfilingZoneID ProfilingZone("FilterResample");
+
+BitmapPtr FilterResample::apply(BitmapPtr pBmpSrc)
+{
+    ScopeTimer timer(ProfilingZone);
+    PixelFormat pf = pBmpSrc->getPixelFormat();
+    int bpp = pBmpSrc->getBytesPerPixel();
+    if ((bpp != 1 && bpp != 3 && bpp != 4) || pf == I32F || pixelFormatIsPlanar(pf)) {
+        throw Exception(AVG_ERR_UNSUPPORTED, "FilterResample: Pixel format "+
+                getPixelFormatString(pf)+" not supported.");
+    }
+    IntPoint srcSize = pBmpSrc->getSize();
+    if (srcSize == m_NewSize) {
+        // Premultiplying would lose precision at low alpha values.
+        return BitmapPtr(new Bitmap(*pBmpSrc));
+    }
+    ResampleWeightsPtr pXWeights = ResampleWeights::get(srcSize.x, m_NewSize.x, m_Filter);
+    ResampleWeightsPtr pYWeights = ResampleWeights::get(srcSize.y, m_NewSize.y, m_Filter);
+    BitmapPtr pBmpDest = BitmapPtr(new Bitmap(m_NewSize, pf, pBmpSrc->getName()));
+    if (pixelFormatHasAlpha(pf)) {
+        int alphaPos = (pf == A8B8G8R8 || pf == A8R8G8B8) ? 0 : 3;
+        Bitmap premultipliedBmp(srcSize, pf, pBmpSrc->getName());
+        processLineBands(srcSize, boost::bind(&premultiplyLines, boost::cref(*pBmpSrc),
+                boost::ref(premultipliedBmp), alphaPos, _1, _2));
+        resampleBitmap(premultipliedBmp, *pBmpDest, pXWeights, pYWeights);
+        processLineBands(m_NewSize, boost::bind(&unmultiplyLines, boost::ref(*pBmpDest),
+                alphaPos, _1, _2));
+    } else {
+        resampleBitmap(*pBmpSrc, *pBmpDest, pXWeights, pYWeights);
+    }
+    return pBmpDest;
+}
+
+}
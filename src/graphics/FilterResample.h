@@ -0,0 +1,52 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _FilterResample_H_
+#define _FilterResample_H_
+
+#include "../api.h"
+#include "Filter.h"
+#include "Resampler.h"
+
+#include "../base/GLMHelper.h"
+
+namespace avg {
+
+// Scales bitmaps with 8 bits per channel using a box, bilinear, Mitchell or Lanczos
+// filter. Bitmaps with an alpha channel are premultiplied while filtering, so the
+// colors of transparent pixels don't bleed into their neighbours.
+class AVG_API FilterResample: public Filter
+{
+public:
+    FilterResample(const IntPoint& newSize, ResampleFilter filter=RESAMPLE_LANCZOS);
+    virtual ~FilterResample();
+
+    virtual BitmapPtr apply(BitmapPtr pBmpSrc);
+
+private:
+    IntPoint m_NewSize;
+    ResampleFilter m_Filter;
+};
+
+}
+
+#endif
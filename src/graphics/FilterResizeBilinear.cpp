@@ -21,7 +21,8 @@
 
 #include "FilterResizeBilinear.h"
 #include "Bitmap.h"
-#include "TwoPassScale.h"
+#include "ContribDefs.h"
+#include "Resampler.h"
 
 #include "../base/Exception.h"
 
@@ -41,37 +42,10 @@ BitmapPtr FilterResizeBilinear::apply(BitmapPtr pBmpSrc)
             pBmpSrc->getPixelFormat(), pBmpSrc->getName()+"_resized"));
 
     BilinearContribDef f(0.64);
-    switch (bpp) {
-        case 4:
-            {
-                TwoPassScale<CDataRGBA_UBYTE> sS(f);
-                sS.Scale((CDataRGBA_UBYTE::PixelClass *) pBmpSrc->getPixels(), 
-                        pBmpSrc->getSize(), pBmpSrc->getStride(), 
-                        (CDataRGBA_UBYTE::PixelClass *) pBmpDest->getPixels(),
-                        pBmpDest->getSize(), pBmpDest->getStride());
-            }
-            break;
-        case 3:
-            {
-                TwoPassScale <CDataRGB_UBYTE> sS(f);
-                sS.Scale((CDataRGB_UBYTE::PixelClass *) pBmpSrc->getPixels(), 
-                        pBmpSrc->getSize(), pBmpSrc->getStride(), 
-                        (CDataRGB_UBYTE::PixelClass *) pBmpDest->getPixels(),
-                        pBmpDest->getSize(), pBmpDest->getStride());
-            }
-            break;
-        case 1:
-            {
-                TwoPassScale <CDataA_UBYTE> sS(f);
-                sS.Scale((CDataA_UBYTE::PixelClass *) pBmpSrc->getPixels(), 
-                        pBmpSrc->getSize(), pBmpSrc->getStride(), 
-                        (CDataA_UBYTE::PixelClass *) pBmpDest->getPixels(),
-                        pBmpDest->getSize(), pBmpDest->getStride());
-            }
-            break;
-        default:
-            AVG_ASSERT(false);
-    }
+    IntPoint srcSize = pBmpSrc->getSize();
+    resampleBitmap(*pBmpSrc, *pBmpDest,
+            ResampleWeights::createFromContribDef(srcSize.x, m_NewSize.x, f),
+            ResampleWeights::createFromContribDef(srcSize.y, m_NewSize.y, f));
     return pBmpDest;
 }
 
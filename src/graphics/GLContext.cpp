@@ -41,6 +41,45 @@ namespace avg {
 using namespace std;
 using namespace boost;
 
+RenderStats::RenderStats()
+    : m_NumDrawCalls(0),
+      m_NumTextureBinds(0),
+      m_NumBlendModeChanges(0),
+      m_NumShaderChanges(0),
+      m_NumBatches(0),
+      m_NumBatchedNodes(0)
+{
+}
+
+RenderStats& RenderStats::operator+=(const RenderStats& other)
+{
+    m_NumDrawCalls += other.m_NumDrawCalls;
+    m_NumTextureBinds += other.m_NumTextureBinds;
+    m_NumBlendModeChanges += other.m_NumBlendModeChanges;
+    m_NumShaderChanges += other.m_NumShaderChanges;
+    m_NumBatches += other.m_NumBatches;
+    m_NumBatchedNodes += other.m_NumBatchedNodes;
+    return *this;
+}
+
+RenderStats RenderStats::operator-(const RenderStats& other) const
+{
+    RenderStats result;
+    result.m_NumDrawCalls = m_NumDrawCalls - other.m_NumDrawCalls;
+    result.m_NumTextureBinds = m_NumTextureBinds - other.m_NumTextureBinds;
+    result.m_NumBlendModeChanges = m_NumBlendModeChanges - other.m_NumBlendModeChanges;
+    result.m_NumShaderChanges = m_NumShaderChanges - other.m_NumShaderChanges;
+    result.m_NumBatches = m_NumBatches - other.m_NumBatches;
+    result.m_NumBatchedNodes = m_NumBatchedNodes - other.m_NumBatchedNodes;
+    return result;
+}
+
+int RenderStats::getNumStateChanges() const
+{
+    return m_NumTextureBinds + m_NumBlendModeChanges + m_NumShaderChanges;
+}
+
+
 GLContext* GLContext::s_pCurrentContext;
 bool GLContext::s_bErrorCheckEnabled = false;
 bool GLContext::s_bErrorLogEnabled = true;
@@ -257,6 +296,7 @@ void GLContext::setBlendMode(BlendMode mode, bool bPremultipliedAlpha)
 
         m_BlendMode = mode;
         m_bPremultipliedAlpha = bPremultipliedAlpha;
+        m_RenderStats.m_NumBlendModeChanges++;
     }
 }
 
@@ -277,9 +317,31 @@ void GLContext::bindTexture(unsigned unit, unsigned texID)
         glBindTexture(GL_TEXTURE_2D, texID);
         checkError("GLContext::bindTexture BindTexture()");
         m_BoundTextures[unit-GL_TEXTURE0] = texID;
+        m_RenderStats.m_NumTextureBinds++;
     }
 }
 
+void GLContext::countDrawCall()
+{
+    m_RenderStats.m_NumDrawCalls++;
+}
+
+void GLContext::countShaderChange()
+{
+    m_RenderStats.m_NumShaderChanges++;
+}
+
+void GLContext::countBatch(int numNodes)
+{
+    m_RenderStats.m_NumBatches++;
+    m_RenderStats.m_NumBatchedNodes += numNodes;
+}
+
+const RenderStats& GLContext::getRenderStats() const
+{
+    return m_RenderStats;
+}
+
 const GLConfig& GLContext::getConfig()
 {
     return m_GLConfig;
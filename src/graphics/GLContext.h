@@ -40,6 +40,23 @@ class ShaderRegistry;
 typedef boost::shared_ptr<ShaderRegistry> ShaderRegistryPtr;
 class StandardShader;
 
+// Counts GL calls that are relevant for rendering performance.
+struct AVG_API RenderStats
+{
+    RenderStats();
+    RenderStats& operator+=(const RenderStats& other);
+    RenderStats operator-(const RenderStats& other) const;
+
+    int getNumStateChanges() const;
+
+    int m_NumDrawCalls;
+    int m_NumTextureBinds;
+    int m_NumBlendModeChanges;
+    int m_NumShaderChanges;
+    int m_NumBatches;
+    int m_NumBatchedNodes;
+};
+
 class AVG_API GLContext
 {
 public:
@@ -64,6 +81,12 @@ public:
     bool isBlendModeSupported(BlendMode mode) const;
     void bindTexture(unsigned unit, unsigned texID);
 
+    // Render statistics.
+    void countDrawCall();
+    void countShaderChange();
+    void countBatch(int numNodes);
+    const RenderStats& getRenderStats() const;
+
     const GLConfig& getConfig();
     void logConfig();
     size_t getVideoMemInstalled();
@@ -128,6 +151,8 @@ private:
     bool m_bPremultipliedAlpha;
     unsigned m_BoundTextures[16];
 
+    RenderStats m_RenderStats;
+
     std::string m_sVendor;
     std::string m_sRenderer;
     int m_MajorGLVersion;
@@ -26,6 +26,7 @@
 #include "../base/Backtrace.h"
 #include "../base/ScopeTimer.h"
 
+#include "Bitmap.h"
 #include "GLTexture.h"
 #include "MCTexture.h"
 #include "VertexArray.h"
@@ -63,6 +64,13 @@ bool GLContextManager::isActive()
 }
 
 GLContextManager::GLContextManager()
+    : m_bTexUploadsSelected(false),
+      m_NextUploadSeqNum(0),
+      m_TexUploadBudget(0),
+      m_FrameUploadBytes(0),
+      m_FrameDeferrableBytes(0),
+      m_LastFrameUploadBytes(0),
+      m_NumPartialUploads(0)
 {
 //    AVG_ASSERT(!s_pGLContextManager);
     s_pGLContextManager = this;
@@ -71,7 +79,8 @@ GLContextManager::GLContextManager()
 GLContextManager::~GLContextManager()
 {
     m_pPendingTexCreates.clear();
-    m_pPendingTexUploads.clear();
+    m_TexUploadSlices.clear();
+    m_PendingTexUploads.clear();
     m_PendingTexDeletes.clear();
 
     m_pPendingFBOCreates.clear();
@@ -163,20 +172,94 @@ void GLContextManager::createShader(const string& sID)
     pContext->activate();
 }
 
-void GLContextManager::scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp)
+void GLContextManager::scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp,
+        TexUploadPriority priority)
 {
-    m_pPendingTexUploads[pTex] = pBmp;
+    // A new bitmap for a texture replaces the one that hasn't been uploaded yet.
+    TexUpload& upload = m_PendingTexUploads[pTex];
+    upload.m_pBmp = pBmp;
+    upload.m_Priority = priority;
+    upload.m_SeqNum = m_NextUploadSeqNum++;
+    upload.m_Rect = IntRect(IntPoint(0,0), pBmp->getSize());
+    upload.m_SubRects.assign(1, upload.m_Rect);
+    upload.m_NumRowsDone = 0;
+    upload.m_bComplete = false;
+}
+
+void GLContextManager::scheduleTexSubUpload(MCTexturePtr pTex, BitmapPtr pBmp,
+        const IntRect& rect, TexUploadPriority priority)
+{
+    AVG_ASSERT(pBmp->getSize() == pTex->getSize());
+    AVG_ASSERT(rect.tl.x >= 0 && rect.tl.y >= 0 && rect.br.x <= pBmp->getSize().x &&
+            rect.br.y <= pBmp->getSize().y);
+    TexUploadMap::iterator it = m_PendingTexUploads.find(pTex);
+    if (it == m_PendingTexUploads.end() || it->second.m_pBmp != pBmp) {
+        scheduleTexUpload(pTex, pBmp, priority);
+        TexUpload& upload = m_PendingTexUploads[pTex];
+        upload.m_Rect = rect;
+        upload.m_SubRects.assign(1, rect);
+    } else {
+        // The merged rect is uploaded from the start, since lines that are done
+        // already might have changed again. Sub-rects that are done stay visible.
+        TexUpload& upload = it->second;
+        int doneY = upload.m_Rect.tl.y+upload.m_NumRowsDone;
+        vector<IntRect> subRects;
+        for (unsigned i = 0; i < upload.m_SubRects.size(); ++i) {
+            if (upload.m_SubRects[i].br.y > doneY) {
+                subRects.push_back(upload.m_SubRects[i]);
+            }
+        }
+        subRects.push_back(rect);
+        upload.m_SubRects.swap(subRects);
+        upload.m_Rect.expand(rect);
+        upload.m_Priority = min(upload.m_Priority, priority);
+        upload.m_NumRowsDone = 0;
+        upload.m_bComplete = false;
+    }
 }
 
 MCTexturePtr GLContextManager::createTextureFromBmp(BitmapPtr pBmp, bool bMipmap,
-        bool bForcePOT, int potBorderColor)
+        bool bForcePOT, int potBorderColor, TexUploadPriority priority)
 {
     MCTexturePtr pTex = createTexture(pBmp->getSize(), pBmp->getPixelFormat(), bMipmap,
             bForcePOT, potBorderColor);
-    scheduleTexUpload(pTex, pBmp);
+    scheduleTexUpload(pTex, pBmp, priority);
     return pTex;
 }
 
+void GLContextManager::raiseTexUploadPriority(const MCTexturePtr& pTex,
+        TexUploadPriority priority)
+{
+    TexUploadMap::iterator it = m_PendingTexUploads.find(pTex);
+    if (it != m_PendingTexUploads.end() && priority < it->second.m_Priority) {
+        it->second.m_Priority = priority;
+    }
+}
+
+bool GLContextManager::isTexUploadPending(const MCTexturePtr& pTex) const
+{
+    TexUploadMap::const_iterator it = m_PendingTexUploads.find(pTex);
+    return it != m_PendingTexUploads.end() && !it->second.m_bComplete;
+}
+
+bool GLContextManager::isTexUploadPending(const MCTexturePtr& pTex, const IntRect& rect)
+        const
+{
+    TexUploadMap::const_iterator it = m_PendingTexUploads.find(pTex);
+    if (it == m_PendingTexUploads.end() || it->second.m_bComplete) {
+        return false;
+    }
+    const TexUpload& upload = it->second;
+    int doneY = upload.m_Rect.tl.y+upload.m_NumRowsDone;
+    for (unsigned i = 0; i < upload.m_SubRects.size(); ++i) {
+        const IntRect& subRect = upload.m_SubRects[i];
+        if (subRect.br.y > doneY && subRect.intersects(rect)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void GLContextManager::deleteTexture(unsigned texID)
 {
     m_PendingTexDeletes.push_back(texID);
@@ -230,11 +313,16 @@ void GLContextManager::uploadDataForContext()
         m_pPendingTexCreates[i]->initForGLContext(pContext);
     }
 
-    TexUploadMap::iterator it;
-    for (it=m_pPendingTexUploads.begin(); it!=m_pPendingTexUploads.end(); ++it) {
-        MCTexturePtr pTex = it->first;
-        BitmapPtr pBmp = it->second;
-        pTex->moveBmpToTexture(pContext, pBmp);
+    if (!m_bTexUploadsSelected) {
+        selectTexUploads();
+    }
+    for (unsigned i=0; i<m_TexUploadSlices.size(); ++i) {
+        TexUploadSlice& slice = m_TexUploadSlices[i];
+        if (slice.m_Rect.size() == slice.m_pBmp->getSize()) {
+            slice.m_pTex->moveBmpToTexture(pContext, slice.m_pBmp);
+        } else {
+            slice.m_pTex->moveBmpRectToTexture(pContext, slice.m_pBmp, slice.m_Rect);
+        }
     }
 
     for (unsigned i=0; i<m_pPendingFBOCreates.size(); ++i) {
@@ -253,7 +341,7 @@ void GLContextManager::reset()
     // cause texture deletes to be scheduled!
     m_PendingTexDeletes.clear();
     m_pPendingTexCreates.clear();
-    m_pPendingTexUploads.clear();
+    finishTexUploads();
 
     m_pPendingFBOCreates.clear();
     m_pPendingShaderParamCreates.clear();
@@ -262,6 +350,142 @@ void GLContextManager::reset()
     m_PendingBufferDeletes.clear();
 }
 
+void GLContextManager::setTexUploadBudget(long long budget)
+{
+    if (budget < 0) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, "Texture upload budget must be >= 0.");
+    }
+    m_TexUploadBudget = budget;
+}
+
+long long GLContextManager::getTexUploadBudget() const
+{
+    return m_TexUploadBudget;
+}
+
+void GLContextManager::endFrame()
+{
+    m_LastFrameUploadBytes = m_FrameUploadBytes;
+    m_FrameUploadBytes = 0;
+    m_FrameDeferrableBytes = 0;
+}
+
+long long GLContextManager::getLastFrameUploadBytes() const
+{
+    return m_LastFrameUploadBytes;
+}
+
+int GLContextManager::getNumDeferredUploads() const
+{
+    return int(m_PendingTexUploads.size());
+}
+
+long long GLContextManager::getDeferredUploadBytes() const
+{
+    long long numBytes = 0;
+    TexUploadMap::const_iterator it;
+    for (it=m_PendingTexUploads.begin(); it!=m_PendingTexUploads.end(); ++it) {
+        const TexUpload& upload = it->second;
+        IntPoint size = upload.m_Rect.size();
+        numBytes += (long long)(size.y-upload.m_NumRowsDone)*size.x*
+                upload.m_pBmp->getBytesPerPixel();
+    }
+    return numBytes;
+}
+
+long long GLContextManager::getNumPartialUploads() const
+{
+    return m_NumPartialUploads;
+}
+
+void GLContextManager::selectTexUploads()
+{
+    // Immediate uploads are always done. The rest is done in priority order until
+    // the budget for the frame is used up.
+    typedef map<pair<int, long long>, TexUploadMap::iterator> UploadQueue;
+    UploadQueue deferrableUploads;
+    TexUploadMap::iterator it = m_PendingTexUploads.begin();
+    while (it != m_PendingTexUploads.end()) {
+        TexUpload& upload = it->second;
+        int numRowsLeft = upload.m_Rect.height()-upload.m_NumRowsDone;
+        if (it->first.use_count() == 1) {
+            // The texture has been discarded before its upload was due.
+            m_PendingTexUploads.erase(it++);
+            continue;
+        }
+        if (upload.m_Priority == UPLOADPRIORITY_IMMEDIATE || m_TexUploadBudget == 0) {
+            addTexUploadSlice(it, numRowsLeft);
+        } else {
+            deferrableUploads[make_pair(int(upload.m_Priority), upload.m_SeqNum)] = it;
+        }
+        ++it;
+    }
+
+    UploadQueue::iterator queueIt;
+    for (queueIt=deferrableUploads.begin(); queueIt!=deferrableUploads.end(); ++queueIt)
+    {
+        TexUploadMap::iterator uploadIt = queueIt->second;
+        const TexUpload& upload = uploadIt->second;
+        long long rowBytes = (long long)(upload.m_Rect.width())*
+                upload.m_pBmp->getBytesPerPixel();
+        int numRowsLeft = upload.m_Rect.height()-upload.m_NumRowsDone;
+        long long budgetLeft = m_TexUploadBudget-m_FrameDeferrableBytes;
+        if (rowBytes*numRowsLeft <= budgetLeft) {
+            m_FrameDeferrableBytes += rowBytes*numRowsLeft;
+            addTexUploadSlice(uploadIt, numRowsLeft);
+        } else {
+            // Bitmaps that don't fit into the budget at all are uploaded in stripes.
+            // The first deferrable upload in a frame always makes progress.
+            int numRows = int(max(budgetLeft, 0LL)/rowBytes);
+            if (m_FrameDeferrableBytes == 0) {
+                numRows = max(numRows, 1);
+            }
+            if (rowBytes*numRowsLeft > m_TexUploadBudget && numRows > 0) {
+                m_FrameDeferrableBytes += rowBytes*numRows;
+                addTexUploadSlice(uploadIt, numRows);
+                m_NumPartialUploads++;
+            }
+            break;
+        }
+    }
+    m_bTexUploadsSelected = true;
+}
+
+void GLContextManager::addTexUploadSlice(TexUploadMap::iterator it, int numRows)
+{
+    TexUpload& upload = it->second;
+    TexUploadSlice slice;
+    slice.m_pTex = it->first;
+    slice.m_pBmp = upload.m_pBmp;
+    const IntRect& rect = upload.m_Rect;
+    int startRow = rect.tl.y+upload.m_NumRowsDone;
+    slice.m_Rect = IntRect(rect.tl.x, startRow, rect.br.x, startRow+numRows);
+    m_TexUploadSlices.push_back(slice);
+    if (upload.m_NumRowsDone+numRows == rect.height()) {
+        upload.m_bComplete = true;
+    }
+    m_FrameUploadBytes += (long long)(rect.width())*numRows*
+            upload.m_pBmp->getBytesPerPixel();
+}
+
+void GLContextManager::finishTexUploads()
+{
+    for (unsigned i=0; i<m_TexUploadSlices.size(); ++i) {
+        const TexUploadSlice& slice = m_TexUploadSlices[i];
+        TexUploadMap::iterator it = m_PendingTexUploads.find(slice.m_pTex);
+        // The texture might have been given a new bitmap in the meantime.
+        if (it != m_PendingTexUploads.end() && it->second.m_pBmp == slice.m_pBmp) {
+            TexUpload& upload = it->second;
+            upload.m_NumRowsDone = slice.m_Rect.br.y-upload.m_Rect.tl.y;
+            if (upload.m_NumRowsDone == upload.m_Rect.height()) {
+                m_PendingTexUploads.erase(it);
+            }
+        }
+    }
+    m_TexUploadSlices.clear();
+    m_bTexUploadsSelected = false;
+}
+
 bool GLContextManager::isGLESSupported()
 {
 #if defined __linux__
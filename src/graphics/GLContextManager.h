@@ -24,9 +24,12 @@
 #include "../api.h"
 
 #include "PixelFormat.h"
+#include "TexInfo.h"
 #include "GLContext.h"
 #include "MCShaderParam.h"
 
+#include "../base/Rect.h"
+
 #include <map>
 
 struct SDL_SysWMinfo;
@@ -75,9 +78,24 @@ public:
         return pParam;
     }
 
-    void scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp);
+    void scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp,
+            TexUploadPriority priority=UPLOADPRIORITY_IMMEDIATE);
+    // Uploads only the part of pBmp inside rect. pBmp must have the size of the texture
+    // and the texture must not use mipmaps. If an upload of the same bitmap is pending,
+    // the rects are merged, so several changes in one frame result in one upload.
+    void scheduleTexSubUpload(MCTexturePtr pTex, BitmapPtr pBmp, const IntRect& rect,
+            TexUploadPriority priority=UPLOADPRIORITY_IMMEDIATE);
     MCTexturePtr createTextureFromBmp(BitmapPtr pBmp, bool bMipmap=false, 
-            bool bForcePOT=false, int potBorderColor=0);
+            bool bForcePOT=false, int potBorderColor=0,
+            TexUploadPriority priority=UPLOADPRIORITY_IMMEDIATE);
+    // Makes a pending upload more urgent. Does nothing if the texture has no pending
+    // upload or the upload already has a higher priority.
+    void raiseTexUploadPriority(const MCTexturePtr& pTex, TexUploadPriority priority);
+    // True if the texture content hasn't been completely uploaded yet.
+    bool isTexUploadPending(const MCTexturePtr& pTex) const;
+    // True if part of rect is waiting for an upload scheduled with scheduleTexUpload()
+    // or scheduleTexSubUpload().
+    bool isTexUploadPending(const MCTexturePtr& pTex, const IntRect& rect) const;
     void deleteTexture(unsigned texID);
 
     VertexArrayPtr createVertexArray(int reserveVerts = 0, int reserveIndexes = 0);
@@ -88,16 +106,60 @@ public:
     void uploadDataForContext();
     void reset();
 
+    // Maximum number of bytes of deferrable texture data uploaded per frame. Bitmaps
+    // that are larger than the budget are uploaded in stripes. 0 disables the budget.
+    void setTexUploadBudget(long long budget);
+    long long getTexUploadBudget() const;
+    void endFrame();
+    long long getLastFrameUploadBytes() const;
+    int getNumDeferredUploads() const;
+    long long getDeferredUploadBytes() const;
+    long long getNumPartialUploads() const;
+
     static bool isGLESSupported();
 
 private:
     std::vector<GLContext*> m_pContexts;
 
+    struct TexUpload {
+        BitmapPtr m_pBmp;
+        TexUploadPriority m_Priority;
+        long long m_SeqNum;
+        // Part of the bitmap to upload. Bounding rect of m_SubRects.
+        IntRect m_Rect;
+        std::vector<IntRect> m_SubRects;
+        // Number of lines of m_Rect that have been uploaded already.
+        int m_NumRowsDone;
+        // Set when the rest of the bitmap is uploaded in the current round.
+        bool m_bComplete;
+    };
+    // A part of an upload that is done in the current round.
+    struct TexUploadSlice {
+        MCTexturePtr m_pTex;
+        BitmapPtr m_pBmp;
+        IntRect m_Rect;
+    };
+
     std::vector<MCTexturePtr> m_pPendingTexCreates;
-    typedef std::map<MCTexturePtr, BitmapPtr> TexUploadMap;
-    TexUploadMap m_pPendingTexUploads;
+    typedef std::map<MCTexturePtr, TexUpload> TexUploadMap;
+
+    void selectTexUploads();
+    void addTexUploadSlice(TexUploadMap::iterator it, int numRows);
+    void finishTexUploads();
+
+    TexUploadMap m_PendingTexUploads;
+    // Uploads done in the current round, identical for all contexts.
+    std::vector<TexUploadSlice> m_TexUploadSlices;
+    bool m_bTexUploadsSelected;
+    long long m_NextUploadSeqNum;
     std::vector<unsigned> m_PendingTexDeletes;
 
+    long long m_TexUploadBudget;
+    long long m_FrameUploadBytes;
+    long long m_FrameDeferrableBytes;
+    long long m_LastFrameUploadBytes;
+    long long m_NumPartialUploads;
+
     std::vector<MCFBOPtr> m_pPendingFBOCreates;
     std::vector<MCShaderParamPtr> m_pPendingShaderParamCreates;
 
@@ -29,6 +29,7 @@
 #include "GLContext.h"
 #include "GLContextManager.h"
 #include "TextureMover.h"
+#include "BmpTextureMover.h"
 
 #include <string.h>
 #include <iostream>
@@ -138,6 +139,13 @@ void GLTexture::moveBmpToTexture(BitmapPtr pBmp)
     pMover->moveBmpToTexture(pBmp, *this);
 }
 
+void GLTexture::moveBmpRectToTexture(BitmapPtr pBmp, const IntRect& rect)
+{
+    // PBOs always transfer the complete bitmap, so this doesn't use them.
+    BmpTextureMover mover(getSize(), getPF());
+    mover.moveBmpRectToTexture(pBmp, *this, rect);
+}
+
 BitmapPtr GLTexture::moveTextureToBmp(int mipmapLevel)
 {
     TextureMoverPtr pMover = TextureMover::create(getGLSize(), getPF(), GL_DYNAMIC_READ);
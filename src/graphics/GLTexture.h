@@ -48,6 +48,9 @@ public:
     void generateMipmaps();
 
     void moveBmpToTexture(BitmapPtr pBmp);
+    // Partial upload, used to spread the upload of large bitmaps over several frames
+    // and to upload changed parts of a bitmap.
+    void moveBmpRectToTexture(BitmapPtr pBmp, const IntRect& rect);
     BitmapPtr moveTextureToBmp(int mipmapLevel=0);
 
     unsigned getID() const;
@@ -26,6 +26,8 @@
 #include "../base/ConfigMgr.h"
 #include "../base/Logger.h"
 
+#include <vector>
+
 using namespace std;
 
 namespace avg {
@@ -47,8 +49,14 @@ ImageCache* ImageCache::get()
 
 ImageCache::ImageCache()
     : m_CPUCacheUsed(0),
-      m_GPUCacheUsed(0)
+      m_GPUCacheUsed(0),
+      m_ExternalMemUsed(0)
 {
+    for (int i = 0; i < 2; ++i) {
+        m_NumHits[i] = 0;
+        m_NumMisses[i] = 0;
+        m_NumEvictions[i] = 0;
+    }
     glm::vec2 sizeOpt = ConfigMgr::get()->getSizeOption("scr", "imgcachesize");
     if (sizeOpt[0] == -1) {
         m_CPUCacheCapacity = (long long)(getPhysMemorySize())/4;
@@ -60,9 +68,16 @@ ImageCache::ImageCache()
     } else {
         m_GPUCacheCapacity = (long long)(sizeOpt[1])*1024*1024;
     }
+    string sPolicy;
+    ConfigMgr::get()->getStringOption("scr", "imgcachepolicy", "lru", sPolicy);
+    setPolicy(sPolicy);
     AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
             "Image cache size: CPU=" << m_CPUCacheCapacity/(1024*1024) <<
-            "MB, GPU=" << m_GPUCacheCapacity/(1024*1024) << "MB" << endl);
+            "MB, GPU=" << m_GPUCacheCapacity/(1024*1024) << "MB, policy: " << sPolicy
+            << endl);
+    string sDiskCacheDir;
+    ConfigMgr::get()->getStringOption("scr", "imgdiskcachedir", "", sDiskCacheDir);
+    setDiskCacheDir(sDiskCacheDir);
 }
 
 ImageCache::~ImageCache()
@@ -94,53 +109,85 @@ long long ImageCache::getMemUsed(CachedImage::StorageType st)
     }
 }
 
+long long ImageCache::getMemEvictable(CachedImage::StorageType st) const
+{
+    long long memEvictable = 0;
+    const EvictionQueue& queue = m_EvictionQueues[st];
+    for (EvictionQueue::const_iterator it = queue.begin(); it != queue.end(); ++it) {
+        memEvictable += it->second->m_pImg->getMemUsed(st);
+    }
+    return memEvictable;
+}
+
 CachedImagePtr ImageCache::getImage(const std::string& sFilename,
-        TexCompression compression)
+        TexCompression compression, const IntPoint& decodeSize, const IntRect& srcRect)
 {
-    ImageMap::iterator it = m_pImageMap.find(sFilename);
+    string sKey = CachedImage::getKey(sFilename, compression, decodeSize, srcRect);
+    ImageMap::iterator it = m_ImageMap.find(sKey);
     CachedImagePtr pImg;
-    if (it == m_pImageMap.end()) {
-        pImg = CachedImagePtr(new CachedImage(sFilename, compression));
-        m_pLRUList.push_front(pImg);
-        m_pImageMap.insert(make_pair(sFilename, m_pLRUList.begin()));
-        m_CPUCacheUsed += pImg->getMemUsed(CachedImage::STORAGE_CPU);
-        checkCPUUnload();
+    if (it == m_ImageMap.end()) {
+        m_NumMisses[CachedImage::STORAGE_CPU]++;
+        pImg = CachedImagePtr(new CachedImage(sFilename, compression, decodeSize,
+                srcRect));
+        insertImage(pImg);
     } else {
-        pImg = *(it->second);
-        pImg->incBmpRef(compression);
-        // Move item to front of list
-        m_pLRUList.splice(m_pLRUList.begin(), m_pLRUList, it->second);
+        m_NumHits[CachedImage::STORAGE_CPU]++;
+        pImg = useImage(it->second);
     }
     assertValid();
     return pImg;
 }
 
-void ImageCache::onTexLoad(const std::string& sFilename)
+bool ImageCache::hasImage(const std::string& sFilename, TexCompression compression,
+        const IntPoint& decodeSize, const IntRect& srcRect) const
 {
-    CachedImagePtr pImg = *(m_pImageMap[sFilename]);
-    m_GPUCacheUsed += pImg->getMemUsed(CachedImage::STORAGE_GPU);
-    ImageMap::iterator it = m_pImageMap.find(sFilename);
-    // Move item to front of list
-    if (it != m_pImageMap.end()) {
-        m_pLRUList.splice(m_pLRUList.begin(), m_pLRUList, it->second);
+    string sKey = CachedImage::getKey(sFilename, compression, decodeSize, srcRect);
+    return m_ImageMap.find(sKey) != m_ImageMap.end();
+}
+
+CachedImagePtr ImageCache::addImage(const std::string& sFilename,
+        TexCompression compression, const IntPoint& decodeSize, const IntRect& srcRect,
+        BitmapPtr pBmp)
+{
+    string sKey = CachedImage::getKey(sFilename, compression, decodeSize, srcRect);
+    ImageMap::iterator it = m_ImageMap.find(sKey);
+    CachedImagePtr pImg;
+    if (it == m_ImageMap.end()) {
+        m_NumMisses[CachedImage::STORAGE_CPU]++;
+        pImg = CachedImagePtr(new CachedImage(sFilename, compression, decodeSize,
+                srcRect, pBmp));
+        insertImage(pImg);
+    } else {
+        m_NumHits[CachedImage::STORAGE_CPU]++;
+        pImg = useImage(it->second);
     }
+    assertValid();
+    return pImg;
+}
+
+void ImageCache::onTexLoad(const std::string& sKey)
+{
+    CacheEntry& entry = getEntry(sKey);
+    m_GPUCacheUsed += entry.m_pImg->getMemUsed(CachedImage::STORAGE_GPU);
+    m_NumMisses[CachedImage::STORAGE_GPU]++;
+    entry.m_NumAccesses[CachedImage::STORAGE_GPU]++;
     checkGPUUnload();
 }
 
-void ImageCache::onImageUnused(const std::string& sFilename, CachedImage::StorageType st)
+void ImageCache::onTexUse(const std::string& sKey)
 {
-    // Move image to first pos with use count == 0
-    // This is currently O(n). If that becomes an issue, we need to remember the first
-    // unused image for both CPU and GPU.
-    LRUListType::iterator itOldPos = m_pImageMap.find(sFilename)->second;
-    LRUListType::iterator itNewPos = itOldPos;
-    itNewPos++;
-    while (itNewPos != m_pLRUList.end() &&
-            (*itNewPos)->getRefCount(st) != 0)
-    {
-        itNewPos++;
+    CacheEntry& entry = getEntry(sKey);
+    m_NumHits[CachedImage::STORAGE_GPU]++;
+    entry.m_NumAccesses[CachedImage::STORAGE_GPU]++;
+    removeFromEvictionQueue(entry, CachedImage::STORAGE_GPU);
+}
+
+void ImageCache::onImageUnused(const std::string& sKey, CachedImage::StorageType st)
+{
+    CacheEntry& entry = getEntry(sKey);
+    if (st == CachedImage::STORAGE_CPU || entry.m_pImg->hasTex()) {
+        addToEvictionQueue(entry, st);
     }
-    m_pLRUList.splice(itNewPos, m_pLRUList, itOldPos);
     checkCPUUnload();
 }
 
@@ -154,28 +201,146 @@ void ImageCache::onSizeChange(int sizeDiff, CachedImage::StorageType st)
     assertValid();
 }
 
+void ImageCache::addExternalMemUsed(long long memDiff)
+{
+    m_ExternalMemUsed += memDiff;
+    AVG_ASSERT(m_ExternalMemUsed >= 0);
+    checkCPUUnload();
+}
+
+long long ImageCache::getExternalMemUsed() const
+{
+    return m_ExternalMemUsed;
+}
+
 int ImageCache::getNumCPUImages() const
 {
-    return m_pImageMap.size();
+    return m_ImageMap.size();
 }
 
 int ImageCache::getNumGPUImages() const
 {
     int numGPUImages = 0;
-    for (LRUListType::const_iterator it=m_pLRUList.begin(); it!=m_pLRUList.end(); ++it) {
-        if ((*it)->hasTex()) {
+    for (ImageMap::const_iterator it=m_ImageMap.begin(); it!=m_ImageMap.end(); ++it) {
+        if (it->second.m_pImg->hasTex()) {
             numGPUImages++;
         }
     }
     return numGPUImages;
 }
 
+void ImageCache::setDiskCacheDir(const std::string& sDir)
+{
+    if (sDir == "") {
+        m_pDiskCache = ImageDiskCachePtr();
+    } else if (!m_pDiskCache || m_pDiskCache->getDir() != sDir) {
+        m_pDiskCache = ImageDiskCachePtr(new ImageDiskCache(sDir));
+    }
+}
+
+std::string ImageCache::getDiskCacheDir() const
+{
+    if (m_pDiskCache) {
+        return m_pDiskCache->getDir();
+    } else {
+        return "";
+    }
+}
+
+ImageDiskCachePtr ImageCache::getDiskCache() const
+{
+    return m_pDiskCache;
+}
+
+void ImageCache::setPolicy(const std::string& sName)
+{
+    ImageCachePolicyPtr pCPUPolicy = ImageCachePolicy::create(sName);
+    m_pPolicies[CachedImage::STORAGE_CPU] = pCPUPolicy;
+    m_pPolicies[CachedImage::STORAGE_GPU] = ImageCachePolicy::create(sName);
+    // Re-add the unused images in their current order so the new policy can assign
+    // priorities.
+    for (int i = 0; i < 2; ++i) {
+        CachedImage::StorageType st = CachedImage::StorageType(i);
+        vector<CacheEntry*> entries;
+        EvictionQueue::iterator it;
+        for (it = m_EvictionQueues[st].begin(); it != m_EvictionQueues[st].end(); ++it) {
+            entries.push_back(it->second);
+        }
+        for (unsigned j = 0; j < entries.size(); ++j) {
+            removeFromEvictionQueue(*entries[j], st);
+            addToEvictionQueue(*entries[j], st);
+        }
+    }
+}
+
+std::string ImageCache::getPolicy() const
+{
+    return m_pPolicies[CachedImage::STORAGE_CPU]->getName();
+}
+
+void ImageCache::pinImage(const std::string& sFilename, TexCompression compression,
+        const IntPoint& decodeSize, const IntRect& srcRect)
+{
+    string sKey = CachedImage::getKey(sFilename, compression, decodeSize, srcRect);
+    m_PinnedKeys.insert(sKey);
+    ImageMap::iterator it = m_ImageMap.find(sKey);
+    if (it != m_ImageMap.end()) {
+        CacheEntry& entry = it->second;
+        entry.m_bPinned = true;
+        removeFromEvictionQueue(entry, CachedImage::STORAGE_CPU);
+        removeFromEvictionQueue(entry, CachedImage::STORAGE_GPU);
+    }
+}
+
+void ImageCache::unpinImage(const std::string& sFilename, TexCompression compression,
+        const IntPoint& decodeSize, const IntRect& srcRect)
+{
+    string sKey = CachedImage::getKey(sFilename, compression, decodeSize, srcRect);
+    m_PinnedKeys.erase(sKey);
+    ImageMap::iterator it = m_ImageMap.find(sKey);
+    if (it != m_ImageMap.end()) {
+        CacheEntry& entry = it->second;
+        entry.m_bPinned = false;
+        CachedImagePtr pImg = entry.m_pImg;
+        if (pImg->getRefCount(CachedImage::STORAGE_CPU) == 0) {
+            addToEvictionQueue(entry, CachedImage::STORAGE_CPU);
+        }
+        if (pImg->getRefCount(CachedImage::STORAGE_GPU) == 0 && pImg->hasTex()) {
+            addToEvictionQueue(entry, CachedImage::STORAGE_GPU);
+        }
+        checkCPUUnload();
+    }
+}
+
+bool ImageCache::isPinned(const std::string& sFilename, TexCompression compression,
+        const IntPoint& decodeSize, const IntRect& srcRect) const
+{
+    string sKey = CachedImage::getKey(sFilename, compression, decodeSize, srcRect);
+    return m_PinnedKeys.find(sKey) != m_PinnedKeys.end();
+}
+
+long long ImageCache::getNumHits(CachedImage::StorageType st) const
+{
+    return m_NumHits[st];
+}
+
+long long ImageCache::getNumMisses(CachedImage::StorageType st) const
+{
+    return m_NumMisses[st];
+}
+
+long long ImageCache::getNumEvictions(CachedImage::StorageType st) const
+{
+    return m_NumEvictions[st];
+}
+
 void ImageCache::unloadAllTextures()
 {
-    for (LRUListType::const_iterator it=m_pLRUList.begin(); it!=m_pLRUList.end(); ++it) {
-        CachedImagePtr pImg = *it;
+    for (ImageMap::iterator it=m_ImageMap.begin(); it!=m_ImageMap.end(); ++it) {
+        CachedImagePtr pImg = it->second.m_pImg;
         AVG_ASSERT(pImg->getRefCount(CachedImage::STORAGE_GPU) == 0);
         if (pImg->hasTex()) {
+            removeFromEvictionQueue(it->second, CachedImage::STORAGE_GPU);
             m_GPUCacheUsed -= pImg->getMemUsed(CachedImage::STORAGE_GPU);
             pImg->unloadTex();
         }
@@ -185,26 +350,81 @@ void ImageCache::unloadAllTextures()
 void ImageCache::dump() const
 {
     cerr << "----------------" << endl;
-    cerr << "ImageCache: " << m_pLRUList.size() << ", CPU used: " << m_CPUCacheUsed <<
-            ", GPU used: " << m_GPUCacheUsed << endl;
-    for (LRUListType::const_iterator it=m_pLRUList.begin(); it!=m_pLRUList.end(); ++it) {
-        (*it)->dump();
+    cerr << "ImageCache: " << m_ImageMap.size() << ", CPU used: " << m_CPUCacheUsed <<
+            ", GPU used: " << m_GPUCacheUsed << ", policy: " << getPolicy() << endl;
+    for (ImageMap::const_iterator it=m_ImageMap.begin(); it!=m_ImageMap.end(); ++it) {
+        it->second.m_pImg->dump();
+    }
+}
+
+void ImageCache::insertImage(CachedImagePtr pImg)
+{
+    string sKey = pImg->getKey();
+    CacheEntry& entry = m_ImageMap[sKey];
+    entry.m_pImg = pImg;
+    entry.m_bPinned = m_PinnedKeys.find(sKey) != m_PinnedKeys.end();
+    entry.m_NumAccesses[CachedImage::STORAGE_CPU] = 1;
+    entry.m_NumAccesses[CachedImage::STORAGE_GPU] = 0;
+    entry.m_bEvictable[CachedImage::STORAGE_CPU] = false;
+    entry.m_bEvictable[CachedImage::STORAGE_GPU] = false;
+    m_CPUCacheUsed += pImg->getMemUsed(CachedImage::STORAGE_CPU);
+    checkCPUUnload();
+}
+
+CachedImagePtr ImageCache::useImage(CacheEntry& entry)
+{
+    CachedImagePtr pImg = entry.m_pImg;
+    pImg->incBmpRef();
+    entry.m_NumAccesses[CachedImage::STORAGE_CPU]++;
+    removeFromEvictionQueue(entry, CachedImage::STORAGE_CPU);
+    return pImg;
+}
+
+ImageCache::CacheEntry& ImageCache::getEntry(const std::string& sKey)
+{
+    ImageMap::iterator it = m_ImageMap.find(sKey);
+    AVG_ASSERT(it != m_ImageMap.end());
+    return it->second;
+}
+
+void ImageCache::addToEvictionQueue(CacheEntry& entry, CachedImage::StorageType st)
+{
+    if (entry.m_bPinned || entry.m_bEvictable[st]) {
+        return;
+    }
+    double priority = m_pPolicies[st]->getPriority(entry.m_NumAccesses[st],
+            entry.m_pImg->getMemUsed(st));
+    entry.m_EvictionIt[st] = m_EvictionQueues[st].insert(make_pair(priority, &entry));
+    entry.m_bEvictable[st] = true;
+}
+
+void ImageCache::removeFromEvictionQueue(CacheEntry& entry, CachedImage::StorageType st)
+{
+    if (entry.m_bEvictable[st]) {
+        m_EvictionQueues[st].erase(entry.m_EvictionIt[st]);
+        entry.m_bEvictable[st] = false;
     }
 }
 
 void ImageCache::checkCPUUnload()
 {
-    while (m_CPUCacheUsed > m_CPUCacheCapacity) {
-        CachedImagePtr pImg = *(m_pLRUList.rbegin());
-        if (pImg->getRefCount(CachedImage::STORAGE_CPU) == 0) {
-            m_pImageMap.erase(pImg->getFilename());
-            m_pLRUList.pop_back();
-            m_CPUCacheUsed -= pImg->getMemUsed(CachedImage::STORAGE_CPU);
+    EvictionQueue& queue = m_EvictionQueues[CachedImage::STORAGE_CPU];
+    while (m_CPUCacheUsed > 0 && m_CPUCacheUsed+m_ExternalMemUsed > m_CPUCacheCapacity
+            && !queue.empty())
+    {
+        m_pPolicies[CachedImage::STORAGE_CPU]->onEvict(queue.begin()->first);
+        CacheEntry& entry = *(queue.begin()->second);
+        CachedImagePtr pImg = entry.m_pImg;
+        AVG_ASSERT(pImg->getRefCount(CachedImage::STORAGE_CPU) == 0);
+        removeFromEvictionQueue(entry, CachedImage::STORAGE_CPU);
+        removeFromEvictionQueue(entry, CachedImage::STORAGE_GPU);
+        m_CPUCacheUsed -= pImg->getMemUsed(CachedImage::STORAGE_CPU);
+        m_NumEvictions[CachedImage::STORAGE_CPU]++;
+        if (pImg->hasTex()) {
             m_GPUCacheUsed -= pImg->getMemUsed(CachedImage::STORAGE_GPU);
-        } else {
-            // Cache full, but everything's in use.
-            break;
+            m_NumEvictions[CachedImage::STORAGE_GPU]++;
         }
+        m_ImageMap.erase(pImg->getKey());
     }
     assertValid();
     checkGPUUnload();
@@ -212,28 +432,16 @@ void ImageCache::checkCPUUnload()
 
 void ImageCache::checkGPUUnload()
 {
-    if (m_GPUCacheUsed > m_GPUCacheCapacity) {
-        LRUListType::reverse_iterator it = m_pLRUList.rbegin();
-        // Find first item that actually has a texture loaded.
-        while (it != m_pLRUList.rend() && !((*it)->hasTex())) {
-            it++;
-        }
-        if (it != m_pLRUList.rend()) {
-            while (m_GPUCacheUsed > m_GPUCacheCapacity) {
-                assertValid();
-                CachedImagePtr pImg = *it;
-                if (pImg->getRefCount(CachedImage::STORAGE_GPU) == 0) {
-                    if (pImg->hasTex()) {
-                        m_GPUCacheUsed -= pImg->getMemUsed(CachedImage::STORAGE_GPU);
-                        pImg->unloadTex();
-                    }
-                    ++it;
-                } else {
-                    // Cache full, but everything's in use.
-                    break;
-                }
-            }
-        }
+    EvictionQueue& queue = m_EvictionQueues[CachedImage::STORAGE_GPU];
+    while (m_GPUCacheUsed > m_GPUCacheCapacity && !queue.empty()) {
+        m_pPolicies[CachedImage::STORAGE_GPU]->onEvict(queue.begin()->first);
+        CacheEntry& entry = *(queue.begin()->second);
+        CachedImagePtr pImg = entry.m_pImg;
+        AVG_ASSERT(pImg->getRefCount(CachedImage::STORAGE_GPU) == 0);
+        removeFromEvictionQueue(entry, CachedImage::STORAGE_GPU);
+        m_GPUCacheUsed -= pImg->getMemUsed(CachedImage::STORAGE_GPU);
+        m_NumEvictions[CachedImage::STORAGE_GPU]++;
+        pImg->unloadTex();
     }
     assertValid();
 }
@@ -241,17 +449,17 @@ void ImageCache::checkGPUUnload()
 void ImageCache::assertValid()
 {
     if (m_CPUCacheUsed == 0) {
-        AVG_ASSERT(m_pLRUList.size() == 0);
-        AVG_ASSERT(m_pImageMap.size() == 0);
+        AVG_ASSERT(m_ImageMap.size() == 0);
     }
-    if (m_pLRUList.size() == 0) {
+    if (m_ImageMap.size() == 0) {
         AVG_ASSERT(m_CPUCacheUsed == 0);
         AVG_ASSERT(m_GPUCacheUsed == 0);
     }
     if (getNumGPUImages() == 0) {
         AVG_ASSERT(m_GPUCacheUsed == 0);
     }
-    AVG_ASSERT(m_pLRUList.size() == m_pImageMap.size());
+    AVG_ASSERT(m_EvictionQueues[CachedImage::STORAGE_CPU].size() <= m_ImageMap.size());
+    AVG_ASSERT(m_EvictionQueues[CachedImage::STORAGE_GPU].size() <= m_ImageMap.size());
 }
 
 }
@@ -27,11 +27,14 @@
 #include "../base/GLMHelper.h"
 
 #include "CachedImage.h"
+#include "ImageCachePolicy.h"
+#include "ImageDiskCache.h"
 #include "TexInfo.h"
 
 #include <boost/shared_ptr.hpp>
 #include <string>
-#include <list>
+#include <map>
+#include <set>
 
 #ifdef _WIN32
 #include <unordered_map>
@@ -53,14 +56,64 @@ class AVG_API ImageCache
         void setCapacity(long long cpuCapacity, long long gpuCapacity);
         long long getCapacity(CachedImage::StorageType st);
         long long getMemUsed(CachedImage::StorageType st);
+        // Memory used by unused, unpinned images, i.e. memory that can be freed by
+        // evicting images if it is needed elsewhere.
+        long long getMemEvictable(CachedImage::StorageType st) const;
+        // Different compressions, decode sizes and source rectangles of the same file
+        // are cached independently.
         CachedImagePtr getImage(const std::string& sFilename,
-                TexCompression compression);
-        void onTexLoad(const std::string& sFilename);
-        void onImageUnused(const std::string& sFilename, CachedImage::StorageType st);
+                TexCompression compression, const IntPoint& decodeSize=IntPoint(0,0),
+                const IntRect& srcRect=IntRect(0,0,0,0));
+        // Used for asynchronous loading: If the image isn't cached yet, the bitmap
+        // is loaded in the background using CachedImage::decodeBmp() and added using
+        // addImage(). addImage() returns the cached image if the same variant has been
+        // loaded in the meantime.
+        bool hasImage(const std::string& sFilename, TexCompression compression,
+                const IntPoint& decodeSize=IntPoint(0,0),
+                const IntRect& srcRect=IntRect(0,0,0,0)) const;
+        CachedImagePtr addImage(const std::string& sFilename,
+                TexCompression compression, const IntPoint& decodeSize,
+                const IntRect& srcRect, BitmapPtr pBmp);
+        void onTexLoad(const std::string& sKey);
+        // Called when an unused image that still has a texture is used again.
+        void onTexUse(const std::string& sKey);
+        void onImageUnused(const std::string& sKey, CachedImage::StorageType st);
         void onSizeChange(int sizeDiff, CachedImage::StorageType st);
+        // Memory used by other caches that share the CPU budget (e.g. preloaded
+        // video clips). Unused images are unloaded to make room for it.
+        void addExternalMemUsed(long long memDiff);
+        long long getExternalMemUsed() const;
         int getNumCPUImages() const;
         int getNumGPUImages() const;
 
+        // An empty directory name disables the disk cache.
+        void setDiskCacheDir(const std::string& sDir);
+        std::string getDiskCacheDir() const;
+        ImageDiskCachePtr getDiskCache() const;
+
+        // See ImageCachePolicy::create() for valid policy names. The same policy is
+        // used for CPU and GPU memory.
+        void setPolicy(const std::string& sName);
+        std::string getPolicy() const;
+
+        // Pinned images are never evicted. Images can be pinned before they are
+        // loaded.
+        void pinImage(const std::string& sFilename, TexCompression compression,
+                const IntPoint& decodeSize=IntPoint(0,0),
+                const IntRect& srcRect=IntRect(0,0,0,0));
+        void unpinImage(const std::string& sFilename, TexCompression compression,
+                const IntPoint& decodeSize=IntPoint(0,0),
+                const IntRect& srcRect=IntRect(0,0,0,0));
+        bool isPinned(const std::string& sFilename, TexCompression compression,
+                const IntPoint& decodeSize=IntPoint(0,0),
+                const IntRect& srcRect=IntRect(0,0,0,0)) const;
+
+        // CPU hits and misses are counted for every image request, GPU hits and
+        // misses whenever an unused image gets a texture reference.
+        long long getNumHits(CachedImage::StorageType st) const;
+        long long getNumMisses(CachedImage::StorageType st) const;
+        long long getNumEvictions(CachedImage::StorageType st) const;
+
         void unloadAllTextures();
         void dump() const;
 
@@ -71,24 +124,45 @@ class AVG_API ImageCache
 
         void assertValid();
 
-        typedef std::list<CachedImagePtr> LRUListType;
-        // This is a list of all loaded images in three partitions:
-        // 1) Images that have both CPU and GPU refcounts > 0
-        // 2) Images that have only CPU refcount > 0
-        // 3) Images that are unused but cached.
-        // The third partition is sorted by LRU.
-        LRUListType m_pLRUList;
+        struct CacheEntry;
+        // Unused images that can be evicted, sorted by eviction priority. Images with
+        // the same priority are evicted in the order they were added.
+        typedef std::multimap<double, CacheEntry*> EvictionQueue;
+        struct CacheEntry {
+            CachedImagePtr m_pImg;
+            bool m_bPinned;
+            int m_NumAccesses[2];
+            bool m_bEvictable[2];
+            EvictionQueue::iterator m_EvictionIt[2];
+        };
 #ifdef __APPLE__
-        typedef boost::unordered_map<std::string, LRUListType::iterator> ImageMap;
+        typedef boost::unordered_map<std::string, CacheEntry> ImageMap;
 #else
-        typedef std::tr1::unordered_map<std::string, LRUListType::iterator> ImageMap;
+        typedef std::tr1::unordered_map<std::string, CacheEntry> ImageMap;
 #endif
-        ImageMap m_pImageMap;
+        ImageMap m_ImageMap;
+        // Indexed by CachedImage::StorageType.
+        EvictionQueue m_EvictionQueues[2];
+        ImageCachePolicyPtr m_pPolicies[2];
+        std::set<std::string> m_PinnedKeys;
+
+        void insertImage(CachedImagePtr pImg);
+        CachedImagePtr useImage(CacheEntry& entry);
+        CacheEntry& getEntry(const std::string& sKey);
+        void addToEvictionQueue(CacheEntry& entry, CachedImage::StorageType st);
+        void removeFromEvictionQueue(CacheEntry& entry, CachedImage::StorageType st);
+
+        long long m_NumHits[2];
+        long long m_NumMisses[2];
+        long long m_NumEvictions[2];
 
         long long m_CPUCacheCapacity;
         long long m_GPUCacheCapacity;
         long long m_CPUCacheUsed;
         long long m_GPUCacheUsed;
+        long long m_ExternalMemUsed;
+
+        ImageDiskCachePtr m_pDiskCache;
 
         static ImageCache * s_pImageCache;
 };
@@ -0,0 +1,116 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "ImageCachePolicy.h"
+
+#include "../base/Exception.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+ImageCachePolicyPtr ImageCachePolicy::create(const std::string& sName)
+{
+    if (sName == "lru") {
+        return ImageCachePolicyPtr(new LRUImageCachePolicy());
+    } else if (sName == "lfu") {
+        return ImageCachePolicyPtr(new LFUImageCachePolicy());
+    } else if (sName == "greedydual") {
+        return ImageCachePolicyPtr(new GreedyDualImageCachePolicy());
+    } else {
+        throw Exception(AVG_ERR_UNSUPPORTED, "Image cache policy '" + sName +
+                "' not supported. Valid policies are 'lru', 'lfu' and 'greedydual'.");
+    }
+}
+
+ImageCachePolicy::~ImageCachePolicy()
+{
+}
+
+void ImageCachePolicy::onEvict(double priority)
+{
+}
+
+
+LRUImageCachePolicy::LRUImageCachePolicy()
+    : m_Clock(0)
+{
+}
+
+std::string LRUImageCachePolicy::getName() const
+{
+    return "lru";
+}
+
+double LRUImageCachePolicy::getPriority(int numAccesses, long long memUsed)
+{
+    m_Clock += 1;
+    return m_Clock;
+}
+
+
+LFUImageCachePolicy::LFUImageCachePolicy()
+    : m_Age(0)
+{
+}
+
+std::string LFUImageCachePolicy::getName() const
+{
+    return "lfu";
+}
+
+double LFUImageCachePolicy::getPriority(int numAccesses, long long memUsed)
+{
+    return m_Age + numAccesses;
+}
+
+void LFUImageCachePolicy::onEvict(double priority)
+{
+    m_Age = max(m_Age, priority);
+}
+
+
+GreedyDualImageCachePolicy::GreedyDualImageCachePolicy()
+    : m_Age(0)
+{
+}
+
+std::string GreedyDualImageCachePolicy::getName() const
+{
+    return "greedydual";
+}
+
+double GreedyDualImageCachePolicy::getPriority(int numAccesses, long long memUsed)
+{
+    // Sizes are measured in kilobytes to keep the priorities in a sensible range.
+    double size = max(1.0, double(memUsed)/1024);
+    return m_Age + numAccesses/size;
+}
+
+void GreedyDualImageCachePolicy::onEvict(double priority)
+{
+    m_Age = max(m_Age, priority);
+}
+
+}
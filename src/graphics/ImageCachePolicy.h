@@ -0,0 +1,100 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _ImageCachePolicy_H_
+#define _ImageCachePolicy_H_
+
+#include "../api.h"
+
+#include <boost/shared_ptr.hpp>
+#include <string>
+
+namespace avg {
+
+class ImageCachePolicy;
+typedef boost::shared_ptr<ImageCachePolicy> ImageCachePolicyPtr;
+
+// Decides which unused image the ImageCache evicts next. Every time an image becomes
+// unused, it gets a priority from the policy; the unused image with the lowest
+// priority is evicted first. CPU and GPU memory each have their own policy object.
+class AVG_API ImageCachePolicy
+{
+public:
+    // Valid names are "lru", "lfu" and "greedydual".
+    static ImageCachePolicyPtr create(const std::string& sName);
+    virtual ~ImageCachePolicy();
+
+    virtual std::string getName() const = 0;
+    // numAccesses is the number of times the image has been requested since it was
+    // loaded, memUsed the number of bytes it occupies.
+    virtual double getPriority(int numAccesses, long long memUsed) = 0;
+    virtual void onEvict(double priority);
+};
+
+// Least recently used: Images are evicted in the order in which they became unused.
+class AVG_API LRUImageCachePolicy: public ImageCachePolicy
+{
+public:
+    LRUImageCachePolicy();
+
+    virtual std::string getName() const;
+    virtual double getPriority(int numAccesses, long long memUsed);
+
+private:
+    double m_Clock;
+};
+
+// Least frequently used with dynamic aging: The priority is the access count plus the
+// priority of the last evicted image, so images that were used often a long time ago
+// eventually become evictable.
+class AVG_API LFUImageCachePolicy: public ImageCachePolicy
+{
+public:
+    LFUImageCachePolicy();
+
+    virtual std::string getName() const;
+    virtual double getPriority(int numAccesses, long long memUsed);
+    virtual void onEvict(double priority);
+
+private:
+    double m_Age;
+};
+
+// GreedyDual-Size with frequency: Like LFU with aging, but the access count is divided
+// by the size of the image, so large images are evicted before small ones that are
+// used equally often.
+class AVG_API GreedyDualImageCachePolicy: public ImageCachePolicy
+{
+public:
+    GreedyDualImageCachePolicy();
+
+    virtual std::string getName() const;
+    virtual double getPriority(int numAccesses, long long memUsed);
+    virtual void onEvict(double priority);
+
+private:
+    double m_Age;
+};
+
+}
+
+#endif
@@ -0,0 +1,279 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ImageDiskCache.h"
+
+#include "../base/Directory.h"
+#include "../base/Logger.h"
+#include "../base/ScopeTimer.h"
+#include "../base/ThreadHelper.h"
+
+#include "Bitmap.h"
+#include "BitmapLoader.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+namespace avg {
+
+static ProfilingZoneID DiskCacheLoadProfilingZone("ImageDiskCache load", true);
+static ProfilingZoneID DiskCacheSaveProfilingZone("ImageDiskCache save", true);
+
+// Bump whenever the file layout changes; old entries are then simply ignored.
+static const unsigned CACHE_MAGIC = 0x43444741;   // "AGDC"
+static const unsigned CACHE_VERSION = 1;
+
+namespace {
+
+struct CacheFileHeader {
+    unsigned m_Magic;
+    unsigned m_Version;
+    int m_PixelFormat;
+    int m_Width;
+    int m_Height;
+    int m_Stride;
+    int m_Compression;
+    int m_bBlueFirst;
+    long long m_SrcMTime;
+    long long m_SrcSize;
+    int m_KeyLen;
+};
+
+bool getSourceFileInfo(const string& sFilename, long long& mtime, long long& size)
+{
+    struct stat fileStat;
+    if (stat(sFilename.c_str(), &fileStat) != 0) {
+        return false;
+    }
+    mtime = (long long)fileStat.st_mtime;
+    size = (long long)fileStat.st_size;
+    return true;
+}
+
+unsigned long long fnv1aHash(const string& s, unsigned long long hash)
+{
+    for (unsigned i = 0; i < s.length(); ++i) {
+        hash ^= (unsigned char)(s[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+}
+
+ImageDiskCache::ImageDiskCache(const string& sDir)
+    : m_sDir(sDir),
+      m_NumHits(0),
+      m_NumMisses(0)
+{
+    Directory dir(m_sDir);
+    if (dir.open(true) != 0) {
+        AVG_LOG_WARNING("Could not open image disk cache directory '" << m_sDir <<
+                "'. Decoded images will not be cached on disk.");
+    } else {
+        AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
+                "Image disk cache directory: " << m_sDir);
+    }
+}
+
+ImageDiskCache::~ImageDiskCache()
+{
+}
+
+const string& ImageDiskCache::getDir() const
+{
+    return m_sDir;
+}
+
+BitmapPtr ImageDiskCache::load(const string& sFilename, const string& sKey,
+        TexCompression compression)
+{
+    ScopeTimer timer(DiskCacheLoadProfilingZone);
+    long long srcMTime;
+    long long srcSize;
+    if (!getSourceFileInfo(sFilename, srcMTime, srcSize)) {
+        countLookup(false);
+        return BitmapPtr();
+    }
+    string sCacheFilename = getCacheFilename(sKey, compression);
+    FILE* pFile = fopen(sCacheFilename.c_str(), "rb");
+    if (!pFile) {
+        countLookup(false);
+        return BitmapPtr();
+    }
+
+    BitmapPtr pBmp;
+    CacheFileHeader header;
+    bool bOk = (fread(&header, sizeof(header), 1, pFile) == 1);
+    bOk = bOk && header.m_Magic == CACHE_MAGIC && header.m_Version == CACHE_VERSION
+            && header.m_Compression == int(compression)
+            && header.m_bBlueFirst == int(BitmapLoader::get()->isBlueFirst())
+            && header.m_SrcMTime == srcMTime && header.m_SrcSize == srcSize
+            && header.m_KeyLen == int(sKey.length())
+            && header.m_PixelFormat >= 0 && header.m_PixelFormat < NO_PIXELFORMAT
+            && header.m_Width > 0 && header.m_Height > 0;
+    if (bOk) {
+        // Guards against hash collisions.
+        string sStoredKey(header.m_KeyLen, ' ');
+        bOk = fread(&sStoredKey[0], header.m_KeyLen, 1, pFile) == 1 &&
+                sStoredKey == sKey;
+    }
+    if (bOk) {
+        IntPoint size(header.m_Width, header.m_Height);
+        PixelFormat pf = PixelFormat(header.m_PixelFormat);
+        pBmp = BitmapPtr(new Bitmap(size, pf, sFilename));
+        int lineLen = pBmp->getLineLen();
+        if (header.m_Stride != lineLen) {
+            bOk = false;
+        } else {
+            unsigned char* pPixels = pBmp->getPixels();
+            int stride = pBmp->getStride();
+            for (int y = 0; bOk && y < size.y; ++y) {
+                bOk = (fread(pPixels+y*stride, lineLen, 1, pFile) == 1);
+            }
+        }
+    }
+    fclose(pFile);
+
+    if (!bOk) {
+        AVG_TRACE(Logger::category::MEMORY, Logger::severity::INFO,
+                "Stale or invalid image disk cache entry for " << sFilename);
+        remove(sCacheFilename.c_str());
+        countLookup(false);
+        return BitmapPtr();
+    }
+    countLookup(true);
+    return pBmp;
+}
+
+void ImageDiskCache::save(const string& sFilename, const string& sKey,
+        TexCompression compression, BitmapPtr pBmp)
+{
+    ScopeTimer timer(DiskCacheSaveProfilingZone);
+    CacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    if (!getSourceFileInfo(sFilename, header.m_SrcMTime, header.m_SrcSize)) {
+        return;
+    }
+    header.m_Magic = CACHE_MAGIC;
+    header.m_Version = CACHE_VERSION;
+    header.m_PixelFormat = int(pBmp->getPixelFormat());
+    header.m_Width = pBmp->getSize().x;
+    header.m_Height = pBmp->getSize().y;
+    header.m_Stride = pBmp->getLineLen();
+    header.m_Compression = int(compression);
+    header.m_bBlueFirst = int(BitmapLoader::get()->isBlueFirst());
+    header.m_KeyLen = int(sKey.length());
+
+    // Write to a temporary file and rename it so concurrent readers never see a
+    // partially written entry. The temporary file is private to this thread, since
+    // other threads or processes may be saving the same entry at the same time.
+    string sCacheFilename = getCacheFilename(sKey, compression);
+    string sTempFilename = getTempFilename(sCacheFilename);
+    FILE* pFile = fopen(sTempFilename.c_str(), "wb");
+    if (!pFile) {
+        AVG_LOG_WARNING("Could not write image disk cache entry " << sTempFilename);
+        return;
+    }
+    bool bOk = (fwrite(&header, sizeof(header), 1, pFile) == 1);
+    bOk = bOk && fwrite(sKey.c_str(), sKey.length(), 1, pFile) == 1;
+    const unsigned char* pPixels = pBmp->getPixels();
+    int stride = pBmp->getStride();
+    for (int y = 0; bOk && y < header.m_Height; ++y) {
+        bOk = (fwrite(pPixels+y*stride, header.m_Stride, 1, pFile) == 1);
+    }
+    bOk = (fclose(pFile) == 0) && bOk;
+    if (bOk) {
+#ifdef _WIN32
+        remove(sCacheFilename.c_str());
+#endif
+        bOk = (rename(sTempFilename.c_str(), sCacheFilename.c_str()) == 0);
+        if (!bOk) {
+            // Another writer got there first; its entry is just as good.
+            remove(sTempFilename.c_str());
+            struct stat cacheStat;
+            bOk = (stat(sCacheFilename.c_str(), &cacheStat) == 0);
+        }
+    }
+    if (!bOk) {
+        AVG_LOG_WARNING("Could not write image disk cache entry " << sCacheFilename);
+        remove(sTempFilename.c_str());
+    }
+}
+
+int ImageDiskCache::getNumHits() const
+{
+    lock_guard lock(m_StatsMutex);
+    return m_NumHits;
+}
+
+int ImageDiskCache::getNumMisses() const
+{
+    lock_guard lock(m_StatsMutex);
+    return m_NumMisses;
+}
+
+string ImageDiskCache::getCacheFilename(const string& sKey,
+        TexCompression compression) const
+{
+    stringstream ss;
+    ss << sKey << '\0' << int(compression) << '\0'
+            << BitmapLoader::get()->isBlueFirst();
+    unsigned long long hash = fnv1aHash(ss.str(), 14695981039346656037ULL);
+    stringstream nameStream;
+    nameStream << m_sDir << "/" << hex << setw(16) << setfill('0') << hash << ".avgimg";
+    return nameStream.str();
+}
+
+string ImageDiskCache::getTempFilename(const string& sCacheFilename) const
+{
+    stringstream ss;
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = int(getpid());
+#endif
+    ss << sCacheFilename << "." << pid << "." << boost::this_thread::get_id() << ".tmp";
+    return ss.str();
+}
+
+void ImageDiskCache::countLookup(bool bHit)
+{
+    lock_guard lock(m_StatsMutex);
+    if (bHit) {
+        m_NumHits++;
+    } else {
+        m_NumMisses++;
+    }
+}
+
+}
@@ -0,0 +1,77 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ImageDiskCache_H_
+#define _ImageDiskCache_H_
+
+#include "../api.h"
+
+#include "TexInfo.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <string>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// Persistent cache of decoded and format-converted images. Each entry is a single
+// file that holds a small header followed by the raw pixels, so a cache hit costs one
+// read and no decoding. Entries are keyed by image variant, compression and channel
+// order and are invalidated when the modification time or size of the source changes.
+// load() and save() may be called from several threads at once.
+class AVG_API ImageDiskCache
+{
+public:
+    ImageDiskCache(const std::string& sDir);
+    virtual ~ImageDiskCache();
+
+    const std::string& getDir() const;
+
+    // sKey identifies the variant of the file (e.g. a reduced resolution version).
+    // Returns an empty pointer if there is no valid entry for the key.
+    BitmapPtr load(const std::string& sFilename, const std::string& sKey,
+            TexCompression compression);
+    void save(const std::string& sFilename, const std::string& sKey,
+            TexCompression compression, BitmapPtr pBmp);
+
+    int getNumHits() const;
+    int getNumMisses() const;
+
+private:
+    std::string getCacheFilename(const std::string& sKey,
+            TexCompression compression) const;
+    std::string getTempFilename(const std::string& sCacheFilename) const;
+    void countLookup(bool bHit);
+
+    std::string m_sDir;
+    int m_NumHits;
+    int m_NumMisses;
+    mutable boost::mutex m_StatsMutex;
+};
+
+typedef boost::shared_ptr<ImageDiskCache> ImageDiskCachePtr;
+
+}
+
+#endif
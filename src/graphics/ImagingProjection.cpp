@@ -33,7 +33,8 @@ using namespace std;
 namespace avg {
 
 ImagingProjection::ImagingProjection(const IntPoint& size)
-    : m_Color(0, 0, 0, 0)
+    : m_Color(0, 0, 0, 0),
+      m_TexRect(0, 0, 1, 1)
 {
     GLContextManager* pCM = GLContextManager::get();
     m_pVA = pCM->createVertexArray();
@@ -43,7 +44,8 @@ ImagingProjection::ImagingProjection(const IntPoint& size)
 }
 
 ImagingProjection::ImagingProjection(const IntPoint& srcSize, const IntRect& destRect)
-    : m_Color(0, 0, 0, 0)
+    : m_Color(0, 0, 0, 0),
+      m_TexRect(0, 0, 1, 1)
 {
     GLContextManager* pCM = GLContextManager::get();
     m_pVA = pCM->createVertexArray();
@@ -69,6 +71,14 @@ void ImagingProjection::setColor(const Pixel32& color)
     }
 }
 
+void ImagingProjection::setTexRect(const FRect& texRect)
+{
+    if (texRect != m_TexRect) {
+        m_TexRect = texRect;
+        init(m_SrcSize, m_DestRect);
+    }
+}
+
 void ImagingProjection::draw(GLContext* pContext, const OGLShaderPtr& pShader)
 {
     IntPoint destSize = m_DestRect.size();
@@ -86,11 +96,13 @@ void ImagingProjection::init(const IntPoint& srcSize, const IntRect& destRect)
     glm::vec2 p3(dest.br.x/srcSize.x, dest.br.y/srcSize.y);
     glm::vec2 p2(p1.x, p3.y);
     glm::vec2 p4(p3.x, p1.y);
+    glm::vec2 texTL = m_TexRect.tl;
+    glm::vec2 texSize = m_TexRect.size();
     m_pVA->reset();
-    m_pVA->appendPos(p1, p1, m_Color);
-    m_pVA->appendPos(p2, p2, m_Color);
-    m_pVA->appendPos(p3, p3, m_Color);
-    m_pVA->appendPos(p4, p4, m_Color);
+    m_pVA->appendPos(p1, texTL+p1*texSize, m_Color);
+    m_pVA->appendPos(p2, texTL+p2*texSize, m_Color);
+    m_pVA->appendPos(p3, texTL+p3*texSize, m_Color);
+    m_pVA->appendPos(p4, texTL+p4*texSize, m_Color);
     m_pVA->appendQuadIndexes(1,0,2,3);
     
     IntPoint destSize = m_DestRect.size();
@@ -46,6 +46,9 @@ public:
 
     void setProjection(const IntPoint& srcSize, const IntRect& destRect);
     void setColor(const Pixel32& color);
+    // Part of the source texture to use, in texture coordinates. Default is the 
+    // complete texture.
+    void setTexRect(const FRect& texRect);
 
     void draw(GLContext* pContext, const OGLShaderPtr& pShader);
 
@@ -56,6 +59,7 @@ private:
     IntRect m_DestRect;
     IntPoint m_Offset;
     Pixel32 m_Color;
+    FRect m_TexRect;
     VertexArrayPtr m_pVA;
     Mat4fGLShaderParamPtr m_pTransformParam;
     glm::mat4 m_ProjMat;
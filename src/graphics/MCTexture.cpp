@@ -65,6 +65,13 @@ void MCTexture::moveBmpToTexture(GLContext* pContext, BitmapPtr pBmp)
     m_bIsDirty = true;
 }
 
+void MCTexture::moveBmpRectToTexture(GLContext* pContext, BitmapPtr pBmp,
+        const IntRect& rect)
+{
+    getTex(pContext)->moveBmpRectToTexture(pBmp, rect);
+    m_bIsDirty = true;
+}
+
 void MCTexture::setDirty()
 {
     m_bIsDirty = true;
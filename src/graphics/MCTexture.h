@@ -26,6 +26,8 @@
 #include "TexInfo.h"
 #include "OGLHelper.h"
 
+#include "../base/Rect.h"
+
 #include <boost/shared_ptr.hpp>
 #ifdef _WIN32 
 #include <unordered_map>
@@ -53,6 +55,7 @@ public:
     void initForGLContext(GLContext* pContext);
 
     void moveBmpToTexture(GLContext* pContext, BitmapPtr pBmp);
+    void moveBmpRectToTexture(GLContext* pContext, BitmapPtr pBmp, const IntRect& rect);
 
     const GLTexturePtr& getTex(GLContext* pContext) const;
 
@@ -21,6 +21,7 @@
 
 #include "OGLShader.h"
 #include "ShaderRegistry.h"
+#include "GLContext.h"
 #include "VertexArray.h"
 
 #include "../base/Logger.h"
@@ -93,6 +94,7 @@ void OGLShader::activate()
         glproc::UseProgram(m_hProgram);
         m_pShaderRegistry->setCurShader(m_sName);
         GLContext::checkError("OGLShader::activate: glUseProgram()");
+        GLContext::getCurrent()->countShaderChange();
     }
 }
 
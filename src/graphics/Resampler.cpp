@@ -0,0 +1,594 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "Resampler.h"
+
+#include "Bitmap.h"
+#include "ContribDefs.h"
+#include "Convolution.h"
+
+#include "../base/Exception.h"
+#include "../base/MathHelper.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+
+#if defined(__SSE2__) || defined(_WIN32)
+#include <emmintrin.h>
+#endif
+
+#include <cstring>
+#include <map>
+#include <math.h>
+
+using namespace std;
+
+namespace avg {
+
+// Weights of the filters sum up to 1 << PRECISION_BITS. 14 bits leave enough room
+// for negative lobes in 16-bit weights.
+static const int PRECISION_BITS = 14;
+static const unsigned MAX_CACHED_WEIGHTS = 64;
+
+ResampleFilter string2ResampleFilter(const string& s)
+{
+    if (s == "box") {
+        return RESAMPLE_BOX;
+    } else if (s == "bilinear") {
+        return RESAMPLE_BILINEAR;
+    } else if (s == "mitchell") {
+        return RESAMPLE_MITCHELL;
+    } else if (s == "lanczos") {
+        return RESAMPLE_LANCZOS;
+    } else {
+        throw(Exception(AVG_ERR_UNSUPPORTED, "Resampling filter "+s+" not supported."));
+    }
+}
+
+string resampleFilter2String(ResampleFilter filter)
+{
+    switch(filter) {
+        case RESAMPLE_BOX:
+            return "box";
+        case RESAMPLE_BILINEAR:
+            return "bilinear";
+        case RESAMPLE_MITCHELL:
+            return "mitchell";
+        case RESAMPLE_LANCZOS:
+            return "lanczos";
+        default:
+            AVG_ASSERT(false);
+            return 0;
+    }
+}
+
+static double getFilterSupport(ResampleFilter filter)
+{
+    switch(filter) {
+        case RESAMPLE_BOX:
+            return 0.5;
+        case RESAMPLE_BILINEAR:
+            return 1;
+        case RESAMPLE_MITCHELL:
+            return 2;
+        case RESAMPLE_LANCZOS:
+            return 3;
+        default:
+            AVG_ASSERT(false);
+            return 0;
+    }
+}
+
+static double evalFilter(ResampleFilter filter, double x)
+{
+    x = fabs(x);
+    switch(filter) {
+        case RESAMPLE_BOX:
+            return x < 0.5 ? 1 : 0;
+        case RESAMPLE_BILINEAR:
+            return x < 1 ? 1-x : 0;
+        case RESAMPLE_MITCHELL:
+            {
+                // Mitchell-Netravali with B = C = 1/3.
+                const double b = 1./3;
+                const double c = 1./3;
+                if (x < 1) {
+                    return ((12-9*b-6*c)*x*x*x + (-18+12*b+6*c)*x*x + (6-2*b))/6;
+                } else if (x < 2) {
+                    return ((-b-6*c)*x*x*x + (6*b+30*c)*x*x + (-12*b-48*c)*x +
+                            (8*b+24*c))/6;
+                } else {
+                    return 0;
+                }
+            }
+        case RESAMPLE_LANCZOS:
+            if (x == 0) {
+                return 1;
+            } else if (x < 3) {
+                return 3*sin(M_PI*x)*sin(M_PI*x/3)/(M_PI*M_PI*x*x);
+            } else {
+                return 0;
+            }
+        default:
+            AVG_ASSERT(false);
+            return 0;
+    }
+}
+
+struct WeightsKey {
+    WeightsKey(int srcLen, int destLen, ResampleFilter filter)
+        : m_SrcLen(srcLen),
+          m_DestLen(destLen),
+          m_Filter(filter)
+    {
+    }
+
+    bool operator<(const WeightsKey& other) const
+    {
+        if (m_SrcLen != other.m_SrcLen) {
+            return m_SrcLen < other.m_SrcLen;
+        } else if (m_DestLen != other.m_DestLen) {
+            return m_DestLen < other.m_DestLen;
+        } else {
+            return m_Filter < other.m_Filter;
+        }
+    }
+
+    int m_SrcLen;
+    int m_DestLen;
+    ResampleFilter m_Filter;
+};
+
+typedef map<WeightsKey, ResampleWeightsPtr> WeightsCache;
+static WeightsCache s_WeightsCache;
+static boost::mutex s_WeightsCacheMutex;
+
+ResampleWeightsPtr ResampleWeights::get(int srcLen, int destLen, ResampleFilter filter)
+{
+    AVG_ASSERT(srcLen > 0 && destLen > 0);
+    WeightsKey key(srcLen, destLen, filter);
+    {
+        boost::mutex::scoped_lock lock(s_WeightsCacheMutex);
+        WeightsCache::iterator it = s_WeightsCache.find(key);
+        if (it != s_WeightsCache.end()) {
+            return it->second;
+        }
+    }
+
+    // Pixel centers are at i+0.5. When downscaling, the filter is stretched so it
+    // covers all source pixels that contribute to a destination pixel.
+    double scale = double(srcLen)/destLen;
+    double filterScale = max(1., scale);
+    double support = getFilterSupport(filter)*filterScale;
+    int maxTaps = int(ceil(2*support))+2;
+    ResampleWeights* pWeights = new ResampleWeights(srcLen, destLen, PRECISION_BITS,
+            maxTaps);
+    if (srcLen == destLen) {
+        pWeights->setIdentity();
+    } else {
+        int one = 1 << PRECISION_BITS;
+        vector<double> floatWeights;
+        vector<int> weights;
+        for (int i = 0; i < destLen; ++i) {
+            double center = (i+0.5)*scale;
+            int left = max(0, int(floor(center-support)));
+            int right = min(srcLen, int(ceil(center+support)));
+            floatWeights.clear();
+            double total = 0;
+            for (int j = left; j < right; ++j) {
+                double weight = evalFilter(filter, (j+0.5-center)/filterScale);
+                floatWeights.push_back(weight);
+                total += weight;
+            }
+            weights.clear();
+            if (total == 0) {
+                left = min(int(center), srcLen-1);
+                weights.push_back(one);
+            } else {
+                // Rounding errors go to the largest weight so a constant color stays
+                // exactly the same.
+                int sum = 0;
+                unsigned largest = 0;
+                for (unsigned j = 0; j < floatWeights.size(); ++j) {
+                    int weight = int(floor(floatWeights[j]/total*one+0.5));
+                    weights.push_back(weight);
+                    sum += weight;
+                    if (weight > weights[largest]) {
+                        largest = j;
+                    }
+                }
+                weights[largest] += one-sum;
+                while (weights.back() == 0) {
+                    weights.pop_back();
+                }
+                while (weights.front() == 0) {
+                    weights.erase(weights.begin());
+                    left++;
+                }
+            }
+            pWeights->setWeights(i, left, weights);
+        }
+    }
+
+    ResampleWeightsPtr pResult(pWeights);
+    boost::mutex::scoped_lock lock(s_WeightsCacheMutex);
+    if (s_WeightsCache.size() >= MAX_CACHED_WEIGHTS) {
+        s_WeightsCache.clear();
+    }
+    s_WeightsCache[key] = pResult;
+    return pResult;
+}
+
+ResampleWeightsPtr ResampleWeights::createFromContribDef(int srcLen, int destLen,
+        const ContribDef& contribDef)
+{
+    AVG_ASSERT(srcLen > 0 && destLen > 0);
+    float dScale = float(destLen)/srcLen;
+    float dWidth;
+    float dFScale = 1.0;
+    float dFilterWidth = contribDef.GetWidth();
+    if (dScale < 1.0) {
+        // Minification
+        dWidth = dFilterWidth / dScale;
+        dFScale = dScale;
+    } else {
+        // Magnification
+        dWidth = dFilterWidth;
+    }
+    // Window size is the number of sampled pixels
+    int windowSize = 2 * (int)ceil(dWidth) + 1;
+
+    ResampleWeights* pWeights = new ResampleWeights(srcLen, destLen, 8, windowSize);
+    if (srcLen == destLen) {
+        pWeights->setIdentity();
+        return ResampleWeightsPtr(pWeights);
+    }
+    vector<int> weights;
+    for (int u = 0; u < destLen; u++) {
+        float dCenter = (u+0.5f)/dScale-0.5f;   // Reverse mapping
+        // Find the significant edge points that affect the pixel
+        int iLeft = std::max(0, (int)floor(dCenter - dWidth));
+        int iRight = std::min((int)ceil(dCenter + dWidth), srcLen - 1);
+        // Cut edge points to fit in filter window in case of spill-off
+        if (iRight - iLeft + 1 > windowSize) {
+            iLeft++;
+        }
+        weights.resize(iRight-iLeft+1);
+        int totalWeight = 0;
+        for (int iSrc = iLeft; iSrc <= iRight; iSrc++) {
+            int curWeight = int(dFScale * (contribDef.Filter(dFScale *
+                    (dCenter - (float)iSrc)))*256);
+            weights[iSrc-iLeft] = curWeight;
+            totalWeight += curWeight;
+        }
+        AVG_ASSERT(totalWeight >= 0);   // An error in the filter function can cause this
+        if (totalWeight > 0) {
+            // Normalize weight of neighbouring points. The last point gets everything
+            // that's left over so the sum is always correct.
+            int usedWeight = 0;
+            for (int iSrc = iLeft; iSrc < iRight; iSrc++) {
+                int curWeight = (weights[iSrc-iLeft]*256)/totalWeight;
+                weights[iSrc-iLeft] = curWeight;
+                usedWeight += curWeight;
+            }
+            weights[iRight-iLeft] = 256 - usedWeight;
+        }
+        pWeights->setWeights(u, iLeft, weights);
+    }
+    return ResampleWeightsPtr(pWeights);
+}
+
+void ResampleWeights::clearCache()
+{
+    boost::mutex::scoped_lock lock(s_WeightsCacheMutex);
+    s_WeightsCache.clear();
+}
+
+int ResampleWeights::getNumCached()
+{
+    boost::mutex::scoped_lock lock(s_WeightsCacheMutex);
+    return int(s_WeightsCache.size());
+}
+
+ResampleWeights::ResampleWeights(int srcLen, int destLen, int shift, int maxTaps)
+    : m_SrcLen(srcLen),
+      m_DestLen(destLen),
+      m_Shift(shift),
+      m_MaxTaps(maxTaps),
+      m_bIdentity(false),
+      m_Left(destLen, 0),
+      m_NumTaps(destLen, 0),
+      m_Weights(destLen*maxTaps, 0)
+{
+}
+
+int ResampleWeights::getSrcLen() const
+{
+    return m_SrcLen;
+}
+
+int ResampleWeights::getDestLen() const
+{
+    return m_DestLen;
+}
+
+int ResampleWeights::getShift() const
+{
+    return m_Shift;
+}
+
+bool ResampleWeights::isIdentity() const
+{
+    return m_bIdentity;
+}
+
+int ResampleWeights::getLeft(int i) const
+{
+    return m_Left[i];
+}
+
+int ResampleWeights::getNumTaps(int i) const
+{
+    return m_NumTaps[i];
+}
+
+const short* ResampleWeights::getWeights(int i) const
+{
+    return &m_Weights[i*m_MaxTaps];
+}
+
+void ResampleWeights::setIdentity()
+{
+    AVG_ASSERT(m_SrcLen == m_DestLen);
+    m_bIdentity = true;
+    vector<int> weights(1, 1 << m_Shift);
+    for (int i = 0; i < m_DestLen; ++i) {
+        setWeights(i, i, weights);
+    }
+}
+
+void ResampleWeights::setWeights(int i, int left, const vector<int>& weights)
+{
+    int numTaps = int(weights.size());
+    AVG_ASSERT(numTaps <= m_MaxTaps);
+    AVG_ASSERT(left >= 0 && left+numTaps <= m_SrcLen);
+    m_Left[i] = left;
+    m_NumTaps[i] = numTaps;
+    for (int j = 0; j < numTaps; ++j) {
+        AVG_ASSERT(weights[j] >= -32768 && weights[j] <= 32767);
+        m_Weights[i*m_MaxTaps+j] = short(weights[j]);
+    }
+}
+
+static inline unsigned char clampToByte(int value)
+{
+    if (value < 0) {
+        return 0;
+    } else if (value > 255) {
+        return 255;
+    } else {
+        return (unsigned char)value;
+    }
+}
+
+#if defined(__SSE2__) || defined(_WIN32)
+static inline __m128i loadFourBytes(const unsigned char* pSrc)
+{
+    int bytes;
+    memcpy(&bytes, pSrc, 4);
+    return _mm_cvtsi32_si128(bytes);
+}
+
+// Two 16-bit weights in every 32-bit lane, as needed by _mm_madd_epi16.
+static inline __m128i weightPair(short weight0, short weight1)
+{
+    return _mm_set1_epi32(int((unsigned)(unsigned short)weight1 << 16 |
+            (unsigned)(unsigned short)weight0));
+}
+
+// Processes all four channels of a pixel at once, two taps per step.
+static void resampleHorizLine4(const unsigned char* pSrc, unsigned char* pDest,
+        const ResampleWeights& weights)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i round = _mm_set1_epi32(1 << (weights.getShift()-1));
+    int shift = weights.getShift();
+    for (int x = 0; x < weights.getDestLen(); ++x) {
+        const unsigned char* pTap = pSrc+weights.getLeft(x)*4;
+        const short* pWeights = weights.getWeights(x);
+        int numTaps = weights.getNumTaps(x);
+        __m128i sum = round;
+        int i = 0;
+        for (; i < numTaps-1; i += 2) {
+            __m128i pixels = _mm_unpacklo_epi8(
+                    _mm_unpacklo_epi8(loadFourBytes(pTap), loadFourBytes(pTap+4)), zero);
+            sum = _mm_add_epi32(sum,
+                    _mm_madd_epi16(pixels, weightPair(pWeights[i], pWeights[i+1])));
+            pTap += 8;
+        }
+        if (i < numTaps) {
+            __m128i pixel = _mm_unpacklo_epi16(
+                    _mm_unpacklo_epi8(loadFourBytes(pTap), zero), zero);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(pixel, weightPair(pWeights[i], 0)));
+        }
+        sum = _mm_srai_epi32(sum, shift);
+        sum = _mm_packs_epi32(sum, sum);
+        int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+        memcpy(pDest+x*4, &bytes, 4);
+    }
+}
+#endif
+
+static void resampleHorizLine(const unsigned char* pSrc, unsigned char* pDest, int bpp,
+        const ResampleWeights& weights)
+{
+    int round = 1 << (weights.getShift()-1);
+    int shift = weights.getShift();
+    for (int x = 0; x < weights.getDestLen(); ++x) {
+        const unsigned char* pTap = pSrc+weights.getLeft(x)*bpp;
+        const short* pWeights = weights.getWeights(x);
+        int numTaps = weights.getNumTaps(x);
+        for (int c = 0; c < bpp; ++c) {
+            int sum = round;
+            for (int i = 0; i < numTaps; ++i) {
+                sum += pTap[i*bpp+c]*pWeights[i];
+            }
+            pDest[x*bpp+c] = clampToByte(sum >> shift);
+        }
+    }
+}
+
+static void resampleHorizLines(const Bitmap& srcBmp, Bitmap& destBmp,
+        const ResampleWeights& weights, int startY, int endY)
+{
+    int bpp = srcBmp.getBytesPerPixel();
+    for (int y = startY; y < endY; ++y) {
+        const unsigned char* pSrc = srcBmp.getPixels()+y*srcBmp.getStride();
+        unsigned char* pDest = destBmp.getPixels()+y*destBmp.getStride();
+#if defined(__SSE2__) || defined(_WIN32)
+        if (bpp == 4) {
+            resampleHorizLine4(pSrc, pDest, weights);
+            continue;
+        }
+#endif
+        resampleHorizLine(pSrc, pDest, bpp, weights);
+    }
+}
+
+static void resampleVertLines(const Bitmap& srcBmp, Bitmap& destBmp,
+        const ResampleWeights& weights, int startY, int endY)
+{
+    int srcStride = srcBmp.getStride();
+    int lineLen = destBmp.getLineLen();
+    int round = 1 << (weights.getShift()-1);
+    int shift = weights.getShift();
+    for (int y = startY; y < endY; ++y) {
+        const unsigned char* pSrc = srcBmp.getPixels()+weights.getLeft(y)*srcStride;
+        unsigned char* pDest = destBmp.getPixels()+y*destBmp.getStride();
+        const short* pWeights = weights.getWeights(y);
+        int numTaps = weights.getNumTaps(y);
+        int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+        // 16 bytes and two source lines per step.
+        __m128i zero = _mm_setzero_si128();
+        __m128i roundVec = _mm_set1_epi32(round);
+        for (; x < lineLen-15; x += 16) {
+            __m128i sum0 = roundVec;
+            __m128i sum1 = roundVec;
+            __m128i sum2 = roundVec;
+            __m128i sum3 = roundVec;
+            const unsigned char* pTap = pSrc+x;
+            int i = 0;
+            for (; i < numTaps-1; i += 2) {
+                __m128i weight = weightPair(pWeights[i], pWeights[i+1]);
+                __m128i line0 = _mm_loadu_si128((const __m128i*)pTap);
+                __m128i line1 = _mm_loadu_si128((const __m128i*)(pTap+srcStride));
+                __m128i lo0 = _mm_unpacklo_epi8(line0, zero);
+                __m128i lo1 = _mm_unpacklo_epi8(line1, zero);
+                __m128i hi0 = _mm_unpackhi_epi8(line0, zero);
+                __m128i hi1 = _mm_unpackhi_epi8(line1, zero);
+                sum0 = _mm_add_epi32(sum0,
+                        _mm_madd_epi16(_mm_unpacklo_epi16(lo0, lo1), weight));
+                sum1 = _mm_add_epi32(sum1,
+                        _mm_madd_epi16(_mm_unpackhi_epi16(lo0, lo1), weight));
+                sum2 = _mm_add_epi32(sum2,
+                        _mm_madd_epi16(_mm_unpacklo_epi16(hi0, hi1), weight));
+                sum3 = _mm_add_epi32(sum3,
+                        _mm_madd_epi16(_mm_unpackhi_epi16(hi0, hi1), weight));
+                pTap += 2*srcStride;
+            }
+            if (i < numTaps) {
+                __m128i weight = weightPair(pWeights[i], 0);
+                __m128i line0 = _mm_loadu_si128((const __m128i*)pTap);
+                __m128i lo0 = _mm_unpacklo_epi8(line0, zero);
+                __m128i hi0 = _mm_unpackhi_epi8(line0, zero);
+                sum0 = _mm_add_epi32(sum0,
+                        _mm_madd_epi16(_mm_unpacklo_epi16(lo0, zero), weight));
+                sum1 = _mm_add_epi32(sum1,
+                        _mm_madd_epi16(_mm_unpackhi_epi16(lo0, zero), weight));
+                sum2 = _mm_add_epi32(sum2,
+                        _mm_madd_epi16(_mm_unpacklo_epi16(hi0, zero), weight));
+                sum3 = _mm_add_epi32(sum3,
+                        _mm_madd_epi16(_mm_unpackhi_epi16(hi0, zero), weight));
+            }
+            __m128i result = _mm_packus_epi16(
+                    _mm_packs_epi32(_mm_srai_epi32(sum0, shift),
+                            _mm_srai_epi32(sum1, shift)),
+                    _mm_packs_epi32(_mm_srai_epi32(sum2, shift),
+                            _mm_srai_epi32(sum3, shift)));
+            _mm_storeu_si128((__m128i*)(pDest+x), result);
+        }
+#endif
+        for (; x < lineLen; ++x) {
+            int sum = round;
+            const unsigned char* pTap = pSrc+x;
+            for (int i = 0; i < numTaps; ++i) {
+                sum += *pTap*pWeights[i];
+                pTap += srcStride;
+            }
+            pDest[x] = clampToByte(sum >> shift);
+        }
+    }
+}
+
+static void copyLines(const Bitmap& srcBmp, Bitmap& destBmp, int startY, int endY)
+{
+    for (int y = startY; y < endY; ++y) {
+        memcpy(destBmp.getPixels()+y*destBmp.getStride(),
+                srcBmp.getPixels()+y*srcBmp.getStride(), destBmp.getLineLen());
+    }
+}
+
+void resampleBitmap(const Bitmap& srcBmp, Bitmap& destBmp,
+        const ResampleWeightsPtr& pXWeights, const ResampleWeightsPtr& pYWeights)
+{
+    IntPoint srcSize = srcBmp.getSize();
+    IntPoint destSize = destBmp.getSize();
+    AVG_ASSERT(srcBmp.getBytesPerPixel() == destBmp.getBytesPerPixel());
+    AVG_ASSERT(pXWeights->getSrcLen() == srcSize.x &&
+            pXWeights->getDestLen() == destSize.x);
+    AVG_ASSERT(pYWeights->getSrcLen() == srcSize.y &&
+            pYWeights->getDestLen() == destSize.y);
+
+    if (pXWeights->isIdentity() && pYWeights->isIdentity()) {
+        processLineBands(destSize, boost::bind(&copyLines, boost::cref(srcBmp),
+                boost::ref(destBmp), _1, _2));
+    } else if (pXWeights->isIdentity()) {
+        processLineBands(destSize, boost::bind(&resampleVertLines, boost::cref(srcBmp),
+                boost::ref(destBmp), boost::cref(*pYWeights), _1, _2));
+    } else if (pYWeights->isIdentity()) {
+        processLineBands(destSize, boost::bind(&resampleHorizLines,
+                boost::cref(srcBmp), boost::ref(destBmp), boost::cref(*pXWeights),
+                _1, _2));
+    } else {
+        IntPoint tempSize(destSize.x, srcSize.y);
+        Bitmap tempBmp(tempSize, srcBmp.getPixelFormat(), "resampletemp");
+        processLineBands(tempSize, boost::bind(&resampleHorizLines,
+                boost::cref(srcBmp), boost::ref(tempBmp), boost::cref(*pXWeights),
+                _1, _2));
+        processLineBands(destSize, boost::bind(&resampleVertLines,
+                boost::cref(tempBmp), boost::ref(destBmp), boost::cref(*pYWeights),
+                _1, _2));
+    }
+}
+
+}
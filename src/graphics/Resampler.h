@@ -0,0 +1,101 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _Resampler_H_
+#define _Resampler_H_
+
+#include "../api.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+class ContribDef;
+
+enum ResampleFilter {
+    RESAMPLE_BOX,
+    RESAMPLE_BILINEAR,
+    RESAMPLE_MITCHELL,
+    RESAMPLE_LANCZOS
+};
+
+ResampleFilter AVG_API string2ResampleFilter(const std::string& s);
+std::string AVG_API resampleFilter2String(ResampleFilter filter);
+
+class ResampleWeights;
+typedef boost::shared_ptr<const ResampleWeights> ResampleWeightsPtr;
+
+// Fixed-point contributions of the source pixels to every destination pixel along
+// one axis. Destination pixel i is the weighted sum of getNumTaps(i) source pixels
+// starting at getLeft(i), divided by 2^getShift().
+class AVG_API ResampleWeights
+{
+public:
+    // Returns the weights for a filter. Tables are cached, so resampling many
+    // bitmaps of the same size only calculates them once. Safe to call from any
+    // thread.
+    static ResampleWeightsPtr get(int srcLen, int destLen, ResampleFilter filter);
+    // Calculates weights with 8 bits of precision the way the original resize filters
+    // did, so their results stay the same. Not cached.
+    static ResampleWeightsPtr createFromContribDef(int srcLen, int destLen,
+            const ContribDef& contribDef);
+    static void clearCache();
+    static int getNumCached();
+
+    int getSrcLen() const;
+    int getDestLen() const;
+    int getShift() const;
+    // True if the weights just copy the source.
+    bool isIdentity() const;
+
+    int getLeft(int i) const;
+    int getNumTaps(int i) const;
+    const short* getWeights(int i) const;
+
+private:
+    ResampleWeights(int srcLen, int destLen, int shift, int maxTaps);
+    void setIdentity();
+    void setWeights(int i, int left, const std::vector<int>& weights);
+
+    int m_SrcLen;
+    int m_DestLen;
+    int m_Shift;
+    int m_MaxTaps;
+    bool m_bIdentity;
+    std::vector<int> m_Left;
+    std::vector<int> m_NumTaps;
+    std::vector<short> m_Weights;
+};
+
+// Scales srcBmp to the size of destBmp in two passes, horizontal first. Every byte
+// is treated as a separate channel; alpha is not taken into account. The passes use
+// SSE2 where available and are spread over the ThreadPool for large bitmaps.
+void AVG_API resampleBitmap(const Bitmap& srcBmp, Bitmap& destBmp,
+        const ResampleWeightsPtr& pXWeights, const ResampleWeightsPtr& pYWeights);
+
+}
+
+#endif
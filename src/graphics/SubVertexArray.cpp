@@ -87,11 +87,26 @@ int SubVertexArray::getNumVerts() const
     return m_NumVerts;
 }
 
+unsigned SubVertexArray::getStartIndex() const
+{
+    return m_StartIndex;
+}
+
+int SubVertexArray::getNumIndexes() const
+{
+    return m_NumIndexes;
+}
+
 void SubVertexArray::draw()
 {
     m_pVA->draw(m_StartIndex, m_NumIndexes, m_StartVertex, m_StartIndex);
 }
 
+void SubVertexArray::draw(int numIndexes)
+{
+    m_pVA->draw(m_StartIndex, numIndexes, m_StartVertex, m_StartIndex);
+}
+
 void SubVertexArray::dump() const
 {
     cerr << "SubVertexArray: m_StartVertex=" << m_StartVertex << ", " 
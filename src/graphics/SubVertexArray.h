@@ -47,8 +47,13 @@ public:
             float width, float tc1=0, float tc2=1);
     void appendVertexData(VertexDataPtr pVertexes);
     int getNumVerts() const;
+    unsigned getStartIndex() const;
+    int getNumIndexes() const;
 
     void draw();
+    // Draws numIndexes indexes starting at the beginning of this SubVertexArray. Used
+    // to draw several consecutive SubVertexArrays at once.
+    void draw(int numIndexes);
     void dump() const;
 
 private:
@@ -40,6 +40,14 @@ enum TexCompression {
 TexCompression string2TexCompression(const std::string& s);
 std::string texCompression2String(TexCompression compression);
 
+// Texture uploads with a priority other than UPLOADPRIORITY_IMMEDIATE count against
+// the upload budget and can be deferred to later frames. Lower values are more urgent.
+enum TexUploadPriority {
+    UPLOADPRIORITY_IMMEDIATE,
+    UPLOADPRIORITY_VISIBLE,
+    UPLOADPRIORITY_BACKGROUND
+};
+
 class AVG_API TexInfo {
 
 public:
@@ -0,0 +1,294 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "TextureAtlas.h"
+
+#include "Bitmap.h"
+#include "GLContextManager.h"
+#include "MCTexture.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+
+namespace avg {
+
+const int TextureAtlas::PAGE_SIZE = 1024;
+const int TextureAtlas::MAX_IMAGE_SIZE = 256;
+// Shelf heights are rounded up to a multiple of this.
+static const int SHELF_HEIGHT_STEP = 8;
+
+struct TextureAtlasPage {
+    // A horizontal strip of the page. m_FreeSpans holds (x, width) pairs, sorted by x.
+    struct Shelf {
+        int m_Y;
+        int m_Height;
+        vector<pair<int, int> > m_FreeSpans;
+    };
+
+    PixelFormat m_PF;
+    MCTexturePtr m_pTex;
+    BitmapPtr m_pBmp;
+    vector<Shelf> m_Shelves;
+    int m_NextShelfY;
+    int m_NumRegions;
+    long long m_UsedPixels;
+};
+
+TextureAtlasRegion::TextureAtlasRegion(TextureAtlas* pAtlas, TextureAtlasPagePtr pPage,
+        unsigned shelf, const IntRect& rect)
+    : m_pAtlas(pAtlas),
+      m_pPage(pPage),
+      m_Shelf(shelf),
+      m_Rect(rect)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+TextureAtlasRegion::~TextureAtlasRegion()
+{
+    m_pAtlas->release(m_pPage, m_Shelf, m_Rect);
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+const MCTexturePtr& TextureAtlasRegion::getTex() const
+{
+    return m_pPage->m_pTex;
+}
+
+const IntRect& TextureAtlasRegion::getRect() const
+{
+    return m_Rect;
+}
+
+bool TextureAtlasRegion::isUploadPending() const
+{
+    return GLContextManager::get()->isTexUploadPending(m_pPage->m_pTex, m_Rect);
+}
+
+
+TextureAtlas* TextureAtlas::s_pTextureAtlas = 0;
+
+TextureAtlas* TextureAtlas::get()
+{
+    if (s_pTextureAtlas == 0) {
+        s_pTextureAtlas = new TextureAtlas();
+    }
+    return s_pTextureAtlas;
+}
+
+TextureAtlas::TextureAtlas()
+    : m_bEnabled(false)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+}
+
+void TextureAtlas::setEnabled(bool bEnabled)
+{
+    m_bEnabled = bEnabled;
+}
+
+bool TextureAtlas::isEnabled() const
+{
+    return m_bEnabled;
+}
+
+bool TextureAtlas::canAdd(const IntPoint& size, PixelFormat pf) const
+{
+    return m_bEnabled && !pixelFormatIsPlanar(pf) && size.x > 0 && size.y > 0 &&
+            size.x <= MAX_IMAGE_SIZE && size.y <= MAX_IMAGE_SIZE;
+}
+
+TextureAtlasRegionPtr TextureAtlas::add(BitmapPtr pBmp, TexUploadPriority priority)
+{
+    PixelFormat pf = pBmp->getPixelFormat();
+    AVG_ASSERT(canAdd(pBmp->getSize(), pf));
+    IntPoint allocSize = pBmp->getSize() + IntPoint(2,2);
+    TextureAtlasRegionPtr pRegion;
+    TextureAtlasPagePtr pPage;
+    for (unsigned i = 0; i < m_pPages.size() && !pRegion; ++i) {
+        if (m_pPages[i]->m_PF == pf) {
+            pPage = m_pPages[i];
+            pRegion = allocate(pPage, allocSize);
+        }
+    }
+    if (!pRegion) {
+        pPage = TextureAtlasPagePtr(new TextureAtlasPage);
+        IntPoint pageSize(PAGE_SIZE, PAGE_SIZE);
+        pPage->m_PF = pf;
+        pPage->m_pBmp = BitmapPtr(new Bitmap(pageSize, pf, "TextureAtlas"));
+        memset(pPage->m_pBmp->getPixels(), 0, pPage->m_pBmp->getMemNeeded());
+        pPage->m_pTex = GLContextManager::get()->createTexture(pageSize, pf);
+        pPage->m_NextShelfY = 0;
+        pPage->m_NumRegions = 0;
+        pPage->m_UsedPixels = 0;
+        m_pPages.push_back(pPage);
+        pRegion = allocate(pPage, allocSize);
+        AVG_ASSERT(pRegion);
+    }
+    pPage->m_NumRegions++;
+    pPage->m_UsedPixels += (long long)(allocSize.x)*allocSize.y;
+    copyToPage(pPage, pRegion->getRect(), pBmp);
+    // Only the changed part of the page is uploaded. Sub-uploads of the same page are
+    // merged, so several images added in one frame result in a single upload.
+    const IntRect& rect = pRegion->getRect();
+    IntRect dirtyRect(rect.tl-IntPoint(1,1), rect.br+IntPoint(1,1));
+    GLContextManager::get()->scheduleTexSubUpload(pPage->m_pTex, pPage->m_pBmp,
+            dirtyRect, priority);
+    return pRegion;
+}
+
+int TextureAtlas::getNumPages() const
+{
+    return int(m_pPages.size());
+}
+
+int TextureAtlas::getNumRegions() const
+{
+    int numRegions = 0;
+    for (unsigned i = 0; i < m_pPages.size(); ++i) {
+        numRegions += m_pPages[i]->m_NumRegions;
+    }
+    return numRegions;
+}
+
+long long TextureAtlas::getUsedPixels() const
+{
+    long long usedPixels = 0;
+    for (unsigned i = 0; i < m_pPages.size(); ++i) {
+        usedPixels += m_pPages[i]->m_UsedPixels;
+    }
+    return usedPixels;
+}
+
+long long TextureAtlas::getTotalPixels() const
+{
+    return (long long)(m_pPages.size())*PAGE_SIZE*PAGE_SIZE;
+}
+
+TextureAtlasRegionPtr TextureAtlas::allocate(const TextureAtlasPagePtr& pPage,
+        const IntPoint& size)
+{
+    int shelfHeight = ((size.y+SHELF_HEIGHT_STEP-1)/SHELF_HEIGHT_STEP)*SHELF_HEIGHT_STEP;
+    vector<TextureAtlasPage::Shelf>& shelves = pPage->m_Shelves;
+    for (unsigned i = 0; i <= shelves.size(); ++i) {
+        if (i == shelves.size()) {
+            if (pPage->m_NextShelfY+shelfHeight > PAGE_SIZE) {
+                break;
+            }
+            TextureAtlasPage::Shelf shelf;
+            shelf.m_Y = pPage->m_NextShelfY;
+            shelf.m_Height = shelfHeight;
+            shelf.m_FreeSpans.push_back(make_pair(0, PAGE_SIZE));
+            shelves.push_back(shelf);
+            pPage->m_NextShelfY += shelfHeight;
+        }
+        TextureAtlasPage::Shelf& shelf = shelves[i];
+        if (shelf.m_Height != shelfHeight) {
+            continue;
+        }
+        vector<pair<int, int> >& spans = shelf.m_FreeSpans;
+        for (unsigned j = 0; j < spans.size(); ++j) {
+            if (spans[j].second >= size.x) {
+                IntPoint pos(spans[j].first+1, shelf.m_Y+1);
+                spans[j].first += size.x;
+                spans[j].second -= size.x;
+                if (spans[j].second == 0) {
+                    spans.erase(spans.begin()+j);
+                }
+                IntRect rect(pos, pos+size-IntPoint(2,2));
+                return TextureAtlasRegionPtr(
+                        new TextureAtlasRegion(this, pPage, i, rect));
+            }
+        }
+    }
+    return TextureAtlasRegionPtr();
+}
+
+void TextureAtlas::copyToPage(const TextureAtlasPagePtr& pPage, const IntRect& rect,
+        BitmapPtr pBmp)
+{
+    Bitmap& pageBmp = *(pPage->m_pBmp);
+    int bpp = pBmp->getBytesPerPixel();
+    IntPoint size = pBmp->getSize();
+    const unsigned char* pSrc = pBmp->getPixels();
+    int srcStride = pBmp->getStride();
+    unsigned char* pDest = pageBmp.getPixels();
+    int destStride = pageBmp.getStride();
+    // Copy the image and repeat its outermost pixels in the border around it.
+    for (int y = -1; y <= size.y; ++y) {
+        int srcY = max(0, min(y, size.y-1));
+        const unsigned char* pSrcLine = pSrc + srcY*srcStride;
+        unsigned char* pDestLine = pDest + (rect.tl.y+y)*destStride + (rect.tl.x-1)*bpp;
+        memcpy(pDestLine, pSrcLine, bpp);
+        memcpy(pDestLine+bpp, pSrcLine, size.x*bpp);
+        memcpy(pDestLine+(size.x+1)*bpp, pSrcLine+(size.x-1)*bpp, bpp);
+    }
+}
+
+void TextureAtlas::release(const TextureAtlasPagePtr& pPage, unsigned shelfIndex,
+        const IntRect& rect)
+{
+    vector<TextureAtlasPage::Shelf>& shelves = pPage->m_Shelves;
+    TextureAtlasPage::Shelf& shelf = shelves[shelfIndex];
+    vector<pair<int, int> >& spans = shelf.m_FreeSpans;
+    pair<int, int> span(rect.tl.x-1, rect.width()+2);
+    vector<pair<int, int> >::iterator it = lower_bound(spans.begin(), spans.end(), span);
+    it = spans.insert(it, span);
+    // Merge with the following and the preceding span.
+    vector<pair<int, int> >::iterator nextIt = it+1;
+    if (nextIt != spans.end() && it->first+it->second == nextIt->first) {
+        it->second += nextIt->second;
+        spans.erase(nextIt);
+    }
+    if (it != spans.begin()) {
+        vector<pair<int, int> >::iterator prevIt = it-1;
+        if (prevIt->first+prevIt->second == it->first) {
+            prevIt->second += it->second;
+            spans.erase(it);
+        }
+    }
+    // Empty shelves at the end of the page are returned for use with other heights.
+    while (!shelves.empty() && shelves.back().m_FreeSpans.size() == 1 &&
+            shelves.back().m_FreeSpans[0].second == PAGE_SIZE)
+    {
+        pPage->m_NextShelfY = shelves.back().m_Y;
+        shelves.pop_back();
+    }
+
+    pPage->m_NumRegions--;
+    pPage->m_UsedPixels -= (long long)(rect.width()+2)*(rect.height()+2);
+    if (pPage->m_NumRegions == 0) {
+        vector<TextureAtlasPagePtr>::iterator pageIt =
+                find(m_pPages.begin(), m_pPages.end(), pPage);
+        AVG_ASSERT(pageIt != m_pPages.end());
+        m_pPages.erase(pageIt);
+    }
+}
+
+}
@@ -0,0 +1,123 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _TextureAtlas_H_
+#define _TextureAtlas_H_
+
+#include "../api.h"
+
+#include "PixelFormat.h"
+#include "TexInfo.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+class MCTexture;
+typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+
+class TextureAtlas;
+struct TextureAtlasPage;
+typedef boost::shared_ptr<TextureAtlasPage> TextureAtlasPagePtr;
+
+// A part of an atlas texture that holds one image. The space is returned to the atlas
+// when the region is destroyed.
+class AVG_API TextureAtlasRegion
+{
+public:
+    virtual ~TextureAtlasRegion();
+
+    const MCTexturePtr& getTex() const;
+    // Position of the image in the texture, in pixels.
+    const IntRect& getRect() const;
+    // True if the image hasn't been completely uploaded to the texture yet.
+    bool isUploadPending() const;
+
+private:
+    friend class TextureAtlas;
+    TextureAtlasRegion(TextureAtlas* pAtlas, TextureAtlasPagePtr pPage, unsigned shelf,
+            const IntRect& rect);
+
+    TextureAtlas* m_pAtlas;
+    TextureAtlasPagePtr m_pPage;
+    unsigned m_Shelf;
+    IntRect m_Rect;
+};
+
+typedef boost::shared_ptr<TextureAtlasRegion> TextureAtlasRegionPtr;
+
+// Packs small images into shared textures so nodes that display them can be drawn
+// in one batch. Each pixel format gets its own set of pages. Pages are split into
+// shelves of similar height; every image is surrounded by a one pixel border that
+// repeats its edge pixels so filtering doesn't pick up the neighbours.
+class AVG_API TextureAtlas
+{
+public:
+    // The atlas used for images and texts when draw batching is enabled.
+    static TextureAtlas* get();
+    TextureAtlas();
+    virtual ~TextureAtlas();
+
+    void setEnabled(bool bEnabled);
+    bool isEnabled() const;
+
+    bool canAdd(const IntPoint& size, PixelFormat pf) const;
+    // Copies the bitmap into an atlas page and schedules the upload of the changed part
+    // of the page. If priority isn't UPLOADPRIORITY_IMMEDIATE, the upload counts
+    // against the upload budget and the owner must check
+    // TextureAtlasRegion::isUploadPending() before displaying the region.
+    TextureAtlasRegionPtr add(BitmapPtr pBmp,
+            TexUploadPriority priority=UPLOADPRIORITY_IMMEDIATE);
+
+    int getNumPages() const;
+    int getNumRegions() const;
+    long long getUsedPixels() const;
+    long long getTotalPixels() const;
+
+    static const int PAGE_SIZE;
+    static const int MAX_IMAGE_SIZE;
+
+private:
+    friend class TextureAtlasRegion;
+
+    TextureAtlasRegionPtr allocate(const TextureAtlasPagePtr& pPage,
+            const IntPoint& size);
+    void copyToPage(const TextureAtlasPagePtr& pPage, const IntRect& rect,
+            BitmapPtr pBmp);
+    void release(const TextureAtlasPagePtr& pPage, unsigned shelf,
+            const IntRect& rect);
+
+    std::vector<TextureAtlasPagePtr> m_pPages;
+    bool m_bEnabled;
+
+    static TextureAtlas* s_pTextureAtlas;
+};
+
+}
+
+#endif
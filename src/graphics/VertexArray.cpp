@@ -28,6 +28,7 @@
 #include "../base/Exception.h"
 #include "../base/WideLine.h"
 #include "../base/ObjectCounter.h"
+#include "../base/ScopeTimer.h"
 
 #include <iostream>
 #include <stddef.h>
@@ -42,8 +43,20 @@ const unsigned VertexArray::TEX_INDEX = 0;
 const unsigned VertexArray::POS_INDEX = 1;
 const unsigned VertexArray::COLOR_INDEX = 2;
 
+static ProfilingZoneID FullUploadProfilingZone("VA upload: full", true);
+static ProfilingZoneID DirtyUploadProfilingZone("VA upload: dirty ranges", true);
+
+VertexArray::UploadState::UploadState()
+    : m_ChangeCount(-1),
+      m_ReserveVerts(0),
+      m_ReserveIndexes(0)
+{
+}
+
 VertexArray::VertexArray(int reserveVerts, int reserveIndexes)
-    : VertexData(reserveVerts, reserveIndexes)
+    : VertexData(reserveVerts, reserveIndexes),
+      m_NumBytesUploaded(0),
+      m_UploadStatsGeneration(0)
 {
     GLContext* pContext = GLContext::getCurrent();
     m_bUseMapBuffer = (!pContext->isGLES());
@@ -59,6 +72,7 @@ void VertexArray::initForGLContext(GLContext* pContext)
     m_VertexBufferIDMap[pContext] = vertexBufferID;
     glproc::GenBuffers(1, &indexBufferID);
     m_IndexBufferIDMap[pContext] = indexBufferID;
+    m_UploadStateMap[pContext] = UploadState();
 }
 
 VertexArray::~VertexArray()
@@ -70,23 +84,29 @@ VertexArray::~VertexArray()
 void VertexArray::update(GLContext* pContext)
 {
     AVG_ASSERT(!m_VertexBufferIDMap.empty());
-    if (hasDataChanged()) {
-        unsigned vertexBufferID = m_VertexBufferIDMap[pContext];
-        transferBuffer(GL_ARRAY_BUFFER, vertexBufferID, 
-                getReserveVerts()*sizeof(Vertex), 
-                getNumVerts()*sizeof(Vertex), getVertexPointer());
-        unsigned indexBufferID = m_IndexBufferIDMap[pContext];
-#ifdef AVG_ENABLE_EGL        
-        transferBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID, 
-                getReserveIndexes()*sizeof(unsigned short),
-                getNumIndexes()*sizeof(unsigned short), getIndexPointer());
+    UploadState& state = m_UploadStateMap[pContext];
+    bool bSameSize = (state.m_ReserveVerts == getReserveVerts() &&
+            state.m_ReserveIndexes == getReserveIndexes());
+    if (bSameSize && state.m_ChangeCount == getChangeCount()) {
+        // The buffers already contain the current data.
+        return;
+    }
+#ifdef AVG_ENABLE_EGL
+    bool bCanUploadRanges = false;
 #else
-        transferBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID, 
-                getReserveIndexes()*sizeof(unsigned int),
-                getNumIndexes()*sizeof(unsigned int), getIndexPointer());
+    // The dirty ranges only describe the changes since the last reset(), so they are
+    // sufficient only if the buffers were up to date at that point.
+    bool bCanUploadRanges = bSameSize && state.m_ChangeCount >= getChangeCountAtReset();
 #endif
-        GLContext::checkError("VertexArray::update()");
+    if (bCanUploadRanges) {
+        uploadDirtyRanges(pContext);
+    } else {
+        uploadAll(pContext);
     }
+    state.m_ChangeCount = getChangeCount();
+    state.m_ReserveVerts = getReserveVerts();
+    state.m_ReserveIndexes = getReserveIndexes();
+    GLContext::checkError("VertexArray::update()");
 }
 
 void VertexArray::activate(GLContext* pContext)
@@ -118,6 +138,7 @@ void VertexArray::draw(GLContext* pContext)
     glDrawElements(GL_TRIANGLES, getNumIndexes(), GL_UNSIGNED_INT, 0);
 #endif
     GLContext::checkError("VertexArray::draw()");
+    pContext->countDrawCall();
 }
 
 void VertexArray::draw(unsigned startIndex, unsigned numIndexes, unsigned startVertex,
@@ -134,6 +155,7 @@ void VertexArray::draw(unsigned startIndex, unsigned numIndexes, unsigned startV
 //    glproc::DrawRangeElements(GL_TRIANGLES, startVertex, startVertex+numVertexes, 
 //            numIndexes, GL_UNSIGNED_SHORT, (void *)(startIndex*sizeof(unsigned short)));
     GLContext::checkError("VertexArray::draw()");
+    GLContext::getCurrent()->countDrawCall();
 }
 
 void VertexArray::startSubVA(SubVertexArray& subVA)
@@ -141,18 +163,86 @@ void VertexArray::startSubVA(SubVertexArray& subVA)
     subVA.init(this, getNumVerts(), getNumIndexes());
 }
 
+int VertexArray::getNumBytesUploaded() const
+{
+    if (m_UploadStatsGeneration != getGeneration()) {
+        return 0;
+    }
+    return m_NumBytesUploaded;
+}
+
+void VertexArray::uploadAll(GLContext* pContext)
+{
+    ScopeTimer timer(FullUploadProfilingZone);
+    transferBuffer(GL_ARRAY_BUFFER, m_VertexBufferIDMap[pContext], 
+            getReserveVerts()*sizeof(Vertex), 
+            getNumVerts()*sizeof(Vertex), getVertexPointer());
+    transferBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferIDMap[pContext], 
+            getReserveIndexes()*getIndexSize(),
+            getNumIndexes()*getIndexSize(), getIndexPointer());
+    updateUploadStats(getNumVerts()*sizeof(Vertex) + getNumIndexes()*getIndexSize());
+}
+
+void VertexArray::uploadDirtyRanges(GLContext* pContext)
+{
+    ScopeTimer timer(DirtyUploadProfilingZone);
+    transferRanges(GL_ARRAY_BUFFER, m_VertexBufferIDMap[pContext], sizeof(Vertex),
+            getDirtyVertexRanges(), getVertexPointer());
+    transferRanges(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferIDMap[pContext], 
+            getIndexSize(), getDirtyIndexRanges(), getIndexPointer());
+}
+
 void VertexArray::transferBuffer(GLenum target, unsigned bufferID, unsigned reservedSize, 
         unsigned usedSize, const void* pData)
 {
     glproc::BindBuffer(target, bufferID);
     if (m_bUseMapBuffer) {
-        glproc::BufferData(target, reservedSize, 0, GL_STREAM_DRAW);
+        glproc::BufferData(target, reservedSize, 0, GL_DYNAMIC_DRAW);
         void * pBuffer = glproc::MapBuffer(target, GL_WRITE_ONLY);
         memcpy(pBuffer, pData, usedSize);
         glproc::UnmapBuffer(target);
     } else {
+#ifdef AVG_ENABLE_EGL
         glproc::BufferData(target, usedSize, pData, GL_STREAM_DRAW);
+#else
+        // Allocate the complete reserved size so later partial updates fit.
+        glproc::BufferData(target, reservedSize, pData, GL_DYNAMIC_DRAW);
+#endif
+    }
+}
+
+void VertexArray::transferRanges(GLenum target, unsigned bufferID, unsigned elementSize,
+        const vector<DataRange>& ranges, const void* pData)
+{
+#ifndef AVG_ENABLE_EGL
+    if (ranges.empty()) {
+        return;
+    }
+    glproc::BindBuffer(target, bufferID);
+    const char* pBytes = (const char*)pData;
+    for (unsigned i = 0; i < ranges.size(); ++i) {
+        unsigned offset = ranges[i].first*elementSize;
+        unsigned size = (ranges[i].second-ranges[i].first)*elementSize;
+        glproc::BufferSubData(target, offset, size, pBytes+offset);
+        updateUploadStats(size);
+    }
+#else
+    AVG_ASSERT(false);
+#endif
+}
+
+unsigned VertexArray::getIndexSize() const
+{
+    return sizeof(GL_INDEX_TYPE);
+}
+
+void VertexArray::updateUploadStats(int numBytes)
+{
+    if (m_UploadStatsGeneration != getGeneration()) {
+        m_UploadStatsGeneration = getGeneration();
+        m_NumBytesUploaded = 0;
     }
+    m_NumBytesUploaded += numBytes;
 }
 
 }
@@ -28,6 +28,7 @@
 
 #include <boost/shared_ptr.hpp>
 #include <map>
+#include <vector>
 
 namespace avg {
 
@@ -52,13 +53,36 @@ public:
 
     void startSubVA(SubVertexArray& subVA);
 
+    // Number of bytes transferred to the GPU since the last reset(), for all contexts.
+    int getNumBytesUploaded() const;
+
 private:
+    // What a GL buffer pair currently holds.
+    struct UploadState {
+        UploadState();
+
+        long long m_ChangeCount;
+        int m_ReserveVerts;
+        int m_ReserveIndexes;
+    };
+
+    void uploadAll(GLContext* pContext);
+    void uploadDirtyRanges(GLContext* pContext);
     void transferBuffer(GLenum target, unsigned bufferID, unsigned reservedSize, 
             unsigned usedSize, const void* pData);
+    void transferRanges(GLenum target, unsigned bufferID, unsigned elementSize,
+            const std::vector<DataRange>& ranges, const void* pData);
+    unsigned getIndexSize() const;
+    void updateUploadStats(int numBytes);
 
     typedef std::map<const GLContext*, unsigned> BufferIDMap;
     BufferIDMap m_VertexBufferIDMap;
     BufferIDMap m_IndexBufferIDMap;
+    typedef std::map<const GLContext*, UploadState> UploadStateMap;
+    UploadStateMap m_UploadStateMap;
+
+    int m_NumBytesUploaded;
+    int m_UploadStatsGeneration;
 
     bool m_bUseMapBuffer;
 };
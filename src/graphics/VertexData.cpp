@@ -38,6 +38,10 @@ namespace avg {
     
 const int VertexData::MIN_VERTEXES = 100;
 const int VertexData::MIN_INDEXES = 100;
+// Dirty ranges closer together than this are merged.
+static const int DIRTY_RANGE_GAP = 16;
+// If there are more dirty ranges than this, they are merged into one.
+static const unsigned MAX_DIRTY_RANGES = 16;
 
 glm::vec2 Vertex::posAsVec()
 {
@@ -45,12 +49,24 @@ glm::vec2 Vertex::posAsVec()
 
 }
 
+bool Vertex::operator ==(const Vertex& v) const
+{
+    return m_Pos[0] == v.m_Pos[0] && m_Pos[1] == v.m_Pos[1] &&
+            m_Tex[0] == v.m_Tex[0] && m_Tex[1] == v.m_Tex[1] && m_Color == v.m_Color;
+}
+
 VertexData::VertexData(int reserveVerts, int reserveIndexes)
     : m_NumVerts(0),
       m_NumIndexes(0),
       m_ReserveVerts(reserveVerts),
       m_ReserveIndexes(reserveIndexes),
-      m_bDataChanged(true)
+      m_NumOldVerts(0),
+      m_NumOldIndexes(0),
+      m_NumChangedVerts(0),
+      m_NumUnchangedVerts(0),
+      m_Generation(0),
+      m_ChangeCount(0),
+      m_ChangeCountAtReset(0)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     if (m_ReserveVerts < MIN_VERTEXES) {
@@ -78,13 +94,13 @@ void VertexData::appendPos(const glm::vec2& pos, const glm::vec2& texPos,
     if (m_NumVerts >= m_ReserveVerts-1) {
         grow();
     }
-    Vertex* pVertex = &(m_pVertexData[m_NumVerts]);
-    pVertex->m_Pos[0] = (GLfloat)(pos.x);
-    pVertex->m_Pos[1] = (GLfloat)(pos.y);
-    pVertex->m_Tex[0] = (GLfloat)(texPos.x);
-    pVertex->m_Tex[1] = (GLfloat)(texPos.y);
-    pVertex->m_Color = color;
-    m_bDataChanged = true;
+    Vertex vertex;
+    vertex.m_Pos[0] = (GLfloat)(pos.x);
+    vertex.m_Pos[1] = (GLfloat)(pos.y);
+    vertex.m_Tex[0] = (GLfloat)(texPos.x);
+    vertex.m_Tex[1] = (GLfloat)(texPos.y);
+    vertex.m_Color = color;
+    setVertex(m_NumVerts, vertex);
     m_NumVerts++;
 }
 
@@ -93,9 +109,9 @@ void VertexData::appendTriIndexes(int v0, int v1, int v2)
     if (m_NumIndexes >= m_ReserveIndexes-3) {
         grow();
     }
-    m_pIndexData[m_NumIndexes] = v0;
-    m_pIndexData[m_NumIndexes+1] = v1;
-    m_pIndexData[m_NumIndexes+2] = v2;
+    setIndex(m_NumIndexes, v0);
+    setIndex(m_NumIndexes+1, v1);
+    setIndex(m_NumIndexes+2, v2);
     m_NumIndexes += 3;
 }
 
@@ -104,12 +120,12 @@ void VertexData::appendQuadIndexes(int v0, int v1, int v2, int v3)
     if (m_NumIndexes >= m_ReserveIndexes-6) {
         grow();
     }
-    m_pIndexData[m_NumIndexes] = v0;
-    m_pIndexData[m_NumIndexes+1] = v1;
-    m_pIndexData[m_NumIndexes+2] = v2;
-    m_pIndexData[m_NumIndexes+3] = v1;
-    m_pIndexData[m_NumIndexes+4] = v2;
-    m_pIndexData[m_NumIndexes+5] = v3;
+    setIndex(m_NumIndexes, v0);
+    setIndex(m_NumIndexes+1, v1);
+    setIndex(m_NumIndexes+2, v2);
+    setIndex(m_NumIndexes+3, v1);
+    setIndex(m_NumIndexes+4, v2);
+    setIndex(m_NumIndexes+5, v3);
     m_NumIndexes += 6;
 }
 
@@ -135,30 +151,29 @@ void VertexData::appendVertexData(const VertexDataPtr& pVertexes)
         grow();
     }
 
-    memcpy(&(m_pVertexData[oldNumVerts]), pVertexes->m_pVertexData, 
-            pVertexes->getNumVerts()*sizeof(Vertex));
+    int numVerts = pVertexes->getNumVerts();
+    for (int i=0; i<numVerts; ++i) {
+        setVertex(oldNumVerts+i, pVertexes->m_pVertexData[i]);
+    }
     int numIndexes = pVertexes->getNumIndexes();
     for (int i=0; i<numIndexes; ++i) {
-        m_pIndexData[oldNumIndexes+i] = pVertexes->m_pIndexData[i] + oldNumVerts;
+        setIndex(oldNumIndexes+i, pVertexes->m_pIndexData[i] + oldNumVerts);
     }
-    m_bDataChanged = true;
-}
-
-bool VertexData::hasDataChanged() const
-{
-    return m_bDataChanged;
-}
-
-void VertexData::resetDataChanged()
-{
-    m_bDataChanged = false;
 }
 
 void VertexData::reset()
 {
+    // The buffer contents are kept so the next frame can be compared against them.
+    m_NumOldVerts = m_NumVerts;
+    m_NumOldIndexes = m_NumIndexes;
     m_NumVerts = 0;
     m_NumIndexes = 0;
-    m_bDataChanged = false;
+    m_NumChangedVerts = 0;
+    m_NumUnchangedVerts = 0;
+    m_DirtyVertexRanges.clear();
+    m_DirtyIndexRanges.clear();
+    m_ChangeCountAtReset = m_ChangeCount;
+    m_Generation++;
 }
 
 FRect VertexData::calcBoundingRect() const
@@ -184,6 +199,41 @@ int VertexData::getNumIndexes() const
     return m_NumIndexes;
 }
 
+int VertexData::getNumChangedVerts() const
+{
+    return m_NumChangedVerts;
+}
+
+int VertexData::getNumUnchangedVerts() const
+{
+    return m_NumUnchangedVerts;
+}
+
+const vector<VertexData::DataRange>& VertexData::getDirtyVertexRanges() const
+{
+    return m_DirtyVertexRanges;
+}
+
+const vector<VertexData::DataRange>& VertexData::getDirtyIndexRanges() const
+{
+    return m_DirtyIndexRanges;
+}
+
+int VertexData::getGeneration() const
+{
+    return m_Generation;
+}
+
+long long VertexData::getChangeCount() const
+{
+    return m_ChangeCount;
+}
+
+long long VertexData::getChangeCountAtReset() const
+{
+    return m_ChangeCountAtReset;
+}
+
 void VertexData::dump() const
 {
     dump(0, m_NumVerts, 0, m_NumIndexes);
@@ -206,9 +256,7 @@ void VertexData::dump(unsigned startVertex, int numVerts, unsigned startIndex,
 
 void VertexData::grow()
 {
-    bool bChanged = false;
     if (m_NumVerts >= m_ReserveVerts-1) {
-        bChanged = true;
         int oldReserveVerts = m_ReserveVerts;
         m_ReserveVerts = int(m_ReserveVerts*1.5);
 #ifdef AVG_ENABLE_EGL
@@ -226,7 +274,6 @@ void VertexData::grow()
         delete[] pVertexData;
     }
     if (m_NumIndexes >= m_ReserveIndexes-6) {
-        bChanged = true;
         int oldReserveIndexes = m_ReserveIndexes;
         m_ReserveIndexes = int(m_ReserveIndexes*1.5);
         if (m_ReserveIndexes < m_NumIndexes) {
@@ -237,8 +284,37 @@ void VertexData::grow()
         memcpy(m_pIndexData, pIndexData, sizeof(GL_INDEX_TYPE)*oldReserveIndexes);
         delete[] pIndexData;
     }
-    if (bChanged) {
-        m_bDataChanged = true;
+}
+
+void VertexData::setVertex(int i, const Vertex& vertex)
+{
+    if (i < m_NumOldVerts && m_pVertexData[i] == vertex) {
+        m_NumUnchangedVerts++;
+    } else {
+        m_pVertexData[i] = vertex;
+        m_NumChangedVerts++;
+        markDirty(m_DirtyVertexRanges, i);
+    }
+}
+
+void VertexData::setIndex(int i, GL_INDEX_TYPE index)
+{
+    if (i >= m_NumOldIndexes || m_pIndexData[i] != index) {
+        m_pIndexData[i] = index;
+        markDirty(m_DirtyIndexRanges, i);
+    }
+}
+
+void VertexData::markDirty(vector<DataRange>& ranges, int i)
+{
+    m_ChangeCount++;
+    if (!ranges.empty() && i <= ranges.back().second+DIRTY_RANGE_GAP) {
+        ranges.back().second = max(ranges.back().second, i+1);
+    } else if (ranges.size() >= MAX_DIRTY_RANGES) {
+        ranges.front().second = i+1;
+        ranges.resize(1);
+    } else {
+        ranges.push_back(DataRange(i, i+1));
     }
 }
 
@@ -32,10 +32,13 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <vector>
+
 namespace avg {
 
 struct Vertex {
     glm::vec2 posAsVec();
+    bool operator ==(const Vertex& v) const;
     GLfloat m_Tex[2];
     GLfloat m_Pos[2];
     Pixel32 m_Color;
@@ -50,8 +53,15 @@ typedef boost::shared_ptr<VertexData> VertexDataPtr;
 #define GL_INDEX_TYPE unsigned int 
 #endif
 
+// reset() keeps the buffer contents: Appended data is compared to the data of the
+// previous frame at the same position and only spans that actually change are marked
+// dirty. This allows VertexArray to upload only the changed parts of the buffers. All
+// vertices are still generated every frame; the comparison is cheap compared to
+// transferring unchanged data to the graphics card.
 class AVG_API VertexData {
 public:
+    typedef std::pair<int, int> DataRange;      // [first, last+1)
+
     VertexData(int reserveVerts = 0, int reserveIndexes = 0);
     virtual ~VertexData();
 
@@ -62,13 +72,23 @@ public:
     void addLineData(Pixel32 color, const glm::vec2& p1, const glm::vec2& p2, 
             float width, float tc1=0, float tc2=1);
     void appendVertexData(const VertexDataPtr& pVertexes);
-    bool hasDataChanged() const;
-    void resetDataChanged();
     void reset();
     FRect calcBoundingRect() const;
 
     int getNumVerts() const;
     int getNumIndexes() const;
+
+    // Statistics and dirty state since the last reset().
+    int getNumChangedVerts() const;
+    int getNumUnchangedVerts() const;
+    const std::vector<DataRange>& getDirtyVertexRanges() const;
+    const std::vector<DataRange>& getDirtyIndexRanges() const;
+    int getGeneration() const;
+    // Incremented on every change. Together with getChangeCountAtReset(), this allows
+    // a buffer holder to determine whether the dirty ranges suffice to update it.
+    long long getChangeCount() const;
+    long long getChangeCountAtReset() const;
+
     void dump() const;
     void dump(unsigned startVertex, int numVerts, unsigned startIndex, int numIndexes) 
             const;
@@ -85,6 +105,9 @@ protected:
 
 private:
     void grow();
+    void setVertex(int i, const Vertex& vertex);
+    void setIndex(int i, GL_INDEX_TYPE index);
+    void markDirty(std::vector<DataRange>& ranges, int i);
 
     int m_NumVerts;
     int m_NumIndexes;
@@ -93,7 +116,15 @@ private:
     Vertex * m_pVertexData;
     GL_INDEX_TYPE * m_pIndexData;
 
-    bool m_bDataChanged;
+    int m_NumOldVerts;
+    int m_NumOldIndexes;
+    int m_NumChangedVerts;
+    int m_NumUnchangedVerts;
+    std::vector<DataRange> m_DirtyVertexRanges;
+    std::vector<DataRange> m_DirtyIndexRanges;
+    int m_Generation;
+    long long m_ChangeCount;
+    long long m_ChangeCountAtReset;
 };
 
 std::ostream& operator<<(std::ostream& os, const Vertex& v);
@@ -36,9 +36,13 @@
 #include "FilterGauss.h"
 #include "FilterBlur.h"
 #include "FilterBandpass.h"
+#include "FilterResizeBilinear.h"
+#include "FilterResample.h"
 
 #include "../base/TimeSource.h"
+#include "../base/StringHelper.h"
 
+#include <cstring>
 #include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
@@ -47,16 +51,21 @@ using namespace avg;
 using namespace std;
 
 template<class TEST>
-void runPerformanceTest(int numRuns=500)
+void runPerformanceTest(TEST& perfTest, int numRuns)
 {
-    TEST PerfTest;
     long long StartTime = TimeSource::get()->getCurrentMicrosecs();
     for (int i = 0; i < numRuns; ++i) {
-        PerfTest.run();
+        perfTest.run();
     }
     float ActiveTime = (TimeSource::get()->getCurrentMicrosecs()-StartTime)/1000.; 
-    cerr << PerfTest.getName() << ": " << ActiveTime/numRuns << " ms" << endl;
-    
+    cerr << perfTest.getName() << ": " << ActiveTime/numRuns << " ms" << endl;
+}
+
+template<class TEST>
+void runPerformanceTest(int numRuns=500)
+{
+    TEST PerfTest;
+    runPerformanceTest(PerfTest, numRuns);
 }
 
 class PerfTestBase {
@@ -233,6 +242,184 @@ private:
         
 };
 
+class NV12toRGBPerfTest: public PerfTestBase {
+public:
+    NV12toRGBPerfTest() 
+        : PerfTestBase("NV12toRGBPerfTest 1920x1080")
+    {
+        m_pYBmp = BitmapPtr(new Bitmap(IntPoint(1920, 1080), I8));
+        m_pUVBmp = BitmapPtr(new Bitmap(IntPoint(1920, 540), I8));
+        m_pRGBBmp = BitmapPtr(new Bitmap(IntPoint(1920, 1080), B8G8R8X8));
+    }
+
+    void run()
+    {
+        m_pRGBBmp->copyNV12Pixels(*m_pYBmp, *m_pUVBmp, false);
+    }
+
+private:
+    BitmapPtr m_pYBmp;
+    BitmapPtr m_pUVBmp;
+    BitmapPtr m_pRGBBmp;
+};
+
+class ConversionPerfTest: public PerfTestBase {
+public:
+    ConversionPerfTest(PixelFormat srcPF, PixelFormat destPF, const IntPoint& size)
+        : PerfTestBase("ConversionPerfTest "+getPixelFormatString(srcPF)+"->"+
+                getPixelFormatString(destPF)+" "+toString(size.x)+"x"+toString(size.y))
+    {
+        m_pSrcBmp = BitmapPtr(new Bitmap(size, srcPF));
+        m_pDestBmp = BitmapPtr(new Bitmap(size, destPF));
+        memset(m_pSrcBmp->getPixels(), 0x80, m_pSrcBmp->getMemNeeded());
+    }
+
+    void run()
+    {
+        m_pDestBmp->copyPixels(*m_pSrcBmp);
+    }
+
+private:
+    BitmapPtr m_pSrcBmp;
+    BitmapPtr m_pDestBmp;
+};
+
+void runConversionPerformanceTests(const IntPoint& size, int numRuns)
+{
+    PixelFormat rgbPFs[] = {B8G8R8A8, B8G8R8X8, R8G8B8A8, R8G8B8X8, B8G8R8, R8G8B8, 
+            B5G6R5, I8};
+    int numRGBPFs = sizeof(rgbPFs)/sizeof(PixelFormat);
+    for (int i = 0; i < numRGBPFs; ++i) {
+        for (int j = 0; j < numRGBPFs; ++j) {
+            if (rgbPFs[i] == I8 && rgbPFs[j] == B5G6R5) {
+                // Unsupported conversion.
+                continue;
+            }
+            ConversionPerfTest test(rgbPFs[i], rgbPFs[j], size);
+            runPerformanceTest(test, numRuns);
+        }
+    }
+    PixelFormat yuvPFs[] = {YCbCr422, YUYV422};
+    for (int i = 0; i < 2; ++i) {
+        ConversionPerfTest bgrTest(yuvPFs[i], B8G8R8X8, size);
+        runPerformanceTest(bgrTest, numRuns);
+        ConversionPerfTest i8Test(yuvPFs[i], I8, size);
+        runPerformanceTest(i8Test, numRuns);
+    }
+    PixelFormat bayerPFs[] = {BAYER8_RGGB, BAYER8_GBRG, BAYER8_GRBG, BAYER8_BGGR};
+    for (int i = 0; i < 4; ++i) {
+        ConversionPerfTest test(bayerPFs[i], B8G8R8X8, size);
+        runPerformanceTest(test, numRuns);
+    }
+    PixelFormat otherPFs[][2] = {{I8, I16}, {I16, I8}, {R8G8B8A8, R32G32B32A32F}, 
+            {R32G32B32A32F, R8G8B8A8}};
+    for (int i = 0; i < 4; ++i) {
+        ConversionPerfTest test(otherPFs[i][0], otherPFs[i][1], size);
+        runPerformanceTest(test, numRuns);
+    }
+}
+
+// Runs a filter on a bitmap filled with noise. Reports megapixels per second in
+// addition to the time so runs on different bitmap sizes can be compared.
+class FilterPerfTest: public PerfTestBase {
+public:
+    FilterPerfTest(const string& sFilterName, FilterPtr pFilter, PixelFormat pf,
+            const IntPoint& size)
+        : PerfTestBase("FilterPerfTest "+sFilterName+" "+getPixelFormatString(pf)+" "+
+                toString(size.x)+"x"+toString(size.y)),
+          m_pFilter(pFilter)
+    {
+        m_pBmp = BitmapPtr(new Bitmap(size, pf));
+        srand(42);
+        for (int y = 0; y < size.y; ++y) {
+            unsigned char* pLine = m_pBmp->getPixels()+y*m_pBmp->getStride();
+            for (int x = 0; x < m_pBmp->getLineLen(); ++x) {
+                pLine[x] = (unsigned char)(rand());
+            }
+        }
+    }
+
+    void run()
+    {
+        BitmapPtr pDestBmp = m_pFilter->apply(m_pBmp);
+    }
+
+    float getMegapixels() const
+    {
+        IntPoint size = m_pBmp->getSize();
+        return float(size.x)*size.y/1000000;
+    }
+
+private:
+    FilterPtr m_pFilter;
+    BitmapPtr m_pBmp;
+};
+
+void runFilterPerformanceTest(FilterPerfTest& perfTest, int numRuns)
+{
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    for (int i = 0; i < numRuns; ++i) {
+        perfTest.run();
+    }
+    float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+    cerr << perfTest.getName() << ": " << activeTime/numRuns << " ms, "
+            << perfTest.getMegapixels()*numRuns*1000/activeTime << " MP/s" << endl;
+}
+
+void runFilterPerformanceTests(const IntPoint& size, int numRuns)
+{
+    float mat3x3[3][3] = {{1/16.f, 2/16.f, 1/16.f}, {2/16.f, 4/16.f, 2/16.f},
+            {1/16.f, 2/16.f, 1/16.f}};
+    float mat5x5[25];
+    for (int i = 0; i < 25; ++i) {
+        mat5x5[i] = 1/25.f;
+    }
+    float gaussRadii[] = {1, 3, 8};
+    for (int i = 0; i < 3; ++i) {
+        FilterPtr pGauss(new FilterGauss(gaussRadii[i]));
+        string sName = "Gauss("+toString(gaussRadii[i])+")";
+        FilterPerfTest i8Test(sName, pGauss, I8, size);
+        runFilterPerformanceTest(i8Test, numRuns);
+        FilterPerfTest rgbaTest(sName, pGauss, B8G8R8A8, size);
+        runFilterPerformanceTest(rgbaTest, numRuns);
+    }
+    FilterPerfTest test3x3("3x3", FilterPtr(new Filter3x3(mat3x3)), B8G8R8A8, size);
+    runFilterPerformanceTest(test3x3, numRuns);
+    FilterPerfTest convolI8Test("Convol(5x5)",
+            FilterPtr(new FilterConvol<Pixel8>(mat5x5, 5, 5)), I8, size);
+    runFilterPerformanceTest(convolI8Test, numRuns);
+    FilterPerfTest convolRGBATest("Convol(5x5)",
+            FilterPtr(new FilterConvol<Pixel32>(mat5x5, 5, 5)), B8G8R8A8, size);
+    runFilterPerformanceTest(convolRGBATest, numRuns);
+    FilterPerfTest blurTest("Blur", FilterPtr(new FilterBlur()), I8, size);
+    runFilterPerformanceTest(blurTest, numRuns);
+    FilterPerfTest highpassTest("Highpass", FilterPtr(new FilterHighpass()), I8, size);
+    runFilterPerformanceTest(highpassTest, numRuns);
+    FilterPerfTest bandpassTest("Bandpass", FilterPtr(new FilterBandpass(1.9f, 3)), I8,
+            size);
+    runFilterPerformanceTest(bandpassTest, numRuns);
+}
+
+void runResamplePerformanceTests(const IntPoint& size, int numRuns)
+{
+    IntPoint destSizes[] = {size/4, size*2};
+    for (int i = 0; i < 2; ++i) {
+        string sSize = toString(destSizes[i].x)+"x"+toString(destSizes[i].y);
+        FilterPerfTest resizeTest("ResizeBilinear("+sSize+")",
+                FilterPtr(new FilterResizeBilinear(destSizes[i])), B8G8R8A8, size);
+        runFilterPerformanceTest(resizeTest, numRuns);
+        ResampleFilter filters[] = {RESAMPLE_BOX, RESAMPLE_MITCHELL, RESAMPLE_LANCZOS};
+        for (int j = 0; j < 3; ++j) {
+            string sName = "Resample("+resampleFilter2String(filters[j])+", "+sSize+")";
+            FilterPtr pFilter(new FilterResample(destSizes[i], filters[j]));
+            FilterPerfTest rgbaTest(sName, pFilter, B8G8R8A8, size);
+            runFilterPerformanceTest(rgbaTest, numRuns);
+            FilterPerfTest rgbxTest(sName, pFilter, B8G8R8X8, size);
+            runFilterPerformanceTest(rgbxTest, numRuns);
+        }
+    }
+}
+
 void runPerformanceTests()
 {
     runPerformanceTest<LoadPNGPerfTest>();
@@ -244,6 +431,11 @@ void runPerformanceTests()
     runPerformanceTest<CopyRGBPerfTest>();
     runPerformanceTest<CopyRGBAPerfTest>();
     runPerformanceTest<YUV2RGBPerfTest>(200);
+    runPerformanceTest<NV12toRGBPerfTest>(100);
+    runConversionPerformanceTests(IntPoint(1920, 1080), 20);
+    runConversionPerformanceTests(IntPoint(3840, 2160), 5);
+    runFilterPerformanceTests(IntPoint(1920, 1080), 20);
+    runResamplePerformanceTests(IntPoint(1920, 1080), 10);
 }
 
 int main(int nargs, char** args)
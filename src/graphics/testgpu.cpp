@@ -37,6 +37,7 @@
 #include "PBO.h"
 #include "ImageCache.h"
 #include "CachedImage.h"
+#include "TextureAtlas.h"
 
 #include "../base/TestSuite.h"
 #include "../base/Exception.h"
@@ -468,9 +469,66 @@ public:
         pCache->setCapacity(0, 0);
         TEST(pCache->getNumCPUImages() == 0);
         TEST(pCache->getNumGPUImages() == 0);
+
+        cerr << "    Testing pinned images" << endl;
+        testPinning();
+        cerr << "    Testing eviction policies" << endl;
+        testEvictionPolicy("lru", true);
+        testEvictionPolicy("lfu", false);
+        testEvictionPolicy("greedydual", false);
+        pCache->setPolicy("lru");
     }
 
 private:
+    void testPinning()
+    {
+        ImageCache* pCache = ImageCache::get();
+        CachedImage::StorageType st = CachedImage::STORAGE_CPU;
+        long long numHits = pCache->getNumHits(st);
+        long long numMisses = pCache->getNumMisses(st);
+        long long numEvictions = pCache->getNumEvictions(st);
+        string sName = getTestBmpName("rgb24-64x64");
+        pCache->pinImage(sName, TEXCOMPRESSION_NONE);
+        TEST(pCache->isPinned(sName, TEXCOMPRESSION_NONE));
+        TEST(!pCache->isPinned(sName, TEXCOMPRESSION_B5G6R5));
+        CachedImagePtr pImage = pCache->getImage(sName, TEXCOMPRESSION_NONE);
+        pImage->decBmpRef();
+        TEST(pCache->getNumCPUImages() == 1);
+        pImage = pCache->getImage(sName, TEXCOMPRESSION_NONE);
+        pImage->decBmpRef();
+        TEST(pCache->getNumHits(st) == numHits+1);
+        TEST(pCache->getNumMisses(st) == numMisses+1);
+        TEST(pCache->getNumEvictions(st) == numEvictions);
+        pCache->unpinImage(sName, TEXCOMPRESSION_NONE);
+        TEST(pCache->getNumCPUImages() == 0);
+        TEST(pCache->getNumEvictions(st) == numEvictions+1);
+    }
+
+    void testEvictionPolicy(const string& sPolicy, bool bSmallImageEvicted)
+    {
+        ImageCache* pCache = ImageCache::get();
+        pCache->setPolicy(sPolicy);
+        TEST(pCache->getPolicy() == sPolicy);
+        // Enough room for the large and one of the other images.
+        pCache->setCapacity(34000, 0);
+        string sSmallName = getTestBmpName("rgb24-32x32");
+        string sLargeName = getTestBmpName("rgb24-64x64");
+        // The small image is used more often, the large one more recently.
+        CachedImagePtr pSmallImage = pCache->getImage(sSmallName, TEXCOMPRESSION_NONE);
+        pCache->getImage(sSmallName, TEXCOMPRESSION_NONE);
+        pSmallImage->decBmpRef();
+        pSmallImage->decBmpRef();
+        CachedImagePtr pLargeImage = pCache->getImage(sLargeName, TEXCOMPRESSION_NONE);
+        pLargeImage->decBmpRef();
+        CachedImagePtr pImage = pCache->getImage(getTestBmpName("rgb24-65x65"),
+                TEXCOMPRESSION_NONE);
+        TEST(pCache->getNumCPUImages() == 2);
+        TEST(pCache->hasImage(sSmallName, TEXCOMPRESSION_NONE) != bSmallImageEvicted);
+        TEST(pCache->hasImage(sLargeName, TEXCOMPRESSION_NONE) == bSmallImageEvicted);
+        pImage->decBmpRef();
+        pCache->setCapacity(0, 0);
+    }
+
     void loadImages()
     {
         GLContextManager* pCM = GLContextManager::get();
@@ -505,6 +563,147 @@ private:
 };
 
 
+class TextureAtlasTest: public GraphicsTest {
+public:
+    TextureAtlasTest()
+        : GraphicsTest("TextureAtlasTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        TextureAtlas* pAtlas = TextureAtlas::get();
+        pAtlas->setEnabled(true);
+        TEST(!pAtlas->canAdd(IntPoint(257, 16), B8G8R8X8));
+        TEST(!pAtlas->canAdd(IntPoint(16, 16), YCbCr420p));
+        {
+            BitmapPtr pBmp1 = loadTestBmp("rgb24-65x65");
+            BitmapPtr pBmp2 = loadTestBmp("rgb24-64x64");
+            BitmapPtr pBmp3 = loadTestBmp("rgb24-32x32");
+            TextureAtlasRegionPtr pRegion1 = pAtlas->add(pBmp1);
+            TextureAtlasRegionPtr pRegion2 = pAtlas->add(pBmp2);
+            TextureAtlasRegionPtr pRegion3 = pAtlas->add(pBmp3);
+            TEST(pAtlas->getNumPages() == 1);
+            TEST(pAtlas->getNumRegions() == 3);
+            TEST(pRegion1->getTex() == pRegion2->getTex());
+            TEST(pRegion1->getRect().size() == pBmp1->getSize());
+
+            // The three images are uploaded together, but not the rest of the page.
+            GLContextManager* pCM = GLContextManager::get();
+            IntRect dirtyRect = getAllocRect(pRegion1);
+            dirtyRect.expand(getAllocRect(pRegion2));
+            dirtyRect.expand(getAllocRect(pRegion3));
+            int bpp = pBmp1->getBytesPerPixel();
+            pCM->endFrame();
+            pCM->uploadData();
+            pCM->endFrame();
+            TEST(pCM->getLastFrameUploadBytes() ==
+                    (long long)(dirtyRect.width())*dirtyRect.height()*bpp);
+            BitmapPtr pPageBmp = pRegion1->getTex()->getTex(GLContext::getCurrent())->
+                    moveTextureToBmp();
+            testRegion(pPageBmp, pRegion1, pBmp1, "atlas1");
+            testRegion(pPageBmp, pRegion2, pBmp2, "atlas2");
+            testRegion(pPageBmp, pRegion3, pBmp3, "atlas3");
+
+            // Freed space is reused.
+            IntRect rect2 = pRegion2->getRect();
+            pRegion2 = TextureAtlasRegionPtr();
+            TEST(pAtlas->getNumRegions() == 2);
+            pRegion2 = pAtlas->add(pBmp2);
+            TEST(pRegion2->getRect() == rect2);
+            pCM->uploadData();
+            pCM->endFrame();
+            IntRect allocRect = getAllocRect(pRegion2);
+            TEST(pCM->getLastFrameUploadBytes() ==
+                    (long long)(allocRect.width())*allocRect.height()*bpp);
+            pPageBmp = pRegion2->getTex()->getTex(GLContext::getCurrent())->
+                    moveTextureToBmp();
+            testRegion(pPageBmp, pRegion1, pBmp1, "atlas1");
+            testRegion(pPageBmp, pRegion2, pBmp2, "atlas2");
+        }
+        TEST(pAtlas->getNumPages() == 0);
+        TEST(pAtlas->getUsedPixels() == 0);
+        pAtlas->setEnabled(false);
+    }
+
+private:
+    IntRect getAllocRect(TextureAtlasRegionPtr pRegion)
+    {
+        const IntRect& rect = pRegion->getRect();
+        return IntRect(rect.tl-IntPoint(1,1), rect.br+IntPoint(1,1));
+    }
+
+    void testRegion(BitmapPtr pPageBmp, TextureAtlasRegionPtr pRegion, BitmapPtr pBmp,
+            const string& sName)
+    {
+        Bitmap regionBmp(*pPageBmp, pRegion->getRect());
+        testEqual(regionBmp, *pBmp, sName, 0.01, 0.1);
+        // The border repeats the edge pixels.
+        IntRect rect = pRegion->getRect();
+        IntRect borderRect(rect.tl.x-1, rect.tl.y, rect.tl.x, rect.br.y);
+        Bitmap borderBmp(*pPageBmp, borderRect);
+        Bitmap edgeBmp(*pBmp, IntRect(0, 0, 1, rect.height()));
+        testEqual(borderBmp, edgeBmp, sName+"-border", 0.01, 0.1);
+    }
+};
+
+
+class TexUploadBudgetTest: public GraphicsTest {
+public:
+    TexUploadBudgetTest()
+        : GraphicsTest("TexUploadBudgetTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        GLContextManager* pCM = GLContextManager::get();
+        BitmapPtr pBigBmp = loadTestBmp("rgb24-65x65");
+        BitmapPtr pSmallBmp = loadTestBmp("rgb24-32x32");
+        long long rowBytes = pBigBmp->getSize().x*pBigBmp->getBytesPerPixel();
+        long long smallBytes = pSmallBmp->getSize().x*pSmallBmp->getSize().y*
+                pSmallBmp->getBytesPerPixel();
+        long long numPartialUploads = pCM->getNumPartialUploads();
+        // Enough for the small bitmap and a few lines of the big one.
+        pCM->setTexUploadBudget(smallBytes+6*rowBytes);
+
+        MCTexturePtr pBigTex = pCM->createTextureFromBmp(pBigBmp, false, false, 0,
+                UPLOADPRIORITY_BACKGROUND);
+        MCTexturePtr pSmallTex = pCM->createTextureFromBmp(pSmallBmp, false, false, 0,
+                UPLOADPRIORITY_BACKGROUND);
+        MCTexturePtr pImmediateTex = pCM->createTextureFromBmp(pBigBmp);
+        pCM->raiseTexUploadPriority(pSmallTex, UPLOADPRIORITY_VISIBLE);
+        TEST(pCM->getNumDeferredUploads() == 3);
+        pCM->uploadData();
+        pCM->endFrame();
+        TEST(!pCM->isTexUploadPending(pImmediateTex));
+        TEST(!pCM->isTexUploadPending(pSmallTex));
+        TEST(pCM->isTexUploadPending(pBigTex));
+        TEST(pCM->getNumDeferredUploads() == 1);
+        TEST(pCM->getDeferredUploadBytes() == (pBigBmp->getSize().y-6)*rowBytes);
+        TEST(pCM->getLastFrameUploadBytes() ==
+                pBigBmp->getSize().y*rowBytes+smallBytes+6*rowBytes);
+        TEST(pCM->getNumPartialUploads() == numPartialUploads+1);
+
+        // The rest of the big bitmap is uploaded in stripes.
+        int numFrames = 0;
+        while (pCM->isTexUploadPending(pBigTex) && numFrames < 100) {
+            pCM->uploadData();
+            pCM->endFrame();
+            numFrames++;
+        }
+        TEST(numFrames > 1 && numFrames < 100);
+        TEST(pCM->getNumDeferredUploads() == 0);
+        GLContext* pContext = GLContext::getCurrent();
+        BitmapPtr pDestBmp = pBigTex->getTex(pContext)->moveTextureToBmp();
+        testEqual(*pDestBmp, *pBigBmp, "TexUploadBudget", 0.01, 0.1);
+        pDestBmp = pSmallTex->getTex(pContext)->moveTextureToBmp();
+        testEqual(*pDestBmp, *pSmallBmp, "TexUploadBudgetSmall", 0.01, 0.1);
+        pCM->setTexUploadBudget(0);
+    }
+};
+
+
 class GPUTestSuite: public TestSuite {
 public:
     GPUTestSuite(const string& sVariant) 
@@ -512,6 +711,8 @@ public:
     {
         addTest(TestPtr(new TextureMoverTest));
         addTest(TestPtr(new ImageCacheTest));
+        addTest(TestPtr(new TextureAtlasTest));
+        addTest(TestPtr(new TexUploadBudgetTest));
         addTest(TestPtr(new BrightnessFilterTest));
         addTest(TestPtr(new HueSatFilterTest));
         addTest(TestPtr(new InvertFilterTest));
@@ -22,6 +22,7 @@
 #include "GraphicsTest.h"
 #include "Bitmap.h"
 #include "BitmapLoader.h"
+#include "BitmapPool.h"
 #include "Pixel32.h"
 #include "Pixel24.h"
 #include "Pixel16.h"
@@ -46,6 +47,7 @@
 #include "FilterErosion.h"
 #include "FilterGetAlpha.h"
 #include "FilterResizeBilinear.h"
+#include "FilterResample.h"
 #include "FilterUnmultiplyAlpha.h"
 
 #include "../base/TestSuite.h"
@@ -281,6 +283,7 @@ public:
         }
         testCopyToGreyscale(R8G8B8X8);
         testCopyToGreyscale(B8G8R8X8);
+        testLargeCopyPixels();
         testSubtract();
         {
             cerr << "    Testing statistics." << endl;
@@ -420,6 +423,44 @@ private:
         TEST(almostEqual(pBmp->getChannelAvg(2), 32));
     }
 
+    void testLargeCopyPixels()
+    {
+        // Large bitmaps are converted in parallel bands using SIMD code, so the
+        // results are compared to per-pixel reference values.
+        cerr << "    Testing copyPixels - large bitmaps." << endl;
+        IntPoint size(1001, 701);
+        BitmapPtr pRGBBmp(new Bitmap(size, R8G8B8X8));
+        BitmapPtr pGreyBaselineBmp(new Bitmap(size, I8));
+        BitmapPtr pRGBBaselineBmp(new Bitmap(size, R8G8B8X8));
+        for (int y = 0; y < size.y; ++y) {
+            for (int x = 0; x < size.x; ++x) {
+                Pixel32 color(x%256, y%256, (x+y)%256, 255);
+                pRGBBmp->setPixel(IntPoint(x, y), color);
+                unsigned char grey = 
+                        (color.getR()*54+color.getG()*183+color.getB()*19)/256;
+                pGreyBaselineBmp->setPixel(IntPoint(x, y), Pixel8(grey));
+                pRGBBaselineBmp->setPixel(IntPoint(x, y), Pixel32(grey, grey, grey, 255));
+            }
+        }
+        Bitmap greyBmp(size, I8);
+        greyBmp.copyPixels(*pRGBBmp);
+        testEqual(greyBmp, *pGreyBaselineBmp, "LargeCopyPixels_RGB_I8");
+
+        Bitmap rgbBmp(size, R8G8B8X8);
+        rgbBmp.copyPixels(greyBmp);
+        testEqual(rgbBmp, *pRGBBaselineBmp, "LargeCopyPixels_I8_RGB");
+
+        Bitmap i16Bmp(size, I16);
+        i16Bmp.copyPixels(greyBmp);
+        greyBmp.copyPixels(i16Bmp);
+        testEqual(greyBmp, *pGreyBaselineBmp, "LargeCopyPixels_I16");
+
+        Bitmap floatBmp(size, R32G32B32A32F);
+        floatBmp.copyPixels(*pRGBBmp);
+        rgbBmp.copyPixels(floatBmp);
+        testEqual(rgbBmp, *pRGBBmp, "LargeCopyPixels_Float");
+    }
+
     void testYUV2RGB()
     {
         BitmapPtr pYBmp = BitmapPtr(new Bitmap(IntPoint(16, 16), I8));
@@ -438,10 +479,103 @@ private:
         FilterFill<Pixel32>(Pixel32(255,0,0,255)).applyInPlace(pRGBBmp);
         pRGBBmp->copyYUVPixels(*pYBmp, *pUBmp, *pVBmp, false);
         testEqual(*pRGBBmp, "YUV2RGBResult1", B8G8R8X8, 0.5, 0.5);
+
+        // Interleaved chroma and red-first destinations must give the same result.
+        BitmapPtr pUVBmp = BitmapPtr(new Bitmap(IntPoint(16, 8), I8));
+        for (int y=0; y<8; ++y) {
+            for (int x=0; x<8; ++x) {
+                pUVBmp->getPixels()[y*pUVBmp->getStride()+x*2] = 
+                        pUBmp->getPixels()[y*pUBmp->getStride()+x];
+                pUVBmp->getPixels()[y*pUVBmp->getStride()+x*2+1] = 
+                        pVBmp->getPixels()[y*pVBmp->getStride()+x];
+            }
+        }
+        Bitmap nv12Bmp(IntPoint(16, 16), B8G8R8X8);
+        nv12Bmp.copyNV12Pixels(*pYBmp, *pUVBmp, false);
+        testEqual(nv12Bmp, *pRGBBmp, "YUV2RGB_NV12", 0, 0);
+        Bitmap rgbxBmp(IntPoint(16, 16), R8G8B8X8);
+        rgbxBmp.copyYUVPixels(*pYBmp, *pUBmp, *pVBmp, false);
+        Bitmap bgrxBmp(IntPoint(16, 16), B8G8R8X8);
+        bgrxBmp.copyPixels(rgbxBmp);
+        testEqual(bgrxBmp, *pRGBBmp, "YUV2RGB_RGBX", 0, 0);
+
+        // Widths that aren't a multiple of the SIMD width.
+        Bitmap narrowBmp(IntPoint(13, 16), B8G8R8X8);
+        narrowBmp.copyYUVPixels(*pYBmp, *pUBmp, *pVBmp, false);
+        Bitmap croppedBmp(*pRGBBmp, IntRect(0, 0, 13, 16));
+        testEqual(narrowBmp, croppedBmp, "YUV2RGB_Narrow", 0, 0);
     }
 
 };
 
+class BitmapPoolTest: public GraphicsTest {
+public:
+    BitmapPoolTest()
+        : GraphicsTest("BitmapPoolTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        BitmapPoolPtr pPool(new BitmapPool(2, "BitmapPoolTest"));
+        BitmapPtr pBmp = pPool->getBmp(IntPoint(16,16), I8);
+        Bitmap* pRawBmp = pBmp.get();
+        pBmp = BitmapPtr();
+        TEST(pPool->getNumFreeBmps() == 1);
+        // Bitmaps are only recycled if size and pixel format match.
+        pBmp = pPool->getBmp(IntPoint(16,16), B8G8R8X8);
+        TEST(pPool->getNumBmpsAllocated() == 2);
+        pBmp = pPool->getBmp(IntPoint(16,16), I8);
+        TEST(pBmp.get() == pRawBmp);
+        TEST(pPool->getNumBmpsAllocated() == 2);
+        TEST(pPool->getNumFreeBmps() == 1);
+
+        vector<BitmapPtr> pBmps;
+        for (int i = 0; i < 4; ++i) {
+            pBmps.push_back(pPool->getBmp(IntPoint(8,8), I8));
+        }
+        pBmps.clear();
+        TEST(pPool->getNumFreeBmps() == 2);
+
+        // Bitmaps that outlive the pool are deleted normally.
+        pBmp = pPool->getBmp(IntPoint(8,8), I8);
+        pPool = BitmapPoolPtr();
+        pBmp = BitmapPtr();
+    }
+};
+
+class BitmapLoaderTest: public GraphicsTest {
+public:
+    BitmapLoaderTest()
+        : GraphicsTest("BitmapLoaderTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        string sFName = getTestBmpName("rgb24-64x64");
+        BitmapPtr pFullBmp = loadTestBmp("rgb24-64x64", B8G8R8X8);
+
+        BitmapPtr pBmp = loadBitmap(sFName, IntPoint(32,32), IntRect(0,0,0,0), 
+                B8G8R8X8);
+        TEST(pBmp->getSize() == IntPoint(32,32));
+        BitmapPtr pResizedBmp = FilterResizeBilinear(IntPoint(32,32)).apply(pFullBmp);
+        testEqual(*pBmp, *pResizedBmp, "BmpLoaderScaled", 4, 8);
+
+        pBmp = loadBitmap(sFName, IntPoint(16,0));
+        TEST(pBmp->getSize() == IntPoint(16,16));
+
+        IntRect srcRect(8, 8, 40, 24);
+        pBmp = loadBitmap(sFName, IntPoint(0,0), srcRect, B8G8R8X8);
+        TEST(pBmp->getSize() == IntPoint(32,16));
+        Bitmap croppedBmp(*pFullBmp, srcRect);
+        testEqual(*pBmp, croppedBmp, "BmpLoaderRect");
+
+        TEST_EXCEPTION(loadBitmap(sFName, IntPoint(16,16), IntRect(32,32,80,80)),
+                Exception);
+    }
+};
+
 class FilterColorizeTest: public GraphicsTest {
 public:
     FilterColorizeTest()
@@ -759,6 +893,36 @@ public:
         testEqual(*pDestBmp, "Gauss15Result", I8);
         pDestBmp = FilterGauss(5).apply(pBmp);
         testEqual(*pDestBmp, "Gauss5Result", I8);
+
+        // Large enough for the vectorized and threaded code paths. Every channel of a
+        // 32 bit bitmap needs to be filtered exactly like an I8 bitmap.
+        IntPoint size(300, 300);
+        BitmapPtr pI8Bmp = BitmapPtr(new Bitmap(size, I8));
+        BitmapPtr pRGBABmp = BitmapPtr(new Bitmap(size, B8G8R8A8));
+        for (int y = 0; y < size.y; ++y) {
+            unsigned char * pI8Line = pI8Bmp->getPixels()+y*pI8Bmp->getStride();
+            unsigned char * pRGBALine = pRGBABmp->getPixels()+y*pRGBABmp->getStride();
+            for (int x = 0; x < size.x; ++x) {
+                pI8Line[x] = (unsigned char)((x*7+y*13+(x*y)%31)&0xff);
+                memset(pRGBALine+x*4, pI8Line[x], 4);
+            }
+        }
+        BitmapPtr pI8DestBmp = FilterGauss(3).apply(pI8Bmp);
+        BitmapPtr pRGBADestBmp = FilterGauss(3).apply(pRGBABmp);
+        TEST(pRGBADestBmp->getSize() == pI8DestBmp->getSize());
+        bool bChannelsEqual = true;
+        IntPoint destSize = pI8DestBmp->getSize();
+        for (int y = 0; y < destSize.y; ++y) {
+            unsigned char * pI8Line = pI8DestBmp->getPixels()+y*pI8DestBmp->getStride();
+            unsigned char * pRGBALine =
+                    pRGBADestBmp->getPixels()+y*pRGBADestBmp->getStride();
+            for (int x = 0; x < destSize.x*4; ++x) {
+                if (pRGBALine[x] != pI8Line[x/4]) {
+                    bChannelsEqual = false;
+                }
+            }
+        }
+        TEST(bChannelsEqual);
     }
 };
 
@@ -997,6 +1161,101 @@ private:
 
 };
 
+class FilterResampleTest: public GraphicsTest {
+public:
+    FilterResampleTest()
+        : GraphicsTest("FilterResampleTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        ResampleFilter filters[] = {RESAMPLE_BOX, RESAMPLE_BILINEAR, RESAMPLE_MITCHELL,
+                RESAMPLE_LANCZOS};
+        PixelFormat pfs[] = {I8, B8G8R8, B8G8R8X8, B8G8R8A8};
+        IntPoint sizes[] = {IntPoint(7,5), IntPoint(40,3), IntPoint(300,200)};
+        for (int i = 0; i < 4; ++i) {
+            TEST(string2ResampleFilter(resampleFilter2String(filters[i])) == filters[i]);
+            for (int j = 0; j < 4; ++j) {
+                // Weights sum up to one, so a constant color needs to stay the same.
+                BitmapPtr pBmp(new Bitmap(IntPoint(61,47), pfs[j]));
+                memset(pBmp->getPixels(), 173, pBmp->getMemNeeded());
+                if (pfs[j] == B8G8R8A8) {
+                    FilterFill<Pixel32>(Pixel32(173,173,173,255)).applyInPlace(pBmp);
+                }
+                for (int k = 0; k < 3; ++k) {
+                    BitmapPtr pDestBmp = FilterResample(sizes[k], filters[i]).apply(pBmp);
+                    TEST(pDestBmp->getSize() == sizes[k]);
+                    TEST(pDestBmp->getPixelFormat() == pfs[j]);
+                    QUIET_TEST(isConstant(*pDestBmp, 173));
+                }
+            }
+        }
+        TEST_EXCEPTION(string2ResampleFilter("cubic"), Exception);
+
+        // Resampling to the same size copies the bitmap.
+        BitmapPtr pBmp = loadTestBmp("rgb24-64x64", B8G8R8X8);
+        BitmapPtr pDestBmp = FilterResample(IntPoint(64,64)).apply(pBmp);
+        testEqual(*pDestBmp, *pBmp, "ResampleIdentity", 0, 0);
+        pBmp = loadTestBmp("rgb24alpha-64x64", B8G8R8A8);
+        pDestBmp = FilterResample(IntPoint(64,64)).apply(pBmp);
+        testEqual(*pDestBmp, *pBmp, "ResampleIdentityAlpha", 0, 0);
+        // Box filtering by a factor of 2 averages 2x2 pixels. The two passes round
+        // separately, so the results can be off by one.
+        pBmp = loadTestBmp("rgb24-64x64", I8);
+        pDestBmp = FilterResample(IntPoint(32,32), RESAMPLE_BOX).apply(pBmp);
+        BitmapPtr pBaselineBmp = FilterFastDownscale(2).apply(pBmp);
+        testEqual(*pDestBmp, *pBaselineBmp, "ResampleBox", 0.5, 0.5);
+
+        // Colors of transparent pixels must not bleed into visible ones.
+        pBmp = BitmapPtr(new Bitmap(IntPoint(64,16), B8G8R8A8));
+        FilterFill<Pixel32>(Pixel32(0,0,255,0)).applyInPlace(pBmp);
+        for (int y = 0; y < 16; ++y) {
+            for (int x = 0; x < 32; ++x) {
+                pBmp->setPixel(IntPoint(x,y), Pixel32(0,255,0,255));
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            pDestBmp = FilterResample(IntPoint(13,5), filters[i]).apply(pBmp);
+            bool bBleeds = false;
+            for (int y = 0; y < 5; ++y) {
+                const Pixel32* pPixel = (const Pixel32*)(pDestBmp->getPixels()+
+                        y*pDestBmp->getStride());
+                for (int x = 0; x < 13; ++x) {
+                    if (pPixel[x].getA() > 0 && pPixel[x].getB() > 0) {
+                        bBleeds = true;
+                    }
+                }
+            }
+            TEST(!bBleeds);
+        }
+
+        // Weight tables are shared between bitmaps of the same size.
+        ResampleWeights::clearCache();
+        ResampleWeightsPtr pWeights = ResampleWeights::get(100, 30, RESAMPLE_LANCZOS);
+        TEST(ResampleWeights::get(100, 30, RESAMPLE_LANCZOS) == pWeights);
+        TEST(ResampleWeights::get(100, 30, RESAMPLE_MITCHELL) != pWeights);
+        TEST(ResampleWeights::getNumCached() == 2);
+    }
+
+private:
+    bool isConstant(const Bitmap& bmp, unsigned char value)
+    {
+        IntPoint size = bmp.getSize();
+        for (int y = 0; y < size.y; ++y) {
+            const unsigned char* pLine = bmp.getPixels()+y*bmp.getStride();
+            for (int x = 0; x < size.x*bmp.getBytesPerPixel(); ++x) {
+                if (pLine[x] != value && !(bmp.getPixelFormat() == B8G8R8A8 &&
+                        x%4 == ALPHAPOS && pLine[x] == 255))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
 class GraphicsTestSuite: public TestSuite {
 public:
     GraphicsTestSuite() 
@@ -1006,6 +1265,8 @@ public:
         addTest(TestPtr(new PixelTest));
         addTest(TestPtr(new ColorTest));
         addTest(TestPtr(new BitmapTest));
+        addTest(TestPtr(new BitmapPoolTest));
+        addTest(TestPtr(new BitmapLoaderTest));
         addTest(TestPtr(new Filter3x3Test));
         addTest(TestPtr(new FilterConvolTest));
         addTest(TestPtr(new FilterColorizeTest));
@@ -1027,6 +1288,7 @@ public:
         addTest(TestPtr(new FilterErosionTest));
         addTest(TestPtr(new FilterAlphaTest));
         addTest(TestPtr(new FilterResizeBilinearTest));
+        addTest(TestPtr(new FilterResampleTest));
         addTest(TestPtr(new FilterUnmultiplyAlphaTest));
     }
 };
@@ -51,11 +51,16 @@ namespace avg {
 
 using namespace std;
 
+// The main thread holds at most the current and the next frame and the capture thread
+// writes one, so a few bitmaps are enough.
+static const unsigned MAX_FREE_BMPS = 4;
+
 Camera::Camera(PixelFormat camPF, PixelFormat destPF, IntPoint size, float frameRate)
     : m_CamPF(camPF),
       m_DestPF(destPF),
       m_Size(size),
-      m_FrameRate(frameRate)
+      m_FrameRate(frameRate),
+      m_pBmpPool(new BitmapPool(MAX_FREE_BMPS, "CameraFrame"))
 {
 //    cerr << "Camera: " << getPixelFormatString(camPF) << "-->" 
 //        << getPixelFormatString(destPF) << endl;
@@ -81,7 +86,7 @@ static ProfilingZoneID CameraConvertProfilingZone("Camera format conversion", tr
 BitmapPtr Camera::convertCamFrameToDestPF(BitmapPtr pCamBmp)
 {
     ScopeTimer Timer(CameraConvertProfilingZone);
-    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(pCamBmp->getSize(), m_DestPF));
+    BitmapPtr pDestBmp = m_pBmpPool->getBmp(pCamBmp->getSize(), m_DestPF);
     pDestBmp->copyPixels(*pCamBmp);
     if (m_CamPF == R8G8B8 && m_DestPF == B8G8R8X8) {
         pDestBmp->setPixelFormat(R8G8B8X8);
@@ -95,6 +100,11 @@ BitmapPtr Camera::convertCamFrameToDestPF(BitmapPtr pCamBmp)
     return pDestBmp;
 }
 
+const BitmapPoolPtr& Camera::getBmpPool() const
+{
+    return m_pBmpPool;
+}
+
 IntPoint Camera::getImgSize()
 {
     return m_Size;
@@ -231,6 +241,8 @@ CameraPtr createCamera(const string& sDriver, const string& sDevice, int unit,
             AVG_LOG_WARNING("DirectShow camera specified, but "
                     "DirectShow is only available under windows.");
 #endif
+        } else if (sDriver == "fake") {
+            pCamera = CameraPtr(new FakeCamera(captureSize, camPF, destPF, frameRate));
         } else {
             throw Exception(AVG_ERR_INVALID_ARGS,
                     "Unable to set up camera. Camera source '"+sDriver+"' unknown.");
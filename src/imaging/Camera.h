@@ -24,6 +24,7 @@
 
 #include "../avgconfigwrapper.h"
 #include "../graphics/Bitmap.h"
+#include "../graphics/BitmapPool.h"
 
 #include <boost/shared_ptr.hpp>
 #include "CameraInfo.h"
@@ -71,7 +72,10 @@ public:
     PixelFormat getCamPF() const;
     void setCamPF(PixelFormat pf);
     PixelFormat getDestPF() const;
+    // The destination bitmaps are recycled once they are no longer referenced, so
+    // converting frames doesn't allocate memory in the steady state.
     BitmapPtr convertCamFrameToDestPF(BitmapPtr pCamBmp);
+    const BitmapPoolPtr& getBmpPool() const;
 
     IntPoint getImgSize();
     float getFrameRate() const;
@@ -99,6 +103,8 @@ private:
 
     IntPoint m_Size;
     float m_FrameRate;
+
+    BitmapPoolPtr m_pBmpPool;
 };
 
 
@@ -0,0 +1,138 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "CameraCaptureThread.h"
+
+#include "../base/ScopeTimer.h"
+#include "../base/ThreadHelper.h"
+#include "../base/TimeSource.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace std;
+
+namespace avg {
+
+// Upper bound for CameraFrameSlot::get(true) so a camera that stopped delivering
+// images doesn't block the caller forever.
+static const int MAX_FRAME_WAIT_MS = 1000;
+
+// The capture thread polls the camera instead of blocking in getImage(true), since a
+// blocked driver call can't be interrupted and would keep stop() from being processed.
+static const int CAPTURE_POLL_MS = 2;
+
+CameraFrameSlot::CameraFrameSlot()
+    : m_NumFrames(0),
+      m_NumDroppedFrames(0)
+{
+}
+
+CameraFrameSlot::~CameraFrameSlot()
+{
+}
+
+void CameraFrameSlot::put(BitmapPtr pBmp)
+{
+    {
+        lock_guard lock(m_Mutex);
+        if (m_pBmp) {
+            m_NumDroppedFrames++;
+        }
+        m_pBmp = pBmp;
+        m_NumFrames++;
+    }
+    m_Cond.notify_one();
+}
+
+BitmapPtr CameraFrameSlot::get(bool bWait)
+{
+    boost::unique_lock<boost::mutex> lock(m_Mutex);
+    if (bWait && !m_pBmp) {
+        m_Cond.timed_wait(lock, boost::posix_time::milliseconds(MAX_FRAME_WAIT_MS));
+    }
+    BitmapPtr pBmp = m_pBmp;
+    m_pBmp = BitmapPtr();
+    return pBmp;
+}
+
+int CameraFrameSlot::getNumFrames() const
+{
+    lock_guard lock(m_Mutex);
+    return m_NumFrames;
+}
+
+int CameraFrameSlot::getNumDroppedFrames() const
+{
+    lock_guard lock(m_Mutex);
+    return m_NumDroppedFrames;
+}
+
+
+CameraCaptureThread::CameraCaptureThread(CQueue& cmdQ, CameraPtr pCamera,
+        CameraFrameSlotPtr pSlot, MutexPtr pCamMutex)
+    : WorkerThread<CameraCaptureThread>("Camera Capture", cmdQ),
+      m_pCamera(pCamera),
+      m_pSlot(pSlot),
+      m_pCamMutex(pCamMutex)
+{
+}
+
+CameraCaptureThread::~CameraCaptureThread()
+{
+}
+
+void CameraCaptureThread::setFeature(CameraFeature feature, int value,
+        bool bIgnoreOldValue)
+{
+    lock_guard lock(*m_pCamMutex);
+    m_pCamera->setFeature(feature, value, bIgnoreOldValue);
+}
+
+void CameraCaptureThread::setFeatureOneShot(CameraFeature feature)
+{
+    lock_guard lock(*m_pCamMutex);
+    m_pCamera->setFeatureOneShot(feature);
+}
+
+void CameraCaptureThread::setWhitebalance(int u, int v, bool bIgnoreOldValue)
+{
+    lock_guard lock(*m_pCamMutex);
+    m_pCamera->setWhitebalance(u, v, bIgnoreOldValue);
+}
+
+static ProfilingZoneID CaptureProfilingZone("Camera capture thread", true);
+
+bool CameraCaptureThread::work()
+{
+    BitmapPtr pBmp;
+    {
+        ScopeTimer timer(CaptureProfilingZone);
+        pBmp = m_pCamera->getImage(false);
+    }
+    if (pBmp) {
+        m_pSlot->put(pBmp);
+    } else {
+        msleep(CAPTURE_POLL_MS);
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,93 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _CameraCaptureThread_H_
+#define _CameraCaptureThread_H_
+
+#include "../api.h"
+#include "Camera.h"
+
+#include "../base/WorkerThread.h"
+#include "../base/ThreadHelper.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
+namespace avg {
+
+// Holds the most recent frame delivered by the capture thread. A frame that hasn't been
+// picked up when the next one arrives is dropped, so the consumer always gets the
+// latest image and never falls behind the camera.
+class AVG_API CameraFrameSlot
+{
+public:
+    CameraFrameSlot();
+    virtual ~CameraFrameSlot();
+
+    void put(BitmapPtr pBmp);
+    // Returns the frame and empties the slot. If bWait is set, waits a limited time for
+    // a frame to arrive.
+    BitmapPtr get(bool bWait);
+
+    int getNumFrames() const;
+    int getNumDroppedFrames() const;
+
+private:
+    BitmapPtr m_pBmp;
+    int m_NumFrames;
+    int m_NumDroppedFrames;
+    mutable boost::mutex m_Mutex;
+    boost::condition m_Cond;
+};
+
+typedef boost::shared_ptr<CameraFrameSlot> CameraFrameSlotPtr;
+
+// Fetches images from a camera in a separate thread. Since Camera::getImage() also
+// demosaics and converts the image to the destination pixel format, all per-frame
+// work except the texture upload happens here. The camera is polled so that commands -
+// including stop() - are processed within a few milliseconds even if no frames arrive.
+class AVG_API CameraCaptureThread: public WorkerThread<CameraCaptureThread>
+{
+public:
+    // pCamMutex serializes feature access to pCamera with the main thread.
+    CameraCaptureThread(CQueue& cmdQ, CameraPtr pCamera, CameraFrameSlotPtr pSlot,
+            MutexPtr pCamMutex);
+    virtual ~CameraCaptureThread();
+
+    // Feature changes are executed between two frames.
+    void setFeature(CameraFeature feature, int value, bool bIgnoreOldValue);
+    void setFeatureOneShot(CameraFeature feature);
+    void setWhitebalance(int u, int v, bool bIgnoreOldValue);
+
+private:
+    virtual bool work();
+
+    CameraPtr m_pCamera;
+    CameraFrameSlotPtr m_pSlot;
+    MutexPtr m_pCamMutex;
+};
+
+typedef boost::shared_ptr<CameraCaptureThread> CameraCaptureThreadPtr;
+
+}
+
+#endif
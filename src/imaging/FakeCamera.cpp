@@ -39,14 +39,24 @@ namespace avg {
 FakeCamera::FakeCamera(PixelFormat camPF, PixelFormat destPF)
     : Camera(camPF, destPF, IntPoint(640, 480), 60),
       m_pBmpQ(new std::queue<BitmapPtr>()),
-      m_bIsOpen(false)
+      m_bIsOpen(false),
+      m_bGenerate(false),
+      m_StartTime(0),
+      m_NumFramesGenerated(0),
+      m_WhitebalanceU(0),
+      m_WhitebalanceV(0)
 {
 }
 
 FakeCamera::FakeCamera(std::vector<std::string>& pictures)
     : Camera(I8, I8, IntPoint(640,480), 60),
       m_pBmpQ(new std::queue<BitmapPtr>()),
-      m_bIsOpen(false)
+      m_bIsOpen(false),
+      m_bGenerate(false),
+      m_StartTime(0),
+      m_NumFramesGenerated(0),
+      m_WhitebalanceU(0),
+      m_WhitebalanceV(0)
 {
     for (vector<string>::iterator it = pictures.begin(); it != pictures.end(); ++it) {
         try {
@@ -61,10 +71,37 @@ FakeCamera::FakeCamera(std::vector<std::string>& pictures)
     }
 }
 
+FakeCamera::FakeCamera(const IntPoint& size, PixelFormat camPF, PixelFormat destPF,
+        float frameRate)
+    : Camera(camPF, destPF, size, frameRate),
+      m_pBmpQ(new std::queue<BitmapPtr>()),
+      m_bIsOpen(false),
+      m_bGenerate(true),
+      m_StartTime(0),
+      m_NumFramesGenerated(0),
+      m_WhitebalanceU(0),
+      m_WhitebalanceV(0)
+{
+    if (pixelFormatIsPlanar(camPF)) {
+        throw Exception(AVG_ERR_INVALID_ARGS, "Fake camera: pixel format "+
+                getPixelFormatString(camPF)+" not supported.");
+    }
+    m_pCamBmp = BitmapPtr(new Bitmap(size, camPF, "FakeCamera"));
+}
+
 FakeCamera::~FakeCamera()
 {
 }
 
+void FakeCamera::startCapture()
+{
+    if (m_bGenerate) {
+        m_StartTime = TimeSource::get()->getCurrentMillisecs();
+        m_NumFramesGenerated = 0;
+        open();
+    }
+}
+
 void FakeCamera::open()
 {
     m_bIsOpen = true;
@@ -78,6 +115,9 @@ void FakeCamera::close()
 
 BitmapPtr FakeCamera::getImage(bool bWait)
 {
+    if (m_bGenerate) {
+        return generateImage(bWait);
+    }
     if (bWait) {
         msleep(100);
     }
@@ -90,6 +130,35 @@ BitmapPtr FakeCamera::getImage(bool bWait)
     }
 }
 
+BitmapPtr FakeCamera::generateImage(bool bWait)
+{
+    if (!m_bIsOpen) {
+        return BitmapPtr();
+    }
+    long long frameTime = m_StartTime +
+            (long long)(m_NumFramesGenerated*1000/getFrameRate());
+    long long curTime = TimeSource::get()->getCurrentMillisecs();
+    if (curTime < frameTime) {
+        if (!bWait) {
+            return BitmapPtr();
+        }
+        msleep(int(frameTime-curTime));
+    }
+    // Diagonal stripes that move by a few pixels per frame. The pattern is written
+    // byte-wise, so it works for bayer, grayscale and color formats alike.
+    IntPoint size = m_pCamBmp->getSize();
+    int lineBytes = size.x*m_pCamBmp->getBytesPerPixel();
+    int offset = m_NumFramesGenerated*4;
+    for (int y = 0; y < size.y; ++y) {
+        unsigned char* pLine = m_pCamBmp->getPixels()+y*m_pCamBmp->getStride();
+        for (int x = 0; x < lineBytes; ++x) {
+            pLine[x] = (unsigned char)(x+y+offset);
+        }
+    }
+    m_NumFramesGenerated++;
+    return convertCamFrameToDestPF(m_pCamBmp);
+}
+
 bool FakeCamera::isCameraAvailable()
 {
     return true;
@@ -117,11 +186,17 @@ const string& FakeCamera::getMode() const
 
 int FakeCamera::getFeature(CameraFeature feature) const
 {
-    return 0;
+    FeatureMap::const_iterator it = m_Features.find(feature);
+    if (it == m_Features.end()) {
+        return 0;
+    } else {
+        return it->second;
+    }
 }
 
 void FakeCamera::setFeature(CameraFeature feature, int value, bool bIgnoreOldValue)
 {
+    m_Features[feature] = value;
 }
 
 void FakeCamera::setFeatureOneShot(CameraFeature feature)
@@ -130,16 +205,18 @@ void FakeCamera::setFeatureOneShot(CameraFeature feature)
 
 int FakeCamera::getWhitebalanceU() const
 {
-    return 0;
+    return m_WhitebalanceU;
 }
 
 int FakeCamera::getWhitebalanceV() const
 {
-    return 0;
+    return m_WhitebalanceV;
 }
 
 void FakeCamera::setWhitebalance(int u, int v, bool bIgnoreOldValue)
 {
+    m_WhitebalanceU = u;
+    m_WhitebalanceV = v;
 }
 
 }
@@ -39,7 +39,12 @@ class AVG_API FakeCamera: public Camera
 public:
     FakeCamera(PixelFormat camPF, PixelFormat destPF);
     FakeCamera(std::vector<std::string>& pictures);
+    // Generates a moving test pattern in camPF at the given frame rate. Every frame
+    // goes through the same conversion as images from a real camera.
+    FakeCamera(const IntPoint& size, PixelFormat camPF, PixelFormat destPF,
+            float frameRate);
     virtual ~FakeCamera();
+    virtual void startCapture();
     virtual void open();
     virtual void close();
 
@@ -58,8 +63,19 @@ public:
     virtual void setWhitebalance(int u, int v, bool bIgnoreOldValue=false);
 
 private:
+    BitmapPtr generateImage(bool bWait);
+
     BitmapQueuePtr m_pBmpQ;
     bool m_bIsOpen;
+
+    bool m_bGenerate;
+    BitmapPtr m_pCamBmp;
+    long long m_StartTime;
+    int m_NumFramesGenerated;
+
+    FeatureMap m_Features;
+    int m_WhitebalanceU;
+    int m_WhitebalanceV;
 };
 
 }
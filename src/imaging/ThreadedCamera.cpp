@@ -0,0 +1,155 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ThreadedCamera.h"
+
+#include "../base/ThreadHelper.h"
+
+#include <boost/bind.hpp>
+
+using namespace std;
+
+namespace avg {
+
+ThreadedCamera::ThreadedCamera(CameraPtr pCamera)
+    : Camera(pCamera->getCamPF(), pCamera->getDestPF(), pCamera->getImgSize(),
+            pCamera->getFrameRate()),
+      m_pCamera(pCamera),
+      m_pSlot(new CameraFrameSlot()),
+      m_pCamMutex(new boost::mutex),
+      m_bWhitebalanceSet(false),
+      m_WhitebalanceU(0),
+      m_WhitebalanceV(0),
+      m_pCaptureThread(0)
+{
+}
+
+ThreadedCamera::~ThreadedCamera()
+{
+    if (m_pCaptureThread) {
+        m_CmdQ.pushCmd(boost::bind(&CameraCaptureThread::stop, _1));
+        m_pCaptureThread->join();
+        delete m_pCaptureThread;
+    }
+}
+
+void ThreadedCamera::startCapture()
+{
+    if (!m_pCaptureThread) {
+        m_pCamera->startCapture();
+        m_pCaptureThread = new boost::thread(
+                CameraCaptureThread(m_CmdQ, m_pCamera, m_pSlot, m_pCamMutex));
+    }
+}
+
+BitmapPtr ThreadedCamera::getImage(bool bWait)
+{
+    return m_pSlot->get(bWait);
+}
+
+CameraPtr ThreadedCamera::getCamera() const
+{
+    return m_pCamera;
+}
+
+int ThreadedCamera::getNumDroppedFrames() const
+{
+    return m_pSlot->getNumDroppedFrames();
+}
+
+const string& ThreadedCamera::getDevice() const
+{
+    return m_pCamera->getDevice();
+}
+
+const string& ThreadedCamera::getDriverName() const
+{
+    return m_pCamera->getDriverName();
+}
+
+int ThreadedCamera::getFeature(CameraFeature feature) const
+{
+    FeatureMap::const_iterator it = m_Features.find(feature);
+    if (it != m_Features.end()) {
+        return it->second;
+    }
+    lock_guard lock(*m_pCamMutex);
+    return m_pCamera->getFeature(feature);
+}
+
+void ThreadedCamera::setFeature(CameraFeature feature, int value, bool bIgnoreOldValue)
+{
+    m_Features[feature] = value;
+    if (m_pCaptureThread) {
+        m_CmdQ.pushCmd(boost::bind(&CameraCaptureThread::setFeature, _1, feature, value,
+                bIgnoreOldValue));
+    } else {
+        m_pCamera->setFeature(feature, value, bIgnoreOldValue);
+    }
+}
+
+void ThreadedCamera::setFeatureOneShot(CameraFeature feature)
+{
+    // The camera determines the new value, so it has to be read from the driver.
+    m_Features.erase(feature);
+    if (feature == CAM_FEATURE_WHITE_BALANCE) {
+        m_bWhitebalanceSet = false;
+    }
+    if (m_pCaptureThread) {
+        m_CmdQ.pushCmd(boost::bind(&CameraCaptureThread::setFeatureOneShot, _1,
+                feature));
+    } else {
+        m_pCamera->setFeatureOneShot(feature);
+    }
+}
+
+int ThreadedCamera::getWhitebalanceU() const
+{
+    if (m_bWhitebalanceSet) {
+        return m_WhitebalanceU;
+    }
+    lock_guard lock(*m_pCamMutex);
+    return m_pCamera->getWhitebalanceU();
+}
+
+int ThreadedCamera::getWhitebalanceV() const
+{
+    if (m_bWhitebalanceSet) {
+        return m_WhitebalanceV;
+    }
+    lock_guard lock(*m_pCamMutex);
+    return m_pCamera->getWhitebalanceV();
+}
+
+void ThreadedCamera::setWhitebalance(int u, int v, bool bIgnoreOldValue)
+{
+    m_bWhitebalanceSet = true;
+    m_WhitebalanceU = u;
+    m_WhitebalanceV = v;
+    if (m_pCaptureThread) {
+        m_CmdQ.pushCmd(boost::bind(&CameraCaptureThread::setWhitebalance, _1, u, v,
+                bIgnoreOldValue));
+    } else {
+        m_pCamera->setWhitebalance(u, v, bIgnoreOldValue);
+    }
+}
+
+}
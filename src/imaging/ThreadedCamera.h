@@ -0,0 +1,77 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ThreadedCamera_H_
+#define _ThreadedCamera_H_
+
+#include "../api.h"
+#include "Camera.h"
+#include "CameraCaptureThread.h"
+
+#include <boost/thread/thread.hpp>
+
+#include <string>
+
+namespace avg {
+
+// Wraps a camera so images are captured and converted in a CameraCaptureThread.
+// getImage() only picks up the latest completed frame. Feature changes are executed
+// by the capture thread, so the values set are cached here to be able to return them
+// immediately.
+class AVG_API ThreadedCamera: public Camera
+{
+public:
+    ThreadedCamera(CameraPtr pCamera);
+    virtual ~ThreadedCamera();
+    virtual void startCapture();
+
+    virtual BitmapPtr getImage(bool bWait);
+    CameraPtr getCamera() const;
+    int getNumDroppedFrames() const;
+
+    virtual const std::string& getDevice() const;
+    virtual const std::string& getDriverName() const;
+
+    virtual int getFeature(CameraFeature feature) const;
+    virtual void setFeature(CameraFeature feature, int value,
+            bool bIgnoreOldValue=false);
+    virtual void setFeatureOneShot(CameraFeature feature);
+    virtual int getWhitebalanceU() const;
+    virtual int getWhitebalanceV() const;
+    virtual void setWhitebalance(int u, int v, bool bIgnoreOldValue=false);
+
+private:
+    CameraPtr m_pCamera;
+    CameraFrameSlotPtr m_pSlot;
+    MutexPtr m_pCamMutex;
+    FeatureMap m_Features;
+    bool m_bWhitebalanceSet;
+    int m_WhitebalanceU;
+    int m_WhitebalanceV;
+    CameraCaptureThread::CQueue m_CmdQ;
+    boost::thread* m_pCaptureThread;
+};
+
+typedef boost::shared_ptr<ThreadedCamera> ThreadedCameraPtr;
+
+}
+
+#endif
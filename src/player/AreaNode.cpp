@@ -111,6 +111,7 @@ void AreaNode::connectDisplay()
         notifySubscribers("SIZE_CHANGED", m_RelViewport.size());
     }
     m_bTransformChanged = true;
+    notifyHitBoundsChanged();
     Node::connectDisplay();
 }
 
@@ -186,6 +187,7 @@ void AreaNode::setAngle(float angle)
 {
     m_Angle = fmod(angle, 2*(float)M_PI);
     m_bTransformChanged = true;
+    notifyHitBoundsChanged();
 }
 
 glm::vec2 AreaNode::getPivot() const
@@ -203,6 +205,7 @@ void AreaNode::setPivot(const glm::vec2& pt)
     m_Pivot.y = pt.y;
     m_bHasCustomPivot = true;
     m_bTransformChanged = true;
+    notifyHitBoundsChanged();
 }
 
 const std::string& AreaNode::getElementOutlineColor() const
@@ -241,6 +244,19 @@ void AreaNode::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
     }
 }
 
+bool AreaNode::getHitBounds(FRect& bounds) const
+{
+    glm::vec2 size = getSize();
+    if (size == glm::vec2(0,0)) {
+        return false;
+    }
+    bounds = FRect(toGlobal(glm::vec2(0,0)), toGlobal(glm::vec2(0,0)));
+    bounds.expand(toGlobal(glm::vec2(size.x,0)));
+    bounds.expand(toGlobal(size));
+    bounds.expand(toGlobal(glm::vec2(0,size.y)));
+    return true;
+}
+
 void AreaNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
         float parentEffectiveOpacity)
 {
@@ -306,6 +322,7 @@ void AreaNode::setViewport(float x, float y, float width, float height)
         notifySubscribers("SIZE_CHANGED", m_RelViewport.size());
     }
     m_bTransformChanged = true;
+    notifyHitBoundsChanged();
 }
 
 const FRect& AreaNode::getRelViewport() const
@@ -340,6 +357,11 @@ Pixel32 AreaNode::getEffectiveOutlineColor(Pixel32 parentColor) const
     }
 }
 
+const glm::mat4& AreaNode::getLocalTransform() const
+{
+    return m_LocalTransform;
+}
+
 void AreaNode::calcTransform()
 {
     if (m_bTransformChanged) {
@@ -85,6 +85,7 @@ class AVG_API AreaNode: public Node
         virtual glm::vec2 toGlobal(const glm::vec2& localPos) const;
         
         virtual void getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements);
+        virtual bool getHitBounds(FRect& bounds) const;
 
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
                 float parentEffectiveOpacity);
@@ -104,6 +105,7 @@ class AVG_API AreaNode: public Node
         AreaNode(const std::string& sPublisherName);
         glm::vec2 getUserSize() const;
         Pixel32 getEffectiveOutlineColor(Pixel32 parentColor) const;
+        const glm::mat4& getLocalTransform() const;
 
     private:
         void calcTransform();
@@ -37,12 +37,15 @@ namespace avg {
 BitmapManager * BitmapManager::s_pBitmapManager=0;
 
 BitmapManager::BitmapManager()
+    : m_NextHandle(1),
+      m_NumCancelled(0)
 {
     if (s_pBitmapManager) {
         throw Exception(AVG_ERR_UNKNOWN, "BitmapMananger has already been instantiated.");
     }
     
     m_pCmdQueue = BitmapManagerThread::CQueuePtr(new BitmapManagerThread::CQueue);
+    m_pRequestQueue = BitmapRequestQueuePtr(new BitmapRequestQueue);
     m_pMsgQueue = BitmapManagerMsgQueuePtr(new BitmapManagerMsgQueue(8));
 
     startThreads(1);
@@ -55,6 +58,7 @@ BitmapManager::~BitmapManager()
     while (!m_pCmdQueue->empty()) {
         m_pCmdQueue->pop();
     }
+    m_pRequestQueue->clear();
     while (!m_pMsgQueue->empty()) {
         m_pMsgQueue->pop();
     }
@@ -70,22 +74,53 @@ BitmapManager* BitmapManager::get()
     return s_pBitmapManager;
 }
 
-void BitmapManager::loadBitmapPy(const UTF8String& sUtf8FileName,
-        const boost::python::object& pyFunc, PixelFormat pf)
+bool BitmapManager::exists()
+{
+    return (s_pBitmapManager != 0);
+}
+
+int BitmapManager::loadBitmapPy(const UTF8String& sUtf8FileName,
+        const boost::python::object& pyFunc, PixelFormat pf, BitmapLoadPriority priority)
 {
     std::string sFileName = convertUTF8ToFilename(sUtf8FileName);
-    BitmapManagerMsgPtr pMsg = BitmapManagerMsgPtr(
-            new BitmapManagerMsg(sUtf8FileName, pyFunc, pf));
-    internalLoadBitmap(pMsg);
+    BitmapManagerMsgPtr pMsg = BitmapManagerMsg::create(sUtf8FileName, pyFunc, pf);
+    return internalLoadBitmap(pMsg, priority);
 }
 
-void BitmapManager::loadBitmap(const UTF8String& sUtf8FileName,
-        IBitmapLoadedListener* pLoadedListener, PixelFormat pf)
+int BitmapManager::loadBitmap(const UTF8String& sUtf8FileName,
+        IBitmapLoadedListener* pLoadedListener, PixelFormat pf,
+        BitmapLoadPriority priority)
 {
     std::string sFileName = convertUTF8ToFilename(sUtf8FileName);
-    BitmapManagerMsgPtr pMsg = BitmapManagerMsgPtr(
-            new BitmapManagerMsg(sUtf8FileName, pLoadedListener, pf));
-    internalLoadBitmap(pMsg);
+    BitmapManagerMsgPtr pMsg = BitmapManagerMsg::create(sUtf8FileName, pLoadedListener,
+            pf);
+    return internalLoadBitmap(pMsg, priority);
+}
+
+int BitmapManager::loadBitmap(const UTF8String& sUtf8FileName, const string& sJobKey,
+        const BitmapManagerMsg::LoadFunc& loadFunc,
+        IBitmapLoadedListener* pLoadedListener, BitmapLoadPriority priority)
+{
+    BitmapManagerMsgPtr pMsg = BitmapManagerMsg::create(sUtf8FileName, pLoadedListener,
+            NO_PIXELFORMAT);
+    pMsg->setLoader(sJobKey, loadFunc);
+    return internalLoadBitmap(pMsg, priority);
+}
+
+bool BitmapManager::cancelRequest(int handle)
+{
+    if (m_PendingRequests.erase(handle) == 0) {
+        return false;
+    }
+    // If the bitmap has already been loaded, the result is discarded in onFrameEnd().
+    m_pRequestQueue->cancel(handle);
+    m_NumCancelled++;
+    return true;
+}
+
+bool BitmapManager::setRequestPriority(int handle, BitmapLoadPriority priority)
+{
+    return m_pRequestQueue->setPriority(handle, priority);
 }
 
 void BitmapManager::setNumThreads(int numThreads)
@@ -94,16 +129,36 @@ void BitmapManager::setNumThreads(int numThreads)
     startThreads(numThreads);
 }
 
+int BitmapManager::getNumPendingRequests() const
+{
+    return int(m_PendingRequests.size());
+}
+
+BitmapRequestStats BitmapManager::getStats() const
+{
+    BitmapRequestStats stats = m_pRequestQueue->getStats();
+    stats.m_NumCancelled = m_NumCancelled;
+    return stats;
+}
+
 void BitmapManager::onFrameEnd()
 {
     while (!m_pMsgQueue->empty()) {
         BitmapManagerMsgPtr pMsg = m_pMsgQueue->pop();
-        pMsg->executeCallback();
+        if (m_PendingRequests.erase(pMsg->getHandle()) != 0) {
+            pMsg->executeCallback();
+        }
     }
 }
 
-void BitmapManager::internalLoadBitmap(BitmapManagerMsgPtr pMsg)
+int BitmapManager::internalLoadBitmap(BitmapManagerMsgPtr pMsg,
+        BitmapLoadPriority priority)
 {
+    int handle = m_NextHandle++;
+    pMsg->setHandle(handle);
+    pMsg->setPriority(priority);
+    m_PendingRequests[handle] = pMsg;
+
 #ifdef WIN32
     int rc = _access(pMsg->getFilename().c_str(), 04);
 #else
@@ -117,15 +172,18 @@ void BitmapManager::internalLoadBitmap(BitmapManagerMsgPtr pMsg)
                 strerror(errno)));
         m_pMsgQueue->push(pMsg);
     } else {
-        m_pCmdQueue->pushCmd(boost::bind(&BitmapManagerThread::loadBitmap, _1, pMsg));
+        if (m_pRequestQueue->push(pMsg)) {
+            m_pCmdQueue->pushCmd(boost::bind(&BitmapManagerThread::loadNextBitmap, _1));
+        }
     }
+    return handle;
 }
 
 void BitmapManager::startThreads(int numThreads)
 {
     for (int i=0; i<numThreads; ++i) {
         boost::thread* pThread = new boost::thread(
-                BitmapManagerThread(*m_pCmdQueue, *m_pMsgQueue));
+                BitmapManagerThread(*m_pCmdQueue, *m_pRequestQueue, *m_pMsgQueue));
         m_pBitmapManagerThreads.push_back(pThread);
     }
 }
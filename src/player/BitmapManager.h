@@ -26,6 +26,7 @@
 
 #include "BitmapManagerThread.h"
 #include "BitmapManagerMsg.h"
+#include "BitmapRequestQueue.h"
 
 #include "../base/Queue.h"
 #include "../base/IFrameEndListener.h"
@@ -33,6 +34,7 @@
 #include <boost/thread.hpp>
 
 #include <vector>
+#include <map>
 
 namespace avg {
 
@@ -42,16 +44,31 @@ class AVG_API BitmapManager : public IFrameEndListener
         BitmapManager();
         ~BitmapManager();
         static BitmapManager* get();
-        void loadBitmapPy(const UTF8String& sUtf8FileName,
-                const boost::python::object& pyFunc, PixelFormat pf=NO_PIXELFORMAT);
-        void loadBitmap(const UTF8String& sUtf8FileName,
-                IBitmapLoadedListener* pLoadedListener, PixelFormat pf=NO_PIXELFORMAT);
+        static bool exists();
+        // The returned handle can be used to cancel or re-prioritize the request
+        // until the callback has been invoked.
+        int loadBitmapPy(const UTF8String& sUtf8FileName,
+                const boost::python::object& pyFunc, PixelFormat pf=NO_PIXELFORMAT,
+                BitmapLoadPriority priority=LOADPRIORITY_VISIBLE);
+        int loadBitmap(const UTF8String& sUtf8FileName,
+                IBitmapLoadedListener* pLoadedListener, PixelFormat pf=NO_PIXELFORMAT,
+                BitmapLoadPriority priority=LOADPRIORITY_VISIBLE);
+        // Loads the bitmap using loadFunc (see BitmapManagerMsg::setLoader()).
+        int loadBitmap(const UTF8String& sUtf8FileName, const std::string& sJobKey,
+                const BitmapManagerMsg::LoadFunc& loadFunc,
+                IBitmapLoadedListener* pLoadedListener,
+                BitmapLoadPriority priority=LOADPRIORITY_VISIBLE);
+        bool cancelRequest(int handle);
+        bool setRequestPriority(int handle, BitmapLoadPriority priority);
         void setNumThreads(int numThreads);
 
+        int getNumPendingRequests() const;
+        BitmapRequestStats getStats() const;
+
         virtual void onFrameEnd();
         
     private:
-        void internalLoadBitmap(BitmapManagerMsgPtr pMsg);
+        int internalLoadBitmap(BitmapManagerMsgPtr pMsg, BitmapLoadPriority priority);
         void startThreads(int numThreads);
         void stopThreads();
 
@@ -59,7 +76,13 @@ class AVG_API BitmapManager : public IFrameEndListener
 
         std::vector<boost::thread*> m_pBitmapManagerThreads;
         BitmapManagerThread::CQueuePtr m_pCmdQueue;
+        BitmapRequestQueuePtr m_pRequestQueue;
         BitmapManagerMsgQueuePtr m_pMsgQueue;
+
+        // Requests whose callback hasn't been invoked yet, by handle.
+        std::map<int, BitmapManagerMsgPtr> m_PendingRequests;
+        int m_NextHandle;
+        int m_NumCancelled;
 };
 
 }
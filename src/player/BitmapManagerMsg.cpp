@@ -26,9 +26,12 @@
 #include "../base/Exception.h"
 #include "../base/TimeSource.h"
 
+#include <boost/make_shared.hpp>
 
 namespace avg {
 
+static BlockPoolPtr s_pBitmapManagerMsgPool(new BlockPool("BitmapManagerMsg"));
+
 BitmapManagerMsg::BitmapManagerMsg(const UTF8String& sFilename,
         const boost::python::object& onLoadedCb, PixelFormat pf) 
 {
@@ -55,15 +58,56 @@ BitmapManagerMsg::~BitmapManagerMsg()
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
+BitmapManagerMsgPtr BitmapManagerMsg::create(const UTF8String& sFilename,
+        const boost::python::object& onLoadedCb, PixelFormat pf)
+{
+    return boost::allocate_shared<BitmapManagerMsg>(
+            PoolAllocator<BitmapManagerMsg>(s_pBitmapManagerMsgPool),
+            sFilename, onLoadedCb, pf);
+}
+
+BitmapManagerMsgPtr BitmapManagerMsg::create(const UTF8String& sFilename,
+        IBitmapLoadedListener* pLoadedListener, PixelFormat pf)
+{
+    return boost::allocate_shared<BitmapManagerMsg>(
+            PoolAllocator<BitmapManagerMsg>(s_pBitmapManagerMsgPool),
+            sFilename, pLoadedListener, pf);
+}
+
+const BlockPoolPtr& BitmapManagerMsg::getPool()
+{
+    return s_pBitmapManagerMsgPool;
+}
+
 void BitmapManagerMsg::init(const UTF8String& sFilename, PixelFormat pf)
 {
     m_sFilename = sFilename;
     m_StartTime = TimeSource::get()->getCurrentMicrosecs()/1000.0f;
     m_PF = pf;
+    m_Handle = 0;
+    m_Priority = LOADPRIORITY_VISIBLE;
+    m_sJobKey = std::string(sFilename)+"|"+getPixelFormatString(pf);
     m_MsgType = REQUEST;
     m_pEx = 0;
 }
 
+void BitmapManagerMsg::setLoader(const std::string& sJobKey, const LoadFunc& loadFunc)
+{
+    AVG_ASSERT(m_MsgType == REQUEST);
+    m_sJobKey = sJobKey;
+    m_LoadFunc = loadFunc;
+}
+
+const std::string& BitmapManagerMsg::getJobKey() const
+{
+    return m_sJobKey;
+}
+
+const BitmapManagerMsg::LoadFunc& BitmapManagerMsg::getLoadFunc() const
+{
+    return m_LoadFunc;
+}
+
 void BitmapManagerMsg::executeCallback()
 {
     switch (m_MsgType) {
@@ -104,6 +148,26 @@ PixelFormat BitmapManagerMsg::getPixelFormat()
     return m_PF;
 }
 
+int BitmapManagerMsg::getHandle() const
+{
+    return m_Handle;
+}
+
+void BitmapManagerMsg::setHandle(int handle)
+{
+    m_Handle = handle;
+}
+
+BitmapLoadPriority BitmapManagerMsg::getPriority() const
+{
+    return m_Priority;
+}
+
+void BitmapManagerMsg::setPriority(BitmapLoadPriority priority)
+{
+    m_Priority = priority;
+}
+
 void BitmapManagerMsg::setBitmap(BitmapPtr pBmp)
 {
     AVG_ASSERT(m_MsgType == REQUEST);
@@ -28,10 +28,12 @@
 #include "../base/Queue.h"
 #include "../base/UTF8String.h"
 #include "../base/Exception.h"
+#include "../base/BlockPool.h"
 
 #include "../graphics/PixelFormat.h"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
 #include <boost/python.hpp>
 
 
@@ -41,22 +43,48 @@ class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 class IBitmapLoadedListener;
 
+// Requests with a lower value are decoded first.
+enum BitmapLoadPriority {
+    LOADPRIORITY_VISIBLE,
+    LOADPRIORITY_PREFETCH,
+    LOADPRIORITY_BACKGROUND
+};
+
 class AVG_API BitmapManagerMsg
 {
 public:
     enum MsgType {REQUEST, BITMAP, ERROR};
+    typedef boost::function<BitmapPtr ()> LoadFunc;
 
     BitmapManagerMsg(const UTF8String& sFilename,
             const boost::python::object& onLoadedCb, PixelFormat pf);
     BitmapManagerMsg(const UTF8String& sFilename,
             IBitmapLoadedListener* pLoadedListener, PixelFormat pf);
     virtual ~BitmapManagerMsg();
+    // Allocate messages from a pool (see BlockPool).
+    static boost::shared_ptr<BitmapManagerMsg> create(const UTF8String& sFilename,
+            const boost::python::object& onLoadedCb, PixelFormat pf);
+    static boost::shared_ptr<BitmapManagerMsg> create(const UTF8String& sFilename,
+            IBitmapLoadedListener* pLoadedListener, PixelFormat pf);
+    static const BlockPoolPtr& getPool();
     void init(const UTF8String& sFilename, PixelFormat pf);
 
+    // By default, the file is loaded using avg::loadBitmap() and requests for the same
+    // file and pixel format share one decode, with every request receiving a copy of
+    // the bitmap. A custom loader is shared by requests with the same job key, which
+    // all receive the same bitmap.
+    void setLoader(const std::string& sJobKey, const LoadFunc& loadFunc);
+    const std::string& getJobKey() const;
+    const LoadFunc& getLoadFunc() const;
+
     void executeCallback();
     const UTF8String getFilename();
     float getStartTime();
     PixelFormat getPixelFormat();
+    int getHandle() const;
+    void setHandle(int handle);
+    BitmapLoadPriority getPriority() const;
+    void setPriority(BitmapLoadPriority priority);
     void setBitmap(BitmapPtr pBmp);
     void setError(const Exception& ex);
 
@@ -69,6 +97,10 @@ private:
     boost::python::object m_OnLoadedCb;
     IBitmapLoadedListener* m_pLoadedListener;
     PixelFormat m_PF;
+    int m_Handle;
+    BitmapLoadPriority m_Priority;
+    std::string m_sJobKey;
+    LoadFunc m_LoadFunc;
     MsgType m_MsgType;
     Exception* m_pEx;
 };
@@ -26,14 +26,17 @@
 #include "../base/TimeSource.h"
 
 #include "../graphics/BitmapLoader.h"
+#include "../graphics/Bitmap.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
 namespace avg {
 
-BitmapManagerThread::BitmapManagerThread(CQueue& cmdQ, BitmapManagerMsgQueue& MsgQueue)
+BitmapManagerThread::BitmapManagerThread(CQueue& cmdQ, BitmapRequestQueue& requestQueue,
+        BitmapManagerMsgQueue& MsgQueue)
     : WorkerThread<BitmapManagerThread>("BitmapManager", cmdQ),
+      m_RequestQueue(requestQueue),
       m_MsgQueue(MsgQueue),
       m_TotalLatency(0),
       m_NumBmpsLoaded(0)
@@ -57,21 +60,48 @@ void BitmapManagerThread::deinit()
 
 static ProfilingZoneID LoaderProfilingZone("loadBitmap", true);
 
-void BitmapManagerThread::loadBitmap(BitmapManagerMsgPtr pRequest)
+void BitmapManagerThread::loadNextBitmap()
 {
+    // There is one command per job, but the job to load is picked by priority, and
+    // the job belonging to this command may have been cancelled already.
+    BitmapLoadJobPtr pJob = m_RequestQueue.popJob();
+    if (!pJob) {
+        return;
+    }
     BitmapPtr pBmp;
-    ScopeTimer timer(LoaderProfilingZone);
-    float startTime = pRequest->getStartTime();
-    try {
-        pBmp = avg::loadBitmap(pRequest->getFilename(), pRequest->getPixelFormat());
-        pRequest->setBitmap(pBmp);
-    } catch (const Exception& ex) {
-        pRequest->setError(ex);
+    Exception* pEx = 0;
+    float decodeStartTime = TimeSource::get()->getCurrentMicrosecs()/1000.0f;
+    {
+        ScopeTimer timer(LoaderProfilingZone);
+        try {
+            if (pJob->m_LoadFunc) {
+                pBmp = pJob->m_LoadFunc();
+            } else {
+                pBmp = avg::loadBitmap(pJob->m_sFilename, pJob->m_PF);
+            }
+        } catch (const Exception& ex) {
+            pEx = new Exception(ex);
+        }
+    }
+    float endTime = TimeSource::get()->getCurrentMicrosecs()/1000.0f;
+    std::vector<BitmapManagerMsgPtr> pRequests = 
+            m_RequestQueue.finishJob(pJob, endTime-decodeStartTime);
+    for (unsigned i = 0; i < pRequests.size(); ++i) {
+        BitmapManagerMsgPtr pRequest = pRequests[i];
+        m_TotalLatency += endTime - pRequest->getStartTime();
+        m_NumBmpsLoaded++;
+        if (pEx) {
+            pRequest->setError(*pEx);
+        } else if (i == 0 || pJob->m_LoadFunc) {
+            // Bitmaps from custom loaders (e.g. for the ImageCache) are shared.
+            pRequest->setBitmap(pBmp);
+        } else {
+            // Every caller gets a bitmap of its own that it can modify.
+            pRequest->setBitmap(BitmapPtr(new Bitmap(*pBmp)));
+        }
+        m_MsgQueue.push(pRequest);
     }
-    m_MsgQueue.push(pRequest);
-    m_NumBmpsLoaded++;
-    float curLatency = TimeSource::get()->getCurrentMicrosecs()/1000 - startTime;
-    m_TotalLatency += curLatency;
+    delete pEx;
     ThreadProfiler::get()->reset();
 }
 
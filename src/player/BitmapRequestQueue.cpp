@@ -0,0 +1,213 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "BitmapRequestQueue.h"
+
+#include "../base/Exception.h"
+#include "../base/ThreadHelper.h"
+#include "../base/TimeSource.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+BitmapRequestStats::BitmapRequestStats()
+    : m_QueueDepth(0),
+      m_NumRequests(0),
+      m_NumCoalesced(0),
+      m_NumCancelled(0),
+      m_NumLoaded(0),
+      m_TotalWaitTime(0),
+      m_MaxWaitTime(0),
+      m_TotalDecodeTime(0),
+      m_MaxDecodeTime(0)
+{
+}
+
+bool BitmapRequestQueue::JobOrder::operator()(const BitmapLoadJobPtr& pJob1,
+        const BitmapLoadJobPtr& pJob2) const
+{
+    if (pJob1->m_Priority != pJob2->m_Priority) {
+        return pJob1->m_Priority < pJob2->m_Priority;
+    }
+    return pJob1->m_SeqNum < pJob2->m_SeqNum;
+}
+
+BitmapRequestQueue::BitmapRequestQueue()
+    : m_NextSeqNum(0)
+{
+}
+
+BitmapRequestQueue::~BitmapRequestQueue()
+{
+}
+
+bool BitmapRequestQueue::push(BitmapManagerMsgPtr pRequest)
+{
+    lock_guard lock(m_Mutex);
+    m_Stats.m_NumRequests++;
+    const string& sKey = pRequest->getJobKey();
+    map<string, BitmapLoadJobPtr>::iterator it = m_Jobs.find(sKey);
+    if (it != m_Jobs.end()) {
+        BitmapLoadJobPtr pJob = it->second;
+        pJob->m_pRequests.push_back(pRequest);
+        m_HandleMap[pRequest->getHandle()] = pJob;
+        updateJobPriority(pJob);
+        m_Stats.m_NumCoalesced++;
+        return false;
+    }
+
+    BitmapLoadJobPtr pJob(new BitmapLoadJob);
+    pJob->m_sKey = sKey;
+    pJob->m_sFilename = pRequest->getFilename();
+    pJob->m_PF = pRequest->getPixelFormat();
+    pJob->m_LoadFunc = pRequest->getLoadFunc();
+    pJob->m_Priority = pRequest->getPriority();
+    pJob->m_SeqNum = m_NextSeqNum++;
+    pJob->m_QueueTime = pRequest->getStartTime();
+    pJob->m_bInProgress = false;
+    pJob->m_pRequests.push_back(pRequest);
+    m_Jobs[sKey] = pJob;
+    m_HandleMap[pRequest->getHandle()] = pJob;
+    m_PendingJobs.insert(pJob);
+    return true;
+}
+
+bool BitmapRequestQueue::cancel(int handle)
+{
+    lock_guard lock(m_Mutex);
+    map<int, BitmapLoadJobPtr>::iterator it = m_HandleMap.find(handle);
+    if (it == m_HandleMap.end()) {
+        return false;
+    }
+    BitmapLoadJobPtr pJob = it->second;
+    m_HandleMap.erase(it);
+    vector<BitmapManagerMsgPtr>& pRequests = pJob->m_pRequests;
+    for (unsigned i = 0; i < pRequests.size(); ++i) {
+        if (pRequests[i]->getHandle() == handle) {
+            pRequests.erase(pRequests.begin()+i);
+            break;
+        }
+    }
+    if (!pJob->m_bInProgress) {
+        if (pRequests.empty()) {
+            m_PendingJobs.erase(pJob);
+            m_Jobs.erase(pJob->m_sKey);
+        } else {
+            updateJobPriority(pJob);
+        }
+    }
+    return true;
+}
+
+bool BitmapRequestQueue::setPriority(int handle, BitmapLoadPriority priority)
+{
+    lock_guard lock(m_Mutex);
+    map<int, BitmapLoadJobPtr>::iterator it = m_HandleMap.find(handle);
+    if (it == m_HandleMap.end()) {
+        return false;
+    }
+    BitmapLoadJobPtr pJob = it->second;
+    vector<BitmapManagerMsgPtr>& pRequests = pJob->m_pRequests;
+    for (unsigned i = 0; i < pRequests.size(); ++i) {
+        if (pRequests[i]->getHandle() == handle) {
+            pRequests[i]->setPriority(priority);
+        }
+    }
+    updateJobPriority(pJob);
+    return true;
+}
+
+void BitmapRequestQueue::clear()
+{
+    lock_guard lock(m_Mutex);
+    m_PendingJobs.clear();
+    m_Jobs.clear();
+    m_HandleMap.clear();
+}
+
+BitmapLoadJobPtr BitmapRequestQueue::popJob()
+{
+    lock_guard lock(m_Mutex);
+    if (m_PendingJobs.empty()) {
+        return BitmapLoadJobPtr();
+    }
+    BitmapLoadJobPtr pJob = *(m_PendingJobs.begin());
+    m_PendingJobs.erase(m_PendingJobs.begin());
+    pJob->m_bInProgress = true;
+
+    float waitTime = TimeSource::get()->getCurrentMicrosecs()/1000.0f - pJob->m_QueueTime;
+    m_Stats.m_TotalWaitTime += waitTime;
+    m_Stats.m_MaxWaitTime = max(m_Stats.m_MaxWaitTime, waitTime);
+    return pJob;
+}
+
+vector<BitmapManagerMsgPtr> BitmapRequestQueue::finishJob(BitmapLoadJobPtr pJob,
+        float decodeTime)
+{
+    lock_guard lock(m_Mutex);
+    AVG_ASSERT(pJob->m_bInProgress);
+    map<string, BitmapLoadJobPtr>::iterator it = m_Jobs.find(pJob->m_sKey);
+    // The queue might have been cleared in the meantime.
+    if (it != m_Jobs.end() && it->second == pJob) {
+        m_Jobs.erase(it);
+    }
+    vector<BitmapManagerMsgPtr> pRequests;
+    pRequests.swap(pJob->m_pRequests);
+    for (unsigned i = 0; i < pRequests.size(); ++i) {
+        m_HandleMap.erase(pRequests[i]->getHandle());
+    }
+    m_Stats.m_NumLoaded++;
+    m_Stats.m_TotalDecodeTime += decodeTime;
+    m_Stats.m_MaxDecodeTime = max(m_Stats.m_MaxDecodeTime, decodeTime);
+    return pRequests;
+}
+
+BitmapRequestStats BitmapRequestQueue::getStats() const
+{
+    lock_guard lock(m_Mutex);
+    BitmapRequestStats stats = m_Stats;
+    stats.m_QueueDepth = int(m_PendingJobs.size());
+    return stats;
+}
+
+void BitmapRequestQueue::updateJobPriority(BitmapLoadJobPtr pJob)
+{
+    // Must be called with m_Mutex held. A job is as urgent as its most urgent request.
+    BitmapLoadPriority priority = LOADPRIORITY_BACKGROUND;
+    for (unsigned i = 0; i < pJob->m_pRequests.size(); ++i) {
+        priority = min(priority, pJob->m_pRequests[i]->getPriority());
+    }
+    if (priority != pJob->m_Priority) {
+        if (pJob->m_bInProgress) {
+            pJob->m_Priority = priority;
+        } else {
+            // The set is ordered by priority, so the job needs to be re-inserted.
+            m_PendingJobs.erase(pJob);
+            pJob->m_Priority = priority;
+            m_PendingJobs.insert(pJob);
+        }
+    }
+}
+
+}
@@ -0,0 +1,116 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _BitmapRequestQueue_H_
+#define _BitmapRequestQueue_H_
+
+#include "../api.h"
+
+#include "BitmapManagerMsg.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace avg {
+
+// A single decode of a file. All requests with the same job key (by default, the
+// same file and pixel format) that arrive before the decode is finished are attached
+// to the same job.
+struct AVG_API BitmapLoadJob
+{
+    std::string m_sKey;
+    UTF8String m_sFilename;
+    PixelFormat m_PF;
+    // Empty for requests that use the default loader.
+    BitmapManagerMsg::LoadFunc m_LoadFunc;
+    BitmapLoadPriority m_Priority;
+    long long m_SeqNum;
+    float m_QueueTime;
+    bool m_bInProgress;
+    std::vector<BitmapManagerMsgPtr> m_pRequests;
+};
+
+typedef boost::shared_ptr<BitmapLoadJob> BitmapLoadJobPtr;
+
+struct AVG_API BitmapRequestStats
+{
+    BitmapRequestStats();
+
+    int m_QueueDepth;
+    int m_NumRequests;
+    int m_NumCoalesced;
+    int m_NumCancelled;
+    int m_NumLoaded;
+    float m_TotalWaitTime;
+    float m_MaxWaitTime;
+    float m_TotalDecodeTime;
+    float m_MaxDecodeTime;
+};
+
+// Thread-safe store of pending bitmap loads, ordered by priority and then by
+// arrival. Requests are added and managed by the main thread and consumed by the
+// BitmapManagerThreads.
+class AVG_API BitmapRequestQueue
+{
+public:
+    BitmapRequestQueue();
+    virtual ~BitmapRequestQueue();
+
+    // Returns true if a new job was created, false if the request was attached to a
+    // job that is already queued or in progress.
+    bool push(BitmapManagerMsgPtr pRequest);
+    bool cancel(int handle);
+    bool setPriority(int handle, BitmapLoadPriority priority);
+    void clear();
+
+    // Returns an empty pointer if there is nothing to do.
+    BitmapLoadJobPtr popJob();
+    // Returns the requests that should receive the result of the job.
+    std::vector<BitmapManagerMsgPtr> finishJob(BitmapLoadJobPtr pJob,
+            float decodeTime);
+
+    BitmapRequestStats getStats() const;
+
+private:
+    struct JobOrder {
+        bool operator()(const BitmapLoadJobPtr& pJob1, const BitmapLoadJobPtr& pJob2)
+                const;
+    };
+    void updateJobPriority(BitmapLoadJobPtr pJob);
+
+    std::set<BitmapLoadJobPtr, JobOrder> m_PendingJobs;
+    std::map<std::string, BitmapLoadJobPtr> m_Jobs;
+    std::map<int, BitmapLoadJobPtr> m_HandleMap;
+    long long m_NextSeqNum;
+
+    BitmapRequestStats m_Stats;
+    mutable boost::mutex m_Mutex;
+};
+
+typedef boost::shared_ptr<BitmapRequestQueue> BitmapRequestQueuePtr;
+
+}
+
+#endif
@@ -39,6 +39,7 @@
 #include "../imaging/Camera.h"
 #include "../imaging/FWCamera.h"
 #include "../imaging/FakeCamera.h"
+#include "../imaging/ThreadedCamera.h"
 
 #include <iostream>
 #include <sstream>
@@ -70,13 +71,15 @@ void CameraNode::registerType()
         .addArg(Arg<int>("camgamma", -1))
         .addArg(Arg<int>("shutter", -1))
         .addArg(Arg<int>("gain", -1))
-        .addArg(Arg<int>("strobeduration", -1));
+        .addArg(Arg<int>("strobeduration", -1))
+        .addArg(Arg<bool>("threaded", false));
     TypeRegistry::get()->registerType(def);
 }
 
 CameraNode::CameraNode(const ArgList& args, const string& sPublisherName)
     : RasterNode(sPublisherName),
       m_bIsPlaying(false),
+      m_bThreaded(false),
       m_FrameNum(0),
       m_bAutoUpdateCameraImage(true),
       m_bNewBmp(false),
@@ -91,6 +94,7 @@ CameraNode::CameraNode(const ArgList& args, const string& sPublisherName)
     int width = args.getArgVal<int>("capturewidth");
     int height = args.getArgVal<int>("captureheight");
     string sPF = args.getArgVal<string>("pixelformat");
+    m_bThreaded = args.getArgVal<bool>("threaded");
 
     PixelFormat camPF = stringToPixelFormat(sPF);
     if (camPF == NO_PIXELFORMAT) {
@@ -122,6 +126,9 @@ CameraNode::CameraNode(const ArgList& args, const string& sPublisherName)
     m_pCamera->setFeature(CAM_FEATURE_GAIN, args.getArgVal<int>("gain"));
     m_pCamera->setFeature(CAM_FEATURE_STROBE_DURATION,
             args.getArgVal<int>("strobeduration"));
+    if (m_bThreaded) {
+        m_pCamera = CameraPtr(new ThreadedCamera(m_pCamera));
+    }
 }
 
 CameraNode::~CameraNode()
@@ -169,13 +176,24 @@ void CameraNode::stop()
 
 bool CameraNode::isAvailable()
 {
-    if (!m_pCamera || boost::dynamic_pointer_cast<FakeCamera>(m_pCamera)) {
+    CameraPtr pCamera = m_pCamera;
+    ThreadedCameraPtr pThreadedCamera =
+            boost::dynamic_pointer_cast<ThreadedCamera>(pCamera);
+    if (pThreadedCamera) {
+        pCamera = pThreadedCamera->getCamera();
+    }
+    if (!pCamera || boost::dynamic_pointer_cast<FakeCamera>(pCamera)) {
         return false;
     } else {
         return true;
     }
 }
 
+bool CameraNode::isThreaded() const
+{
+    return m_bThreaded;
+}
+
 int CameraNode::getBrightness() const
 {
     return getFeature(CAM_FEATURE_BRIGHTNESS);
@@ -58,6 +58,7 @@ class AVG_API CameraNode : public RasterNode
         void play();
         void stop();
         bool isAvailable();
+        bool isThreaded() const;
 
         const std::string& getDevice() const 
         {
@@ -120,6 +121,7 @@ class AVG_API CameraNode : public RasterNode
         void updateToLatestCameraImage();
 
         bool m_bIsPlaying;
+        bool m_bThreaded;
     
         CameraPtr m_pCamera;
         int m_FrameNum;
@@ -241,6 +241,7 @@ void Canvas::preRender()
 {
     ScopeTimer Timer(PreRenderProfilingZone);
     m_pVertexArray->reset();
+    m_RenderStats = RenderStats();
     createStdSubVA();
     m_pRootNode->preRender(m_pVertexArray, true, 1.0f);
 }
@@ -251,6 +252,7 @@ void Canvas::renderWindow(WindowPtr pWindow, MCFBOPtr pFBO, const IntRect& viewp
 {
     GLContext* pContext = pWindow->getGLContext();
     pContext->activate();
+    RenderStats startStats = pContext->getRenderStats();
 
     GLContextManager::get()->uploadDataForContext();
     renderFX(pContext);
@@ -282,6 +284,7 @@ void Canvas::renderWindow(WindowPtr pWindow, MCFBOPtr pFBO, const IntRect& viewp
         m_pRootNode->maybeRender(pContext, projMat);
     }
     renderOutlines(pContext, projMat);
+    m_RenderStats += pContext->getRenderStats() - startStats;
 }
 
 void Canvas::scheduleFXRender(const RasterNodePtr& pNode)
@@ -294,6 +297,26 @@ SubVertexArray& Canvas::getStdSubVA()
     return m_StdSubVA;
 }
 
+int Canvas::getNumChangedVerts() const
+{
+    return m_pVertexArray->getNumChangedVerts();
+}
+
+int Canvas::getNumUnchangedVerts() const
+{
+    return m_pVertexArray->getNumUnchangedVerts();
+}
+
+int Canvas::getNumVertexBytesUploaded() const
+{
+    return m_pVertexArray->getNumBytesUploaded();
+}
+
+const RenderStats& Canvas::getRenderStats() const
+{
+    return m_RenderStats;
+}
+
 void Canvas::renderOutlines(GLContext* pContext, const glm::mat4& transform)
 {
     m_pOutlinesVA->reset();
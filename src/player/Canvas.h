@@ -34,6 +34,7 @@
 #include "../base/Rect.h"
 
 #include "../graphics/OGLHelper.h"
+#include "../graphics/GLContext.h"
 #include "../graphics/SubVertexArray.h"
 
 #include <map>
@@ -106,6 +107,13 @@ class AVG_API Canvas: public ExportedObject
         void scheduleFXRender(const RasterNodePtr& pNode);
         SubVertexArray& getStdSubVA();
 
+        // Vertex statistics for the last frame.
+        int getNumChangedVerts() const;
+        int getNumUnchangedVerts() const;
+        int getNumVertexBytesUploaded() const;
+        // Draw call and state change statistics for the last frame.
+        const RenderStats& getRenderStats() const;
+
     protected:
         Player * getPlayer() const;
         void preRender();
@@ -139,6 +147,7 @@ class AVG_API Canvas: public ExportedObject
         int m_ClipLevel;
 
         std::vector<RasterNodePtr> m_pScheduledFXNodes;
+        RenderStats m_RenderStats;
 };
 
 }
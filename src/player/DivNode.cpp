@@ -25,6 +25,7 @@
 #include "TypeRegistry.h"
 #include "Canvas.h"
 #include "NodeChain.h"
+#include "RasterNode.h"
 
 #include "../graphics/GLContext.h"
 
@@ -56,7 +57,9 @@ void DivNode::registerType()
             ExportedObject::buildObject<DivNode>)
         .addChildren(sChildren)
         .addArg(Arg<bool>("crop", false, false, offsetof(DivNode, m_bCrop)))
-        .addArg(Arg<UTF8String>("mediadir", "", false, offsetof(DivNode, m_sMediaDir)));
+        .addArg(Arg<UTF8String>("mediadir", "", false, offsetof(DivNode, m_sMediaDir)))
+        .addArg(Arg<bool>("spatialindex", false, false,
+                offsetof(DivNode, m_bSpatialIndex)));
     TypeRegistry::get()->registerType(def);
 }
 
@@ -64,6 +67,9 @@ DivNode::DivNode(const ArgList& args, const string& sPublisherName)
     : AreaNode(sPublisherName)
 {
     args.setMembers(this);
+    if (m_bSpatialIndex) {
+        m_pHitTestGrid = HitTestGridPtr(new HitTestGrid);
+    }
     ObjectCounter::get()->incRef(&typeid(*this));
 }
 
@@ -171,6 +177,7 @@ void DivNode::insertChild(NodePtr pChild, unsigned i)
     }
     std::vector<NodePtr>::iterator pos = m_Children.begin()+i;
     m_Children.insert(pos, pChild);
+    invalidateHitTestGrid();
     try {
         pChild->setParent(this, getState(), getCanvas());
     } catch (Exception&) {
@@ -192,6 +199,7 @@ void DivNode::reorderChild(NodePtr pChild, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    invalidateHitTestGrid();
 }
 
 void DivNode::reorderChild(unsigned i, unsigned j)
@@ -204,6 +212,7 @@ void DivNode::reorderChild(unsigned i, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    invalidateHitTestGrid();
 }
 
 unsigned DivNode::indexOf(NodePtr pChild)
@@ -248,6 +257,7 @@ void DivNode::removeChild(NodePtr pChild, bool bKill)
                 getID()+"::removeChild: index "+toString(i)+" out of bounds."));
     }
     m_Children.erase(m_Children.begin()+i);
+    invalidateHitTestGrid();
 }
 
 void DivNode::removeChild(unsigned i, bool bKill)
@@ -278,19 +288,57 @@ void DivNode::setMediaDir(const UTF8String& sMediaDir)
     checkReload();
 }
 
+bool DivNode::getSpatialIndex() const
+{
+    return m_bSpatialIndex;
+}
+
+void DivNode::setSpatialIndex(bool bSpatialIndex)
+{
+    m_bSpatialIndex = bSpatialIndex;
+    if (m_bSpatialIndex) {
+        if (!m_pHitTestGrid) {
+            m_pHitTestGrid = HitTestGridPtr(new HitTestGrid);
+        }
+    } else {
+        m_pHitTestGrid = HitTestGridPtr();
+    }
+}
+
+void DivNode::childHitBoundsChanged(const Node* pChild)
+{
+    if (m_pHitTestGrid) {
+        m_pHitTestGrid->updateChild(pChild);
+    }
+}
+
 void DivNode::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
 {
     if (reactsToMouseEvents() &&
             ((getSize() == glm::vec2(0,0) ||
              (pos.x >= 0 && pos.y >= 0 && pos.x < getSize().x && pos.y < getSize().y))))
     {
-        for (int i = getNumChildren()-1; i >= 0; i--) {
-            NodePtr pCurChild = getChild(i);
-            glm::vec2 relPos = pCurChild->toLocal(pos);
-            pCurChild->getElementsByPos(relPos, pElements);
-            if (!pElements->empty()) {
-                pElements->append(getSharedThis());
-                return;
+        if (m_pHitTestGrid) {
+            vector<unsigned> candidates;
+            m_pHitTestGrid->getCandidates(m_Children, pos, candidates);
+            for (unsigned i = 0; i < candidates.size(); ++i) {
+                const NodePtr& pCurChild = m_Children[candidates[i]];
+                glm::vec2 relPos = pCurChild->toLocal(pos);
+                pCurChild->getElementsByPos(relPos, pElements);
+                if (!pElements->empty()) {
+                    pElements->append(getSharedThis());
+                    return;
+                }
+            }
+        } else {
+            for (int i = getNumChildren()-1; i >= 0; i--) {
+                NodePtr pCurChild = getChild(i);
+                glm::vec2 relPos = pCurChild->toLocal(pos);
+                pCurChild->getElementsByPos(relPos, pElements);
+                if (!pElements->empty()) {
+                    pElements->append(getSharedThis());
+                    return;
+                }
             }
         }
         // pos isn't in any of the children.
@@ -301,6 +349,63 @@ void DivNode::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
     }
 }
 
+void DivNode::getElementsByPositions(const vector<glm::vec2>& positions,
+        vector<NodeChainPtr>& pElementsList)
+{
+    AVG_ASSERT(positions.size() == pElementsList.size());
+    if (m_pHitTestGrid) {
+        // The grid already restricts the search to a few children per position.
+        Node::getElementsByPositions(positions, pElementsList);
+        return;
+    }
+    if (!reactsToMouseEvents()) {
+        return;
+    }
+    bool bHasSize = (getSize() != glm::vec2(0,0));
+
+    // Positions inside this div that no child has claimed yet.
+    vector<glm::vec2> openPositions;
+    vector<NodeChainPtr> pOpenElements;
+    for (unsigned i = 0; i < positions.size(); ++i) {
+        const glm::vec2& pos = positions[i];
+        if (!bHasSize ||
+                (pos.x >= 0 && pos.y >= 0 && pos.x < getSize().x && pos.y < getSize().y))
+        {
+            openPositions.push_back(pos);
+            pOpenElements.push_back(pElementsList[i]);
+        }
+    }
+
+    vector<glm::vec2> childPositions;
+    for (int i = getNumChildren()-1; i >= 0 && !openPositions.empty(); i--) {
+        const NodePtr& pCurChild = m_Children[i];
+        childPositions.resize(openPositions.size());
+        for (unsigned j = 0; j < openPositions.size(); ++j) {
+            childPositions[j] = pCurChild->toLocal(openPositions[j]);
+        }
+        // The chains of open positions are empty, so the child can fill them directly.
+        pCurChild->getElementsByPositions(childPositions, pOpenElements);
+        unsigned numOpen = 0;
+        for (unsigned j = 0; j < openPositions.size(); ++j) {
+            if (pOpenElements[j]->empty()) {
+                openPositions[numOpen] = openPositions[j];
+                pOpenElements[numOpen] = pOpenElements[j];
+                numOpen++;
+            } else {
+                pOpenElements[j]->append(getSharedThis());
+            }
+        }
+        openPositions.resize(numOpen);
+        pOpenElements.resize(numOpen);
+    }
+    // Positions that aren't in any of the children.
+    if (bHasSize) {
+        for (unsigned j = 0; j < pOpenElements.size(); ++j) {
+            pOpenElements[j]->append(getSharedThis());
+        }
+    }
+}
+
 void DivNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
         float parentEffectiveOpacity)
 {
@@ -326,14 +431,45 @@ void DivNode::render(GLContext* pContext, const glm::mat4& transform)
     if (getCrop() && getSize() != glm::vec2(0,0)) {
         getCanvas()->pushClipRect(pContext, transform, m_ClipVA);
     }
-    for (unsigned i = 0; i < getNumChildren(); i++) {
-        getChild(i)->maybeRender(pContext, transform);
+    if (Player::get()->isDrawBatchingEnabled()) {
+        renderBatched(pContext, transform);
+    } else {
+        for (unsigned i = 0; i < getNumChildren(); i++) {
+            getChild(i)->maybeRender(pContext, transform);
+        }
     }
     if (getCrop() && getSize() != glm::vec2(0,0)) {
         getCanvas()->popClipRect(pContext, transform, m_ClipVA);
     }
 }
 
+void DivNode::renderBatched(GLContext* pContext, const glm::mat4& transform)
+{
+    unsigned i = 0;
+    while (i < getNumChildren()) {
+        RasterNode* pFirstNode = dynamic_cast<RasterNode*>(m_Children[i].get());
+        if (pFirstNode && pFirstNode->isBatched()) {
+            // Collect the run of compatible siblings and draw it in one call.
+            int numNodes = 1;
+            int numIndexes = pFirstNode->getNumBatchIndexes();
+            RasterNode* pPrevNode = pFirstNode;
+            for (i++; i < getNumChildren(); i++) {
+                RasterNode* pNode = dynamic_cast<RasterNode*>(m_Children[i].get());
+                if (!pNode || !pNode->canBatchWith(*pPrevNode)) {
+                    break;
+                }
+                numNodes++;
+                numIndexes += pNode->getNumBatchIndexes();
+                pPrevNode = pNode;
+            }
+            pFirstNode->renderBatch(pContext, transform, numNodes, numIndexes);
+        } else {
+            m_Children[i]->maybeRender(pContext, transform);
+            i++;
+        }
+    }
+}
+
 void DivNode::renderOutlines(const VertexArrayPtr& pVA, Pixel32 parentColor)
 {
     Pixel32 effColor = getEffectiveOutlineColor(parentColor);
@@ -393,6 +529,13 @@ IntPoint DivNode::getMediaSize()
     return IntPoint(0, 0);
 }
  
+void DivNode::invalidateHitTestGrid()
+{
+    if (m_pHitTestGrid) {
+        m_pHitTestGrid->invalidate();
+    }
+}
+
 bool DivNode::isChildTypeAllowed(const string& sType)
 {
     return getDefinition()->isChildAllowed(sType);
@@ -24,6 +24,7 @@
 
 #include "../api.h"
 #include "AreaNode.h"
+#include "HitTestGrid.h"
 
 #include "../graphics/SubVertexArray.h"
 
@@ -68,7 +69,13 @@ class AVG_API DivNode : public AreaNode
         const UTF8String& getMediaDir() const;
         void setMediaDir(const UTF8String& mediaDir);
 
+        bool getSpatialIndex() const;
+        void setSpatialIndex(bool bSpatialIndex);
+        void childHitBoundsChanged(const Node* pChild);
+
         void getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements);
+        virtual void getElementsByPositions(const std::vector<glm::vec2>& positions,
+                std::vector<NodeChainPtr>& pElementsList);
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
         virtual void render(GLContext* pContext, const glm::mat4& transform);
@@ -82,9 +89,13 @@ class AVG_API DivNode : public AreaNode
    
     private:
         bool isChildTypeAllowed(const std::string& sType);
+        void invalidateHitTestGrid();
+        void renderBatched(GLContext* pContext, const glm::mat4& transform);
 
         UTF8String m_sMediaDir;
         bool m_bCrop;
+        bool m_bSpatialIndex;
+        HitTestGridPtr m_pHitTestGrid;
 
         SubVertexArray m_ClipVA;
 
@@ -29,6 +29,7 @@
 #include "../base/Exception.h"
 #include "../base/OSHelper.h"
 
+#include <set>
 #include <string>
 
 using namespace std;
@@ -39,7 +40,8 @@ namespace avg {
 EventDispatcher::EventDispatcher(Player* pPlayer, bool bMouseEnabled)
     : m_pPlayer(pPlayer),
       m_NumMouseButtonsDown(0),
-      m_bMouseEnabled(bMouseEnabled)
+      m_bMouseEnabled(bMouseEnabled),
+      m_bEventBatching(false)
 {
 }
 
@@ -63,6 +65,11 @@ void EventDispatcher::dispatch()
         }
     }
 
+    if (m_bEventBatching) {
+        coalesceMotionEvents(events);
+        precalcNodesUnderCursors(events);
+    }
+
     vector<EventPtr>::iterator it;
     for (it = events.begin(); it != events.end(); ++it) {
         EventPtr pEvent = *it;
@@ -91,6 +98,11 @@ void EventDispatcher::enableMouse(bool bEnabled)
     m_bMouseEnabled = bEnabled;
 }
 
+void EventDispatcher::enableEventBatching(bool bEnabled)
+{
+    m_bEventBatching = bEnabled;
+}
+
 ContactPtr EventDispatcher::getContact(int id)
 {
     std::map<int, ContactPtr>::iterator it = m_ContactMap.find(id);
@@ -118,6 +130,49 @@ bool EventDispatcher::processEventHook(EventPtr pEvent)
     return false;
 }
 
+void EventDispatcher::coalesceMotionEvents(vector<EventPtr>& events)
+{
+    // A motion event is dropped if the same cursor moves again later in the frame
+    // and nothing else happens to the cursor in between. Walks the events backwards,
+    // remembering the cursors whose next event is a motion event.
+    typedef pair<InputDevice*, pair<int, int> > CursorKey;
+    set<CursorKey> movedLater;
+    vector<EventPtr> keptEvents;
+    for (vector<EventPtr>::reverse_iterator it = events.rbegin(); it != events.rend();
+            ++it)
+    {
+        CursorEventPtr pCursorEvent = dynamic_pointer_cast<CursorEvent>(*it);
+        if (pCursorEvent) {
+            CursorKey key(pCursorEvent->getInputDevice().get(), 
+                    make_pair(int(pCursorEvent->getSource()), 
+                            pCursorEvent->getCursorID()));
+            if (pCursorEvent->getType() == Event::CURSOR_MOTION) {
+                if (!movedLater.insert(key).second) {
+                    continue;
+                }
+            } else {
+                movedLater.erase(key);
+            }
+        }
+        keptEvents.push_back(*it);
+    }
+    events.assign(keptEvents.rbegin(), keptEvents.rend());
+}
+
+void EventDispatcher::precalcNodesUnderCursors(const vector<EventPtr>& events)
+{
+    vector<CursorEventPtr> pCursorEvents;
+    for (unsigned i = 0; i < events.size(); ++i) {
+        CursorEventPtr pCursorEvent = dynamic_pointer_cast<CursorEvent>(events[i]);
+        if (pCursorEvent && !(!m_bMouseEnabled && 
+                pCursorEvent->getSource() == Event::MOUSE))
+        {
+            pCursorEvents.push_back(pCursorEvent);
+        }
+    }
+    m_pPlayer->precalcNodesUnderCursors(pCursorEvents);
+}
+
 void EventDispatcher::testAddContact(EventPtr pEvent)
 {
     ContactPtr pContact;
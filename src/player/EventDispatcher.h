@@ -48,6 +48,7 @@ class AVG_API EventDispatcher {
 
         void sendEvent(EventPtr pEvent);
         void enableMouse(bool bEnabled);
+        void enableEventBatching(bool bEnabled);
         ContactPtr getContact(int id);
 
     private:
@@ -55,12 +56,15 @@ class AVG_API EventDispatcher {
         bool processEventHook(EventPtr pEvent);
         void testAddContact(EventPtr pEvent);
         void testRemoveContact(EventPtr pEvent);
+        void coalesceMotionEvents(std::vector<EventPtr>& events);
+        void precalcNodesUnderCursors(const std::vector<EventPtr>& events);
 
         std::vector<InputDevicePtr> m_InputDevices;
         Player* m_pPlayer;
         std::map<int, ContactPtr> m_ContactMap;
         int m_NumMouseButtonsDown;
         bool m_bMouseEnabled;
+        bool m_bEventBatching;
 };
 typedef boost::shared_ptr<EventDispatcher> EventDispatcherPtr;
 
@@ -0,0 +1,217 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "FrameStats.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/TimeSource.h"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace std;
+
+namespace avg {
+
+// One minute at 60 fps.
+const unsigned FrameStats::DEFAULT_CAPACITY = 3600;
+
+FrameStats::FrameStats(unsigned capacity)
+    : m_Records(capacity)
+{
+    AVG_ASSERT(capacity > 0);
+    reset();
+}
+
+FrameStats::~FrameStats()
+{
+}
+
+void FrameStats::reset()
+{
+    m_NumRecords = 0;
+    m_NextRecord = 0;
+    m_LastTime = 0;
+    m_LastFrameEndTime = 0;
+    m_NumFrames = 0;
+    m_NumMissedDeadlines = 0;
+    m_TargetInterval = 0;
+}
+
+void FrameStats::startFrame()
+{
+    m_LastTime = TimeSource::get()->getCurrentMicrosecs();
+    for (int i = 0; i < NUM_PHASES; ++i) {
+        m_CurRecord.m_PhaseTimes[i] = 0;
+    }
+}
+
+void FrameStats::endPhase(Phase phase)
+{
+    long long curTime = TimeSource::get()->getCurrentMicrosecs();
+    m_CurRecord.m_PhaseTimes[phase] += curTime-m_LastTime;
+    m_LastTime = curTime;
+}
+
+void FrameStats::endFrame(long long targetInterval)
+{
+    long long curTime = TimeSource::get()->getCurrentMicrosecs();
+    m_CurRecord.m_FrameNum = m_NumFrames;
+    m_CurRecord.m_EndTime = curTime;
+    if (m_LastFrameEndTime == 0) {
+        long long frameTime = 0;
+        for (int i = 0; i < NUM_PHASES; ++i) {
+            frameTime += m_CurRecord.m_PhaseTimes[i];
+        }
+        m_CurRecord.m_Interval = frameTime;
+    } else {
+        m_CurRecord.m_Interval = curTime-m_LastFrameEndTime;
+    }
+    m_TargetInterval = targetInterval;
+    m_CurRecord.m_bMissedDeadline = (targetInterval > 0 && 
+            m_CurRecord.m_Interval*2 > targetInterval*3);
+    if (m_CurRecord.m_bMissedDeadline) {
+        m_NumMissedDeadlines++;
+    }
+    m_LastFrameEndTime = curTime;
+    m_NumFrames++;
+
+    m_Records[m_NextRecord] = m_CurRecord;
+    m_NextRecord = (m_NextRecord+1) % m_Records.size();
+    if (m_NumRecords < m_Records.size()) {
+        m_NumRecords++;
+    }
+}
+
+long long FrameStats::getNumFrames() const
+{
+    return m_NumFrames;
+}
+
+long long FrameStats::getNumMissedDeadlines() const
+{
+    return m_NumMissedDeadlines;
+}
+
+long long FrameStats::getTargetInterval() const
+{
+    return m_TargetInterval;
+}
+
+unsigned FrameStats::getNumRecords() const
+{
+    return m_NumRecords;
+}
+
+const FrameStats::FrameRecord& FrameStats::getRecord(unsigned i) const
+{
+    AVG_ASSERT(i < m_NumRecords);
+    unsigned capacity = m_Records.size();
+    unsigned firstRecord = (m_NextRecord+capacity-m_NumRecords) % capacity;
+    return m_Records[(firstRecord+i) % capacity];
+}
+
+long long FrameStats::getIntervalPercentile(float percentile) const
+{
+    if (m_NumRecords == 0) {
+        return 0;
+    }
+    vector<long long> intervals(m_NumRecords);
+    for (unsigned i = 0; i < m_NumRecords; ++i) {
+        intervals[i] = m_Records[i].m_Interval;
+    }
+    // Nearest rank.
+    unsigned rank = unsigned(percentile/100*m_NumRecords+0.5f);
+    rank = min(max(rank, 1u), m_NumRecords)-1;
+    nth_element(intervals.begin(), intervals.begin()+rank, intervals.end());
+    return intervals[rank];
+}
+
+long long FrameStats::getMaxInterval() const
+{
+    long long maxInterval = 0;
+    for (unsigned i = 0; i < m_NumRecords; ++i) {
+        maxInterval = max(maxInterval, m_Records[i].m_Interval);
+    }
+    return maxInterval;
+}
+
+void FrameStats::dump(const string& sFilename) const
+{
+    ofstream file(sFilename.c_str());
+    if (!file) {
+        throw Exception(AVG_ERR_FILEIO, 
+                "Could not open '" + sFilename + "' for writing frame statistics.");
+    }
+    file << "frame,endtime,interval";
+    for (int i = 0; i < NUM_PHASES; ++i) {
+        file << "," << getPhaseName(Phase(i));
+    }
+    file << ",misseddeadline" << endl;
+    for (unsigned i = 0; i < m_NumRecords; ++i) {
+        const FrameRecord& record = getRecord(i);
+        file << record.m_FrameNum << "," << record.m_EndTime << "," << record.m_Interval;
+        for (int j = 0; j < NUM_PHASES; ++j) {
+            file << "," << record.m_PhaseTimes[j];
+        }
+        file << "," << record.m_bMissedDeadline << endl;
+    }
+}
+
+void FrameStats::logStatistics() const
+{
+    if (m_NumRecords == 0) {
+        return;
+    }
+    AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+            "Frame time statistics (last " << m_NumRecords << " frames, in ms): ");
+    AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+            "  p50: " << getIntervalPercentile(50)/1000.f
+            << ", p95: " << getIntervalPercentile(95)/1000.f
+            << ", p99: " << getIntervalPercentile(99)/1000.f
+            << ", max: " << getMaxInterval()/1000.f);
+    AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+            "  Missed deadlines: " << m_NumMissedDeadlines << " of " << m_NumFrames
+            << " frames");
+}
+
+const char* FrameStats::getPhaseName(Phase phase)
+{
+    switch (phase) {
+        case TIMERS:
+            return "timers";
+        case EVENTS:
+            return "events";
+        case OFFSCREEN:
+            return "offscreen";
+        case MAIN_CANVAS:
+            return "maincanvas";
+        case END_FRAME:
+            return "endframe";
+        default:
+            AVG_ASSERT(false);
+            return 0;
+    }
+}
+
+}
@@ -0,0 +1,96 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _FrameStats_H_
+#define _FrameStats_H_
+
+#include "../api.h"
+
+#include <string>
+#include <vector>
+
+namespace avg {
+
+// Timing records of the last frames of the main loop, used to find stutter. Records
+// are kept in a ring buffer that is allocated once, so recording a frame never 
+// allocates memory or takes a lock. All methods must be called from the main thread.
+class AVG_API FrameStats
+{
+public:
+    enum Phase {TIMERS, EVENTS, OFFSCREEN, MAIN_CANVAS, END_FRAME, NUM_PHASES};
+
+    struct FrameRecord {
+        long long m_FrameNum;
+        // Time at which the frame ended, in microseconds.
+        long long m_EndTime;
+        // Time between the end of the previous frame and the end of this one.
+        long long m_Interval;
+        long long m_PhaseTimes[NUM_PHASES];
+        bool m_bMissedDeadline;
+    };
+
+    FrameStats(unsigned capacity=DEFAULT_CAPACITY);
+    virtual ~FrameStats();
+
+    void reset();
+
+    void startFrame();
+    // Records the time since the start of the frame or the end of the last phase.
+    void endPhase(Phase phase);
+    // targetInterval is the frame duration in microseconds that the framerate asks
+    // for. Frames that take more than one and a half times as long missed at least
+    // one deadline. 0 disables the deadline check.
+    void endFrame(long long targetInterval);
+
+    long long getNumFrames() const;
+    long long getNumMissedDeadlines() const;
+    long long getTargetInterval() const;
+    // Recorded frames, oldest first.
+    unsigned getNumRecords() const;
+    const FrameRecord& getRecord(unsigned i) const;
+    // Frame interval percentile (0..100) of the recorded frames, in microseconds.
+    long long getIntervalPercentile(float percentile) const;
+    long long getMaxInterval() const;
+
+    void dump(const std::string& sFilename) const;
+    void logStatistics() const;
+
+    static const char* getPhaseName(Phase phase);
+
+    static const unsigned DEFAULT_CAPACITY;
+
+private:
+    std::vector<FrameRecord> m_Records;
+    unsigned m_NumRecords;
+    unsigned m_NextRecord;
+    FrameRecord m_CurRecord;
+    long long m_LastTime;
+    long long m_LastFrameEndTime;
+
+    long long m_NumFrames;
+    long long m_NumMissedDeadlines;
+    long long m_TargetInterval;
+};
+
+}
+
+#endif
@@ -28,6 +28,7 @@
 #include "../graphics/Bitmap.h"
 #include "../graphics/ImageCache.h"
 #include "../graphics/CachedImage.h"
+#include "../graphics/TextureAtlas.h"
 #include "../graphics/GLContextManager.h"
 #include "../graphics/Filterfliprgb.h"
 
@@ -41,12 +42,15 @@ using namespace std;
 
 namespace avg {
 
-GPUImage::GPUImage(OGLSurface * pSurface, bool bUseMipmaps)
+GPUImage::GPUImage(OGLSurface * pSurface, bool bUseMipmaps,
+        TexUploadPriority uploadPriority)
     : m_sFilename(""),
+      m_DecodeSize(0,0),
       m_pSurface(pSurface),
       m_State(CPU),
       m_Source(NONE),
-      m_bUseMipmaps(bUseMipmaps)
+      m_bUseMipmaps(bUseMipmaps),
+      m_UploadPriority(uploadPriority)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     assertValid();
@@ -104,10 +108,11 @@ void GPUImage::setEmpty()
     assertValid();
 }
 
-void GPUImage::setFilename(const std::string& sFilename, TexCompression comp)
+void GPUImage::setFilename(const std::string& sFilename, TexCompression comp,
+        const IntPoint& decodeSize)
 {
     assertValid();
-    CachedImagePtr pImage = ImageCache::get()->getImage(sFilename, comp);
+    CachedImagePtr pImage = ImageCache::get()->getImage(sFilename, comp, decodeSize);
     BitmapPtr pBmp = pImage->getBmp();
     if (comp == TEXCOMPRESSION_B5G6R5 && pBmp->hasAlpha()) {
         pImage->decBmpRef();
@@ -120,6 +125,7 @@ void GPUImage::setFilename(const std::string& sFilename, TexCompression comp)
     changeSource(FILE);
 
     m_sFilename = sFilename;
+    m_DecodeSize = decodeSize;
 
     if (m_State == GPU) {
         m_pSurface->destroy();
@@ -182,6 +188,11 @@ const string& GPUImage::getFilename() const
     return m_sFilename;
 }
 
+const IntPoint& GPUImage::getDecodeSize() const
+{
+    return m_DecodeSize;
+}
+
 BitmapPtr GPUImage::getBitmap()
 {
     if (m_Source == NONE || m_Source == SCENE) {
@@ -236,12 +247,38 @@ GPUImage::Source GPUImage::getSource()
     return m_Source;
 }
 
+bool GPUImage::isTexUploadPending() const
+{
+    if (m_State == GPU && m_Source == FILE) {
+        TextureAtlasRegionPtr pRegion = m_pImage->getAtlasRegion();
+        if (pRegion) {
+            // Other images on the atlas page can be displayed while this one waits.
+            return pRegion->isUploadPending();
+        } else {
+            return GLContextManager::get()->isTexUploadPending(m_pImage->getTex());
+        }
+    } else {
+        return false;
+    }
+}
+
+void GPUImage::raiseTexUploadPriority(TexUploadPriority priority)
+{
+    if (m_State == GPU && m_Source == FILE) {
+        GLContextManager::get()->raiseTexUploadPriority(m_pImage->getTex(), priority);
+    }
+}
+
 void GPUImage::setupImageSurface()
 {
     PixelFormat pf = m_pImage->getBmp()->getPixelFormat();
-    m_pImage->incTexRef(m_bUseMipmaps);
+    m_pImage->incTexRef(m_bUseMipmaps, m_UploadPriority);
     MCTexturePtr pTex = m_pImage->getTex();
     m_pSurface->create(pf, pTex);
+    TextureAtlasRegionPtr pRegion = m_pImage->getAtlasRegion();
+    if (pRegion) {
+        m_pSurface->setTexRect(pRegion->getRect());
+    }
 }
 
 void GPUImage::setupBitmapSurface()
@@ -260,6 +297,7 @@ bool GPUImage::changeSource(Source newSource)
             case FILE:
             case BITMAP:
                 m_sFilename = "";
+                m_DecodeSize = IntPoint(0,0);
                 break;
             case SCENE:
                 m_pCanvas = OffscreenCanvasPtr();
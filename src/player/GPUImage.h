@@ -48,7 +48,11 @@ class AVG_API GPUImage
         enum State {CPU, GPU};
         enum Source {NONE, FILE, BITMAP, SCENE};
 
-        GPUImage(OGLSurface * pSurface, bool bUseMipmaps);
+        // Texture uploads of image files use uploadPriority. If it isn't
+        // UPLOADPRIORITY_IMMEDIATE, the owner must check isTexUploadPending() before
+        // rendering.
+        GPUImage(OGLSurface * pSurface, bool bUseMipmaps,
+                TexUploadPriority uploadPriority=UPLOADPRIORITY_IMMEDIATE);
         virtual ~GPUImage();
 
         virtual void moveToGPU();
@@ -56,12 +60,14 @@ class AVG_API GPUImage
 
         void setEmpty();
         void setFilename(const std::string& sFilename,
-                TexCompression comp = TEXCOMPRESSION_NONE);
+                TexCompression comp = TEXCOMPRESSION_NONE,
+                const IntPoint& decodeSize = IntPoint(0,0));
         void setBitmap(BitmapPtr pBmp, 
                 TexCompression comp = TEXCOMPRESSION_NONE);
         void setCanvas(OffscreenCanvasPtr pCanvas);
         OffscreenCanvasPtr getCanvas() const;
         const std::string& getFilename() const;
+        const IntPoint& getDecodeSize() const;
 
         BitmapPtr getBitmap();
         IntPoint getSize();
@@ -70,6 +76,9 @@ class AVG_API GPUImage
         State getState();
         Source getSource();
 
+        bool isTexUploadPending() const;
+        void raiseTexUploadPriority(TexUploadPriority priority);
+
     private:
         void setupImageSurface();
         void setupBitmapSurface();
@@ -78,6 +87,7 @@ class AVG_API GPUImage
         void assertValid() const;
 
         std::string m_sFilename;
+        IntPoint m_DecodeSize;
         CachedImagePtr m_pImage;
         OGLSurface * m_pSurface;
 
@@ -87,6 +97,7 @@ class AVG_API GPUImage
         State m_State;
         Source m_Source;
         bool m_bUseMipmaps;
+        TexUploadPriority m_UploadPriority;
 };
 
 typedef boost::shared_ptr<GPUImage> GPUImagePtr;
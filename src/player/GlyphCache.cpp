@@ -0,0 +1,298 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "GlyphCache.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+
+#include "../graphics/Bitmap.h"
+#include "../graphics/Filterfill.h"
+
+#include <pango/pangoft2.h>
+
+using namespace std;
+
+namespace avg {
+
+const unsigned GlyphCache::MAX_GLYPHS = 4096;
+const unsigned GlyphCache::MAX_LAYOUTS = 256;
+
+TextLayout::TextLayout(PangoLayout* pLayout)
+    : m_pLayout(pLayout),
+      m_bHasGlyphs(false),
+      m_bCanUseGlyphs(false)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    pango_layout_get_pixel_extents(m_pLayout, &m_InkRect, &m_LogicalRect);
+}
+
+TextLayout::~TextLayout()
+{
+    g_object_unref(m_pLayout);
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+PangoLayout* TextLayout::getLayout() const
+{
+    return m_pLayout;
+}
+
+const PangoRectangle& TextLayout::getInkRect() const
+{
+    return m_InkRect;
+}
+
+const PangoRectangle& TextLayout::getLogicalRect() const
+{
+    return m_LogicalRect;
+}
+
+bool TextLayout::hasGlyphs() const
+{
+    return m_bHasGlyphs;
+}
+
+bool TextLayout::canUseGlyphs() const
+{
+    AVG_ASSERT(m_bHasGlyphs);
+    return m_bCanUseGlyphs;
+}
+
+const vector<PositionedGlyph>& TextLayout::getGlyphs() const
+{
+    return m_Glyphs;
+}
+
+const MCTexturePtr& TextLayout::getGlyphTex() const
+{
+    return m_pGlyphTex;
+}
+
+
+GlyphCache::GlyphCache()
+{
+    m_Atlas.setEnabled(true);
+}
+
+GlyphCache::~GlyphCache()
+{
+    clear();
+}
+
+TextLayoutPtr GlyphCache::getLayout(const string& sKey)
+{
+    map<string, LayoutList::iterator>::iterator it = m_LayoutMap.find(sKey);
+    if (it == m_LayoutMap.end()) {
+        return TextLayoutPtr();
+    }
+    // Move to front of the LRU list.
+    m_Layouts.splice(m_Layouts.begin(), m_Layouts, it->second);
+    return it->second->second;
+}
+
+void GlyphCache::addLayout(const string& sKey, TextLayoutPtr pLayout)
+{
+    AVG_ASSERT(m_LayoutMap.find(sKey) == m_LayoutMap.end());
+    m_Layouts.push_front(make_pair(sKey, pLayout));
+    m_LayoutMap[sKey] = m_Layouts.begin();
+    if (m_Layouts.size() > MAX_LAYOUTS) {
+        m_LayoutMap.erase(m_Layouts.back().first);
+        m_Layouts.pop_back();
+    }
+}
+
+void GlyphCache::calcGlyphs(TextLayoutPtr pLayout)
+{
+    AVG_ASSERT(!pLayout->m_bHasGlyphs);
+    pLayout->m_bHasGlyphs = true;
+    pLayout->m_bCanUseGlyphs = false;
+    if (hasDecorations(pLayout->m_pLayout)) {
+        return;
+    }
+    if (m_Glyphs.size() > MAX_GLYPHS) {
+        clear();
+    }
+
+    bool bOK = true;
+    vector<PositionedGlyph>& glyphs = pLayout->m_Glyphs;
+    MCTexturePtr pTex;
+    PangoLayoutIter* pIter = pango_layout_get_iter(pLayout->m_pLayout);
+    do {
+        PangoLayoutRun* pRun = pango_layout_iter_get_run(pIter);
+        if (!pRun) {
+            // End of line.
+            continue;
+        }
+        PangoRectangle runRect;
+        pango_layout_iter_get_run_extents(pIter, 0, &runRect);
+        int baseline = pango_layout_iter_get_baseline(pIter);
+        PangoFont* pFont = pRun->item->analysis.font;
+        PangoGlyphString* pGlyphString = pRun->glyphs;
+        int x = runRect.x;
+        for (int i = 0; i < pGlyphString->num_glyphs && bOK; ++i) {
+            const PangoGlyphInfo& info = pGlyphString->glyphs[i];
+            if (info.glyph & PANGO_GLYPH_UNKNOWN_FLAG) {
+                // Rendered as hex box by pango.
+                bOK = false;
+            } else if (info.glyph != PANGO_GLYPH_EMPTY) {
+                CachedGlyphPtr pGlyph = getGlyph(pFont, info.glyph);
+                if (!pGlyph) {
+                    bOK = false;
+                } else if (pGlyph->m_pRegion) {
+                    const MCTexturePtr& pGlyphTex = pGlyph->m_pRegion->getTex();
+                    if (!pTex) {
+                        pTex = pGlyphTex;
+                    }
+                    // All glyphs need to be in one texture so the text can be
+                    // rendered in one pass.
+                    bOK = (pTex == pGlyphTex);
+                    PositionedGlyph positionedGlyph;
+                    positionedGlyph.m_pGlyph = pGlyph;
+                    positionedGlyph.m_Pos = pGlyph->m_Offset + IntPoint(
+                            PANGO_PIXELS(x + info.geometry.x_offset),
+                            PANGO_PIXELS(baseline + info.geometry.y_offset));
+                    glyphs.push_back(positionedGlyph);
+                }
+            }
+            x += info.geometry.width;
+        }
+    } while (bOK && pango_layout_iter_next_run(pIter));
+    pango_layout_iter_free(pIter);
+
+    if (bOK && pTex) {
+        pLayout->m_bCanUseGlyphs = true;
+        pLayout->m_pGlyphTex = pTex;
+    } else {
+        glyphs.clear();
+    }
+}
+
+void GlyphCache::clear()
+{
+    m_Glyphs.clear();
+    for (set<PangoFont*>::iterator it = m_pFonts.begin(); it != m_pFonts.end(); ++it) {
+        g_object_unref(*it);
+    }
+    m_pFonts.clear();
+    m_Layouts.clear();
+    m_LayoutMap.clear();
+}
+
+int GlyphCache::getNumGlyphs() const
+{
+    return int(m_Glyphs.size());
+}
+
+int GlyphCache::getNumLayouts() const
+{
+    return int(m_Layouts.size());
+}
+
+CachedGlyphPtr GlyphCache::getGlyph(PangoFont* pFont, PangoGlyph glyph)
+{
+    pair<PangoFont*, PangoGlyph> key(pFont, glyph);
+    GlyphMap::iterator it = m_Glyphs.find(key);
+    if (it != m_Glyphs.end()) {
+        return it->second;
+    }
+    CachedGlyphPtr pGlyph = renderGlyph(pFont, glyph);
+    if (pGlyph) {
+        if (m_pFonts.find(pFont) == m_pFonts.end()) {
+            g_object_ref(pFont);
+            m_pFonts.insert(pFont);
+        }
+        m_Glyphs[key] = pGlyph;
+    }
+    return pGlyph;
+}
+
+CachedGlyphPtr GlyphCache::renderGlyph(PangoFont* pFont, PangoGlyph glyph)
+{
+    CachedGlyphPtr pGlyph(new CachedGlyph);
+    PangoRectangle inkRect;
+    pango_font_get_glyph_extents(pFont, glyph, &inkRect, 0);
+    if (inkRect.width <= 0 || inkRect.height <= 0) {
+        return pGlyph;
+    }
+    // Add a pixel on each side for antialiasing.
+    IntPoint tl(PANGO_PIXELS_FLOOR(inkRect.x)-1, PANGO_PIXELS_FLOOR(inkRect.y)-1);
+    IntPoint br(PANGO_PIXELS_CEIL(inkRect.x+inkRect.width)+1,
+            PANGO_PIXELS_CEIL(inkRect.y+inkRect.height)+1);
+    IntPoint size = br-tl;
+    if (!m_Atlas.canAdd(size, A8)) {
+        return CachedGlyphPtr();
+    }
+
+    BitmapPtr pBmp(new Bitmap(size, A8));
+    FilterFill<unsigned char>(0).applyInPlace(pBmp);
+    FT_Bitmap bitmap;
+    bitmap.rows = size.y;
+    bitmap.width = size.x;
+    bitmap.pitch = pBmp->getStride();
+    bitmap.buffer = pBmp->getPixels();
+    bitmap.num_grays = 256;
+    bitmap.pixel_mode = ft_pixel_mode_grays;
+
+    PangoGlyphString* pGlyphString = pango_glyph_string_new();
+    pango_glyph_string_set_size(pGlyphString, 1);
+    PangoGlyphInfo& info = pGlyphString->glyphs[0];
+    info.glyph = glyph;
+    info.geometry.width = 0;
+    info.geometry.x_offset = 0;
+    info.geometry.y_offset = 0;
+    info.attr.is_cluster_start = 1;
+    pango_ft2_render(&bitmap, pFont, pGlyphString, -tl.x, -tl.y);
+    pango_glyph_string_free(pGlyphString);
+
+    pGlyph->m_pRegion = m_Atlas.add(pBmp);
+    pGlyph->m_Offset = tl;
+    return pGlyph;
+}
+
+static bool isIntAttrSet(PangoAttrIterator* pIter, PangoAttrType type)
+{
+    PangoAttribute* pAttr = pango_attr_iterator_get(pIter, type);
+    return pAttr && ((PangoAttrInt*)pAttr)->value != 0;
+}
+
+bool GlyphCache::hasDecorations(PangoLayout* pLayout) const
+{
+    // Underlines, strikethroughs and raised text are drawn by the pango renderer,
+    // not by the font. These layouts are rendered into a bitmap.
+    PangoAttrList* pAttrList = pango_layout_get_attributes(pLayout);
+    if (!pAttrList) {
+        return false;
+    }
+    bool bFound = false;
+    PangoAttrIterator* pIter = pango_attr_list_get_iterator(pAttrList);
+    do {
+        bFound = isIntAttrSet(pIter, PANGO_ATTR_UNDERLINE) ||
+                isIntAttrSet(pIter, PANGO_ATTR_STRIKETHROUGH) ||
+                isIntAttrSet(pIter, PANGO_ATTR_RISE) ||
+                pango_attr_iterator_get(pIter, PANGO_ATTR_SHAPE) != 0;
+    } while (!bFound && pango_attr_iterator_next(pIter));
+    pango_attr_iterator_destroy(pIter);
+    return bFound;
+}
+
+}
@@ -0,0 +1,145 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _GlyphCache_H_
+#define _GlyphCache_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../graphics/TextureAtlas.h"
+
+#include <pango/pango.h>
+#include <boost/shared_ptr.hpp>
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace avg {
+
+// A single rendered glyph in the glyph atlas. Glyphs without ink (e.g. spaces) don't
+// have a region.
+struct CachedGlyph
+{
+    TextureAtlasRegionPtr m_pRegion;
+    // Position of the top left corner of the region relative to the glyph origin.
+    IntPoint m_Offset;
+};
+
+typedef boost::shared_ptr<CachedGlyph> CachedGlyphPtr;
+
+struct PositionedGlyph
+{
+    CachedGlyphPtr m_pGlyph;
+    // Position of the top left corner of the glyph region in layout coordinates.
+    IntPoint m_Pos;
+};
+
+// The result of laying out a text in a specific style. Shared by all words nodes 
+// that display the same text in the same style.
+class AVG_API TextLayout
+{
+public:
+    // Takes over the reference to pLayout.
+    TextLayout(PangoLayout* pLayout);
+    virtual ~TextLayout();
+
+    PangoLayout* getLayout() const;
+    // Pixel extents as returned by pango_layout_get_pixel_extents.
+    const PangoRectangle& getInkRect() const;
+    const PangoRectangle& getLogicalRect() const;
+
+    // Glyph positions, calculated on first use by the GlyphCache.
+    bool hasGlyphs() const;
+    // False if the layout can't be assembled from cached glyphs. In this case, it needs
+    // to be rendered into a bitmap.
+    bool canUseGlyphs() const;
+    const std::vector<PositionedGlyph>& getGlyphs() const;
+    // The atlas texture that contains all glyphs.
+    const MCTexturePtr& getGlyphTex() const;
+
+private:
+    friend class GlyphCache;
+
+    PangoLayout* m_pLayout;
+    PangoRectangle m_InkRect;
+    PangoRectangle m_LogicalRect;
+
+    bool m_bHasGlyphs;
+    bool m_bCanUseGlyphs;
+    std::vector<PositionedGlyph> m_Glyphs;
+    MCTexturePtr m_pGlyphTex;
+};
+
+typedef boost::shared_ptr<TextLayout> TextLayoutPtr;
+
+// Caches rendered glyphs in an A8 texture atlas, keyed by pango font (which includes 
+// description and size) and glyph index, so changed texts can be displayed without
+// rasterizing and uploading a bitmap of the complete text. Also caches recently 
+// used layouts by text and style. There is one GlyphCache per TextEngine, so hinted
+// and unhinted glyphs are cached separately.
+class AVG_API GlyphCache
+{
+public:
+    GlyphCache();
+    virtual ~GlyphCache();
+
+    // Returns an empty pointer if the layout isn't in the cache.
+    TextLayoutPtr getLayout(const std::string& sKey);
+    void addLayout(const std::string& sKey, TextLayoutPtr pLayout);
+
+    // Calculates the glyph positions of the layout, rendering glyphs that aren't in
+    // the cache yet.
+    void calcGlyphs(TextLayoutPtr pLayout);
+
+    // Drops all glyphs and layouts. Glyphs that are still in use by nodes stay valid.
+    void clear();
+
+    int getNumGlyphs() const;
+    int getNumLayouts() const;
+
+    static const unsigned MAX_GLYPHS;
+    static const unsigned MAX_LAYOUTS;
+
+private:
+    CachedGlyphPtr getGlyph(PangoFont* pFont, PangoGlyph glyph);
+    CachedGlyphPtr renderGlyph(PangoFont* pFont, PangoGlyph glyph);
+    bool hasDecorations(PangoLayout* pLayout) const;
+
+    TextureAtlas m_Atlas;
+
+    typedef std::map<std::pair<PangoFont*, PangoGlyph>, CachedGlyphPtr> GlyphMap;
+    GlyphMap m_Glyphs;
+    // Fonts used as keys in m_Glyphs. We hold a reference so they stay valid.
+    std::set<PangoFont*> m_pFonts;
+
+    typedef std::list<std::pair<std::string, TextLayoutPtr> > LayoutList;
+    LayoutList m_Layouts;
+    std::map<std::string, LayoutList::iterator> m_LayoutMap;
+};
+
+}
+
+#endif
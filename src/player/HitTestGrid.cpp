@@ -0,0 +1,219 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "HitTestGrid.h"
+
+#include "Node.h"
+
+#include "../base/Exception.h"
+
+#include <algorithm>
+#include <functional>
+#include <math.h>
+
+using namespace std;
+
+namespace avg {
+
+// Maximum number of cells along one axis.
+static const int MAX_CELLS = 64;
+// Bounds are enlarged a bit so rounding differences between toGlobal() and
+// toLocal() never cause a miss.
+static const float BOUNDS_TOLERANCE = 1.f;
+
+HitTestGrid::HitTestGrid()
+    : m_bDirty(true),
+      m_NumCells(0,0),
+      m_NumRebuilds(0)
+{
+}
+
+HitTestGrid::~HitTestGrid()
+{
+}
+
+void HitTestGrid::invalidate()
+{
+    m_bDirty = true;
+}
+
+void HitTestGrid::updateChild(const Node* pChild)
+{
+    if (m_bDirty) {
+        return;
+    }
+    map<const Node*, unsigned>::iterator it = m_ChildIndexes.find(pChild);
+    if (it == m_ChildIndexes.end()) {
+        // Child was added after the last rebuild.
+        m_bDirty = true;
+        return;
+    }
+    unsigned i = it->second;
+    ChildEntry& entry = m_Entries[i];
+    if (entry.m_bInGrid) {
+        removeFromCells(i);
+    } else if (!entry.m_bBounded) {
+        m_Unbounded.erase(find(m_Unbounded.begin(), m_Unbounded.end(), i));
+    }
+    calcBounds(entry);
+    if (!entry.m_bBounded) {
+        m_Unbounded.push_back(i);
+    } else if (entry.m_Bounds.tl.x >= m_Extent.tl.x &&
+            entry.m_Bounds.tl.y >= m_Extent.tl.y &&
+            entry.m_Bounds.br.x <= m_Extent.br.x &&
+            entry.m_Bounds.br.y <= m_Extent.br.y)
+    {
+        addToCells(i);
+    } else {
+        // Moved out of the area covered by the grid.
+        m_bDirty = true;
+    }
+}
+
+void HitTestGrid::getCandidates(const vector<NodePtr>& children, const glm::vec2& pos,
+        vector<unsigned>& candidates)
+{
+    if (m_bDirty || m_Entries.size() != children.size()) {
+        rebuild(children);
+    }
+    candidates.clear();
+    if (m_NumCells.x > 0 && pos.x >= m_Extent.tl.x && pos.y >= m_Extent.tl.y &&
+            pos.x <= m_Extent.br.x && pos.y <= m_Extent.br.y)
+    {
+        IntPoint cell = posToCell(pos);
+        const vector<unsigned>& cellEntries = getCell(cell.x, cell.y);
+        for (unsigned i = 0; i < cellEntries.size(); ++i) {
+            const FRect& bounds = m_Entries[cellEntries[i]].m_Bounds;
+            if (pos.x >= bounds.tl.x && pos.y >= bounds.tl.y &&
+                    pos.x <= bounds.br.x && pos.y <= bounds.br.y)
+            {
+                candidates.push_back(cellEntries[i]);
+            }
+        }
+    }
+    candidates.insert(candidates.end(), m_Unbounded.begin(), m_Unbounded.end());
+    sort(candidates.begin(), candidates.end(), greater<unsigned>());
+}
+
+int HitTestGrid::getNumRebuilds() const
+{
+    return m_NumRebuilds;
+}
+
+void HitTestGrid::rebuild(const vector<NodePtr>& children)
+{
+    m_NumRebuilds++;
+    m_Entries.resize(children.size());
+    m_ChildIndexes.clear();
+    m_Unbounded.clear();
+    m_Cells.clear();
+
+    int numBounded = 0;
+    for (unsigned i = 0; i < children.size(); ++i) {
+        ChildEntry& entry = m_Entries[i];
+        entry.m_pNode = children[i].get();
+        entry.m_bInGrid = false;
+        calcBounds(entry);
+        m_ChildIndexes[entry.m_pNode] = i;
+        if (entry.m_bBounded) {
+            if (numBounded == 0) {
+                m_Extent = entry.m_Bounds;
+            } else {
+                m_Extent.expand(entry.m_Bounds);
+            }
+            numBounded++;
+        } else {
+            m_Unbounded.push_back(i);
+        }
+    }
+
+    if (numBounded == 0) {
+        m_NumCells = IntPoint(0,0);
+    } else {
+        // Leave some room so children that move a little don't force a rebuild.
+        glm::vec2 margin = m_Extent.size()*0.1f + glm::vec2(1,1);
+        m_Extent.tl -= margin;
+        m_Extent.br += margin;
+        int cellsPerAxis = int(ceil(sqrt(float(numBounded))));
+        cellsPerAxis = max(1, min(cellsPerAxis, MAX_CELLS));
+        m_NumCells = IntPoint(cellsPerAxis, cellsPerAxis);
+        m_CellSize = m_Extent.size()/glm::vec2(m_NumCells);
+        m_Cells.resize(m_NumCells.x*m_NumCells.y);
+        for (unsigned i = 0; i < m_Entries.size(); ++i) {
+            if (m_Entries[i].m_bBounded) {
+                addToCells(i);
+            }
+        }
+    }
+    m_bDirty = false;
+}
+
+void HitTestGrid::calcBounds(ChildEntry& entry) const
+{
+    entry.m_bBounded = entry.m_pNode->getHitBounds(entry.m_Bounds);
+    if (entry.m_bBounded) {
+        entry.m_Bounds.tl -= glm::vec2(BOUNDS_TOLERANCE, BOUNDS_TOLERANCE);
+        entry.m_Bounds.br += glm::vec2(BOUNDS_TOLERANCE, BOUNDS_TOLERANCE);
+    }
+}
+
+IntPoint HitTestGrid::posToCell(const glm::vec2& pos) const
+{
+    glm::vec2 relPos = (pos-m_Extent.tl)/m_CellSize;
+    IntPoint cell(int(floor(relPos.x)), int(floor(relPos.y)));
+    cell.x = max(0, min(cell.x, m_NumCells.x-1));
+    cell.y = max(0, min(cell.y, m_NumCells.y-1));
+    return cell;
+}
+
+void HitTestGrid::addToCells(unsigned childIndex)
+{
+    ChildEntry& entry = m_Entries[childIndex];
+    entry.m_Cells = IntRect(posToCell(entry.m_Bounds.tl), posToCell(entry.m_Bounds.br));
+    for (int y = entry.m_Cells.tl.y; y <= entry.m_Cells.br.y; ++y) {
+        for (int x = entry.m_Cells.tl.x; x <= entry.m_Cells.br.x; ++x) {
+            getCell(x, y).push_back(childIndex);
+        }
+    }
+    entry.m_bInGrid = true;
+}
+
+void HitTestGrid::removeFromCells(unsigned childIndex)
+{
+    ChildEntry& entry = m_Entries[childIndex];
+    AVG_ASSERT(entry.m_bInGrid);
+    for (int y = entry.m_Cells.tl.y; y <= entry.m_Cells.br.y; ++y) {
+        for (int x = entry.m_Cells.tl.x; x <= entry.m_Cells.br.x; ++x) {
+            vector<unsigned>& cell = getCell(x, y);
+            vector<unsigned>::iterator it = find(cell.begin(), cell.end(), childIndex);
+            AVG_ASSERT(it != cell.end());
+            cell.erase(it);
+        }
+    }
+    entry.m_bInGrid = false;
+}
+
+vector<unsigned>& HitTestGrid::getCell(int x, int y)
+{
+    return m_Cells[y*m_NumCells.x+x];
+}
+
+}
@@ -0,0 +1,96 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _HitTestGrid_H_
+#define _HitTestGrid_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <vector>
+
+namespace avg {
+
+class Node;
+typedef boost::shared_ptr<Node> NodePtr;
+
+// Uniform grid over the bounding boxes of the children of a DivNode, in the
+// coordinate system of the DivNode. Used to avoid testing every child in
+// DivNode::getElementsByPos(). Children that can't report bounds (e.g. vector nodes
+// or divs without a size) are always returned as candidates.
+//
+// The grid is rebuilt lazily after the child list changes. Geometry changes of
+// single children are applied incrementally as long as the child stays inside the
+// area covered by the grid.
+class AVG_API HitTestGrid
+{
+public:
+    HitTestGrid();
+    virtual ~HitTestGrid();
+
+    void invalidate();
+    void updateChild(const Node* pChild);
+
+    // Returns the indexes of the children that might contain pos, topmost first.
+    void getCandidates(const std::vector<NodePtr>& children, const glm::vec2& pos,
+            std::vector<unsigned>& candidates);
+
+    int getNumRebuilds() const;
+
+private:
+    struct ChildEntry {
+        const Node* m_pNode;
+        bool m_bBounded;
+        bool m_bInGrid;
+        FRect m_Bounds;
+        IntRect m_Cells;
+    };
+
+    void rebuild(const std::vector<NodePtr>& children);
+    void calcBounds(ChildEntry& entry) const;
+    IntPoint posToCell(const glm::vec2& pos) const;
+    void addToCells(unsigned childIndex);
+    void removeFromCells(unsigned childIndex);
+    std::vector<unsigned>& getCell(int x, int y);
+
+    bool m_bDirty;
+    std::vector<ChildEntry> m_Entries;
+    std::map<const Node*, unsigned> m_ChildIndexes;
+    std::vector<unsigned> m_Unbounded;
+
+    FRect m_Extent;
+    IntPoint m_NumCells;
+    glm::vec2 m_CellSize;
+    std::vector<std::vector<unsigned> > m_Cells;
+
+    int m_NumRebuilds;
+};
+
+typedef boost::shared_ptr<HitTestGrid> HitTestGridPtr;
+
+}
+
+#endif
@@ -28,16 +28,22 @@
 #include "OffscreenCanvasNode.h"
 #include "OffscreenCanvas.h"
 #include "GPUImage.h"
+#include "BitmapManager.h"
 
 #include "../base/Logger.h"
 #include "../base/ScopeTimer.h"
 #include "../base/XMLHelper.h"
 #include "../base/Exception.h"
 #include "../base/ObjectCounter.h"
+#include "../base/OSHelper.h"
 
 #include "../graphics/Filterfliprgb.h"
 #include "../graphics/MCTexture.h"
 #include "../graphics/Bitmap.h"
+#include "../graphics/ImageCache.h"
+#include "../graphics/CachedImage.h"
+
+#include <boost/bind.hpp>
 
 #include <iostream>
 #include <sstream>
@@ -52,16 +58,23 @@ void ImageNode::registerType()
     TypeDefinition def = TypeDefinition("image", "rasternode", 
             ExportedObject::buildObject<ImageNode>)
         .addArg(Arg<UTF8String>("href", "", false, offsetof(ImageNode, m_href)))
-        .addArg(Arg<string>("compression", "none"));
+        .addArg(Arg<string>("compression", "none"))
+        .addArg(Arg<glm::vec2>("decodesize", glm::vec2(0,0), false,
+                offsetof(ImageNode, m_DecodeSize)))
+        .addArg(Arg<bool>("async", false, false, offsetof(ImageNode, m_bAsync)))
+        .addArg(Arg<UTF8String>("placeholder", "", false,
+                offsetof(ImageNode, m_Placeholder)));
     TypeRegistry::get()->registerType(def);
 }
 
 ImageNode::ImageNode(const ArgList& args, const string& sPublisherName)
     : RasterNode(sPublisherName),
-      m_Compression(TEXCOMPRESSION_NONE)
+      m_Compression(TEXCOMPRESSION_NONE),
+      m_LoadHandle(0)
 {
     args.setMembers(this);
-    m_pGPUImage = GPUImagePtr(new GPUImage(getSurface(), getMipmap()));
+    m_pGPUImage = GPUImagePtr(new GPUImage(getSurface(), getMipmap(),
+            UPLOADPRIORITY_BACKGROUND));
     m_Compression = string2TexCompression(args.getArgVal<string>("compression"));
     setHRef(m_href);
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -73,6 +86,7 @@ ImageNode::~ImageNode()
     // However, if connect() has been called but rendering never started, 
     // disconnect isn't called either.
 //    AVG_ASSERT(!m_pImage->getCanvas());
+    cancelAsyncLoad();
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
@@ -101,8 +115,10 @@ void ImageNode::disconnect(bool bKill)
         pCanvas->removeDependentCanvas(getCanvas());
     }
     if (bKill) {
+        cancelAsyncLoad();
         RasterNode::disconnect(bKill);
-        m_pGPUImage = GPUImagePtr(new GPUImage(getSurface(), getMipmap()));
+        m_pGPUImage = GPUImagePtr(new GPUImage(getSurface(), getMipmap(),
+                UPLOADPRIORITY_BACKGROUND));
         m_href = "";
     } else {
         m_pGPUImage->moveToCPU();
@@ -124,6 +140,7 @@ void ImageNode::setHRef(const UTF8String& href)
     }
     try {
         if (href == "") {
+            cancelAsyncLoad();
             m_pGPUImage->setEmpty();
         } else {
             checkReload();
@@ -140,8 +157,37 @@ const string ImageNode::getCompression() const
     return texCompression2String(m_Compression);
 }
 
+const glm::vec2& ImageNode::getDecodeSize() const
+{
+    return m_DecodeSize;
+}
+
+void ImageNode::setDecodeSize(const glm::vec2& size)
+{
+    m_DecodeSize = size;
+    if (m_href != "" && !isCanvasURL(m_href)) {
+        checkReload();
+    }
+}
+
+bool ImageNode::getAsync() const
+{
+    return m_bAsync;
+}
+
+const UTF8String& ImageNode::getPlaceholder() const
+{
+    return m_Placeholder;
+}
+
+void ImageNode::setPlaceholder(const UTF8String& placeholder)
+{
+    m_Placeholder = placeholder;
+}
+
 void ImageNode::setBitmap(BitmapPtr pBmp)
 {
+    cancelAsyncLoad();
     if (m_pGPUImage->getSource() == GPUImage::SCENE && getState() == Node::NS_CANRENDER) {
         m_pGPUImage->getCanvas()->removeDependentCanvas(getCanvas());
     }
@@ -161,6 +207,9 @@ void ImageNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
     ScopeTimer timer(PrerenderProfilingZone);
     AreaNode::preRender(pVA, bIsParentActive, parentEffectiveOpacity);
     if (isVisible() && m_pGPUImage->getSource() != GPUImage::NONE) {
+        // Textures of visible images are uploaded before the others if the upload
+        // budget doesn't allow uploading everything at once.
+        m_pGPUImage->raiseTexUploadPriority(UPLOADPRIORITY_VISIBLE);
         if (m_pGPUImage->getCanvas()) {
             // Force FX render every frame for canvas nodes.
             getSurface()->setDirty();
@@ -175,11 +224,22 @@ static ProfilingZoneID RenderProfilingZone("ImageNode::render");
 void ImageNode::render(GLContext* pContext, const glm::mat4& transform)
 {
     ScopeTimer Timer(RenderProfilingZone);
-    if (m_pGPUImage->getSource() != GPUImage::NONE) {
+    if (m_pGPUImage->getSource() != GPUImage::NONE && !m_pGPUImage->isTexUploadPending())
+    {
         blt32(pContext, transform);
     }
 }
 
+bool ImageNode::getBatchDestRect(FRect& destRect)
+{
+    if (m_pGPUImage->getSource() == GPUImage::NONE || m_pGPUImage->isTexUploadPending())
+    {
+        return false;
+    }
+    destRect = FRect(glm::vec2(0,0), getSize());
+    return true;
+}
+
 IntPoint ImageNode::getMediaSize()
 {
     return m_pGPUImage->getSize();
@@ -190,6 +250,11 @@ GPUImage::Source ImageNode::getSource() const
     return m_pGPUImage->getSource();
 }
 
+bool ImageNode::isLoading() const
+{
+    return m_LoadHandle != 0;
+}
+
 string ImageNode::dump(int indent)
 {
     string dumpStr = AreaNode::dump(indent);
@@ -207,6 +272,7 @@ void ImageNode::checkReload()
             throw Exception(AVG_ERR_UNSUPPORTED, 
                     "Texture compression can't be used with canvas hrefs.");
         }
+        cancelAsyncLoad();
         OffscreenCanvasPtr pCanvas = Player::get()->getCanvasFromURL(m_href);
         checkCanvasValid(pCanvas);
         m_pGPUImage->setCanvas(pCanvas);
@@ -215,7 +281,14 @@ void ImageNode::checkReload()
         }
         newSurface();
     } else {
-        bool bNewImage = Node::checkReload(m_href, m_pGPUImage, m_Compression);
+        bool bNewImage;
+        if (m_bAsync && needsAsyncLoad()) {
+            bNewImage = startAsyncLoad();
+        } else {
+            cancelAsyncLoad();
+            bNewImage = Node::checkReload(m_href, m_pGPUImage, m_Compression,
+                    IntPoint(m_DecodeSize));
+        }
         if (bNewImage) {
             newSurface();
         }
@@ -224,6 +297,31 @@ void ImageNode::checkReload()
     RasterNode::checkReload();
 }
 
+void ImageNode::onBitmapLoaded(BitmapPtr pBmp)
+{
+    m_LoadHandle = 0;
+    // Adding the bitmap to the cache makes the following checkReload() a cache hit.
+    // The texture is uploaded when the node is rendered next.
+    CachedImagePtr pImage = ImageCache::get()->addImage(m_sLoadFilename, m_Compression,
+            m_LoadDecodeSize, IntRect(0,0,0,0), pBmp);
+    Node::checkReload(m_href, m_pGPUImage, m_Compression, m_LoadDecodeSize);
+    pImage->decBmpRef();
+    m_sLoadFilename = "";
+    newSurface();
+    setViewport(-32767, -32767, -32767, -32767);
+    notifySubscribers("LOADED");
+}
+
+void ImageNode::onBitmapLoadError(const Exception* e)
+{
+    m_LoadHandle = 0;
+    m_sLoadFilename = "";
+    m_pGPUImage->setEmpty();
+    newSurface();
+    setViewport(-32767, -32767, -32767, -32767);
+    logFileNotFoundWarning(e->getStr());
+}
+
 void ImageNode::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
 {
     if (reactsToMouseEvents()) {
@@ -260,6 +358,59 @@ bool ImageNode::isCanvasURL(const std::string& sURL)
     return sURL.find("canvas:") == 0;
 }
 
+bool ImageNode::needsAsyncLoad()
+{
+    if (m_href == "") {
+        return false;
+    }
+    string sFilename = m_href;
+    initFilename(sFilename);
+    IntPoint decodeSize(m_DecodeSize);
+    if (sFilename == m_pGPUImage->getFilename() &&
+            decodeSize == m_pGPUImage->getDecodeSize())
+    {
+        return false;
+    }
+    sFilename = convertUTF8ToFilename(sFilename);
+    return !ImageCache::get()->hasImage(sFilename, m_Compression, decodeSize);
+}
+
+bool ImageNode::startAsyncLoad()
+{
+    string sFilename = m_href;
+    initFilename(sFilename);
+    sFilename = convertUTF8ToFilename(sFilename);
+    IntPoint decodeSize(m_DecodeSize);
+    IntRect srcRect(0,0,0,0);
+    if (m_LoadHandle && sFilename == m_sLoadFilename && decodeSize == m_LoadDecodeSize) {
+        return false;
+    }
+    cancelAsyncLoad();
+    Node::checkReload(m_Placeholder, m_pGPUImage, m_Compression, IntPoint(0,0));
+
+    // Nodes that request the same image variant share one job in the BitmapManager.
+    string sJobKey = "image:" +
+            CachedImage::getKey(sFilename, m_Compression, decodeSize, srcRect);
+    m_LoadHandle = BitmapManager::get()->loadBitmap(sFilename, sJobKey,
+            boost::bind(&CachedImage::decodeBmp, sFilename, m_Compression, decodeSize,
+                    srcRect, ImageCache::get()->getDiskCache()),
+            this);
+    m_sLoadFilename = sFilename;
+    m_LoadDecodeSize = decodeSize;
+    return true;
+}
+
+void ImageNode::cancelAsyncLoad()
+{
+    if (m_LoadHandle) {
+        if (BitmapManager::exists()) {
+            BitmapManager::get()->cancelRequest(m_LoadHandle);
+        }
+        m_LoadHandle = 0;
+        m_sLoadFilename = "";
+    }
+}
+
 void ImageNode::checkCanvasValid(const CanvasPtr& pCanvas)
 {
     if (pCanvas == getCanvas()) {
@@ -25,6 +25,7 @@
 #include "../api.h"
 #include "RasterNode.h"
 #include "GPUImage.h"
+#include "IBitmapLoadedListener.h"
 #include "../graphics/TexInfo.h"
 
 #include "../base/UTF8String.h"
@@ -36,7 +37,7 @@ namespace avg {
 class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 
-class AVG_API ImageNode : public RasterNode
+class AVG_API ImageNode : public RasterNode, public IBitmapLoadedListener
 {
     public:
         static void registerType();
@@ -51,6 +52,11 @@ class AVG_API ImageNode : public RasterNode
         const UTF8String& getHRef() const;
         void setHRef(const UTF8String& href);
         const std::string getCompression() const;
+        const glm::vec2& getDecodeSize() const;
+        void setDecodeSize(const glm::vec2& size);
+        bool getAsync() const;
+        const UTF8String& getPlaceholder() const;
+        void setPlaceholder(const UTF8String& placeholder);
         void setBitmap(BitmapPtr pBmp);
         
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
@@ -63,16 +69,34 @@ class AVG_API ImageNode : public RasterNode
         virtual BitmapPtr getBitmap();
         virtual IntPoint getMediaSize();
         GPUImage::Source getSource() const;
+        bool isLoading() const;
 
         virtual std::string dump(int indent = 0);
 
+        virtual void onBitmapLoaded(BitmapPtr pBmp);
+        virtual void onBitmapLoadError(const Exception* e);
+
+    protected:
+        virtual bool getBatchDestRect(FRect& destRect);
+
     private:
         bool isCanvasURL(const std::string& sURL);
         void checkCanvasValid(const CanvasPtr& pCanvas);
+        bool needsAsyncLoad();
+        bool startAsyncLoad();
+        void cancelAsyncLoad();
 
         UTF8String m_href;
+        glm::vec2 m_DecodeSize;
         TexCompression m_Compression;
+        bool m_bAsync;
+        UTF8String m_Placeholder;
         GPUImagePtr m_pGPUImage;
+
+        // Pending BitmapManager request if an asynchronous load is in progress.
+        int m_LoadHandle;
+        std::string m_sLoadFilename;
+        IntPoint m_LoadDecodeSize;
 };
 
 typedef boost::shared_ptr<ImageNode> ImageNodePtr;
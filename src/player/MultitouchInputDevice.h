@@ -26,12 +26,11 @@
 #include "InputDevice.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/ThreadHelper.h"
 
 #include <boost/thread.hpp>
 #include <map>
 
-typedef boost::shared_ptr<boost::mutex> MutexPtr;
-
 namespace avg {
 
 class TouchStatus;
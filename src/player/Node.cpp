@@ -70,6 +70,7 @@ void Node::registerType()
     pPubDef->addMessage("PEN_OVER");
     pPubDef->addMessage("PEN_OUT");
     pPubDef->addMessage("END_OF_FILE");
+    pPubDef->addMessage("LOADED");
     pPubDef->addMessage("SIZE_CHANGED");
     pPubDef->addMessage("KILLED");
 
@@ -368,6 +369,20 @@ void Node::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
 {
 }
 
+void Node::getElementsByPositions(const vector<glm::vec2>& positions,
+        vector<NodeChainPtr>& pElementsList)
+{
+    AVG_ASSERT(positions.size() == pElementsList.size());
+    for (unsigned i = 0; i < positions.size(); ++i) {
+        getElementsByPos(positions[i], pElementsList[i]);
+    }
+}
+
+bool Node::getHitBounds(FRect& bounds) const
+{
+    return false;
+}
+
 void Node::preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
         float parentEffectiveOpacity)
 {
@@ -448,6 +463,11 @@ void Node::setState(Node::NodeState state)
 }
         
 void Node::initFilename(string& sFilename)
+{
+    resolveFilename(sFilename, getParent());
+}
+
+void Node::resolveFilename(string& sFilename, const DivNodePtr& pParent)
 {
     if (sFilename != "") {
         bool bAbsDir = sFilename[0] == '/';
@@ -457,7 +477,6 @@ void Node::initFilename(string& sFilename)
         }
 #endif
         if (!bAbsDir) {
-            DivNodePtr pParent = getParent();
             if (!pParent) {
                 sFilename = Player::get()->getRootMediaDir()+sFilename;
             } else {
@@ -468,18 +487,18 @@ void Node::initFilename(string& sFilename)
 }
 
 bool Node::checkReload(const std::string& sHRef, const GPUImagePtr& pGPUImage,
-        TexCompression comp)
+        TexCompression comp, const IntPoint& decodeSize)
 {
     string sLastFilename = pGPUImage->getFilename();
     string sFilename = sHRef;
     initFilename(sFilename);
-    if (sLastFilename != sFilename) {
+    if (sLastFilename != sFilename || pGPUImage->getDecodeSize() != decodeSize) {
         try {
             sFilename = convertUTF8ToFilename(sFilename);
             if (sHRef == "") {
                 pGPUImage->setEmpty();
             } else {
-                pGPUImage->setFilename(sFilename, comp);
+                pGPUImage->setFilename(sFilename, comp, decodeSize);
             }
         } catch (Exception& ex) {
             pGPUImage->setEmpty();
@@ -506,6 +525,13 @@ NodePtr Node::getSharedThis()
     return dynamic_pointer_cast<Node>(ExportedObject::getSharedThis());
 }
 
+void Node::notifyHitBoundsChanged()
+{
+    if (m_pParent) {
+        m_pParent->childHitBoundsChanged(this);
+    }
+}
+
 void Node::logFileNotFoundWarning(const string& sWarn) const
 {
     unsigned int sev;
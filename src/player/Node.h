@@ -31,6 +31,7 @@
 #include "../graphics/TexInfo.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
@@ -82,6 +83,9 @@ class AVG_API Node: public Publisher
         void checkSetParentError(DivNode* pParent);
         DivNodePtr getParent() const;
         NodeChainPtr getParentChain();
+        // Makes a relative filename absolute the way a child of pParent does. Uses the
+        // root media dir if pParent is empty.
+        static void resolveFilename(std::string& sFilename, const DivNodePtr& pParent);
 
         virtual void connectDisplay();
         virtual void connect(CanvasPtr pCanvas);
@@ -116,6 +120,13 @@ class AVG_API Node: public Publisher
         virtual glm::vec2 toGlobal(const glm::vec2& pos) const;
         NodePtr getElementByPos(const glm::vec2& pos);
         virtual void getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements);
+        // Resolves several positions in one traversal. pElementsList[i] receives the
+        // nodes under positions[i].
+        virtual void getElementsByPositions(const std::vector<glm::vec2>& positions,
+                std::vector<NodeChainPtr>& pElementsList);
+        // Conservative bounding box of the area that getElementsByPos() can hit, in
+        // parent coordinates. Returns false if the node can't give a bound.
+        virtual bool getHitBounds(FRect& bounds) const;
 
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
@@ -142,10 +153,12 @@ class AVG_API Node: public Publisher
         void setState(NodeState state);
         void initFilename(std::string& sFilename);
         bool checkReload(const std::string& sHRef, const GPUImagePtr& pGPUImage,
-                TexCompression comp=TEXCOMPRESSION_NONE);
+                TexCompression comp=TEXCOMPRESSION_NONE,
+                const IntPoint& decodeSize=IntPoint(0,0));
         virtual bool isVisible() const;
         bool getEffectiveActive() const;
         NodePtr getSharedThis();
+        void notifyHitBoundsChanged();
 
         void logFileNotFoundWarning(const std::string& sWarn) const;
 
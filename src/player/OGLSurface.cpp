@@ -51,6 +51,7 @@ OGLSurface::OGLSurface(const WrapMode& wrapMode)
     : m_Size(-1,-1),
       m_WrapMode(wrapMode),
       m_Gamma(1,1,1,1),
+      m_bColorIsModified(false),
       m_Brightness(1,1,1),
       m_Contrast(1,1,1),
       m_bIsDirty(true)
@@ -68,6 +69,7 @@ void OGLSurface::create(PixelFormat pf, MCTexturePtr pTex0, MCTexturePtr pTex1,
 {
     m_pf = pf;
     m_Size = pTex0->getSize();
+    m_TexRect = IntRect();
     m_pMCTextures[0] = pTex0;
     m_pMCTextures[1] = pTex1;
     m_pMCTextures[2] = pTex2;
@@ -88,6 +90,14 @@ void OGLSurface::create(PixelFormat pf, MCTexturePtr pTex0, MCTexturePtr pTex1,
     }
 }
 
+void OGLSurface::setTexRect(const IntRect& rect)
+{
+    AVG_ASSERT(!pixelFormatIsPlanar(m_pf));
+    m_TexRect = rect;
+    m_Size = rect.size();
+    m_bIsDirty = true;
+}
+
 void OGLSurface::setMask(MCTexturePtr pTex)
 {
     m_pMaskMCTexture = pTex;
@@ -144,18 +154,13 @@ void OGLSurface::activate(GLContext* pContext, const IntPoint& logicalSize) cons
         m_pMaskMCTexture->getTex(pContext)->activate(m_WrapMode, GL_TEXTURE4);
         // The shader maskpos param takes the position in texture coordinates (0..1) of 
         // the main texture.
-        glm::vec2 maskPos = m_MaskPos;
-        glm::vec2 maskSize = m_MaskSize;
-
-        // Special case for pot textures: 
-        //   The tex coords in the vertex array are scaled to fit the image texture. We 
-        //   need to a) undo this and b) adjust for pot mask textures. In the npot case,
-        //   everything evaluates to (1,1);
-        glm::vec2 texSize = m_pMCTextures[0]->getGLSize();
-        glm::vec2 imgSize = m_pMCTextures[0]->getSize();
-        glm::vec2 imgScale = glm::vec2(texSize.x/imgSize.x, texSize.y/imgSize.y);
-        maskPos = maskPos/imgScale;
-        maskSize = maskSize/imgScale;
+        // Special case for pot textures and atlas regions: 
+        //   The tex coords in the vertex array only cover a part of the image texture.
+        //   We need to a) map the mask to this part and b) adjust for pot mask 
+        //   textures. In the npot case, everything evaluates to (1,1);
+        FRect texRect = getTexCoordRect();
+        glm::vec2 maskPos = texRect.tl + m_MaskPos*texRect.size();
+        glm::vec2 maskSize = m_MaskSize*texRect.size();
 
         glm::vec2 maskTexSize = m_pMaskMCTexture->getGLSize();
         glm::vec2 maskImgSize = m_pMaskMCTexture->getSize();
@@ -194,6 +199,21 @@ IntPoint OGLSurface::getTextureSize()
     return m_pMCTextures[0]->getGLSize();
 }
 
+bool OGLSurface::hasTexRect() const
+{
+    return m_TexRect.size() != IntPoint(0,0);
+}
+
+FRect OGLSurface::getTexCoordRect() const
+{
+    glm::vec2 texSize = glm::vec2(m_pMCTextures[0]->getGLSize());
+    if (hasTexRect()) {
+        return FRect(glm::vec2(m_TexRect.tl)/texSize, glm::vec2(m_TexRect.br)/texSize);
+    } else {
+        return FRect(glm::vec2(0,0), glm::vec2(m_Size)/texSize);
+    }
+}
+
 bool OGLSurface::isCreated() const
 {
     return (m_pMCTextures[0] != MCTexturePtr());
@@ -247,6 +267,27 @@ void OGLSurface::resetDirty()
     }
 }
 
+bool OGLSurface::isBatchCompatible(const OGLSurface& other) const
+{
+    for (unsigned i=0; i<4; ++i) {
+        if (m_pMCTextures[i] != other.m_pMCTextures[i]) {
+            return false;
+        }
+    }
+    // Mask coordinates depend on the texture rect, so they can't be shared.
+    if (m_pMaskMCTexture || other.m_pMaskMCTexture) {
+        return false;
+    }
+    return m_pf == other.m_pf &&
+            m_bPremultipliedAlpha == other.m_bPremultipliedAlpha &&
+            m_WrapMode.getS() == other.m_WrapMode.getS() &&
+            m_WrapMode.getT() == other.m_WrapMode.getT() &&
+            m_Gamma == other.m_Gamma &&
+            m_bColorIsModified == other.m_bColorIsModified &&
+            (!m_bColorIsModified || (m_Brightness == other.m_Brightness &&
+                    m_Contrast == other.m_Contrast));
+}
+
 glm::mat4 OGLSurface::calcColorspaceMatrix() const
 {
     glm::mat4 mat;
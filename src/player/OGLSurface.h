@@ -25,6 +25,7 @@
 #include "../api.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 #include "../graphics/PixelFormat.h"
 #include "../graphics/WrapMode.h"
 
@@ -44,6 +45,8 @@ public:
     virtual void create(PixelFormat pf, MCTexturePtr pTex0, 
             MCTexturePtr pTex1 = MCTexturePtr(), MCTexturePtr pTex2 = MCTexturePtr(), 
             MCTexturePtr pTex3 = MCTexturePtr(), bool bPremultipliedAlpha = false);
+    // Restricts the surface to a part of the first texture, e.g. an atlas region.
+    void setTexRect(const IntRect& rect);
     void setMask(MCTexturePtr pTex);
     virtual void destroy();
     void activate(GLContext* pContext, const IntPoint& logicalSize = IntPoint(1,1)) const;
@@ -53,6 +56,9 @@ public:
     PixelFormat getPixelFormat();
     IntPoint getSize();
     IntPoint getTextureSize();
+    bool hasTexRect() const;
+    // The area of the first texture that contains the image, in texture coordinates.
+    FRect getTexCoordRect() const;
     bool isCreated() const;
     bool isPremultipliedAlpha() const;
 
@@ -64,11 +70,15 @@ public:
     void setDirty();
     void resetDirty();
 
+    // True if both surfaces can be rendered with the same GL state.
+    bool isBatchCompatible(const OGLSurface& other) const;
+
 private:
     glm::mat4 calcColorspaceMatrix() const;
 
     MCTexturePtr m_pMCTextures[4];
     IntPoint m_Size;
+    IntRect m_TexRect;
     PixelFormat m_pf;
     MCTexturePtr m_pMaskMCTexture;
     glm::vec2 m_MaskPos;
@@ -72,12 +72,14 @@
 #include "../base/ScopeTimer.h"
 #include "../base/WorkerThread.h"
 #include "../base/DAG.h"
+#include "../base/ThreadPool.h"
 
 #include "../graphics/BitmapLoader.h"
 #include "../graphics/ShaderRegistry.h"
 #include "../graphics/Display.h"
 #include "../graphics/GLContextManager.h"
 #include "../graphics/ImageCache.h"
+#include "../graphics/TextureAtlas.h"
 
 #include "../imaging/Camera.h"
 
@@ -114,7 +116,7 @@ Player::Player()
       m_bIsTraversingTree(false),
       m_pMultitouchInputDevice(),
       m_bInHandleTimers(false),
-      m_bCurrentTimeoutDeleted(false),
+      m_NextSchedulingOrder(0),
       m_bKeepWindowOpen(false),
       m_bStopOnEscape(true),
       m_bIsPlaying(false),
@@ -126,7 +128,9 @@ Player::Player()
       m_pLastMouseEvent(new MouseEvent(Event::CURSOR_MOTION, false, false, false,
             IntPoint(-1, -1), MouseEvent::NO_BUTTON, glm::vec2(-1, -1), 0)),
       m_EventHookPyFunc(Py_None),
-      m_bMouseEnabled(true)
+      m_bMouseEnabled(true),
+      m_bEventBatching(false),
+      m_bDrawBatching(false)
 {
     string sDummy;
 #ifdef _WIN32
@@ -185,6 +189,7 @@ Player::Player()
     if (getEnv("AVG_BREAK_ON_IMPORT", sDummy)) {
         debugBreak();
     }
+    getEnv("AVG_FRAMESTATS_FILE", m_sFrameStatsFile);
 }
 
 Player::~Player()
@@ -528,6 +533,7 @@ void Player::initPlayback()
 {
     m_bIsPlaying = true;
     AVG_TRACE(Logger::category::PLAYER, Logger::severity::INFO, "Playback started.");
+    m_FrameStats.reset();
     initGraphics();
     initAudio();
     try {
@@ -653,6 +659,21 @@ float Player::getFrameDuration()
     }
 }
 
+const FrameStats& Player::getFrameStats() const
+{
+    return m_FrameStats;
+}
+
+void Player::setFrameStatsFile(const string& sFilename)
+{
+    m_sFrameStatsFile = sFilename;
+}
+
+const string& Player::getFrameStatsFile() const
+{
+    return m_sFrameStatsFile;
+}
+
 BitmapPtr Player::getTouchUserBmp() const
 {
     TUIOInputDevicePtr pTUIODev = dynamic_pointer_cast<TUIOInputDevice>(
@@ -672,6 +693,74 @@ void Player::enableMouse(bool enabled)
     }
 }
 
+void Player::enableEventBatching(bool bEnabled)
+{
+    m_bEventBatching = bEnabled;
+
+    if (m_pEventDispatcher) {
+        m_pEventDispatcher->enableEventBatching(bEnabled);
+    }
+}
+
+bool Player::isEventBatchingEnabled() const
+{
+    return m_bEventBatching;
+}
+
+void Player::enableDrawBatching(bool bEnabled)
+{
+    m_bDrawBatching = bEnabled;
+    // Images loaded from now on are packed into atlas textures so they can share
+    // draw calls.
+    TextureAtlas::get()->setEnabled(bEnabled);
+}
+
+bool Player::isDrawBatchingEnabled() const
+{
+    return m_bDrawBatching;
+}
+
+void Player::setTexUploadBudget(long long budget)
+{
+    m_pContextManager->setTexUploadBudget(budget);
+}
+
+long long Player::getTexUploadBudget() const
+{
+    return m_pContextManager->getTexUploadBudget();
+}
+
+void Player::precalcNodesUnderCursors(const vector<CursorEventPtr>& pEvents)
+{
+    // Group the events by the node that receives them so each tree is traversed once.
+    typedef map<DivNodePtr, vector<CursorEventPtr> > ReceiverMap;
+    ReceiverMap receiverEvents;
+    for (unsigned i = 0; i < pEvents.size(); ++i) {
+        DivNodePtr pEventReceiverNode =
+                pEvents[i]->getInputDevice()->getEventReceiverNode();
+        if (!pEventReceiverNode) {
+            pEventReceiverNode = getRootNode();
+        }
+        receiverEvents[pEventReceiverNode].push_back(pEvents[i]);
+    }
+
+    for (ReceiverMap::iterator it = receiverEvents.begin(); it != receiverEvents.end();
+            ++it)
+    {
+        const vector<CursorEventPtr>& pCurEvents = it->second;
+        vector<glm::vec2> positions;
+        vector<NodeChainPtr> pCursorNodesList;
+        for (unsigned i = 0; i < pCurEvents.size(); ++i) {
+            positions.push_back(pCurEvents[i]->getPos());
+            pCursorNodesList.push_back(NodeChainPtr(new NodeChain));
+        }
+        it->first->getElementsByPositions(positions, pCursorNodesList);
+        for (unsigned i = 0; i < pCurEvents.size(); ++i) {
+            m_PrecalcCursorNodes[pCurEvents[i].get()] = pCursorNodesList[i];
+        }
+    }
+}
+
 void Player::setEventCapture(NodePtr pNode, int cursorID=MOUSECURSORID)
 {
     std::map<int, EventCaptureInfoPtr>::iterator it =
@@ -749,25 +838,22 @@ int Player::setOnFrameHandler(PyObject * pyfunc)
 
 bool Player::clearInterval(int id)
 {
-    vector<Timeout*>::iterator it;
-    for (it = m_PendingTimeouts.begin(); it != m_PendingTimeouts.end(); it++) {
-        if (id == (*it)->getID()) {
-            if (it == m_PendingTimeouts.begin() && m_bInHandleTimers) {
-                m_bCurrentTimeoutDeleted = true;
-            }
-            delete *it;
-            m_PendingTimeouts.erase(it);
-            return true;
-        }
+    boost::unordered_map<int, Timeout*>::iterator it = m_TimeoutsByID.find(id);
+    if (it == m_TimeoutsByID.end()) {
+        return false;
     }
-    for (it = m_NewTimeouts.begin(); it != m_NewTimeouts.end(); it++) {
-        if (id == (*it)->getID()) {
-            delete *it;
-            m_NewTimeouts.erase(it);
-            return true;
-        }
+    Timeout* pTimeout = it->second;
+    m_TimeoutsByID.erase(it);
+    set<Timeout*, TimeoutLess>::iterator pendingIt = m_PendingTimeouts.find(pTimeout);
+    if (pendingIt != m_PendingTimeouts.end() && *pendingIt == pTimeout) {
+        m_PendingTimeouts.erase(pendingIt);
+        delete pTimeout;
+    } else {
+        // The timeout is firing right now or will be added to the schedule at the end
+        // of handleTimers(), which deletes it.
+        pTimeout->cancel();
     }
-    return false;
+    return true;
 }
 
 void Player::callFromThread(PyObject * pyfunc)
@@ -987,6 +1073,7 @@ void Player::doFrame(bool bFirstFrame)
 {
     {
         ScopeTimer Timer(MainProfilingZone);
+        m_FrameStats.startFrame();
         if (!bFirstFrame) {
             m_NumFrames++;
             if (m_bFakeFPS) {
@@ -998,22 +1085,28 @@ void Player::doFrame(bool bFirstFrame)
                 ScopeTimer Timer(TimersProfilingZone);
                 handleTimers();
             }
+            m_FrameStats.endPhase(FrameStats::TIMERS);
             {
                 ScopeTimer Timer(EventsProfilingZone);
                 m_pEventDispatcher->dispatch();
+                m_PrecalcCursorNodes.clear();
                 sendFakeEvents();
                 removeDeadEventCaptures();
             }
+            m_FrameStats.endPhase(FrameStats::EVENTS);
         }
         for (unsigned i = 0; i < m_pCanvases.size(); ++i) {
             ScopeTimer Timer(OffscreenProfilingZone);
             dispatchOffscreenRendering(m_pCanvases[i].get());
         }
+        m_FrameStats.endPhase(FrameStats::OFFSCREEN);
         {
             ScopeTimer Timer(MainCanvasProfilingZone);
             m_pMainCanvas->doFrame(m_bPythonAvailable);
         }
         GLContext::mandatoryCheckError("End of frame");
+        m_pContextManager->endFrame();
+        m_FrameStats.endPhase(FrameStats::MAIN_CANVAS);
         if (m_bPythonAvailable) {
             Py_BEGIN_ALLOW_THREADS;
             try {
@@ -1026,6 +1119,12 @@ void Player::doFrame(bool bFirstFrame)
         } else {
             m_pDisplayEngine->endFrame();
         }
+        m_FrameStats.endPhase(FrameStats::END_FRAME);
+        long long targetInterval = 0;
+        if (!m_bFakeFPS && getFramerate() > 0) {
+            targetInterval = (long long)(1000000/getFramerate());
+        }
+        m_FrameStats.endFrame(targetInterval);
     }
     ThreadProfiler::get()->reset();
     if (m_NumFrames == 5) {
@@ -1197,6 +1296,7 @@ void Player::initAudio()
 void Player::initMainCanvas(NodePtr pRootNode)
 {
     m_pEventDispatcher = EventDispatcherPtr(new EventDispatcher(this, m_bMouseEnabled));
+    m_pEventDispatcher->enableEventBatching(m_bEventBatching);
     m_pMainCanvas = MainCanvasPtr(new MainCanvas(this));
     m_pMainCanvas->setRoot(pRootNode);
     if (m_DP.getNumWindows() == 1) {
@@ -1353,6 +1453,13 @@ void Player::sendFakeEvents()
     // This happens if the node constellation changes: A node moves so it's underneath
     // the cursor, is deleted, etc.
     std::map<int, CursorStatePtr>::iterator it;
+    if (m_bEventBatching) {
+        vector<CursorEventPtr> pEvents;
+        for (it = m_pLastCursorStates.begin(); it != m_pLastCursorStates.end(); ++it) {
+            pEvents.push_back(it->second->getLastEvent());
+        }
+        precalcNodesUnderCursors(pEvents);
+    }
     for (it = m_pLastCursorStates.begin(); it != m_pLastCursorStates.end(); ++it) {
         CursorStatePtr pState = it->second;
         CursorEventPtr pEvent = pState->getLastEvent();
@@ -1360,6 +1467,7 @@ void Player::sendFakeEvents()
         generateOverEvents(pEvent, pCursorNodes);
         updateCursorState(pEvent, pCursorNodes);
     }
+    m_PrecalcCursorNodes.clear();
 }
 
 void Player::sendOver(const CursorEventPtr pOtherEvent, Event::Type type,
@@ -1433,6 +1541,11 @@ void Player::handleCursorEvent(CursorEventPtr pEvent)
 
 NodeChainPtr Player::getNodesUnderCursor(CursorEventPtr pEvent) const
 {
+    map<const CursorEvent*, NodeChainPtr>::const_iterator it =
+            m_PrecalcCursorNodes.find(pEvent.get());
+    if (it != m_PrecalcCursorNodes.end()) {
+        return it->second;
+    }
     NodeChainPtr pCursorNodes(new NodeChain);
     DivNodePtr pEventReceiverNode = pEvent->getInputDevice()->getEventReceiverNode();
     if (!pEventReceiverNode) {
@@ -1519,29 +1632,32 @@ void Player::handleTimers()
     vector<Timeout *>::iterator it;
     m_bInHandleTimers = true;
 
-    it = m_PendingTimeouts.begin();
-    while (it != m_PendingTimeouts.end() && (*it)->isReady(getFrameTime())
-            && !m_bStopping)
-    {
-        m_bCurrentTimeoutDeleted = false;
-        (*it)->fire(getFrameTime());
-        if (m_bCurrentTimeoutDeleted) {
-            it = m_PendingTimeouts.begin();
+    while (!m_PendingTimeouts.empty() && !m_bStopping) {
+        Timeout* pTimeout = *m_PendingTimeouts.begin();
+        if (!pTimeout->isReady(getFrameTime())) {
+            break;
+        }
+        m_PendingTimeouts.erase(m_PendingTimeouts.begin());
+        try {
+            pTimeout->fire(getFrameTime());
+        } catch (...) {
+            // The timeout that threw stays scheduled. Everything else needs to be in a
+            // consistent state before the exception is passed on.
+            m_FiredIntervals.push_back(pTimeout);
+            rescheduleFiredTimeouts();
+            m_bInHandleTimers = false;
+            throw;
+        }
+        if (pTimeout->isCancelled()) {
+            delete pTimeout;
+        } else if (pTimeout->isInterval()) {
+            m_FiredIntervals.push_back(pTimeout);
         } else {
-            if ((*it)->isInterval()) {
-                Timeout* pTempTimeout = *it;
-                it = m_PendingTimeouts.erase(it);
-                m_NewTimeouts.insert(m_NewTimeouts.begin(), pTempTimeout);
-            } else {
-                delete *it;
-                it = m_PendingTimeouts.erase(it);
-            }
+            m_TimeoutsByID.erase(pTimeout->getID());
+            delete pTimeout;
         }
     }
-    for (it = m_NewTimeouts.begin(); it != m_NewTimeouts.end(); ++it) {
-        addTimeout(*it);
-    }
-    m_NewTimeouts.clear();
+    rescheduleFiredTimeouts();
 
     notifySubscribers("ON_FRAME");
 
@@ -1640,15 +1756,33 @@ OffscreenCanvasPtr Player::getCanvasFromURL(const std::string& sURL)
 void Player::cleanup(bool bIsAbort)
 {
     // Kill all timeouts.
-    vector<Timeout*>::iterator it;
+    set<Timeout*, TimeoutLess>::iterator it;
     for (it = m_PendingTimeouts.begin(); it != m_PendingTimeouts.end(); it++) {
         delete *it;
     }
     m_PendingTimeouts.clear();
+    vector<Timeout*>::iterator vit;
+    for (vit = m_FiredIntervals.begin(); vit != m_FiredIntervals.end(); ++vit) {
+        delete *vit;
+    }
+    m_FiredIntervals.clear();
+    for (vit = m_NewTimeouts.begin(); vit != m_NewTimeouts.end(); ++vit) {
+        delete *vit;
+    }
+    m_NewTimeouts.clear();
+    m_TimeoutsByID.clear();
     m_EventCaptureInfoMap.clear();
     m_pLastCursorStates.clear();
     m_pTestHelper->reset();
     ThreadProfiler::get()->dumpStatistics();
+    m_FrameStats.logStatistics();
+    if (m_sFrameStatsFile != "") {
+        try {
+            m_FrameStats.dump(m_sFrameStatsFile);
+        } catch (Exception& ex) {
+            AVG_LOG_ERROR(ex.getStr());
+        }
+    }
     for (unsigned i = 0; i < m_pCanvases.size(); ++i) {
         m_pCanvases[i]->stopPlayback(bIsAbort);
     }
@@ -1676,6 +1810,10 @@ void Player::cleanup(bool bIsAbort)
     if (ImageCache::exists()) {
         ImageCache::get()->unloadAllTextures();
     }
+    if (ThreadPool::exists()) {
+        delete ThreadPool::get();
+    }
+    TextEngine::clearGlyphCaches();
     if (AudioEngine::get()) {
         AudioEngine::get()->teardown();
     }
@@ -1694,6 +1832,7 @@ void Player::cleanup(bool bIsAbort)
 int Player::internalSetTimeout(int time, PyObject * pyfunc, bool bIsInterval)
 {
     Timeout* pTimeout = new Timeout(time, pyfunc, bIsInterval, getFrameTime());
+    m_TimeoutsByID[pTimeout->getID()] = pTimeout;
     if (m_bInHandleTimers) {
         m_NewTimeouts.push_back(pTimeout);
     } else {
@@ -1705,14 +1844,43 @@ int Player::internalSetTimeout(int time, PyObject * pyfunc, bool bIsInterval)
 
 int Player::addTimeout(Timeout* pTimeout)
 {
-    vector<Timeout*>::iterator it = m_PendingTimeouts.begin();
-    while (it != m_PendingTimeouts.end() && (**it)<*pTimeout) {
-        it++;
-    }
-    m_PendingTimeouts.insert(it, pTimeout);
+    pTimeout->setSchedulingOrder(m_NextSchedulingOrder);
+    m_NextSchedulingOrder++;
+    m_PendingTimeouts.insert(pTimeout);
     return pTimeout->getID();
 }
 
+void Player::rescheduleFiredTimeouts()
+{
+    // Intervals are rescheduled in reverse firing order, before the timeouts that
+    // were set during this frame.
+    vector<Timeout *>::reverse_iterator rit;
+    for (rit = m_FiredIntervals.rbegin(); rit != m_FiredIntervals.rend(); ++rit) {
+        rescheduleTimeout(*rit);
+    }
+    m_FiredIntervals.clear();
+    vector<Timeout *>::iterator it;
+    for (it = m_NewTimeouts.begin(); it != m_NewTimeouts.end(); ++it) {
+        rescheduleTimeout(*it);
+    }
+    m_NewTimeouts.clear();
+}
+
+void Player::rescheduleTimeout(Timeout* pTimeout)
+{
+    if (pTimeout->isCancelled()) {
+        delete pTimeout;
+    } else {
+        addTimeout(pTimeout);
+    }
+}
+
+bool Player::TimeoutLess::operator()(const Timeout* pTimeout1,
+        const Timeout* pTimeout2) const
+{
+    return *pTimeout1 < *pTimeout2;
+}
+
 void Player::setPluginPath(const string& newPath)
 {
     PluginManager::get().setSearchPath(newPath);
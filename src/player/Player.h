@@ -27,6 +27,7 @@
 #include "DisplayParams.h"
 #include "BoostPython.h"
 #include "Event.h"
+#include "FrameStats.h"
 
 #include "../audio/AudioParams.h"
 #include "../graphics/GLConfig.h"
@@ -34,9 +35,11 @@
 #include <libxml/parser.h>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <string>
 #include <vector>
+#include <set>
 
 namespace avg {
 
@@ -138,6 +141,10 @@ class AVG_API Player: public Publisher
         void setFakeFPS(float fps);
         long long getFrameTime();
         float getFrameDuration();
+        const FrameStats& getFrameStats() const;
+        // The frame statistics are written to this file when playback ends.
+        void setFrameStatsFile(const std::string& sFilename);
+        const std::string& getFrameStatsFile() const;
 
         NodePtr createNode(const std::string& sType, const py::dict& PyDict,
                 const py::object& self=py::object());
@@ -154,6 +161,13 @@ class AVG_API Player: public Publisher
         EventPtr getCurrentEvent() const;
         BitmapPtr getTouchUserBmp() const;
         void enableMouse(bool enabled);
+        void enableEventBatching(bool bEnabled);
+        bool isEventBatchingEnabled() const;
+        void enableDrawBatching(bool bEnabled);
+        bool isDrawBatchingEnabled() const;
+        void setTexUploadBudget(long long budget);
+        long long getTexUploadBudget() const;
+        void precalcNodesUnderCursors(const std::vector<CursorEventPtr>& pEvents);
         void setEventCapture(NodePtr pNode, int cursorID);
         void releaseEventCapture(int cursorID);
         bool isCaptured(int cursorID);
@@ -256,11 +270,22 @@ class AVG_API Player: public Publisher
         int internalSetTimeout(int time, PyObject * pyfunc, bool bIsInterval);
         int addTimeout(Timeout* pTimeout);
         void handleTimers();
+        void rescheduleFiredTimeouts();
+        void rescheduleTimeout(Timeout* pTimeout);
         bool m_bInHandleTimers;
-        bool m_bCurrentTimeoutDeleted;
 
-        std::vector<Timeout *> m_PendingTimeouts;
+        struct TimeoutLess {
+            bool operator()(const Timeout* pTimeout1, const Timeout* pTimeout2) const;
+        };
+        // Ordered by due time, so adding, clearing and firing timeouts is O(log n).
+        std::set<Timeout *, TimeoutLess> m_PendingTimeouts;
+        // All timeouts created by setTimeout() and setInterval() that haven't been
+        // cleared or fired yet, by id.
+        boost::unordered_map<int, Timeout *> m_TimeoutsByID;
+        long long m_NextSchedulingOrder;
         std::vector<Timeout *> m_NewTimeouts; // Timeouts to be added this frame.
+        // Intervals that fired this frame, in firing order.
+        std::vector<Timeout *> m_FiredIntervals;
         std::vector<Timeout *> m_AsyncCalls;
         boost::mutex m_AsyncCallMutex;
 
@@ -279,6 +304,8 @@ class AVG_API Player: public Publisher
         long long m_FrameTime;
         long long m_PlayStartTime;
         long long m_NumFrames;
+        FrameStats m_FrameStats;
+        std::string m_sFrameStatsFile;
 
         float m_Volume;
 
@@ -308,6 +335,13 @@ class AVG_API Player: public Publisher
 
         PyObject * m_EventHookPyFunc;
         bool m_bMouseEnabled;
+
+        bool m_bEventBatching;
+        // Hit test results of the cursor events of the current frame, computed in one
+        // pass if event batching is enabled.
+        std::map<const CursorEvent*, NodeChainPtr> m_PrecalcCursorNodes;
+
+        bool m_bDrawBatching;
 };
 
 }
@@ -27,6 +27,7 @@
 #include "FXNode.h"
 #include "Canvas.h"
 #include "NodeChain.h"
+#include "Player.h"
 
 #include "../graphics/ImagingProjection.h"
 #include "../graphics/ShaderRegistry.h"
@@ -81,6 +82,7 @@ RasterNode::RasterNode(const string& sPublisherName)
       m_Color(0,0,0,0),
       m_TileSize(-1,-1),
       m_pSubVA(0),
+      m_bBatched(false),
       m_bFXDirty(true)
 {
 }
@@ -390,6 +392,9 @@ void RasterNode::renderFX(GLContext* pContext)
         }
         pContext->setBlendMode(GLContext::BLEND_BLEND, bPremultipliedAlpha);
         m_pImagingProjection->setColor(m_Color);
+        if (m_pSurface->hasTexRect()) {
+            m_pImagingProjection->setTexRect(m_pSurface->getTexCoordRect());
+        }
         m_pImagingProjection->draw(pContext, pSShader->getShader());
 /*
         static int i=0;
@@ -426,23 +431,130 @@ void RasterNode::scheduleFXRender()
     }
 }
 
+static glm::vec2 transformPoint(const glm::mat4& transform, const glm::vec2& pt)
+{
+    glm::vec4 result = transform*glm::vec4(pt.x, pt.y, 0, 1);
+    return glm::vec2(result.x, result.y);
+}
+
 void RasterNode::calcVertexArray(const VertexArrayPtr& pVA)
 {
-    if (m_pSurface->isCreated() && !m_bHasStdVertices && isVisible()) {
-        pVA->startSubVA(*m_pSubVA);
-        for (unsigned y = 0; y < m_TileVertices.size()-1; y++) {
-            for (unsigned x = 0; x < m_TileVertices[0].size()-1; x++) {
-                int curVertex = m_pSubVA->getNumVerts();
-                m_pSubVA->appendPos(m_TileVertices[y][x], m_TexCoords[y][x], m_Color);
-                m_pSubVA->appendPos(m_TileVertices[y][x+1], m_TexCoords[y][x+1],
-                        m_Color);
-                m_pSubVA->appendPos(m_TileVertices[y+1][x+1], m_TexCoords[y+1][x+1],
-                        m_Color);
-                m_pSubVA->appendPos(m_TileVertices[y+1][x], m_TexCoords[y+1][x],
-                        m_Color);
-                m_pSubVA->appendQuadIndexes(
-                        curVertex+1, curVertex, curVertex+2, curVertex+3);
-            }
+    m_bBatched = false;
+    if (m_pSurface->isCreated() && isVisible()) {
+        FRect destRect;
+        if (Player::get()->isDrawBatchingEnabled() && !m_pFXNode &&
+                getBatchDestRect(destRect))
+        {
+            glm::vec3 pos(destRect.tl.x, destRect.tl.y, 0);
+            glm::vec3 scaleVec(destRect.size().x, destRect.size().y, 1);
+            glm::mat4 transform = glm::translate(getLocalTransform(), pos);
+            transform = glm::scale(transform, scaleVec);
+            appendTileVertices(pVA, m_BatchSubVA, transform);
+            m_bBatched = true;
+        } else {
+            appendVertices(pVA);
+        }
+    }
+}
+
+void RasterNode::appendVertices(const VertexArrayPtr& pVA)
+{
+    if (!m_bHasStdVertices) {
+        appendTileVertices(pVA, *m_pSubVA, glm::mat4(1.0f));
+    }
+}
+
+void RasterNode::renderVertices(GLContext* pContext, const glm::mat4& transform,
+        SubVertexArray& subVA)
+{
+    AVG_ASSERT(!m_pFXNode);
+    StandardShader* pShader = pContext->getStandardShader();
+    float opacity = getEffectiveOpacity();
+    pContext->setBlendColor(glm::vec4(1.0f, 1.0f, 1.0f, opacity));
+    pShader->setAlpha(opacity);
+    m_pSurface->activate(pContext, getMediaSize());
+    pContext->setBlendMode(m_BlendMode, m_pSurface->isPremultipliedAlpha());
+    pShader->setTransform(transform);
+    pShader->activate();
+    subVA.draw();
+}
+
+bool RasterNode::hasEffect() const
+{
+    return m_pFXNode != FXNodePtr();
+}
+
+void RasterNode::maybeRender(GLContext* pContext, const glm::mat4& parentTransform)
+{
+    if (m_bBatched) {
+        AVG_ASSERT(getState() == NS_CANRENDER);
+        renderBatch(pContext, parentTransform, 1, getNumBatchIndexes());
+    } else {
+        AreaNode::maybeRender(pContext, parentTransform);
+    }
+}
+
+bool RasterNode::isBatched() const
+{
+    return m_bBatched;
+}
+
+int RasterNode::getNumBatchIndexes() const
+{
+    return m_BatchSubVA.getNumIndexes();
+}
+
+bool RasterNode::canBatchWith(const RasterNode& prevNode) const
+{
+    // Index ranges need to be contiguous so the nodes can be drawn with one call.
+    return m_bBatched && prevNode.m_bBatched &&
+            m_BatchSubVA.getStartIndex() == prevNode.m_BatchSubVA.getStartIndex() +
+                    prevNode.m_BatchSubVA.getNumIndexes() &&
+            m_BlendMode == prevNode.m_BlendMode &&
+            getEffectiveOpacity() == prevNode.getEffectiveOpacity() &&
+            m_pSurface->isBatchCompatible(*(prevNode.m_pSurface));
+}
+
+static ProfilingZoneID BatchRenderProfilingZone("RasterNode::renderBatch");
+
+void RasterNode::renderBatch(GLContext* pContext, const glm::mat4& parentTransform,
+        int numNodes, int numIndexes)
+{
+    ScopeTimer timer(BatchRenderProfilingZone);
+    AVG_ASSERT(m_bBatched);
+    StandardShader* pShader = pContext->getStandardShader();
+    float opacity = getEffectiveOpacity();
+    pContext->setBlendColor(glm::vec4(1.0f, 1.0f, 1.0f, opacity));
+    pShader->setAlpha(opacity);
+    m_pSurface->activate(pContext, getMediaSize());
+    pContext->setBlendMode(m_BlendMode, m_pSurface->isPremultipliedAlpha());
+    pShader->setTransform(parentTransform);
+    pShader->activate();
+    m_BatchSubVA.draw(numIndexes);
+    pContext->countBatch(numNodes);
+}
+
+bool RasterNode::getBatchDestRect(FRect& destRect)
+{
+    return false;
+}
+
+void RasterNode::appendTileVertices(const VertexArrayPtr& pVA, SubVertexArray& subVA,
+        const glm::mat4& transform)
+{
+    pVA->startSubVA(subVA);
+    for (unsigned y = 0; y < m_TileVertices.size()-1; y++) {
+        for (unsigned x = 0; x < m_TileVertices[0].size()-1; x++) {
+            int curVertex = subVA.getNumVerts();
+            subVA.appendPos(transformPoint(transform, m_TileVertices[y][x]),
+                    m_TexCoords[y][x], m_Color);
+            subVA.appendPos(transformPoint(transform, m_TileVertices[y][x+1]),
+                    m_TexCoords[y][x+1], m_Color);
+            subVA.appendPos(transformPoint(transform, m_TileVertices[y+1][x+1]),
+                    m_TexCoords[y+1][x+1], m_Color);
+            subVA.appendPos(transformPoint(transform, m_TileVertices[y+1][x]),
+                    m_TexCoords[y+1][x], m_Color);
+            subVA.appendQuadIndexes(curVertex+1, curVertex, curVertex+2, curVertex+3);
         }
     }
 }
@@ -560,7 +672,8 @@ void RasterNode::newSurface()
 {
     if (m_pSurface->isCreated()) {
         m_bHasStdVertices = !(m_pSurface->getPixelFormat() == A8) &&
-                !GLContext::getCurrent()->usePOTTextures();
+                !GLContext::getCurrent()->usePOTTextures() &&
+                !m_pSurface->hasTexRect();
         if (m_bHasStdVertices) {
             m_pSubVA = &(getCanvas()->getStdSubVA());
         } else {
@@ -630,10 +743,10 @@ void RasterNode::calcTileVertex(int x, int y, glm::vec2& Vertex)
 
 void RasterNode::calcTexCoords()
 {
-    glm::vec2 textureSize = glm::vec2(m_pSurface->getTextureSize());
     glm::vec2 imageSize = glm::vec2(m_pSurface->getSize());
-    glm::vec2 texCoordExtents = glm::vec2(imageSize.x/textureSize.x,
-            imageSize.y/textureSize.y);
+    FRect texCoordRect = m_pSurface->getTexCoordRect();
+    glm::vec2 texCoordOffset = texCoordRect.tl;
+    glm::vec2 texCoordExtents = texCoordRect.size();
 
     glm::vec2 texSizePerTile;
     if (m_TileSize.x == -1) {
@@ -659,6 +772,7 @@ void RasterNode::calcTexCoords()
             } else {
                 m_TexCoords[y][x].x = texSizePerTile.x*x;
             }
+            m_TexCoords[y][x] += texCoordOffset;
         }
     }
 }
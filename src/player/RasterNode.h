@@ -30,12 +30,12 @@
 #include "../base/UTF8String.h"
 
 #include "../graphics/GLContext.h"
+#include "../graphics/SubVertexArray.h"
 
 #include <string>
 
 namespace avg {
 
-class SubVertexArray;
 class OGLSurface;
 class ImagingProjection;
 typedef boost::shared_ptr<ImagingProjection> ImagingProjectionPtr;
@@ -101,6 +101,16 @@ class AVG_API RasterNode: public AreaNode
         virtual void renderFX(GLContext* pContext);
         void resetFXDirty();
 
+        // Draw call batching: Nodes that are batched emit their vertices in the
+        // coordinate system of the parent, so consecutive compatible siblings can be
+        // rendered in one draw call.
+        virtual void maybeRender(GLContext* pContext, const glm::mat4& parentTransform);
+        bool isBatched() const;
+        int getNumBatchIndexes() const;
+        bool canBatchWith(const RasterNode& prevNode) const;
+        void renderBatch(GLContext* pContext, const glm::mat4& parentTransform,
+                int numNodes, int numIndexes);
+
     protected:
         RasterNode(const std::string& sPublisherName);
         
@@ -119,6 +129,17 @@ class AVG_API RasterNode: public AreaNode
         void newSurface();
         void setupFX();
 
+        // Returns the area covered by the surface in local coordinates or false if
+        // the node can't be batched.
+        virtual bool getBatchDestRect(FRect& destRect);
+        // Adds the vertices of a node that isn't batched. The default implementation
+        // adds the tile grid.
+        virtual void appendVertices(const VertexArrayPtr& pVA);
+        // Renders vertices in local coordinates with the surface texture.
+        void renderVertices(GLContext* pContext, const glm::mat4& transform,
+                SubVertexArray& subVA);
+        bool hasEffect() const;
+
     private:
         void downloadMask();
         virtual void calcMaskCoords();
@@ -128,6 +149,8 @@ class AVG_API RasterNode: public AreaNode
         void calcVertexGrid(VertexGrid& grid);
         void calcTileVertex(int x, int y, glm::vec2& Vertex);
         void calcTexCoords();
+        void appendTileVertices(const VertexArrayPtr& pVA, SubVertexArray& subVA,
+                const glm::mat4& transform);
 
         OGLSurface * m_pSurface;
         
@@ -148,6 +171,8 @@ class AVG_API RasterNode: public AreaNode
         bool m_bHasStdVertices;
         SubVertexArray* m_pSubVA;
         std::vector<std::vector<glm::vec2> > m_TexCoords;
+        bool m_bBatched;
+        SubVertexArray m_BatchSubVA;
 
         glm::vec3 m_Gamma;
         glm::vec3 m_Intensity;
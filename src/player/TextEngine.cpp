@@ -20,6 +20,7 @@
 //
 
 #include "TextEngine.h"
+#include "GlyphCache.h"
 
 #include "../base/Logger.h"
 #include "../base/OSHelper.h"
@@ -52,6 +53,8 @@ text_subst_func_nohint(FcPattern *pattern, gpointer data)
     FcPatternAddBool(pattern, FC_ANTIALIAS, true);
 }
 
+vector<TextEngine*> TextEngine::s_pEngines;
+
 TextEngine& TextEngine::get(bool bHint)
 {
     if (bHint) {
@@ -65,10 +68,12 @@ TextEngine& TextEngine::get(bool bHint)
 
 
 TextEngine::TextEngine(bool bHint)
-    : m_bHint(bHint)
+    : m_bHint(bHint),
+      m_pGlyphCache(0)
 {
     m_sFontDirs.push_back("fonts/");
     init();
+    s_pEngines.push_back(this);
 }
 
 TextEngine::~TextEngine()
@@ -80,6 +85,7 @@ void TextEngine::init()
 {
     initFonts();
 
+    m_pGlyphCache = new GlyphCache();
     m_pFontMap = PANGO_FT2_FONT_MAP(pango_ft2_font_map_new());
     pango_ft2_font_map_set_resolution(m_pFontMap, 72, 72);
     if (m_bHint) {
@@ -113,6 +119,9 @@ void TextEngine::init()
 
 void TextEngine::deinit()
 {
+    // Cached fonts and layouts belong to the font map.
+    delete m_pGlyphCache;
+    m_pGlyphCache = 0;
     g_object_unref(m_pFontMap);
     g_free(m_ppFontFamilies);
     g_object_unref(m_pPangoContext);
@@ -126,6 +135,18 @@ void TextEngine::addFontDir(const std::string& sDir)
     init();
 }
 
+GlyphCache& TextEngine::getGlyphCache()
+{
+    return *m_pGlyphCache;
+}
+
+void TextEngine::clearGlyphCaches()
+{
+    for (unsigned i = 0; i < s_pEngines.size(); ++i) {
+        s_pEngines[i]->getGlyphCache().clear();
+    }
+}
+
 PangoContext * TextEngine::getPangoContext()
 {
     return m_pPangoContext;
@@ -33,6 +33,8 @@
 
 namespace avg {
 
+class GlyphCache;
+
 class TextEngine {
 public:
     static TextEngine& get(bool bHint);
@@ -48,6 +50,11 @@ public:
             const std::string& sVariant);
     void FT2SubstituteFunc(FcPattern *pattern, gpointer data);
 
+    GlyphCache& getGlyphCache();
+    // Drops the cached glyphs and layouts of all text engines. Called when the 
+    // graphics context goes away.
+    static void clearGlyphCaches();
+
 private:
     TextEngine(bool bHint);
     void init();
@@ -69,6 +76,9 @@ private:
     FontDescriptionCache m_FontDescriptionCache;
     PangoFontFamily** m_ppFontFamilies;
     std::vector<std::string> m_sFontDirs;
+    GlyphCache* m_pGlyphCache;
+
+    static std::vector<TextEngine*> s_pEngines;
 
 };
 
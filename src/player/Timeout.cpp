@@ -37,8 +37,10 @@ int Timeout::s_LastID = 100000;
 
 Timeout::Timeout(int time, PyObject * pyfunc, bool isInterval, long long startTime)
     : m_Interval(time),
+      m_SchedulingOrder(0),
       m_PyFunc(pyfunc),
-      m_IsInterval(isInterval)
+      m_IsInterval(isInterval),
+      m_bCancelled(false)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     m_NextTimeout = m_Interval+startTime;
@@ -85,9 +87,28 @@ int Timeout::getID() const
     return m_ID;
 }
 
+void Timeout::setSchedulingOrder(long long order)
+{
+    m_SchedulingOrder = order;
+}
+
 bool Timeout::operator <(const Timeout& other) const
 {
-    return m_NextTimeout < other.m_NextTimeout;
+    if (m_NextTimeout != other.m_NextTimeout) {
+        return m_NextTimeout < other.m_NextTimeout;
+    } else {
+        return m_SchedulingOrder > other.m_SchedulingOrder;
+    }
+}
+
+void Timeout::cancel()
+{
+    m_bCancelled = true;
+}
+
+bool Timeout::isCancelled() const
+{
+    return m_bCancelled;
 }
 
 }
@@ -38,13 +38,22 @@ class AVG_API Timeout
         bool isInterval() const;
         void fire(long long curTime);
         int getID() const;
+        // Timeouts that are due at the same time are ordered by descending
+        // scheduling order, i.e. the most recently scheduled one fires first.
+        void setSchedulingOrder(long long order);
         bool operator <(const Timeout& other) const;
 
+        // Used for timeouts that are cleared while they are not in the schedule.
+        void cancel();
+        bool isCancelled() const;
+
     private:
         long long m_Interval;
         long long m_NextTimeout;
+        long long m_SchedulingOrder;
         PyObject * m_PyFunc;
         bool m_IsInterval;
+        bool m_bCancelled;
         int m_ID;
         static int s_LastID;
 };
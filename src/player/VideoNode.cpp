@@ -40,6 +40,7 @@
 
 #include "../video/AsyncVideoDecoder.h"
 #include "../video/SyncVideoDecoder.h"
+#include "../video/PreloadedVideoDecoder.h"
 
 #include <iostream>
 #include <sstream>
@@ -66,6 +67,11 @@ void VideoNode::registerType()
         .addArg(Arg<float>("volume", 1.0, false, offsetof(VideoNode, m_Volume)))
         .addArg(Arg<bool>("enablesound", true, false,
                 offsetof(VideoNode, m_bEnableSound)))
+        .addArg(Arg<bool>("keyframeindex", false, false,
+                offsetof(VideoNode, m_bKeyframeIndex)))
+        .addArg(Arg<UTF8String>("keyframeindexfile", "", false,
+                offsetof(VideoNode, m_KeyframeIndexFile)))
+        .addArg(Arg<bool>("preload", false, false, offsetof(VideoNode, m_bPreload)))
         ;
     TypeRegistry::get()->registerType(def);
 }
@@ -84,6 +90,8 @@ VideoNode::VideoNode(const ArgList& args,const string& sPublisherName)
       m_pDecoder(0),
       m_Volume(1.0),
       m_bEnableSound(true),
+      m_bKeyframeIndex(false),
+      m_bPreload(false),
       m_AudioID(-1)
 {
     args.setMembers(this);
@@ -93,7 +101,9 @@ VideoNode::VideoNode(const ArgList& args,const string& sPublisherName)
         throw Exception(AVG_ERR_INVALID_ARGS, 
                 "Can't set queue length for unthreaded videos because there is no decoder queue in this case.");
     }
-    if (m_bThreaded) {
+    if (m_bPreload) {
+        m_pDecoder = new PreloadedVideoDecoder();
+    } else if (m_bThreaded) {
         m_pDecoder = new AsyncVideoDecoder(m_QueueLength);
     } else {
         m_pDecoder = new SyncVideoDecoder();
@@ -185,7 +195,12 @@ int VideoNode::getNumFramesQueued() const
     return m_pDecoder->getNumFramesQueued();
 }
 
-void VideoNode::seekToFrame(int frameNum)
+VideoFramePoolPtr VideoNode::getFramePool() const
+{
+    return m_pDecoder->getFramePool();
+}
+
+void VideoNode::seekToFrame(int frameNum, bool bPreview)
 {
     if (frameNum < 0) {
         throw Exception(AVG_ERR_OUT_OF_RANGE,
@@ -194,6 +209,9 @@ void VideoNode::seekToFrame(int frameNum)
     exceptionIfUnloaded("seekToFrame");
     if (getCurFrame() != frameNum) {
         long long destTime = (long long)(frameNum*1000.0/m_pDecoder->getStreamFPS());
+        if (bPreview) {
+            destTime = getPreviewSeekTime(destTime);
+        }
         seek(destTime);
     }
 }
@@ -280,13 +298,16 @@ long long VideoNode::getCurTime() const
     }
 }
 
-void VideoNode::seekToTime(long long time)
+void VideoNode::seekToTime(long long time, bool bPreview)
 {
     if (time < 0) {
         throw Exception(AVG_ERR_OUT_OF_RANGE,
                 "Can't seek to a negative time in a video.");
     }
     exceptionIfUnloaded("seekToTime");
+    if (bPreview) {
+        time = getPreviewSeekTime(time);
+    }
     seek(time);
 }
 
@@ -300,6 +321,21 @@ bool VideoNode::isThreaded() const
     return m_bThreaded;
 }
 
+bool VideoNode::isPreloaded() const
+{
+    return m_bPreload;
+}
+
+bool VideoNode::getKeyframeIndex() const
+{
+    return m_bKeyframeIndex;
+}
+
+const UTF8String& VideoNode::getKeyframeIndexFile() const
+{
+    return m_KeyframeIndexFile;
+}
+
 bool VideoNode::hasAudio() const
 {
     exceptionIfUnloaded("hasAudio");
@@ -449,11 +485,21 @@ void VideoNode::seek(long long destTime)
     }
 }
 
+long long VideoNode::getPreviewSeekTime(long long destTime) const
+{
+    // Decoding can start at the keyframe, so the first frame is available right away.
+    float keyframeTime = m_pDecoder->getKeyframeTime(float(destTime)/1000.0f);
+    return (long long)(keyframeTime*1000.0f+0.5f);
+}
+
 void VideoNode::open() 
 {
     m_FramesTooLate = 0;
     m_FramesInRowTooLate = 0;
     m_FramesPlayed = 0;
+    string sKeyframeIndexFile = m_KeyframeIndexFile;
+    initFilename(sKeyframeIndexFile);
+    m_pDecoder->setKeyframeIndexEnabled(m_bKeyframeIndex, sKeyframeIndexFile);
     m_pDecoder->open(m_Filename, m_bEnableSound);
     VideoInfo videoInfo = m_pDecoder->getVideoInfo();
     if (!videoInfo.m_bHasVideo) {
@@ -70,7 +70,8 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         int getNumFrames() const;
         int getCurFrame() const;
         int getNumFramesQueued() const;
-        void seekToFrame(int frameNum);
+        VideoFramePoolPtr getFramePool() const;
+        void seekToFrame(int frameNum, bool bPreview=false);
         bool isSeeking() const;
         std::string getStreamPixelFormat() const;
         long long getDuration() const;
@@ -84,9 +85,12 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         int getNumAudioChannels() const;
 
         long long getCurTime() const;
-        void seekToTime(long long time);
+        void seekToTime(long long time, bool bPreview=false);
         bool getLoop() const;
+        bool getKeyframeIndex() const;
+        const UTF8String& getKeyframeIndexFile() const;
         bool isThreaded() const;
+        bool isPreloaded() const;
         bool hasAudio() const;
         bool hasAlpha() const;
         void setEOFCallback(PyObject * pEOFCallback);
@@ -102,6 +106,7 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         bool renderFrame();
         FrameAvailableCode renderToSurface();
         void seek(long long destTime);
+        long long getPreviewSeekTime(long long destTime) const;
         void onEOF();
         void updateStatusDueToDecoderEOF();
         void dumpFramesTooLate();
@@ -144,6 +149,9 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         VideoDecoder * m_pDecoder;
         float m_Volume;
         bool m_bEnableSound;
+        bool m_bKeyframeIndex;
+        UTF8String m_KeyframeIndexFile;
+        bool m_bPreload;
         int m_AudioID;
 
         MCTexturePtr m_pTextures[4];
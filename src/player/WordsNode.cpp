@@ -25,6 +25,7 @@
 #include "TypeRegistry.h"
 #include "TextEngine.h"
 #include "Canvas.h"
+#include "GlyphCache.h"
 
 #include "../base/Logger.h"
 #include "../base/Exception.h"
@@ -38,18 +39,23 @@
 #include "../graphics/GLContext.h"
 #include "../graphics/GLContextManager.h"
 #include "../graphics/GLTexture.h"
+#include "../graphics/MCTexture.h"
 #include "../graphics/TextureMover.h"
+#include "../graphics/TextureAtlas.h"
 
 #include <pango/pangoft2.h>
 
 #include <iostream>
 #include <algorithm>
+#include <sstream>
 
 using namespace std;
 using namespace boost;
 
 namespace avg {
 
+bool WordsNode::s_bGlyphRendering = false;
+
 void WordsNode::registerType()
 {
     static const string sDTDElements =
@@ -117,6 +123,7 @@ WordsNode::WordsNode(const ArgList& args, const string& sPublisherName)
       m_LogicalSize(0,0),
       m_pFontDescription(0),
       m_pLayout(0),
+      m_bGlyphMode(false),
       m_bRenderNeeded(true)
 {
     m_bParsedText = false;
@@ -175,6 +182,10 @@ void WordsNode::disconnect(bool bKill)
         m_pFontDescription = 0;
         updateFont();
     }
+    m_pAtlasRegion = TextureAtlasRegionPtr();
+    // The glyphs of the layout might live in textures of the current GL context.
+    m_pTextLayout = TextLayoutPtr();
+    m_bGlyphMode = false;
     RasterNode::disconnect(bKill);
 }
 
@@ -286,6 +297,16 @@ void WordsNode::addFontDir(const std::string& sDir)
     TextEngine::get(false).addFontDir(sDir);
 }
 
+void WordsNode::enableGlyphRendering(bool bEnable)
+{
+    s_bGlyphRendering = bEnable;
+}
+
+bool WordsNode::isGlyphRenderingEnabled()
+{
+    return s_bGlyphRendering;
+}
+
 void WordsNode::setFontVariant(const UTF8String& sVariant)
 {
     m_FontStyle.setFontVariant(sVariant);
@@ -533,65 +554,25 @@ void WordsNode::updateLayout()
 
     if (m_sText.length() == 0) {
         m_LogicalSize = IntPoint(0,0);
+        m_pTextLayout = TextLayoutPtr();
         m_bRenderNeeded = true;
     } else {
         TextEngine& engine = TextEngine::get(m_FontStyle.getHint());
-        PangoContext* pContext = engine.getPangoContext();
-        pango_context_set_font_description(pContext, m_pFontDescription);
-
+        GlyphCache& glyphCache = engine.getGlyphCache();
+        string sKey = getLayoutKey();
+        m_pTextLayout = glyphCache.getLayout(sKey);
+        if (!m_pTextLayout) {
+            m_pTextLayout = TextLayoutPtr(new TextLayout(createLayout()));
+            glyphCache.addLayout(sKey, m_pTextLayout);
+        }
         if (m_pLayout) {
             g_object_unref(m_pLayout);
         }
-        m_pLayout = pango_layout_new(pContext);
-
-        PangoAttrList * pAttrList = 0;
-#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2)
-        PangoAttribute * pLetterSpacing = pango_attr_letter_spacing_new
-            (int(m_FontStyle.getLetterSpacing()*1024));
-#endif
-        if (m_bParsedText) {
-            char * pText = 0;
-            parseString(&pAttrList, &pText);
-#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2)
-            // Workaround for pango bug.
-            pango_attr_list_insert_before(pAttrList, pLetterSpacing);
-#endif
-            pango_layout_set_text(m_pLayout, pText, -1);
-            g_free(pText);
-        } else {
-            pAttrList = pango_attr_list_new();
-#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2)
-            pango_attr_list_insert_before(pAttrList, pLetterSpacing);
-#endif
-            pango_layout_set_text(m_pLayout, m_sText.c_str(), -1);
-        }
-#if PANGO_VERSION >= PANGO_VERSION_ENCODE(1,44,0)
-        pango_attr_list_insert(pAttrList, pango_attr_insert_hyphens_new(FALSE));
-#endif
-        pango_layout_set_attributes(m_pLayout, pAttrList);
-        pango_attr_list_unref(pAttrList);
-
-        pango_layout_set_wrap(m_pLayout, m_FontStyle.getWrapModeVal());
-        pango_layout_set_alignment(m_pLayout, m_FontStyle.getAlignmentVal());
-        pango_layout_set_justify(m_pLayout, m_FontStyle.getJustify());
-        if (getUserSize().x != 0) {
-            pango_layout_set_width(m_pLayout, int(getUserSize().x * PANGO_SCALE));
-        }
-        int indent = m_FontStyle.getIndent() * PANGO_SCALE;
-        pango_layout_set_indent(m_pLayout, indent);
-        if (indent < 0) {
-            // For hanging indentation, we add a tabstop to support lists
-            PangoTabArray* pTabs = pango_tab_array_new_with_positions(1, false,
-                    PANGO_TAB_LEFT, -indent);
-            pango_layout_set_tabs(m_pLayout, pTabs);
-            pango_tab_array_free(pTabs);
-        }
-        pango_layout_set_spacing(m_pLayout,
-                (int)(m_FontStyle.getLineSpacing()*PANGO_SCALE));
-        PangoRectangle logical_rect;
-        PangoRectangle ink_rect;
-        pango_layout_get_pixel_extents(m_pLayout, &ink_rect, &logical_rect);
+        m_pLayout = m_pTextLayout->getLayout();
+        g_object_ref(m_pLayout);
 
+        const PangoRectangle& ink_rect = m_pTextLayout->getInkRect();
+        const PangoRectangle& logical_rect = m_pTextLayout->getLogicalRect();
         /*
                   cerr << getID() << endl;
                   cerr << "Ink: " << ink_rect.x << ", " << ink_rect.y << ", "
@@ -620,6 +601,83 @@ void WordsNode::updateLayout()
     }
 }
 
+PangoLayout* WordsNode::createLayout()
+{
+    TextEngine& engine = TextEngine::get(m_FontStyle.getHint());
+    PangoContext* pContext = engine.getPangoContext();
+    pango_context_set_font_description(pContext, m_pFontDescription);
+
+    PangoLayout* pLayout = pango_layout_new(pContext);
+    // The layout can be shared with other nodes, so it shouldn't depend on the font
+    // description that happens to be set in the context.
+    pango_layout_set_font_description(pLayout, m_pFontDescription);
+
+    PangoAttrList * pAttrList = 0;
+#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2)
+    PangoAttribute * pLetterSpacing = pango_attr_letter_spacing_new
+        (int(m_FontStyle.getLetterSpacing()*1024));
+#endif
+    if (m_bParsedText) {
+        char * pText = 0;
+        try {
+            parseString(&pAttrList, &pText);
+        } catch (const Exception&) {
+            g_object_unref(pLayout);
+            throw;
+        }
+#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2)
+        // Workaround for pango bug.
+        pango_attr_list_insert_before(pAttrList, pLetterSpacing);
+#endif
+        pango_layout_set_text(pLayout, pText, -1);
+        g_free(pText);
+    } else {
+        pAttrList = pango_attr_list_new();
+#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2)
+        pango_attr_list_insert_before(pAttrList, pLetterSpacing);
+#endif
+        pango_layout_set_text(pLayout, m_sText.c_str(), -1);
+    }
+#if PANGO_VERSION >= PANGO_VERSION_ENCODE(1,44,0)
+    pango_attr_list_insert(pAttrList, pango_attr_insert_hyphens_new(FALSE));
+#endif
+    pango_layout_set_attributes(pLayout, pAttrList);
+    pango_attr_list_unref(pAttrList);
+
+    pango_layout_set_wrap(pLayout, m_FontStyle.getWrapModeVal());
+    pango_layout_set_alignment(pLayout, m_FontStyle.getAlignmentVal());
+    pango_layout_set_justify(pLayout, m_FontStyle.getJustify());
+    if (getUserSize().x != 0) {
+        pango_layout_set_width(pLayout, int(getUserSize().x * PANGO_SCALE));
+    }
+    int indent = m_FontStyle.getIndent() * PANGO_SCALE;
+    pango_layout_set_indent(pLayout, indent);
+    if (indent < 0) {
+        // For hanging indentation, we add a tabstop to support lists
+        PangoTabArray* pTabs = pango_tab_array_new_with_positions(1, false,
+                PANGO_TAB_LEFT, -indent);
+        pango_layout_set_tabs(pLayout, pTabs);
+        pango_tab_array_free(pTabs);
+    }
+    pango_layout_set_spacing(pLayout, (int)(m_FontStyle.getLineSpacing()*PANGO_SCALE));
+    return pLayout;
+}
+
+string WordsNode::getLayoutKey() const
+{
+    // Everything that influences the layout. Color, gamma and hinting don't: the
+    // first two are applied at render time, and there is a glyph cache per hint mode.
+    stringstream ss;
+    char* pszFontDesc = pango_font_description_to_string(m_pFontDescription);
+    ss << pszFontDesc << "|" << m_bParsedText << "|" << m_FontStyle.getWrapModeVal()
+            << "|" << m_FontStyle.getAlignmentVal() << "|" << m_FontStyle.getJustify()
+            << "|" << getUserSize().x << "|" << m_FontStyle.getIndent()
+            << "|" << m_FontStyle.getLineSpacing() << "|"
+            << m_FontStyle.getLetterSpacing() << "|" << m_sText;
+    g_free(pszFontDesc);
+    return ss.str();
+}
+
 static ProfilingZoneID RenderTextProfilingZone("WordsNode: render text");
 
 void WordsNode::renderText()
@@ -629,34 +687,20 @@ void WordsNode::renderText()
     if (!(getState() == NS_CANRENDER)) {
         return;
     }
+    if (m_sText.length() != 0 && !m_pTextLayout) {
+        // Layout was dropped on disconnect.
+        updateLayout();
+    }
     if (m_bRenderNeeded) {
         if (m_sText.length() != 0) {
             ScopeTimer timer(RenderTextProfilingZone);
-            TextEngine& engine = TextEngine::get(m_FontStyle.getHint());
-            PangoContext* pContext = engine.getPangoContext();
-            pango_context_set_font_description(pContext, m_pFontDescription);
             int maxTexSize = GLContext::getCurrent()->getMaxTexSize();
             if (m_InkSize.x > maxTexSize || m_InkSize.y > maxTexSize) {
                 throw Exception(AVG_ERR_UNSUPPORTED,
                         "WordsNode size exceeded maximum (Size="
                         + toString(m_InkSize) + ", max=" + toString(maxTexSize) + ")");
             }
-
-            BitmapPtr pBmp(new Bitmap(m_InkSize, A8));
-            FilterFill<unsigned char>(0).applyInPlace(pBmp);
-            FT_Bitmap bitmap;
-            bitmap.rows = m_InkSize.y;
-            bitmap.width = m_InkSize.x;
-            unsigned char * pLines = pBmp->getPixels();
-            bitmap.pitch = pBmp->getStride();
-            bitmap.buffer = pLines;
-            bitmap.num_grays = 256;
-            bitmap.pixel_mode = ft_pixel_mode_grays;
-
-            PangoRectangle logical_rect;
-            PangoRectangle ink_rect;
-            pango_layout_get_pixel_extents(m_pLayout, &ink_rect, &logical_rect);
-            pango_ft2_render_layout(&bitmap, m_pLayout, -ink_rect.x, -ink_rect.y);
+            const PangoRectangle& logical_rect = m_pTextLayout->getLogicalRect();
             switch (m_FontStyle.getAlignmentVal()) {
                 case PANGO_ALIGN_LEFT:
                     m_AlignOffset = 0;
@@ -670,22 +714,70 @@ void WordsNode::renderText()
                 default:
                     AVG_ASSERT(false);
             }
+            notifyHitBoundsChanged();
             setRenderColor(m_FontStyle.getColor());
 
-            GLContextManager* pCM = GLContextManager::get();
-            MCTexturePtr pTex = pCM->createTextureFromBmp(pBmp);
-            getSurface()->create(A8, pTex);
+            m_pAtlasRegion = TextureAtlasRegionPtr();
+            m_bGlyphMode = false;
+            if (s_bGlyphRendering && !hasMask() && !hasEffect()) {
+                if (!m_pTextLayout->hasGlyphs()) {
+                    TextEngine& engine = TextEngine::get(m_FontStyle.getHint());
+                    engine.getGlyphCache().calcGlyphs(m_pTextLayout);
+                }
+                m_bGlyphMode = m_pTextLayout->canUseGlyphs();
+            }
+            if (m_bGlyphMode) {
+                getSurface()->create(A8, m_pTextLayout->getGlyphTex());
+            } else {
+                renderBmp();
+            }
             newSurface();
         }
         m_bRenderNeeded = false;
     }
 }
 
+void WordsNode::renderBmp()
+{
+    TextEngine& engine = TextEngine::get(m_FontStyle.getHint());
+    PangoContext* pContext = engine.getPangoContext();
+    pango_context_set_font_description(pContext, m_pFontDescription);
+
+    BitmapPtr pBmp(new Bitmap(m_InkSize, A8));
+    FilterFill<unsigned char>(0).applyInPlace(pBmp);
+    FT_Bitmap bitmap;
+    bitmap.rows = m_InkSize.y;
+    bitmap.width = m_InkSize.x;
+    unsigned char * pLines = pBmp->getPixels();
+    bitmap.pitch = pBmp->getStride();
+    bitmap.buffer = pLines;
+    bitmap.num_grays = 256;
+    bitmap.pixel_mode = ft_pixel_mode_grays;
+
+    const PangoRectangle& ink_rect = m_pTextLayout->getInkRect();
+    pango_ft2_render_layout(&bitmap, m_pLayout, -ink_rect.x, -ink_rect.y);
+
+    TextureAtlas* pAtlas = TextureAtlas::get();
+    if (pAtlas->canAdd(m_InkSize, A8)) {
+        m_pAtlasRegion = pAtlas->add(pBmp);
+        getSurface()->create(A8, m_pAtlasRegion->getTex());
+        getSurface()->setTexRect(m_pAtlasRegion->getRect());
+    } else {
+        GLContextManager* pCM = GLContextManager::get();
+        MCTexturePtr pTex = pCM->createTextureFromBmp(pBmp);
+        getSurface()->create(A8, pTex);
+    }
+}
+
 void WordsNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
         float parentEffectiveOpacity)
 {
     AreaNode::preRender(pVA, bIsParentActive, parentEffectiveOpacity);
     if (isVisible()) {
+        if (m_bGlyphMode && (hasMask() || hasEffect())) {
+            // Masks and effects need the text in a single texture.
+            m_bRenderNeeded = true;
+        }
         renderText();
         if (hasMask()) {
             calcMaskCoords();
@@ -703,6 +795,10 @@ void WordsNode::render(GLContext* pContext, const glm::mat4& transform)
 {
     ScopeTimer timer(RenderProfilingZone);
     if (m_sText.length() != 0 && isVisible()) {
+        if (m_bGlyphMode) {
+            renderVertices(pContext, transform, m_GlyphSubVA);
+            return;
+        }
         IntPoint offset = m_InkOffset + IntPoint(m_AlignOffset, 0);
         glm::mat4 totalTransform;
         if (offset == IntPoint(0,0)) {
@@ -714,6 +810,44 @@ void WordsNode::render(GLContext* pContext, const glm::mat4& transform)
     }
 }
 
+void WordsNode::appendVertices(const VertexArrayPtr& pVA)
+{
+    if (!m_bGlyphMode) {
+        RasterNode::appendVertices(pVA);
+        return;
+    }
+    // One quad per glyph, in the coordinate system of the node.
+    pVA->startSubVA(m_GlyphSubVA);
+    const PangoRectangle& logicalRect = m_pTextLayout->getLogicalRect();
+    glm::vec2 offset(m_AlignOffset-logicalRect.x, -logicalRect.y);
+    glm::vec2 texSize(m_pTextLayout->getGlyphTex()->getGLSize());
+    Pixel32 color = m_FontStyle.getColor();
+    const vector<PositionedGlyph>& glyphs = m_pTextLayout->getGlyphs();
+    for (unsigned i = 0; i < glyphs.size(); ++i) {
+        const IntRect& texRect = glyphs[i].m_pGlyph->m_pRegion->getRect();
+        glm::vec2 tl = glm::vec2(glyphs[i].m_Pos) + offset;
+        glm::vec2 br = tl + glm::vec2(texRect.size());
+        glm::vec2 texTL = glm::vec2(texRect.tl)/texSize;
+        glm::vec2 texBR = glm::vec2(texRect.br)/texSize;
+        int curVertex = m_GlyphSubVA.getNumVerts();
+        m_GlyphSubVA.appendPos(tl, texTL, color);
+        m_GlyphSubVA.appendPos(glm::vec2(br.x, tl.y), glm::vec2(texBR.x, texTL.y), color);
+        m_GlyphSubVA.appendPos(br, texBR, color);
+        m_GlyphSubVA.appendPos(glm::vec2(tl.x, br.y), glm::vec2(texTL.x, texBR.y), color);
+        m_GlyphSubVA.appendQuadIndexes(curVertex+1, curVertex, curVertex+2, curVertex+3);
+    }
+}
+
+bool WordsNode::getBatchDestRect(FRect& destRect)
+{
+    if (m_sText.length() == 0 || m_bGlyphMode) {
+        return false;
+    }
+    glm::vec2 offset = glm::vec2(m_InkOffset + IntPoint(m_AlignOffset, 0));
+    destRect = FRect(offset, offset + glm::vec2(getSurface()->getSize()));
+    return true;
+}
+
 IntPoint WordsNode::getMediaSize()
 {
     return m_LogicalSize;
@@ -25,7 +25,9 @@
 #include "../api.h"
 #include "RasterNode.h"
 #include "FontStyle.h"
+#include "GlyphCache.h"
 #include "../base/UTF8String.h"
+#include "../graphics/TextureAtlas.h"
 
 #include <pango/pango.h>
 
@@ -117,11 +119,23 @@ class AVG_API WordsNode : public RasterNode
                 const std::string& sFontName);
         static void addFontDir(const std::string& sDir);
 
+        // If enabled, texts are assembled from cached glyphs where possible instead of
+        // being rendered into a bitmap.
+        static void enableGlyphRendering(bool bEnable);
+        static bool isGlyphRenderingEnabled();
+
+    protected:
+        virtual void appendVertices(const VertexArrayPtr& pVA);
+        virtual bool getBatchDestRect(FRect& destRect);
+
     private:
         virtual void calcMaskCoords();
         void updateFont();
         void updateLayout();
+        PangoLayout* createLayout();
+        std::string getLayoutKey() const;
         void renderText();
+        void renderBmp();
         void parseString(PangoAttrList** ppAttrList, char** ppText);
         void setParsedText(const UTF8String& sText);
         UTF8String applyBR(const UTF8String& sText);
@@ -141,8 +155,14 @@ class AVG_API WordsNode : public RasterNode
         int m_AlignOffset;
         PangoFontDescription * m_pFontDescription;
         PangoLayout * m_pLayout;
+        TextureAtlasRegionPtr m_pAtlasRegion;
+        TextLayoutPtr m_pTextLayout;
+        bool m_bGlyphMode;
+        SubVertexArray m_GlyphSubVA;
 
         bool m_bRenderNeeded;
+
+        static bool s_bGlyphRendering;
 };
 
 }
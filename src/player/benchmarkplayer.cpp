@@ -0,0 +1,137 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "Player.h"
+#include "DivNode.h"
+
+#include "../base/TimeSource.h"
+#include "../base/StringHelper.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace avg;
+using namespace std;
+
+static const glm::vec2 SCENE_SIZE(1280, 800);
+
+// Hit tests M cursor positions against a div with N children, with and without
+// spatial index. Every run also moves one child so incremental updates of the
+// index are part of the measurement.
+class HitTestPerfTest {
+public:
+    HitTestPerfTest(Player& player, int numNodes, int numCursors, bool bSpatialIndex)
+        : m_NumNodes(numNodes),
+          m_CurNode(0),
+          m_NumHits(0)
+    {
+        stringstream ss;
+        ss << "HitTestPerfTest (" << numNodes << " nodes, " << numCursors
+                << " cursors, spatialindex=" << bSpatialIndex << ")";
+        m_sName = ss.str();
+
+        srand(42);
+        int nodesPerRow = max(1, int(sqrt(float(numNodes))));
+        glm::vec2 nodeSize = SCENE_SIZE/float(nodesPerRow);
+        stringstream xml;
+        xml << "<?xml version=\"1.0\"?>"
+            << "<avg width=\"" << SCENE_SIZE.x << "\" height=\"" << SCENE_SIZE.y
+            << "\"><div id=\"container\" spatialindex=\""
+            << (bSpatialIndex ? "True" : "False") << "\">";
+        for (int i = 0; i < numNodes; ++i) {
+            glm::vec2 pos(float(i%nodesPerRow)*nodeSize.x,
+                    float(i/nodesPerRow)*nodeSize.y);
+            float angle = (i%7 == 0) ? 0.3f : 0.f;
+            xml << "<div pos=\"(" << pos.x << "," << pos.y << ")\" size=\"("
+                    << nodeSize.x*0.9f << "," << nodeSize.y*0.9f << ")\" angle=\""
+                    << angle << "\"/>";
+        }
+        xml << "</div></avg>";
+        player.loadString(xml.str());
+        m_pContainer = boost::dynamic_pointer_cast<DivNode>(
+                player.getElementByID("container"));
+
+        for (int i = 0; i < numCursors; ++i) {
+            m_CursorPositions.push_back(glm::vec2(
+                    SCENE_SIZE.x*(rand()/float(RAND_MAX)),
+                    SCENE_SIZE.y*(rand()/float(RAND_MAX))));
+        }
+    }
+
+    const string& getName() const
+    {
+        return m_sName;
+    }
+
+    int getNumHitTests() const
+    {
+        return int(m_CursorPositions.size());
+    }
+
+    void run()
+    {
+        AreaNodePtr pNode = boost::dynamic_pointer_cast<AreaNode>(
+                m_pContainer->getChild(m_CurNode));
+        pNode->setPos(pNode->getPos()+glm::vec2(0.5f, 0));
+        m_CurNode = (m_CurNode+1) % m_NumNodes;
+        for (unsigned i = 0; i < m_CursorPositions.size(); ++i) {
+            if (m_pContainer->getElementByPos(m_CursorPositions[i])) {
+                m_NumHits++;
+            }
+        }
+    }
+
+private:
+    string m_sName;
+    int m_NumNodes;
+    DivNodePtr m_pContainer;
+    vector<glm::vec2> m_CursorPositions;
+    int m_CurNode;
+    int m_NumHits;
+};
+
+void runHitTestPerfTest(Player& player, int numNodes, int numCursors, int numRuns)
+{
+    for (int i = 0; i < 2; ++i) {
+        HitTestPerfTest perfTest(player, numNodes, numCursors, i == 1);
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        for (int j = 0; j < numRuns; ++j) {
+            perfTest.run();
+        }
+        float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+        cerr << perfTest.getName() << ": " << activeTime/numRuns << " ms, "
+                << activeTime*1000/(numRuns*perfTest.getNumHitTests())
+                << " us per hit test" << endl;
+    }
+}
+
+int main(int nargs, char** args)
+{
+    Player player;
+    player.disablePython();
+    int nodeCounts[] = {10, 100, 1000, 10000};
+    for (int i = 0; i < 4; ++i) {
+        runHitTestPerfTest(player, nodeCounts[i], 10, 200);
+    }
+    runHitTestPerfTest(player, 1000, 100, 100);
+}
@@ -23,6 +23,9 @@
 from libavg import avg, player
 from libavg.testcase import *
 
+import tempfile
+import time
+
 class AVTestCase(AVGTestCase):
     def __init__(self, testFuncName):
         AVGTestCase.__init__(self, testFuncName)
@@ -155,6 +158,44 @@ class AVTestCase(AVGTestCase):
                 sys.stderr.write("    threaded: "+str(isThreaded)+"\n")
                 testVideoFile(filename, isThreaded)
 
+    def testVideoDecoderStats(self):
+        def checkStats():
+            stats = node.getDecoderStats()
+            self.assert_(stats["framesDecoded"] > 0)
+            # Planar frames are uploaded straight from the decoder's buffers.
+            self.assertEqual(stats["bytesCopied"], 0)
+            self.assertEqual(stats["bytesCopiedPerFrame"], 0)
+
+        for isThreaded in [False, True]:
+            root = self.loadEmptyScene()
+            node = avg.VideoNode(href="mpeg1-48x48.mov", threaded=isThreaded,
+                    parent=root)
+            self.assertEqual(node.getDecoderStats()["framesDecoded"], 0)
+            node.play()
+            self.start(False,
+                    (None,
+                     None,
+                     checkStats,
+                    ))
+
+    def testMsgPoolStats(self):
+        def checkStats():
+            stats = player.getMsgPoolStats()
+            self.assertEqual(set(stats.keys()),
+                    set(["AudioMsg", "VideoMsg", "BitmapManagerMsg"]))
+            videoStats = stats["VideoMsg"]
+            self.assert_(videoStats["highWaterMark"] > 0)
+            self.assert_(videoStats["inUse"] <= videoStats["highWaterMark"])
+
+        root = self.loadEmptyScene()
+        node = avg.VideoNode(href="mpeg1-48x48.mov", threaded=True, parent=root)
+        node.play()
+        self.start(False,
+                (None,
+                 None,
+                 checkStats,
+                ))
+
     def testPlayBeforeConnect(self):
         node = avg.VideoNode(href="media/mpeg1-48x48.mov", threaded=False)
         node.play()
@@ -307,6 +348,46 @@ class AVTestCase(AVGTestCase):
                      lambda: self.compareImage("testVideoSeek3")
                     ))
 
+    def testVideoKeyframeSeek(self):
+        def seek(frame, preview):
+            videoNode.seekToFrame(frame, preview)
+            self.assert_(videoNode.isSeeking())
+
+        def checkCurFrame(frame):
+            self.assertEqual(videoNode.getCurFrame(), frame)
+            self.assert_(not(videoNode.isSeeking()))
+
+        def checkPreviewFrame():
+            # Preview seeks stop at the keyframe before the destination.
+            self.assert_(videoNode.getCurFrame() <= 20)
+            self.assert_(not(videoNode.isSeeking()))
+
+        indexFile = os.path.join(tempfile.gettempdir(), "avgtestkeyframeindex.txt")
+        if os.path.exists(indexFile):
+            os.remove(indexFile)
+        player.setFakeFPS(25)
+        for isThreaded in [False, True]:
+            root = self.loadEmptyScene()
+            videoNode = avg.VideoNode(href="mpeg1-48x48.mov", threaded=isThreaded,
+                    keyframeindex=True, keyframeindexfile=indexFile, parent=root)
+            self.assert_(videoNode.keyframeindex)
+            self.assertEqual(videoNode.keyframeindexfile, indexFile)
+            videoNode.play()
+            videoNode.pause()
+            self.start(False,
+                    (lambda: self.assert_(os.path.exists(indexFile)),
+                     lambda: seek(20, False),
+                     None,
+                     lambda: checkCurFrame(20),
+                     lambda: seek(5, False),
+                     None,
+                     lambda: checkCurFrame(5),
+                     lambda: seek(20, True),
+                     None,
+                     checkPreviewFrame,
+                    ))
+        os.remove(indexFile)
+
     def testVideoFPS(self):
         player.setFakeFPS(25)
         root = self.loadEmptyScene()
@@ -329,7 +410,8 @@ class AVTestCase(AVGTestCase):
                     self.compareImage("testVideoLoop")
                 player.stop()
 
-        for audio, threaded in [(False, False), (False, True), (True, True)]:
+        for audio, threaded, preload in [(False, False, False), (False, True, False),
+                (False, False, True), (True, True, False)]:
             self.eof = False
             if audio:
                 player.setFakeFPS(-1)
@@ -341,12 +423,79 @@ class AVTestCase(AVGTestCase):
                         href="48kHz_16bit_mono.wav")
             else:
                 node = avg.VideoNode(parent=root, loop=True, fps=25, size=(96,96),
-                    threaded=threaded, href="mpeg1-48x48.mov")
+                    threaded=threaded, preload=preload, href="mpeg1-48x48.mov")
             node.subscribe(avg.Node.END_OF_FILE, onEOF)
             node.play()
             player.subscribe(player.ON_FRAME, onFrame)
             player.play()
 
+    def testVideoPreload(self):
+        def checkPreloaded():
+            self.assert_(node1.preload)
+            self.memUsed = player.imageCache.getExternalMemUsed()
+            self.assert_(self.memUsed > 0)
+
+        def addSecondVideo():
+            node2 = avg.VideoNode(parent=root, loop=True, preload=True,
+                    href="mpeg1-48x48.mov")
+            node2.play()
+
+        def checkShared():
+            self.assertEqual(player.imageCache.getExternalMemUsed(), self.memUsed)
+
+        def seek(frame):
+            node1.seekToFrame(frame)
+
+        player.setFakeFPS(25)
+        root = self.loadEmptyScene()
+        node1 = avg.VideoNode(parent=root, loop=True, preload=True,
+                href="mpeg1-48x48.mov")
+        node1.play()
+        # The clip is decoded while the video plays. It is complete after one loop at
+        # the latest.
+        self.start(False,
+                ([None]*31,
+                 checkPreloaded,
+                 addSecondVideo,
+                 None,
+                 checkShared,
+                 lambda: seek(20),
+                 lambda: self.assertEqual(node1.getCurFrame(), 20),
+                 lambda: seek(5),
+                 lambda: self.assertEqual(node1.getCurFrame(), 5),
+                ))
+
+    def testVideoPreloadFullImageCache(self):
+        # Unused images in the image cache must make room for preloaded clips.
+        def fillImageCache():
+            for href in ("spritesheet.png", "checker.png"):
+                node = avg.ImageNode(href=href, parent=root)
+                node.unlink(True)
+            memUsed = cache.getMemUsed()[0]
+            self.assert_(memUsed > 0)
+            cache.capacity = (memUsed+cache.getExternalMemUsed(), oldCapacity[1])
+
+        def preloadVideo():
+            self.memUsed = cache.getExternalMemUsed()
+            self.node = avg.VideoNode(parent=root, loop=True, preload=True,
+                    href="mpeg1-48x48-sound.avi")
+            self.node.play()
+
+        def checkPreloaded():
+            self.assert_(cache.getExternalMemUsed() > self.memUsed)
+            cache.capacity = oldCapacity
+
+        player.setFakeFPS(25)
+        cache = player.imageCache
+        oldCapacity = cache.capacity
+        root = self.loadEmptyScene()
+        self.start(False,
+                (fillImageCache,
+                 preloadVideo,
+                 [None]*31,
+                 checkPreloaded,
+                ))
+
     def testVideoMask(self):
         def testWithFile(filename, testImgName):
             def setMask(href):
@@ -655,6 +804,55 @@ class AVTestCase(AVGTestCase):
                 [lambda: self.compareImage("test2VideosAtOnce1"),])
 
 
+    def testFakeCamera(self):
+        def createCamera(bThreaded):
+            self.camera = avg.CameraNode(driver="fake", pixelformat="BAYER8_GBRG",
+                    framerate=100, capturewidth=64, captureheight=48,
+                    threaded=bThreaded, parent=root)
+            self.assertEqual(self.camera.threaded, bThreaded)
+            self.assert_(not(self.camera.isAvailable()))
+            self.camera.play()
+
+        def waitForFrames():
+            time.sleep(0.05)
+
+        def checkFrames():
+            self.assert_(self.camera.framenum > 0)
+            self.assertEqual(self.camera.getBitmap().getSize(), (64,48))
+
+        def checkFeatures():
+            # Values set must be readable immediately, even if the capture thread
+            # hasn't applied them yet.
+            self.camera.brightness = 5
+            self.assertEqual(self.camera.brightness, 5)
+            self.camera.gain = 7
+            self.assertEqual(self.camera.gain, 7)
+            self.camera.setWhitebalance(3, 4)
+            self.assertEqual(self.camera.getWhitebalanceU(), 3)
+            self.assertEqual(self.camera.getWhitebalanceV(), 4)
+
+        def deleteCamera():
+            self.camera.unlink(True)
+            self.camera = None
+
+        root = self.loadEmptyScene()
+        self.assert_(not(avg.CameraNode(driver="fake").threaded))
+        self.start(False,
+                (lambda: createCamera(True),
+                 waitForFrames,
+                 None,
+                 checkFrames,
+                 checkFeatures,
+                 deleteCamera,
+                 lambda: createCamera(False),
+                 waitForFrames,
+                 None,
+                 checkFrames,
+                 checkFeatures,
+                 deleteCamera,
+                ))
+
+
 def AVTestSuite(tests):
     availableTests = [
             "testSound",
@@ -664,20 +862,26 @@ def AVTestSuite(tests):
             "testSoundEOF",
             "testVideoInfo",
             "testVideoFiles",
+            "testVideoDecoderStats",
+            "testMsgPoolStats",
             "testPlayBeforeConnect",
             "testVideoState",
             "testVideoActive",
             "testVideoHRef",
             "testVideoOpacity",
             "testVideoSeek",
+            "testVideoKeyframeSeek",
             "testVideoFPS",
             "testLoop",
+            "testVideoPreload",
+            "testVideoPreloadFullImageCache",
             "testVideoMask",
             "testVideoEOF",
             "testVideoSeekAfterEOF",
             "testException",
             "testVideoWriter",
             "test2VideosAtOnce",
+            "testFakeCamera",
             ]
     return createAVGTestSuite(availableTests, AVTestCase, tests)
 
@@ -510,6 +510,48 @@ class AnimTestCase(AVGTestCase):
         genericObject3 = None
 
 
+    def testOverriddenAttrAnim(self):
+        # Animations set attributes of libavg nodes directly in C++. Attributes that
+        # are replaced in python subclasses must still go through python.
+        class SizeCountingNode(avg.DivNode):
+            def __init__(self, parent=None, **kwargs):
+                avg.DivNode.__init__(self, **kwargs)
+                self.registerInstance(self, parent)
+                self.numSizeChanges = 0
+
+            def getSize(self):
+                return avg.DivNode.size.__get__(self)
+
+            def setSize(self, size):
+                self.numSizeChanges += 1
+                avg.DivNode.size.__set__(self, size)
+            size = property(getSize, setSize)
+
+        def checkMidway():
+            self.assert_(countingNode.numSizeChanges > 0)
+            self.assertEqual(countingNode.size, plainNode.size)
+            self.assert_(0 < plainNode.size.x < 100)
+            self.assertAlmostEqual(1-plainNode.opacity, plainNode.size.x/100, places=4)
+
+        root = self.loadEmptyScene()
+        player.setFakeFPS(10)
+        countingNode = SizeCountingNode(parent=root)
+        plainNode = avg.DivNode(parent=root)
+        anims = [
+                avg.LinearAnim(countingNode, "size", 1000, (0,0), (100,200)),
+                avg.LinearAnim(plainNode, "size", 1000, (0,0), (100,200)),
+                avg.LinearAnim(plainNode, "opacity", 1000, 1, 0),
+                ]
+        self.start(False,
+                (lambda: [anim.start() for anim in anims],
+                 lambda: self.delay(400),
+                 checkMidway,
+                 lambda: self.delay(600),
+                 lambda: self.assertEqual(countingNode.size, (100,200)),
+                 lambda: self.assertEqual(plainNode.size, (100,200)),
+                 lambda: self.assertEqual(plainNode.opacity, 0),
+                ))
+
     def _testPointAnim(self, startPos, endPos, keepAttrPos, startPosImgSrc, endPosImgSrc,
             keepAttrPosImgSrc):
         def startAnim():
@@ -554,7 +596,8 @@ def animTestSuite(tests):
         "testParallelAnimRegistry",
         "testStateAnim",
         "testStateAnimRegistry",
-        "testNonNodeAttrAnim"
+        "testNonNodeAttrAnim",
+        "testOverriddenAttrAnim"
         )
     return createAVGTestSuite(availableTests, AnimTestCase, tests)
 
@@ -1006,6 +1006,51 @@ class EventTestCase(AVGTestCase):
         # The order of callbacks is unspecified, so onContact2 might be called once.
         self.assert_(self.numContact2Callbacks <= 1)
 
+    def testEventBatching(self):
+        def onMotion(event):
+            self.motionEvents.append((event.cursorid, event.pos))
+
+        def checkMotion(expected):
+            self.assertEqual(self.motionEvents, expected)
+            self.motionEvents = []
+
+        root = self.loadEmptyScene()
+        img1 = avg.ImageNode(pos=(0,0), href="rgb24-65x65.png", parent=root)
+        img1Tester = NodeHandlerTester(self, img1)
+        img2 = avg.ImageNode(pos=(80,0), href="rgb24-65x65.png", parent=root)
+        img2Tester = NodeHandlerTester(self, img2)
+        root.subscribe(avg.Node.CURSOR_MOTION, onMotion)
+        self.motionEvents = []
+        player.enableEventBatching(True)
+        self.assert_(player.isEventBatchingEnabled())
+        self.start(False,
+                (lambda: self._sendTouchEvents((
+                        (1, avg.Event.CURSOR_DOWN, 10, 10),
+                        (2, avg.Event.CURSOR_DOWN, 90, 10))),
+                 lambda: img1Tester.assertState(
+                        (avg.Node.CURSOR_DOWN, avg.Node.CURSOR_OVER)),
+                 lambda: img2Tester.assertState(
+                        (avg.Node.CURSOR_DOWN, avg.Node.CURSOR_OVER)),
+                 # Only the last motion event of cursor 1 is delivered.
+                 lambda: self._sendTouchEvents((
+                        (1, avg.Event.CURSOR_MOTION, 20, 10),
+                        (1, avg.Event.CURSOR_MOTION, 70, 10),
+                        (2, avg.Event.CURSOR_MOTION, 100, 10),
+                        (1, avg.Event.CURSOR_MOTION, 85, 10))),
+                 lambda: checkMotion([(2, avg.Point2D(100,10)), 
+                        (1, avg.Point2D(85,10))]),
+                 lambda: img1Tester.assertState((avg.Node.CURSOR_OUT,)),
+                 lambda: img2Tester.assertState(
+                        (avg.Node.CURSOR_MOTION, avg.Node.CURSOR_OVER)),
+                 lambda: self._sendTouchEvents((
+                        (1, avg.Event.CURSOR_UP, 85, 10),
+                        (2, avg.Event.CURSOR_UP, 100, 10))),
+                 lambda: img1Tester.assertState(()),
+                 lambda: img2Tester.assertState(
+                        (avg.Node.CURSOR_UP, avg.Node.CURSOR_OUT)),
+                ))
+        player.enableEventBatching(False)
+
     def testPlaybackMessages(self):
 
         self.loadEmptyScene()
@@ -1149,6 +1194,7 @@ def eventTestSuite(tests):
             "testContacts",
             "testContactRegistration",
             "testMultiContactRegistration",
+            "testEventBatching",
             "testPlaybackMessages",
             "testImageSizeChanged",
             "testWordsSizeChanged",
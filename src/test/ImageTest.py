@@ -164,6 +164,127 @@ class ImageTestCase(AVGTestCase):
         self.assert_(cache.getMemUsed() == (0,0))
         cache.capacity = oldCapacity
 
+    def testImageCachePolicy(self):
+        def getNumCPUImages():
+            return cache.getNumImages()[0]
+
+        cache = player.imageCache
+        oldCapacity = cache.capacity
+        self.assertEqual(cache.policy, "lru")
+        for policy in ("lfu", "greedydual", "lru"):
+            cache.policy = policy
+            self.assertEqual(cache.policy, policy)
+        self.assertRaises(RuntimeError, lambda: setattr(cache, "policy", "fifo"))
+
+        root = self.loadEmptyScene()
+        cache.capacity = (0, 0)
+        oldStats = cache.getStats()
+        cache.pinImage("rgb24-64x64.png")
+        self.assert_(cache.isPinned("rgb24-64x64.png"))
+        self.assert_(not cache.isPinned("rgb24-64x64.png", texcompression="B5G6R5"))
+        for i in range(2):
+            node = avg.ImageNode(href="rgb24-64x64.png", parent=root)
+            node.unlink(True)
+            self.assertEqual(getNumCPUImages(), 1)
+        cache.unpinImage("rgb24-64x64.png")
+        self.assertEqual(getNumCPUImages(), 0)
+        stats = cache.getStats()
+        self.assertEqual(stats["cpu"]["hits"]-oldStats["cpu"]["hits"], 1)
+        self.assertEqual(stats["cpu"]["misses"]-oldStats["cpu"]["misses"], 1)
+        self.assertEqual(stats["cpu"]["evictions"]-oldStats["cpu"]["evictions"], 1)
+
+        # Pin an image that is resolved through a div's media directory.
+        div = avg.DivNode(mediadir="incompleteSkinMedia", parent=root)
+        cache.pinImage("scrollbar_horiz_track.png", parent=div)
+        self.assert_(cache.isPinned("scrollbar_horiz_track.png", parent=div))
+        self.assert_(not cache.isPinned("scrollbar_horiz_track.png"))
+        node = avg.ImageNode(href="scrollbar_horiz_track.png", parent=div)
+        node.unlink(True)
+        self.assertEqual(getNumCPUImages(), 1)
+        cache.unpinImage("scrollbar_horiz_track.png", parent=div)
+        self.assertEqual(getNumCPUImages(), 0)
+        cache.capacity = oldCapacity
+
+    def testImageDecodeSize(self):
+        root = self.loadEmptyScene()
+        node = avg.ImageNode(href="rgb24-64x64.png", decodesize=(32,0), parent=root)
+        self.assertEqual(node.getMediaSize(), (32,32))
+        self.assertEqual(node.getBitmap().getSize(), (32,32))
+        fullNode = avg.ImageNode(href="rgb24-64x64.png", parent=root)
+        self.assertEqual(fullNode.getMediaSize(), (64,64))
+        node.decodesize = (16,8)
+        self.assertEqual(node.getMediaSize(), (16,8))
+        node.decodesize = (0,0)
+        self.assertEqual(node.getMediaSize(), (64,64))
+
+    def testImageDiskCache(self):
+        def loadImage():
+            # Evict the image from the in-memory cache first.
+            cache.capacity = (0, 0)
+            cache.capacity = oldCapacity
+            node = avg.ImageNode(href="rgb24-65x65.png", parent=root)
+            self.compareBitmapToFile(node.getBitmap(), "rgb24-65x65")
+            node.unlink(True)
+
+        import tempfile
+        import shutil
+        cache = player.imageCache
+        oldCapacity = cache.capacity
+        cacheDir = tempfile.mkdtemp()
+        root = self.loadEmptyScene()
+        cache.diskCacheDir = cacheDir
+        self.assertEqual(cache.diskCacheDir, cacheDir)
+        loadImage()
+        self.assertEqual(cache.getDiskCacheStats(), (0,1))
+        loadImage()
+        self.assertEqual(cache.getDiskCacheStats(), (1,1))
+        cache.diskCacheDir = ""
+        self.assertEqual(cache.diskCacheDir, "")
+        shutil.rmtree(cacheDir)
+
+    def testImageAsync(self):
+        def onLoaded(node):
+            self.assert_(not node.loading)
+            self.assertEqual(node.getMediaSize(), (65,65))
+            loadedNodes.append(node)
+            if len(loadedNodes) == 2:
+                player.stop()
+
+        def loadImages():
+            # Evict the image from the cache so it has to be decoded.
+            cache.capacity = (0, 0)
+            cache.capacity = oldCapacity
+            for i in range(2):
+                node = avg.ImageNode(href="rgb24-65x65.png", async=True,
+                        placeholder="rgb24-32x32.png", parent=root)
+                self.assert_(node.loading)
+                self.assertEqual(node.getMediaSize(), (32,32))
+                node.subscribe(node.LOADED, lambda node=node: onLoaded(node))
+            cancelledNode = avg.ImageNode(href="rgb24-64x32.png", async=True,
+                    parent=root)
+            self.assertEqual(cancelledNode.getMediaSize(), (0,0))
+            cancelledNode.subscribe(cancelledNode.LOADED,
+                    lambda: self.fail("LOADED sent after href change"))
+            cancelledNode.href = ""
+            self.assert_(not cancelledNode.loading)
+
+        cache = player.imageCache
+        oldCapacity = cache.capacity
+        bitmapManager = avg.BitmapManager.get()
+        oldStats = bitmapManager.getStats()
+        loadedNodes = []
+        root = self.loadEmptyScene()
+        player.setTimeout(0, loadImages)
+        player.setTimeout(5000, lambda: self.fail("Image wasn't loaded"))
+        player.play()
+        stats = bitmapManager.getStats()
+        self.assertEqual(stats["numCoalesced"]-oldStats["numCoalesced"], 1)
+        # Cached images are displayed immediately.
+        root = self.loadEmptyScene()
+        node = avg.ImageNode(href="rgb24-65x65.png", async=True, parent=root)
+        self.assert_(not node.loading)
+        self.assertEqual(node.getMediaSize(), (65,65))
+
     def testBitmap(self):
         def getBitmap(node):
             bmp = node.getBitmap()
@@ -229,6 +350,16 @@ class ImageTestCase(AVGTestCase):
             node = avg.ImageNode(pos=(128,0), size=(32,32), parent=root)
             node.setBitmap(destBmp)
 
+        def testResample():
+            srcBmp = avg.Bitmap('media/rgb24-65x65.png')
+            for filter in ("box", "bilinear", "mitchell", "lanczos"):
+                destBmp = srcBmp.getResampled((32,32), filter)
+                self.assertEqual(destBmp.getSize(), (32,32))
+            destBmp = srcBmp.getResampled(newsize=(130,130), filter="mitchell")
+            self.assertEqual(destBmp.getPixel((2,2)), (255,0,0,255))
+            self.assertRaises(avg.Exception,
+                    lambda: srcBmp.getResampled((32,32), "cubic"))
+
         def testUnicode():
             if self._isCurrentDirWriteable():
                 # Can't check unicode filenames into svn or the windows client breaks.
@@ -285,6 +416,7 @@ class ImageTestCase(AVGTestCase):
                  testGetPixel,
                  lambda: self.assertRaises(avg.Exception, setNullBitmap),
                  testSubBitmap,
+                 testResample,
                 ))
 
     def testBitmapManager(self):
@@ -347,6 +479,49 @@ class ImageTestCase(AVGTestCase):
             player.play()
         avg.BitmapManager.get().setNumThreads(1)
         
+    def testBitmapManagerPriority(self):
+        def onLoaded(name, bmp):
+            self.assert_(not isinstance(bmp, Exception))
+            loadOrder.append(name)
+            if len(loadOrder) == 6:
+                player.stop()
+
+        def loadBitmaps():
+            for i, pf in enumerate((avg.B8G8R8A8, avg.B8G8R8X8, avg.R8G8B8A8, 
+                    avg.R8G8B8X8)):
+                bitmapManager.loadBitmap("media/rgb24alpha-64x64.png",
+                        lambda bmp, i=i: onLoaded("background"+str(i), bmp),
+                        pf, avg.LOADPRIORITY_BACKGROUND)
+            # Requests for the same file and format are decoded once.
+            bitmapManager.loadBitmap("media/rgb24-65x65.png",
+                    lambda bmp: onLoaded("visible", bmp))
+            bitmapManager.loadBitmap("media/rgb24-65x65.png",
+                    lambda bmp: onLoaded("coalesced", bmp))
+            handle = bitmapManager.loadBitmap("media/rgb24-64x64.png",
+                    lambda bmp: self.fail("Callback of cancelled request invoked"),
+                    avg.NO_PIXELFORMAT, avg.LOADPRIORITY_PREFETCH)
+            self.assert_(bitmapManager.cancelRequest(handle))
+            self.assert_(not bitmapManager.cancelRequest(handle))
+            self.assertEqual(bitmapManager.getNumPendingRequests(), 6)
+
+        bitmapManager = avg.BitmapManager.get()
+        oldStats = bitmapManager.getStats()
+        loadOrder = []
+        self.loadEmptyScene()
+        player.setFakeFPS(-1)
+        player.setTimeout(0, loadBitmaps)
+        player.setTimeout(5000, lambda: self.fail("BitmapManager didn't reply"))
+        player.play()
+        # The thread might already be decoding background bitmaps when the visible one
+        # is requested, but it can't have gotten to all of them.
+        self.assert_(loadOrder.index("visible") < loadOrder.index("background3"))
+        stats = bitmapManager.getStats()
+        self.assertEqual(stats["numRequests"]-oldStats["numRequests"], 7)
+        self.assertEqual(stats["numCoalesced"]-oldStats["numCoalesced"], 1)
+        self.assertEqual(stats["numCancelled"]-oldStats["numCancelled"], 1)
+        self.assertEqual(stats["queueDepth"], 0)
+        self.assertEqual(bitmapManager.getNumPendingRequests(), 0)
+
     def testBitmapManagerException(self):
         def bitmapCb(bitmap):
             raise RuntimeError
@@ -577,8 +752,13 @@ def imageTestSuite(tests):
             "testImagePos",
             "testImageSize",
             "testImageCache",
+            "testImageCachePolicy",
+            "testImageDecodeSize",
+            "testImageDiskCache",
+            "testImageAsync",
             "testBitmap",
             "testBitmapManager",
+            "testBitmapManagerPriority",
             "testBitmapManagerException",
             "testBlendMode",
             "testImageMask",
@@ -293,6 +293,214 @@ class PlayerTestCase(AVGTestCase):
                  lambda: self.compareImage("testRotatePivot3"),
                 ))
 
+    def testSpatialIndex(self):
+        def checkHits(expected):
+            for pos, node in expected:
+                self.assertEqual(container.getElementByPos(pos), node)
+                container.spatialindex = False
+                self.assertEqual(container.getElementByPos(pos), node)
+                container.spatialindex = True
+
+        def moveNodes():
+            nodes[0].pos = (100, 50)
+            nodes[1].angle = math.pi/4
+            nodes[2].size = (8, 8)
+
+        def reorderNodes():
+            container.reorderChild(rect, 0)
+            nodes[0].pos = (0, 0)
+            nodes[3].unlink(True)
+
+        root = self.loadEmptyScene()
+        container = avg.DivNode(spatialindex=True, parent=root)
+        nodes = []
+        for i in range(30):
+            nodes.append(avg.DivNode(pos=((i%10)*16, (i/10)*16), size=(16,16), 
+                    parent=container))
+        rect = avg.RectNode(pos=(4,4), size=(4,4), parent=container)
+        unsized = avg.DivNode(parent=container)
+        innerNode = avg.DivNode(pos=(150,110), size=(8,8), parent=unsized)
+        self.assert_(container.spatialindex)
+        self.start(False,
+                (lambda: checkHits((((2,2), nodes[0]), ((5,5), rect), 
+                        ((20,4), nodes[1]), ((152,112), innerNode), 
+                        ((100,100), None))),
+                 moveNodes,
+                 lambda: checkHits((((2,2), None), ((102,52), nodes[0]), 
+                        ((24,-2), nodes[1]), ((17,1), None), ((34,4), nodes[2]),
+                        ((44,4), None))),
+                 reorderNodes,
+                 lambda: checkHits((((5,5), nodes[0]), ((102,52), None), 
+                        ((50,4), None), ((66,4), nodes[4]))),
+                ))
+
+    def testPartialVertexUploads(self):
+        def checkUnchanged():
+            stats = player.getMainCanvas().getVertexStats()
+            self.assertEqual(stats["numChanged"], 0)
+            self.assertEqual(stats["numBytesUploaded"], 0)
+            self.assert_(stats["numUnchanged"] > 0)
+
+        def checkChanged():
+            stats = player.getMainCanvas().getVertexStats()
+            self.assert_(stats["numChanged"] > 0)
+            self.assert_(stats["numChanged"] < stats["numUnchanged"])
+            self.assert_(stats["numBytesUploaded"] > 0)
+
+        def changeRect():
+            rects[5].fillcolor = "00FF00"
+
+        root = self.loadEmptyScene()
+        rects = []
+        for i in range(10):
+            rects.append(avg.RectNode(pos=(i*16, 0), size=(16,16), fillcolor="FF0000",
+                    fillopacity=1, parent=root))
+        self.start(False,
+                (None,
+                 None,
+                 checkUnchanged,
+                 changeRect,
+                 checkChanged,
+                 None,
+                 checkUnchanged,
+                ))
+
+    def testDrawBatching(self):
+        def renderUnbatched():
+            player.enableDrawBatching(False)
+
+        def checkUnbatched():
+            self.__unbatchedBmp = player.screenshot()
+            stats = player.getMainCanvas().getRenderStats()
+            self.__unbatchedDrawCalls = stats["drawCalls"]
+            self.assertEqual(stats["batches"], 0)
+            player.enableDrawBatching(True)
+
+        def checkBatched():
+            bmp = player.screenshot()
+            self.assert_(self.areSimilarBmps(bmp, self.__unbatchedBmp, 0.01, 0.01))
+            stats = player.getMainCanvas().getRenderStats()
+            self.assert_(stats["drawCalls"] < self.__unbatchedDrawCalls)
+            self.assert_(stats["batches"] > 0)
+            self.assert_(stats["batchedNodes"] > stats["batches"])
+            atlasStats = player.getTextureAtlasStats()
+            self.assert_(atlasStats["numRegions"] >= 3)
+            self.assert_(atlasStats["occupancy"] > 0)
+
+        def disableBatching():
+            player.enableDrawBatching(False)
+            self.assert_(not(player.isDrawBatchingEnabled()))
+
+        root = self.loadEmptyScene()
+        player.enableDrawBatching(True)
+        self.assert_(player.isDrawBatchingEnabled())
+        for i in range(10):
+            avg.ImageNode(pos=(i*16, 0), href="rgb24-32x32.png", parent=root)
+        for i in range(10):
+            avg.ImageNode(pos=(i*16, 40), href="rgb24-64x64.png", size=(16,16),
+                    parent=root)
+        for i in range(3):
+            avg.WordsNode(pos=(i*50, 60), text="Text"+str(i), fontsize=10,
+                    font="Bitstream Vera Sans", parent=root)
+        self.start(False,
+                (renderUnbatched,
+                 checkUnbatched,
+                 checkBatched,
+                 disableBatching,
+                ))
+
+    def testTexUploadBudget(self):
+        self.__testTexUploadBudget(False)
+
+    def testTexUploadBudgetBatched(self):
+        # The images share atlas pages. Each one is hidden until its part of the page
+        # has been uploaded.
+        self.__testTexUploadBudget(True)
+
+    def __testTexUploadBudget(self, bBatched):
+        def checkDeferred():
+            stats = player.getTexUploadStats()
+            self.assert_(stats["numDeferred"] > 0)
+            self.assert_(0 < stats["lastFrameBytes"] <= budget)
+            if bBatched:
+                self.assert_(player.getTextureAtlasStats()["numRegions"] >= 6)
+                renderStats = player.getMainCanvas().getRenderStats()
+                self.assert_(renderStats["batchedNodes"] < 6)
+
+        def checkUploaded():
+            stats = player.getTexUploadStats()
+            self.assertEqual(stats["numDeferred"], 0)
+            self.assertEqual(stats["deferredBytes"], 0)
+
+        def checkDisplayed():
+            if bBatched:
+                renderStats = player.getMainCanvas().getRenderStats()
+                self.assertEqual(renderStats["batchedNodes"], 6)
+                player.enableDrawBatching(False)
+            player.setTexUploadBudget(0)
+            cache.capacity = oldCapacity
+
+        # Evict the images so they get new textures.
+        cache = player.imageCache
+        oldCapacity = cache.capacity
+        cache.capacity = (0, 0)
+        root = self.loadEmptyScene()
+        player.enableDrawBatching(bBatched)
+        budget = 20000
+        player.setTexUploadBudget(budget)
+        self.assertEqual(player.getTexUploadBudget(), budget)
+        self.assertRaises(avg.Exception, lambda: player.setTexUploadBudget(-1))
+        for i, href in enumerate(("rgb24-64x64.png", "rgb24alpha-64x64.png",
+                "rgb24-65x65.png", "rgb24-32x32.png", "rgb24-64x32.png",
+                "rgb24alpha-32x32.png")):
+            avg.ImageNode(pos=(i*66, 0), href=href, parent=root)
+        self.start(False,
+                (checkDeferred,
+                 None,
+                 None,
+                 None,
+                 None,
+                 None,
+                 None,
+                 None,
+                 None,
+                 checkUploaded,
+                 checkDisplayed,
+                ))
+
+    def testFrameStats(self):
+        def checkStats():
+            stats = player.getFrameStats()
+            self.assert_(stats["numFrames"] >= 2)
+            self.assertEqual(stats["numRecords"], stats["numFrames"])
+            self.assert_(stats["p50"] <= stats["p95"] <= stats["p99"] <= stats["max"])
+            self.assert_(stats["missedDeadlines"] <= stats["numFrames"])
+            records = player.getFrameRecords()
+            self.assertEqual(len(records), stats["numRecords"])
+            for i in range(1, len(records)):
+                self.assertEqual(records[i]["frame"], records[i-1]["frame"]+1)
+                self.assert_(records[i]["endTime"] >= records[i-1]["endTime"])
+            for phase in ("timers", "events", "offscreen", "maincanvas", "endframe"):
+                self.assert_(records[-1][phase] >= 0)
+
+        if not(self._isCurrentDirWriteable()):
+            self.skip("Current dir not writeable.")
+            return
+        self.loadEmptyScene()
+        player.setFrameStatsFile("framestats.csv")
+        self.assertEqual(player.getFrameStatsFile(), "framestats.csv")
+        self.start(False,
+                (None,
+                 None,
+                 checkStats,
+                ))
+        player.setFrameStatsFile("")
+        # The file is written at the end of playback.
+        lines = open("framestats.csv").readlines()
+        os.remove("framestats.csv")
+        self.assert_(lines[0].startswith("frame,endtime,interval,timers"))
+        self.assert_(len(lines) > 3)
+
     def testOpacity(self):
         root = self.loadEmptyScene()
         avg.ImageNode(pos=(0,0), href="rgb24-65x65.png", opacity=0.5, parent=root)
@@ -344,6 +552,24 @@ class PlayerTestCase(AVGTestCase):
         else:
             self.assert_(0)
 
+    def testTimeoutsAfterException(self):
+        # An exception in a timeout must leave the timer handling usable.
+        def throwException():
+            raise ZeroDivisionError
+
+        def onTimeout():
+            self.timeoutCalled = True
+
+        self.initDefaultImageScene()
+        self.assertRaises(ZeroDivisionError, lambda: self.start(False, [throwException]))
+
+        self.timeoutCalled = False
+        self.initDefaultImageScene()
+        player.setTimeout(0, onTimeout)
+        self.start(False,
+                (lambda: self.assert_(self.timeoutCalled),
+                ))
+
     def testInvalidImageFilename(self):
         def activateNode():
             div.active = 1
@@ -440,6 +666,52 @@ class PlayerTestCase(AVGTestCase):
                 ))
 
 
+    def testManyTimeouts(self):
+        def onTimeout(dueTime):
+            self.assert_(player.getFrameTime() >= dueTime)
+            self.dueTimes.append(dueTime)
+
+        def onInterval(i):
+            self.numIntervalCalls[i] += 1
+            if i % 2 == 1:
+                player.clearInterval(self.intervalIDs[i])
+
+        def setupTimeouts():
+            startTime = player.getFrameTime()
+            for i in xrange(1000):
+                time = (i*7) % 300
+                player.setTimeout(time, lambda dueTime=startTime+time: onTimeout(dueTime))
+            self.intervalIDs = [player.setInterval(10, lambda i=i: onInterval(i))
+                    for i in xrange(1000)]
+            for i in xrange(0, 1000, 4):
+                player.clearInterval(self.intervalIDs[i])
+
+        def checkIntervals():
+            for i, numCalls in enumerate(self.numIntervalCalls):
+                if i % 4 == 0:
+                    self.assertEqual(numCalls, 0)
+                elif i % 2 == 1:
+                    self.assertEqual(numCalls, 1)
+                else:
+                    self.assert_(numCalls > 1)
+
+        def clearIntervals():
+            for intervalID in self.intervalIDs:
+                player.clearInterval(intervalID)
+
+        self.initDefaultImageScene()
+        player.setFakeFPS(100)
+        self.dueTimes = []
+        self.numIntervalCalls = [0]*1000
+        self.start(False,
+                (setupTimeouts,
+                 lambda: self.delay(400),
+                 lambda: self.assertEqual(len(self.dueTimes), 1000),
+                 lambda: self.assertEqual(self.dueTimes, sorted(self.dueTimes)),
+                 checkIntervals,
+                 clearIntervals,
+                ))
+
     def testCallFromThread(self):
 
         def onAsyncCall():
@@ -953,14 +1225,22 @@ def playerTestSuite(tests):
             "testRotate",
             "testRotate2",
             "testRotatePivot",
+            "testSpatialIndex",
+            "testPartialVertexUploads",
+            "testDrawBatching",
+            "testTexUploadBudget",
+            "testTexUploadBudgetBatched",
+            "testFrameStats",
             "testOpacity",
             "testOutlines",
             "testWordsOutlines",
             "testError",
             "testExceptionInTimeout",
+            "testTimeoutsAfterException",
             "testInvalidImageFilename",
             "testInvalidVideoFilename",
             "testTimeouts",
+            "testManyTimeouts",
             "testTimeoutOnFrameHandling",
             "testCallFromThread",
             "testAVGFile",
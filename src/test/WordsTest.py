@@ -669,6 +669,50 @@ class WordsTestCase(AVGTestCase):
                 ))
 
 
+    def testGlyphRendering(self):
+        def setGlyphRendering(bEnable):
+            avg.WordsNode.enableGlyphRendering(bEnable)
+            self.assertEqual(avg.WordsNode.isGlyphRenderingEnabled(), bEnable)
+            # Changing the text makes the nodes render again in the new mode.
+            for node in nodes:
+                text = node.text
+                node.text = ""
+                node.text = text
+
+        def setText(text):
+            for node in nodes:
+                node.text = text
+
+        def takeScreenshot():
+            self.__bmps.append(player.screenshot())
+
+        def compareScreenshots():
+            self.assert_(self.areSimilarBmps(self.__bmps[0], self.__bmps[1], 0.5, 0.5))
+            self.__bmps = []
+
+        self.__bmps = []
+        self.assert_(not(avg.WordsNode.isGlyphRenderingEnabled()))
+        root = self.loadEmptyScene()
+        nodes = []
+        # The second node shares its layout with the first one.
+        for pos in ((1,1), (1,20)):
+            nodes.append(avg.WordsNode(pos=pos, fontsize=12, font="Bitstream Vera Sans",
+                    variant="roman", text="00:00", parent=root))
+        nodes.append(avg.WordsNode(pos=(80,1), fontsize=12, font="Bitstream Vera Sans",
+                variant="roman", text="<i>Lorem</i> ipsum <b>dolor</b>", width=60,
+                alignment="center", parent=root))
+        self.start(False,
+                (takeScreenshot,
+                 lambda: setGlyphRendering(True),
+                 takeScreenshot,
+                 compareScreenshots,
+                 lambda: setText("12:59"),
+                 takeScreenshot,
+                 lambda: setGlyphRendering(False),
+                 takeScreenshot,
+                 compareScreenshots,
+                ))
+
 def wordsTestSuite(tests):
     availableTests = (
             "testSimpleWords",
@@ -697,5 +741,6 @@ def wordsTestSuite(tests):
             "testSetWidth",
             "testTooWide",
             "testWordsGamma",
+            "testGlyphRendering",
             )
     return createAVGTestSuite(availableTests, WordsTestCase, tests)
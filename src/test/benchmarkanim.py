@@ -0,0 +1,100 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# libavg - Media Playback Engine.
+# Copyright (C) 2003-2021 Ulrich von Zadow
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2 of the License, or (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Current versions can be found at www.libavg.de
+
+# Measures the time per frame spent on running many LinearAnims and EaseInOutAnims
+# at once. Node attributes are normally set from C++ directly; animating a subclass
+# that overrides the attribute in python shows the cost of the python path.
+
+from libavg import avg, player
+
+import time
+
+NUM_FRAMES = 100
+ANIM_DURATION = 100000
+
+
+class PythonPosNode(avg.DivNode):
+    def __init__(self, parent=None, **kwargs):
+        avg.DivNode.__init__(self, **kwargs)
+        self.registerInstance(self, parent)
+
+    def getPos(self):
+        return avg.DivNode.pos.__get__(self)
+
+    def setPos(self, pos):
+        avg.DivNode.pos.__set__(self, pos)
+    pos = property(getPos, setPos)
+
+
+class AnimBenchmark(object):
+    def __init__(self, animType, numAnims, bPythonAttr):
+        self.__animType = animType
+        self.__numAnims = numAnims
+        self.__bPythonAttr = bPythonAttr
+
+    def run(self):
+        root = player.createMainCanvas(size=(320,240))
+        if self.__bPythonAttr:
+            nodeClass = PythonPosNode
+        else:
+            nodeClass = avg.DivNode
+        self.__nodes = [nodeClass(size=(1,1), parent=root)
+                for i in xrange(self.__numAnims)]
+        self.__frameNum = 0
+        player.subscribe(player.ON_FRAME, self.__onFrame)
+        player.setTimeout(0, self.__startAnims)
+        player.play()
+        player.unsubscribe(player.ON_FRAME, self.__onFrame)
+        self.__nodes = []
+
+        msPerFrame = (self.__endTime-self.__startTime)*1000/NUM_FRAMES
+        if self.__bPythonAttr:
+            sPath = "python"
+        else:
+            sPath = "native"
+        print "%s, %d anims, %s: %.2f ms per frame" % (self.__animType,
+                self.__numAnims, sPath, msPerFrame)
+
+    def __startAnims(self):
+        for node in self.__nodes:
+            if self.__animType == "LinearAnim":
+                anim = avg.LinearAnim(node, "pos", ANIM_DURATION, (0,0), (320,240))
+            else:
+                anim = avg.EaseInOutAnim(node, "pos", ANIM_DURATION, (0,0), (320,240),
+                        ANIM_DURATION/4, ANIM_DURATION/4)
+            anim.start()
+        self.__frameNum = 0
+        self.__startTime = time.time()
+
+    def __onFrame(self):
+        self.__frameNum += 1
+        if self.__frameNum == NUM_FRAMES:
+            self.__endTime = time.time()
+            player.stop()
+
+
+# Don't wait for vertical blank, so the frame time reflects the work done.
+player.setFramerate(1000)
+for animType in ("LinearAnim", "EaseInOutAnim"):
+    for numAnims in (1000, 5000):
+        for bPythonAttr in (False, True):
+            AnimBenchmark(animType, numAnims, bPythonAttr).run()
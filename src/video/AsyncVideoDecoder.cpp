@@ -42,8 +42,9 @@ using boost::dynamic_pointer_cast;
 
 namespace avg {
 
-AsyncVideoDecoder::AsyncVideoDecoder(int queueLength)
+AsyncVideoDecoder::AsyncVideoDecoder(int queueLength, bool bUseDecoderPool)
     : m_QueueLength(queueLength),
+      m_pPool(0),
       m_pDemuxThread(0),
       m_pVDecoderThread(0),
       m_pADecoderThread(0),
@@ -51,11 +52,14 @@ AsyncVideoDecoder::AsyncVideoDecoder(int queueLength)
       m_FPS(0)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
+    if (bUseDecoderPool) {
+        m_pPool = VideoDecoderPool::get();
+    }
 }
 
 AsyncVideoDecoder::~AsyncVideoDecoder()
 {
-    if (m_pVDecoderThread || m_pADecoderThread) {
+    if (m_pVDecoderThread || m_pADecoderThread || m_pVDecoderTask || m_pADecoderTask) {
         close();
     }
     ObjectCounter::get()->decRef(&typeid(*this));
@@ -85,7 +89,7 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
 {
     VideoDecoder::startDecoding(bDeliverYCbCr, pAP);
 
-    AVG_ASSERT(!m_pDemuxThread);
+    AVG_ASSERT(!m_pDemuxThread && !m_pDemuxTask);
     vector<int> streamIndexes;
     if (getVStreamIndex() >= 0) {
         streamIndexes.push_back(getVStreamIndex());
@@ -105,9 +109,9 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
         m_pVMsgQ = VideoMsgQueuePtr(new VideoMsgQueue(m_QueueLength));
         VideoMsgQueue& packetQ = *m_PacketQs[getVStreamIndex()];
 
-        m_pVDecoderThread = new boost::thread(VideoDecoderThread(
-                *m_pVCmdQ, *m_pVMsgQ, packetQ, getVideoStream(), 
-                getSize(), getPixelFormat()));
+        startWorker(VideoDecoderThread(*m_pVCmdQ, *m_pVMsgQ, packetQ, getVideoStream(),
+                getSize(), getPixelFormat(), getFramePool()),
+                m_pVDecoderThread, m_pVDecoderTask);
     }
     
     if (getVideoInfo().m_bHasAudio) {
@@ -115,9 +119,8 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
         m_pAMsgQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_MSG_QUEUE_LENGTH));
         m_pAStatusQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_STATUS_QUEUE_LENGTH));
         VideoMsgQueue& packetQ = *m_PacketQs[getAStreamIndex()];
-        m_pADecoderThread = new boost::thread(
-                AudioDecoderThread(*m_pACmdQ, *m_pAMsgQ, packetQ, getAudioStream(),
-                        *pAP));
+        startWorker(AudioDecoderThread(*m_pACmdQ, *m_pAMsgQ, packetQ, getAudioStream(),
+                *pAP), m_pADecoderThread, m_pADecoderTask);
     }
 }
 
@@ -125,29 +128,26 @@ void AsyncVideoDecoder::close()
 {
     AVG_ASSERT(getState() != CLOSED);
 
-    if (m_pDemuxThread) {
+    bool bHasDemuxer = (m_pDemuxThread || m_pDemuxTask);
+    if (bHasDemuxer) {
         m_pDemuxCmdQ->pushCmd(boost::bind(&VideoDemuxerThread::close, _1));
-        m_pDemuxThread->join();
+        joinWorker(m_pDemuxThread, m_pDemuxTask);
     }
 
-    if (m_pVDecoderThread) {
+    if (m_pVDecoderThread || m_pVDecoderTask) {
         m_pVMsgQ->clear();
-        m_pVDecoderThread->join();
-        delete m_pVDecoderThread;
-        m_pVDecoderThread = 0;
+        joinWorker(m_pVDecoderThread, m_pVDecoderTask);
         m_pVMsgQ = VideoMsgQueuePtr();
     }
-    if (m_pADecoderThread) {
+    if (m_pADecoderThread || m_pADecoderTask) {
         m_pAMsgQ->clear();
         m_pAStatusQ->clear();
-        m_pADecoderThread->join();
-        delete m_pADecoderThread;
-        m_pADecoderThread = 0;
+        joinWorker(m_pADecoderThread, m_pADecoderTask);
         m_pAStatusQ = AudioMsgQueuePtr();
         m_pAMsgQ = AudioMsgQueuePtr();
     }
     VideoDecoder::close();
-    if (m_pDemuxThread) {
+    if (bHasDemuxer) {
         deleteDemuxer();
     }
 }
@@ -160,6 +160,7 @@ void AsyncVideoDecoder::seek(float destTime)
     m_NumSeeksSent++;
     m_pDemuxCmdQ->pushCmd(boost::bind(&VideoDemuxerThread::seek, _1, m_NumSeeksSent,
             destTime));
+    notifyPool();
 }
 
 void AsyncVideoDecoder::loop()
@@ -200,8 +201,9 @@ float AsyncVideoDecoder::getFPS() const
 
 void AsyncVideoDecoder::setFPS(float fps)
 {
-    AVG_ASSERT(!m_pADecoderThread);
+    AVG_ASSERT(!m_pADecoderThread && !m_pADecoderTask);
     m_pVCmdQ->pushCmd(boost::bind(&VideoDecoderThread::setFPS, _1, fps));
+    notifyPool();
     m_bUseStreamFPS = (fps == 0);
     if (m_bUseStreamFPS) {
         m_FPS = getVideoInfo().m_StreamFPS;
@@ -282,14 +284,12 @@ void AsyncVideoDecoder::setupDemuxer(vector<int> streamIndexes)
         VideoMsgQueuePtr pPacketQ(new VideoMsgQueue(PACKET_QUEUE_LENGTH));
         m_PacketQs[streamIndexes[i]] = pPacketQ;
     }
-    m_pDemuxThread = new boost::thread(VideoDemuxerThread(*m_pDemuxCmdQ,
-            getFormatContext(), m_PacketQs));
+    startWorker(VideoDemuxerThread(*m_pDemuxCmdQ, getFormatContext(), m_PacketQs,
+            getKeyframeIndex()), m_pDemuxThread, m_pDemuxTask);
 }
 
 void AsyncVideoDecoder::deleteDemuxer()
 {
-    delete m_pDemuxThread;
-    m_pDemuxThread = 0;
     map<int, VideoMsgQueuePtr>::iterator it;
     for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
         VideoMsgQueuePtr pPacketQ = it->second;
@@ -302,6 +302,37 @@ void AsyncVideoDecoder::deleteDemuxer()
     }
 }
 
+template<class WORKER>
+void AsyncVideoDecoder::startWorker(const WORKER& worker, boost::thread*& pThread,
+        PooledTaskPtr& pTask)
+{
+    if (m_pPool) {
+        pTask = m_pPool->addWorker(new WORKER(worker));
+    } else {
+        pThread = new boost::thread(worker);
+    }
+}
+
+void AsyncVideoDecoder::joinWorker(boost::thread*& pThread, PooledTaskPtr& pTask)
+{
+    if (pTask) {
+        m_pPool->waitForTask(pTask);
+        pTask = PooledTaskPtr();
+    } else {
+        pThread->join();
+        delete pThread;
+        pThread = 0;
+    }
+}
+
+void AsyncVideoDecoder::notifyPool()
+{
+    // Called whenever the main thread makes room in a queue or sends a command.
+    if (m_pPool) {
+        m_pPool->notify();
+    }
+}
+
 VideoMsgPtr AsyncVideoDecoder::getBmpsForTime(float timeWanted, 
         FrameAvailableCode& frameAvailable)
 {
@@ -333,9 +364,6 @@ VideoMsgPtr AsyncVideoDecoder::getBmpsForTime(float timeWanted,
     } else {
         float frameTime = -1;
         while (frameTime-timeWanted < -0.5*timePerFrame && !m_bVideoEOF) {
-            if (pFrameMsg) {
-                returnFrame(pFrameMsg);
-            }
             pFrameMsg = getNextBmps(false);
             if (pFrameMsg) {
                 frameTime = pFrameMsg->getFrameTime();
@@ -357,8 +385,12 @@ VideoMsgPtr AsyncVideoDecoder::getBmpsForTime(float timeWanted,
 
 VideoMsgPtr AsyncVideoDecoder::getNextBmps(bool bWait)
 {
+    if (bWait) {
+        notifyPool();
+    }
     VideoMsgPtr pMsg = m_pVMsgQ->pop(bWait);
     if (pMsg) {
+        notifyPool();
         switch (pMsg->getType()) {
             case VideoMsg::FRAME:
                 return pMsg;
@@ -383,6 +415,7 @@ VideoMsgPtr AsyncVideoDecoder::getNextBmps(bool bWait)
 }
 void AsyncVideoDecoder::waitForSeekDone()
 {
+    notifyPool();
     while (isVSeeking()) {
         VideoMsgPtr pMsg = m_pVMsgQ->pop(true);
         handleVSeekMsg(pMsg);
@@ -409,7 +442,7 @@ void AsyncVideoDecoder::handleVSeekMsg(VideoMsgPtr pMsg)
             handleVSeekDone(pMsg);
             break;
         case VideoMsg::FRAME:
-            returnFrame(dynamic_pointer_cast<VideoMsg>(pMsg));
+            // Frame bitmaps return to the frame pool by themselves.
             break;
         case VideoMsg::END_OF_FILE:
             m_NumVSeeksDone = m_NumSeeksSent;
@@ -454,14 +487,6 @@ void AsyncVideoDecoder::handleAudioMsg(AudioMsgPtr pMsg)
     }
 }
 
-void AsyncVideoDecoder::returnFrame(VideoMsgPtr pFrameMsg)
-{
-    if (pFrameMsg) {
-        AVG_ASSERT(pFrameMsg->getType() == VideoMsg::FRAME);
-        m_pVCmdQ->pushCmd(boost::bind(&VideoDecoderThread::returnFrame, _1, pFrameMsg));
-    }
-}
-
 bool AsyncVideoDecoder::isSeeking() const
 {
     return (m_NumSeeksSent > m_NumVSeeksDone || m_NumSeeksSent > m_NumASeeksDone);
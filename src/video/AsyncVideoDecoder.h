@@ -28,6 +28,7 @@
 #include "VideoDecoderThread.h"
 #include "AudioDecoderThread.h"
 #include "VideoMsg.h"
+#include "VideoDecoderPool.h"
 
 #include "../graphics/Bitmap.h"
 #include "../audio/AudioParams.h"
@@ -41,7 +42,9 @@ namespace avg {
 class AVG_API AsyncVideoDecoder: public VideoDecoder
 {
 public:
-    AsyncVideoDecoder(int queueLength);
+    // If bUseDecoderPool is set and the decoder pool is enabled, demuxing and decoding
+    // happen in the shared VideoDecoderPool instead of in threads of their own.
+    AsyncVideoDecoder(int queueLength, bool bUseDecoderPool=true);
     virtual ~AsyncVideoDecoder();
     virtual void open(const std::string& sFilename, bool bEnableSound);
     virtual void startDecoding(bool bDeliverYCbCr, const AudioParams* pAP);
@@ -66,6 +69,11 @@ public:
 private:
     void setupDemuxer(std::vector<int> streamIndexes);
     void deleteDemuxer();
+    template<class WORKER>
+    void startWorker(const WORKER& worker, boost::thread*& pThread,
+            PooledTaskPtr& pTask);
+    void joinWorker(boost::thread*& pThread, PooledTaskPtr& pTask);
+    void notifyPool();
     VideoMsgPtr getBmpsForTime(float timeWanted, FrameAvailableCode& frameAvailable);
     VideoMsgPtr getNextBmps(bool bWait);
     void waitForSeekDone();
@@ -73,21 +81,24 @@ private:
     void handleVSeekMsg(VideoMsgPtr pMsg);
     void handleVSeekDone(AudioMsgPtr pMsg);
     void handleAudioMsg(AudioMsgPtr pMsg);
-    void returnFrame(VideoMsgPtr pFrameMsg);
     bool isSeeking() const;
     bool isVSeeking() const;
 
     int m_QueueLength;
+    VideoDecoderPool* m_pPool;
 
     boost::thread* m_pDemuxThread;
+    PooledTaskPtr m_pDemuxTask;
     std::map<int, VideoMsgQueuePtr> m_PacketQs;
     VideoDemuxerThread::CQueuePtr m_pDemuxCmdQ;
 
     boost::thread* m_pVDecoderThread;
+    PooledTaskPtr m_pVDecoderTask;
     VideoDecoderThread::CQueuePtr m_pVCmdQ;
     VideoMsgQueuePtr m_pVMsgQ;
 
     boost::thread* m_pADecoderThread;
+    PooledTaskPtr m_pADecoderTask;
     AudioDecoderThread::CQueuePtr m_pACmdQ;
     AudioMsgQueuePtr m_pAMsgQ;
     AudioMsgQueuePtr m_pAStatusQ;
@@ -67,6 +67,29 @@ AudioDecoderThread::~AudioDecoderThread()
     }
 }
 
+// Decoding one packet can result in several audio messages, so pooled decoding only
+// starts if there is room for a few of them.
+static const int POOLED_MSG_QUEUE_MARGIN = 8;
+
+bool AudioDecoderThread::canWork() const
+{
+    VideoMsgPtr pMsg = m_PacketQ.peek(false);
+    if (!pMsg) {
+        return false;
+    }
+    if (pMsg->getType() != VideoMsg::PACKET) {
+        return true;
+    }
+    return m_MsgQ.getMaxSize() == -1 ||
+            m_MsgQ.size() <= m_MsgQ.getMaxSize()-POOLED_MSG_QUEUE_MARGIN;
+}
+
+float AudioDecoderThread::getDeadline() const
+{
+    // Audio underruns are more noticeable than late video frames.
+    return 0;
+}
+
 static ProfilingZoneID DecoderProfilingZone("Audio Decoder Thread", true);
 static ProfilingZoneID PacketWaitProfilingZone("Audio Wait for packet", true);
 
@@ -287,21 +310,21 @@ void AudioDecoderThread::insertSilence(float duration)
 
 void AudioDecoderThread::pushAudioMsg(AudioBufferPtr pBuffer, float time)
 {
-    VideoMsgPtr pMsg(new VideoMsg());
+    VideoMsgPtr pMsg = VideoMsg::create();
     pMsg->setAudio(pBuffer, time);
     m_MsgQ.push(pMsg);
 }
 
 void AudioDecoderThread::pushSeekDone(float time, int seqNum)
 {
-    VideoMsgPtr pMsg(new VideoMsg());
+    VideoMsgPtr pMsg = VideoMsg::create();
     pMsg->setSeekDone(seqNum, time);
     m_MsgQ.push(pMsg);
 }
 
 void AudioDecoderThread::pushEOF()
 {
-    VideoMsgPtr pMsg(new VideoMsg());
+    VideoMsgPtr pMsg = VideoMsg::create();
     pMsg->setEOF();
     m_MsgQ.push(pMsg);
 }
@@ -46,6 +46,10 @@ class AVG_API AudioDecoderThread : public WorkerThread<AudioDecoderThread> {
 
         bool work();
 
+        // Used by VideoDecoderPool.
+        bool canWork() const;
+        float getDeadline() const;
+
     private:
         void decodePacket(AVPacket* pPacket);
         void handleSeekDone(AVPacket* pPacket);
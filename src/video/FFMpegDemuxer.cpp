@@ -108,14 +108,46 @@ AVPacket * FFMpegDemuxer::getPacket(int streamIndex)
 
     return pPacket;
 }
-        
+
+void FFMpegDemuxer::setKeyframeIndex(KeyframeIndexPtr pKeyframeIndex)
+{
+    m_pKeyframeIndex = pKeyframeIndex;
+}
+
+static ProfilingZoneID SeekProfilingZone("Demuxer seek", true);
+
 void FFMpegDemuxer::seek(float destTime)
 {
-    av_seek_frame(m_pFormatContext, -1, (long long)(destTime*AV_TIME_BASE),
-            AVSEEK_FLAG_BACKWARD);
+    ScopeTimer timer(SeekProfilingZone);
+    if (!m_pKeyframeIndex || !seekToKeyframe(destTime)) {
+        av_seek_frame(m_pFormatContext, -1, (long long)(destTime*AV_TIME_BASE),
+                AVSEEK_FLAG_BACKWARD);
+    }
     clearPacketCache();
 }
 
+bool FFMpegDemuxer::seekToKeyframe(float destTime)
+{
+    int i = m_pKeyframeIndex->findKeyframe(destTime);
+    if (i == -1) {
+        return false;
+    }
+    const KeyframeIndex::Keyframe& keyframe = m_pKeyframeIndex->getKeyframe(i);
+    int streamIndex = m_pKeyframeIndex->getStreamIndex();
+    AVStream* pStream = m_pFormatContext->streams[streamIndex];
+    int err;
+    if (pStream->nb_index_entries == 0 && keyframe.m_Pos != -1) {
+        // The demuxer can't look up timestamps by itself, but we know where the
+        // keyframe is.
+        err = av_seek_frame(m_pFormatContext, streamIndex, keyframe.m_Pos,
+                AVSEEK_FLAG_BYTE);
+    } else {
+        err = av_seek_frame(m_pFormatContext, streamIndex, keyframe.m_Timestamp,
+                AVSEEK_FLAG_BACKWARD);
+    }
+    return err >= 0;
+}
+
 void FFMpegDemuxer::clearPacketCache()
 {
     map<int, PacketList>::iterator it;
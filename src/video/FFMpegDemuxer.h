@@ -25,6 +25,7 @@
 #include "../avgconfigwrapper.h"
 
 #include "WrapFFMpeg.h"
+#include "KeyframeIndex.h"
 
 #include <list>
 #include <vector>
@@ -40,10 +41,13 @@ class AVG_API FFMpegDemuxer {
         virtual ~FFMpegDemuxer();
        
         AVPacket * getPacket(int streamIndex);
+        // With an index, seeks go straight to the keyframe before destTime.
+        void setKeyframeIndex(KeyframeIndexPtr pKeyframeIndex);
         void seek(float destTime);
         void dump();
         
     private:
+        bool seekToKeyframe(float destTime);
         void clearPacketCache();
 
         // Packets that haven't been delivered yet.
@@ -51,6 +55,7 @@ class AVG_API FFMpegDemuxer {
         std::map<int, PacketList> m_PacketLists;
        
         AVFormatContext * m_pFormatContext;
+        KeyframeIndexPtr m_pKeyframeIndex;
 };
 
 typedef boost::shared_ptr<FFMpegDemuxer> FFMpegDemuxerPtr;
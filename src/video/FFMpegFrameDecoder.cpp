@@ -42,11 +42,11 @@ using namespace std;
 namespace avg {
 
 FFMpegFrameDecoder::FFMpegFrameDecoder(AVStream* pStream)
-    : m_pSwsContext(0),
-      m_pStream(pStream),
+    : m_pStream(pStream),
       m_bEOF(false),
       m_StartTimestamp(-1),
       m_LastFrameTime(-1),
+      m_SeekTargetTime(-1),
       m_bUseStreamFPS(true)
 {
     m_TimeUnitsPerSecond = float(1.0/av_q2d(pStream->time_base));
@@ -57,10 +57,6 @@ FFMpegFrameDecoder::FFMpegFrameDecoder(AVStream* pStream)
 
 FFMpegFrameDecoder::~FFMpegFrameDecoder()
 {
-    if (m_pSwsContext) {
-        sws_freeContext(m_pSwsContext);
-        m_pSwsContext = 0;
-    }
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
@@ -73,9 +69,15 @@ bool FFMpegFrameDecoder::decodePacket(AVPacket* pPacket, AVFrame* pFrame,
     int bGotPicture = 0;
     AVCodecContext* pContext = m_pStream->codec;
     AVG_ASSERT(pPacket);
+    // Drop our reference to the previous frame. Frame bitmaps may still reference it.
+    av_frame_unref(pFrame);
+    if (m_SeekTargetTime != -1) {
+        setSkipFrames(pPacket);
+    }
     avcodec_decode_video2(pContext, pFrame, &bGotPicture, pPacket);
     if (bGotPicture) {
         m_LastFrameTime = getFrameTime(pPacket->dts, bFrameAfterSeek);
+        updateSeekTarget();
     }
     av_free_packet(pPacket);
     delete pPacket;
@@ -91,12 +93,16 @@ bool FFMpegFrameDecoder::decodeLastFrame(AVFrame* pFrame)
     av_init_packet(&packet);
     packet.data = 0;
     packet.size = 0;
+    av_frame_unref(pFrame);
     avcodec_decode_video2(pContext, pFrame, &bGotPicture, &packet);
     m_bEOF = true;
 
     // We don't have a timestamp for the last frame, so we'll
     // calculate it based on the frame before.
     m_LastFrameTime += 1.0f/m_FPS;
+    if (bGotPicture) {
+        updateSeekTarget();
+    }
     return (bGotPicture != 0);
 }
 
@@ -105,14 +111,9 @@ static ProfilingZoneID ConvertImageLibavgProfilingZone(
         "FFMpeg: colorspace conv (libavg)", true);
 static ProfilingZoneID ConvertImageSWSProfilingZone(
         "FFMpeg: colorspace conv (SWS)", true);
-static ProfilingZoneID SetAlphaProfilingZone("FFMpeg: set alpha channel", true);
 
 void FFMpegFrameDecoder::convertFrameToBmp(AVFrame* pFrame, BitmapPtr pBmp)
 {
-    AVPicture destPict;
-    unsigned char * pDestBits = pBmp->getPixels();
-    destPict.data[0] = pDestBits;
-    destPict.linesize[0] = pBmp->getStride();
     AVPixelFormat destFmt;
     switch (pBmp->getPixelFormat()) {
         case R8G8B8X8:
@@ -137,46 +138,34 @@ void FFMpegFrameDecoder::convertFrameToBmp(AVFrame* pFrame, BitmapPtr pBmp)
                     toString(pBmp->getPixelFormat()) + " not supported.").c_str());
             destFmt = AV_PIX_FMT_BGRA;
     }
-    AVCodecContext const* pContext = m_pStream->codec;
-    if (destFmt == AV_PIX_FMT_BGRA && (pContext->pix_fmt == AV_PIX_FMT_YUV420P || 
-                pContext->pix_fmt == AV_PIX_FMT_YUVJ420P))
+    AVPixelFormat srcFmt = m_pStream->codec->pix_fmt;
+    bool bRGB32Dest = (destFmt == AV_PIX_FMT_BGRA || destFmt == AV_PIX_FMT_RGBA);
+    if (bRGB32Dest && (srcFmt == AV_PIX_FMT_YUV420P || srcFmt == AV_PIX_FMT_YUVJ420P ||
+                srcFmt == AV_PIX_FMT_NV12))
     {
+        // The common cases: SSE2 conversion that also sets alpha, split into bands
+        // that run in parallel.
         ScopeTimer timer(ConvertImageLibavgProfilingZone);
-        BitmapPtr pBmpY(new Bitmap(pBmp->getSize(), I8, pFrame->data[0],
-                pFrame->linesize[0], false));
-        BitmapPtr pBmpU(new Bitmap(pBmp->getSize(), I8, pFrame->data[1],
-                pFrame->linesize[1], false));
-        BitmapPtr pBmpV(new Bitmap(pBmp->getSize(), I8, pFrame->data[2],
-                pFrame->linesize[2], false));
-        pBmp->copyYUVPixels(*pBmpY, *pBmpU, *pBmpV, 
-                pContext->pix_fmt == AV_PIX_FMT_YUVJ420P);
-    } else {
-        if (!m_pSwsContext) {
-            m_pSwsContext = sws_getContext(pContext->width, pContext->height, 
-                    pContext->pix_fmt, pContext->width, pContext->height, destFmt, 
-                    SWS_BICUBIC, 0, 0, 0);
-            AVG_ASSERT(m_pSwsContext);
-        }
-        {
-            ScopeTimer timer(ConvertImageSWSProfilingZone);
-            sws_scale(m_pSwsContext, pFrame->data, pFrame->linesize, 0, 
-                    pContext->height, destPict.data, destPict.linesize);
+        IntPoint size = pBmp->getSize();
+        IntPoint halfSize((size.x+1)/2, (size.y+1)/2);
+        Bitmap yBmp(size, I8, pFrame->data[0], pFrame->linesize[0], false);
+        if (srcFmt == AV_PIX_FMT_NV12) {
+            Bitmap uvBmp(IntPoint(halfSize.x*2, halfSize.y), I8, pFrame->data[1],
+                    pFrame->linesize[1], false);
+            pBmp->copyNV12Pixels(yBmp, uvBmp, false);
+        } else {
+            Bitmap uBmp(halfSize, I8, pFrame->data[1], pFrame->linesize[1], false);
+            Bitmap vBmp(halfSize, I8, pFrame->data[2], pFrame->linesize[2], false);
+            pBmp->copyYUVPixels(yBmp, uBmp, vBmp, srcFmt == AV_PIX_FMT_YUVJ420P);
         }
-        if (pBmp->getPixelFormat() == B8G8R8X8 || pBmp->getPixelFormat() == R8G8B8X8) {
-            ScopeTimer timer(SetAlphaProfilingZone);
-            // Make sure the alpha channel is white.
-            // TODO: This is slow. Make OpenGL do it.
-            unsigned char * pLine = pBmp->getPixels();
-            IntPoint size = pBmp->getSize();
-            for (int y = 0; y < size.y; ++y) {
-                unsigned char * pPixel = pLine;
-                for (int x = 0; x < size.x; ++x) {
-                    pPixel[3] = 0xFF;
-                    pPixel += 4;
-                }
-                pLine = pLine + pBmp->getStride();
-            }
+    } else {
+        ScopeTimer timer(ConvertImageSWSProfilingZone);
+        if (!m_pSwsConverter) {
+            AVCodecContext const* pContext = m_pStream->codec;
+            m_pSwsConverter = SwsConverterPtr(new SwsConverter(
+                    IntPoint(pContext->width, pContext->height), srcFmt, destFmt));
         }
+        m_pSwsConverter->convert(pFrame, pBmp);
     }
 }
 
@@ -194,9 +183,11 @@ void FFMpegFrameDecoder::copyPlaneToBmp(BitmapPtr pBmp, unsigned char * pData, i
     }
 }
 
-void FFMpegFrameDecoder::handleSeek()
+void FFMpegFrameDecoder::handleSeek(float seekTime)
 {
     m_LastFrameTime = -1.0f;
+    m_SeekTargetTime = seekTime;
+    m_pStream->codec->skip_frame = AVDISCARD_DEFAULT;
     avcodec_flush_buffers(m_pStream->codec);
     m_bEOF = false;
     if (m_StartTimestamp == -1) {
@@ -204,6 +195,11 @@ void FFMpegFrameDecoder::handleSeek()
     }
 }
 
+bool FFMpegFrameDecoder::isFrameBeforeSeekTarget() const
+{
+    return m_SeekTargetTime != -1;
+}
+
 float FFMpegFrameDecoder::getCurTime() const
 {
     return m_LastFrameTime;
@@ -252,5 +248,30 @@ float FFMpegFrameDecoder::getFrameTime(long long dts, bool bFrameAfterSeek)
     return frameTime;
 }
 
+void FFMpegFrameDecoder::setSkipFrames(AVPacket* pPacket)
+{
+    // Frames that nothing references are skipped while still well before the seek
+    // target. This needs frame times that come from the stream. The margin covers
+    // reordering delays and the frame right before the target, which may be the one
+    // that is displayed.
+    AVCodecContext* pContext = m_pStream->codec;
+    bool bSkip = false;
+    if (m_bUseStreamFPS && pPacket->dts != (long long)AV_NOPTS_VALUE &&
+            m_StartTimestamp != -1)
+    {
+        float packetTime = float(pPacket->dts-m_StartTimestamp)/m_TimeUnitsPerSecond;
+        float margin = (pContext->has_b_frames+2)/m_FPS;
+        bSkip = packetTime < m_SeekTargetTime-margin;
+    }
+    pContext->skip_frame = bSkip ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+}
+
+void FFMpegFrameDecoder::updateSeekTarget()
+{
+    if (m_SeekTargetTime != -1 && m_LastFrameTime >= m_SeekTargetTime-0.5f/m_FPS) {
+        m_SeekTargetTime = -1;
+        m_pStream->codec->skip_frame = AVDISCARD_DEFAULT;
+    }
 }
 
+}
@@ -25,9 +25,12 @@
 #include "../avgconfigwrapper.h"
 
 #include "WrapFFMpeg.h"
+#include "SwsConverter.h"
 
 #include <boost/shared_ptr.hpp>
 
+#include <vector>
+
 namespace avg {
 
 class Bitmap;
@@ -44,7 +47,11 @@ class AVG_API FFMpegFrameDecoder
         void convertFrameToBmp(AVFrame* pFrame, BitmapPtr pBmp);
         void copyPlaneToBmp(BitmapPtr pBmp, unsigned char * pData, int stride);
 
-        void handleSeek();
+        // Frames before seekTime are decoded as far as other frames depend on them.
+        void handleSeek(float seekTime);
+        // True if the last frame decoded is before the destination of the last seek.
+        // These frames don't need to be converted or displayed.
+        bool isFrameBeforeSeekTarget() const;
 
         virtual float getCurTime() const;
         virtual float getFPS() const;
@@ -54,8 +61,10 @@ class AVG_API FFMpegFrameDecoder
         
     private:
         float getFrameTime(long long dts, bool bFrameAfterSeek);
+        void setSkipFrames(AVPacket* pPacket);
+        void updateSeekTarget();
 
-        SwsContext * m_pSwsContext;
+        SwsConverterPtr m_pSwsConverter;
         AVStream* m_pStream;
 
         bool m_bEOF;
@@ -63,6 +72,7 @@ class AVG_API FFMpegFrameDecoder
         float m_TimeUnitsPerSecond;
         long long m_StartTimestamp;
         float m_LastFrameTime;
+        float m_SeekTargetTime;
 
         bool m_bUseStreamFPS;
         float m_FPS;
@@ -0,0 +1,238 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "KeyframeIndex.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ObjectCounter.h"
+#include "../base/ScopeTimer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace avg {
+
+// Bump whenever the file layout changes; old index files are then rebuilt.
+static const char* INDEX_FILE_HEADER = "libavg-keyframe-index";
+static const int INDEX_FILE_VERSION = 1;
+
+static bool getVideoFileInfo(const string& sFilename, long long& mtime, long long& size)
+{
+    struct stat fileStat;
+    if (stat(sFilename.c_str(), &fileStat) != 0) {
+        return false;
+    }
+    mtime = (long long)fileStat.st_mtime;
+    size = (long long)fileStat.st_size;
+    return true;
+}
+
+static bool operator <(const KeyframeIndex::Keyframe& kf1,
+        const KeyframeIndex::Keyframe& kf2)
+{
+    return kf1.m_Timestamp < kf2.m_Timestamp;
+}
+
+KeyframeIndex::Keyframe::Keyframe(long long timestamp, long long pos, float time)
+    : m_Timestamp(timestamp),
+      m_Pos(pos),
+      m_Time(time)
+{
+}
+
+KeyframeIndex::KeyframeIndex(AVStream* pStream)
+    : m_pStream(pStream)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    if (pStream->start_time == (long long)AV_NOPTS_VALUE) {
+        m_StartTimestamp = 0;
+    } else {
+        m_StartTimestamp = pStream->start_time;
+    }
+}
+
+KeyframeIndex::~KeyframeIndex()
+{
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+static ProfilingZoneID BuildIndexProfilingZone("Build keyframe index", true);
+
+void KeyframeIndex::build(AVFormatContext* pFormatContext)
+{
+    ScopeTimer timer(BuildIndexProfilingZone);
+    m_Keyframes.clear();
+    for (int i = 0; i < m_pStream->nb_index_entries; ++i) {
+        const AVIndexEntry& entry = m_pStream->index_entries[i];
+        if (entry.flags & AVINDEX_KEYFRAME) {
+            addKeyframe(entry.timestamp, entry.pos);
+        }
+    }
+    if (m_Keyframes.empty()) {
+        // No usable container index: Scan the file.
+        AVPacket packet;
+        av_init_packet(&packet);
+        packet.data = 0;
+        packet.size = 0;
+        while (av_read_frame(pFormatContext, &packet) >= 0) {
+            if (packet.stream_index == m_pStream->index &&
+                    (packet.flags & AV_PKT_FLAG_KEY))
+            {
+                long long timestamp = packet.dts;
+                if (timestamp == (long long)AV_NOPTS_VALUE) {
+                    timestamp = packet.pts;
+                }
+                if (timestamp != (long long)AV_NOPTS_VALUE) {
+                    addKeyframe(timestamp, packet.pos);
+                }
+            }
+            av_free_packet(&packet);
+        }
+        int err = av_seek_frame(pFormatContext, -1, 0, AVSEEK_FLAG_BACKWARD);
+        if (err < 0 && !m_Keyframes.empty()) {
+            av_seek_frame(pFormatContext, m_pStream->index, m_Keyframes[0].m_Pos,
+                    AVSEEK_FLAG_BYTE);
+        }
+    }
+    sort(m_Keyframes.begin(), m_Keyframes.end());
+    AVG_TRACE(Logger::category::PROFILE_VIDEO, Logger::severity::INFO,
+            "Keyframe index: " << m_Keyframes.size() << " keyframes.");
+}
+
+bool KeyframeIndex::load(const string& sFilename, const string& sVideoFilename)
+{
+    long long videoMTime;
+    long long videoSize;
+    if (!getVideoFileInfo(sVideoFilename, videoMTime, videoSize)) {
+        return false;
+    }
+    ifstream file(sFilename.c_str());
+    if (!file) {
+        return false;
+    }
+    string sHeader;
+    int version;
+    long long fileMTime;
+    long long fileSize;
+    int streamIndex;
+    int numKeyframes;
+    file >> sHeader >> version >> fileMTime >> fileSize >> streamIndex >> numKeyframes;
+    // Every keyframe occupies at least one byte of the video file, so a larger count
+    // means the index file is corrupt. The count isn't used to reserve memory, since
+    // it may still be large enough to fail allocation.
+    if (!file || sHeader != INDEX_FILE_HEADER || version != INDEX_FILE_VERSION ||
+            fileMTime != videoMTime || fileSize != videoSize ||
+            streamIndex != m_pStream->index || numKeyframes < 0 ||
+            numKeyframes > videoSize)
+    {
+        return false;
+    }
+    vector<Keyframe> keyframes;
+    for (int i = 0; i < numKeyframes; ++i) {
+        long long timestamp;
+        long long pos;
+        file >> timestamp >> pos;
+        if (!file) {
+            return false;
+        }
+        keyframes.push_back(Keyframe(timestamp, pos,
+                float((timestamp-m_StartTimestamp)*av_q2d(m_pStream->time_base))));
+    }
+    m_Keyframes.swap(keyframes);
+    return true;
+}
+
+void KeyframeIndex::save(const string& sFilename, const string& sVideoFilename) const
+{
+    long long videoMTime;
+    long long videoSize;
+    if (!getVideoFileInfo(sVideoFilename, videoMTime, videoSize)) {
+        return;
+    }
+    ofstream file(sFilename.c_str());
+    file << INDEX_FILE_HEADER << " " << INDEX_FILE_VERSION << endl;
+    file << videoMTime << " " << videoSize << " " << m_pStream->index << " "
+            << m_Keyframes.size() << endl;
+    for (unsigned i = 0; i < m_Keyframes.size(); ++i) {
+        file << m_Keyframes[i].m_Timestamp << " " << m_Keyframes[i].m_Pos << endl;
+    }
+    if (!file) {
+        AVG_LOG_WARNING("Could not write keyframe index file '" << sFilename << "'.");
+    }
+}
+
+int KeyframeIndex::getStreamIndex() const
+{
+    return m_pStream->index;
+}
+
+int KeyframeIndex::getNumKeyframes() const
+{
+    return int(m_Keyframes.size());
+}
+
+const KeyframeIndex::Keyframe& KeyframeIndex::getKeyframe(int i) const
+{
+    AVG_ASSERT(i >= 0 && i < int(m_Keyframes.size()));
+    return m_Keyframes[i];
+}
+
+int KeyframeIndex::findKeyframe(float time) const
+{
+    if (m_Keyframes.empty()) {
+        return -1;
+    }
+    // Keyframes are sorted by timestamp, so they are sorted by time as well.
+    int lo = 0;
+    int hi = int(m_Keyframes.size())-1;
+    while (lo < hi) {
+        int mid = (lo+hi+1)/2;
+        if (m_Keyframes[mid].m_Time <= time) {
+            lo = mid;
+        } else {
+            hi = mid-1;
+        }
+    }
+    return lo;
+}
+
+float KeyframeIndex::getKeyframeTime(float time) const
+{
+    int i = findKeyframe(time);
+    if (i == -1) {
+        return time;
+    } else {
+        return min(time, m_Keyframes[i].m_Time);
+    }
+}
+
+void KeyframeIndex::addKeyframe(long long timestamp, long long pos)
+{
+    float time = float((timestamp-m_StartTimestamp)*av_q2d(m_pStream->time_base));
+    m_Keyframes.push_back(Keyframe(timestamp, pos, time));
+}
+
+}
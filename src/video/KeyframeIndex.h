@@ -0,0 +1,86 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _KeyframeIndex_H_
+#define _KeyframeIndex_H_
+
+#include "../api.h"
+
+#include "WrapFFMpeg.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace avg {
+
+// Positions of the keyframes of a video stream. Lets seeks start decoding at the
+// closest keyframe before the destination instead of relying on the container
+// having a usable index.
+class AVG_API KeyframeIndex
+{
+public:
+    struct Keyframe {
+        Keyframe(long long timestamp, long long pos, float time);
+
+        // In units of the stream time base.
+        long long m_Timestamp;
+        // Byte position in the file, -1 if unknown.
+        long long m_Pos;
+        // Seconds since the start of the stream.
+        float m_Time;
+    };
+
+    KeyframeIndex(AVStream* pStream);
+    virtual ~KeyframeIndex();
+
+    // Uses the index of the container if it has one. Otherwise, all packets of the
+    // file are read and the read position is reset to the start afterwards.
+    void build(AVFormatContext* pFormatContext);
+    // Returns false if the file doesn't exist or was written for a different version
+    // of the video.
+    bool load(const std::string& sFilename, const std::string& sVideoFilename);
+    void save(const std::string& sFilename, const std::string& sVideoFilename) const;
+
+    int getStreamIndex() const;
+    int getNumKeyframes() const;
+    const Keyframe& getKeyframe(int i) const;
+    // Index of the last keyframe at or before time. Returns the first keyframe if time
+    // is before it and -1 if the index is empty.
+    int findKeyframe(float time) const;
+    // Time of the keyframe findKeyframe() returns, or time itself if there is none.
+    float getKeyframeTime(float time) const;
+
+private:
+    void addKeyframe(long long timestamp, long long pos);
+
+    AVStream* m_pStream;
+    long long m_StartTimestamp;
+    std::vector<Keyframe> m_Keyframes;
+};
+
+typedef boost::shared_ptr<KeyframeIndex> KeyframeIndexPtr;
+
+}
+
+#endif
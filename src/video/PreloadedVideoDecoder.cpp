@@ -0,0 +1,283 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "PreloadedVideoDecoder.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ObjectCounter.h"
+#include "../base/ScopeTimer.h"
+#include "../base/TimeSource.h"
+
+#include "../graphics/Bitmap.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+// Time per frame that may be spent decoding ahead of playback while a clip is being
+// preloaded.
+static const long long PRELOAD_BUDGET_MICROSECS = 2000;
+
+PreloadedVideoDecoder::PreloadedVideoDecoder()
+    : m_bClipComplete(false),
+      m_MemAvailable(0),
+      m_bPreloadFailed(false),
+      m_CurFrame(-1),
+      m_NextFrame(0),
+      m_bEOF(false)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+PreloadedVideoDecoder::~PreloadedVideoDecoder()
+{
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+void PreloadedVideoDecoder::open(const string& sFilename, bool bEnableSound)
+{
+    m_sFilename = sFilename;
+    SyncVideoDecoder::open(sFilename, false);
+}
+
+void PreloadedVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP)
+{
+    SyncVideoDecoder::startDecoding(bDeliverYCbCr, 0);
+    m_bPreloadFailed = false;
+    startClip();
+}
+
+void PreloadedVideoDecoder::close()
+{
+    m_pClip = VideoClipPtr();
+    m_bClipComplete = false;
+    SyncVideoDecoder::close();
+}
+
+int PreloadedVideoDecoder::getCurFrame() const
+{
+    if (!m_pClip) {
+        return SyncVideoDecoder::getCurFrame();
+    }
+    return max(m_CurFrame, 0);
+}
+
+int PreloadedVideoDecoder::getNumFramesQueued() const
+{
+    return 0;
+}
+
+float PreloadedVideoDecoder::getCurTime() const
+{
+    if (!m_pClip) {
+        return SyncVideoDecoder::getCurTime();
+    }
+    return max(m_CurFrame, 0)/getFPS();
+}
+
+static ProfilingZoneID PreloadedFrameProfilingZone("Preloaded video: get frame", true);
+
+FrameAvailableCode PreloadedVideoDecoder::getRenderedBmps(vector<BitmapPtr>& pBmps,
+        float timeWanted)
+{
+    AVG_ASSERT(getState() == DECODING);
+    if (!m_pClip) {
+        return SyncVideoDecoder::getRenderedBmps(pBmps, timeWanted);
+    }
+    ScopeTimer timer(PreloadedFrameProfilingZone);
+    int frame;
+    if (timeWanted == -1) {
+        frame = m_NextFrame;
+    } else {
+        frame = getFrameForTime(timeWanted);
+    }
+    if (!m_bClipComplete && !decodeClipFrames(frame, pBmps)) {
+        if (SyncVideoDecoder::isEOF()) {
+            return FA_USE_LAST_FRAME;
+        } else {
+            // The clip didn't fit. pBmps contains the last frame decoded.
+            return FA_NEW_FRAME;
+        }
+    }
+    if (frame >= m_pClip->getNumFrames()) {
+        m_bEOF = true;
+        return FA_USE_LAST_FRAME;
+    }
+    if (frame == m_CurFrame) {
+        return FA_USE_LAST_FRAME;
+    }
+    m_CurFrame = frame;
+    m_NextFrame = frame+1;
+    // The bitmaps are shared with the clip. They are only read from here on.
+    const vector<BitmapPtr>& pFrameBmps = m_pClip->getFrame(frame);
+    for (unsigned i = 0; i < pBmps.size(); ++i) {
+        pBmps[i] = pFrameBmps[i];
+    }
+    return FA_NEW_FRAME;
+}
+
+void PreloadedVideoDecoder::throwAwayFrame(float timeWanted)
+{
+    AVG_ASSERT(getState() == DECODING);
+    if (!m_pClip) {
+        SyncVideoDecoder::throwAwayFrame(timeWanted);
+        return;
+    }
+    int frame = getFrameForTime(timeWanted);
+    if (!m_bClipComplete) {
+        vector<BitmapPtr> pBmps(getNumPixelFormatPlanes(getPixelFormat()));
+        if (!decodeClipFrames(frame, pBmps)) {
+            return;
+        }
+    }
+    if (frame >= m_pClip->getNumFrames()) {
+        m_bEOF = true;
+    } else {
+        m_CurFrame = frame;
+        m_NextFrame = frame+1;
+    }
+}
+
+void PreloadedVideoDecoder::seek(float destTime)
+{
+    AVG_ASSERT(getState() == DECODING);
+    if (!m_pClip) {
+        SyncVideoDecoder::seek(destTime);
+        if (destTime == 0) {
+            // Try again. Another decoder might have completed the clip in the meantime.
+            startClip();
+        }
+        return;
+    }
+    int frame = getFrameForTime(destTime);
+    if (m_bClipComplete) {
+        frame = min(frame, m_pClip->getNumFrames()-1);
+    } else if (frame > m_pClip->getNumFrames()) {
+        // Decoding all frames up to the seek target would stall playback.
+        abandonClip(false);
+        SyncVideoDecoder::seek(destTime);
+        return;
+    }
+    m_CurFrame = -1;
+    m_NextFrame = frame;
+    m_bEOF = false;
+}
+
+void PreloadedVideoDecoder::loop()
+{
+    seek(0);
+}
+
+bool PreloadedVideoDecoder::isEOF() const
+{
+    AVG_ASSERT(getState() == DECODING);
+    if (!m_pClip) {
+        return SyncVideoDecoder::isEOF();
+    }
+    return m_bEOF;
+}
+
+VideoClipPtr PreloadedVideoDecoder::getClip() const
+{
+    if (m_bClipComplete) {
+        return m_pClip;
+    } else {
+        return VideoClipPtr();
+    }
+}
+
+void PreloadedVideoDecoder::startClip()
+{
+    // The SyncVideoDecoder must be positioned at the start of the video.
+    m_CurFrame = -1;
+    m_NextFrame = 0;
+    m_bEOF = false;
+    VideoClipCache* pCache = VideoClipCache::get();
+    m_pClip = pCache->getClip(VideoClipCache::getKey(m_sFilename, getPixelFormat()));
+    m_bClipComplete = bool(m_pClip);
+    if (!m_pClip && !m_bPreloadFailed) {
+        m_pClip = VideoClipPtr(new VideoClip(getSize(), getPixelFormat()));
+        m_MemAvailable = pCache->getMemAvailable();
+    }
+}
+
+static ProfilingZoneID PreloadProfilingZone("Preloaded video: decode", true);
+
+// Decodes frames into the clip until it contains frame, then keeps decoding ahead
+// until the time budget is used up. Returns false if the clip was abandoned. In that
+// case, decoding continues on the fly.
+bool PreloadedVideoDecoder::decodeClipFrames(int frame, vector<BitmapPtr>& pBmps)
+{
+    ScopeTimer timer(PreloadProfilingZone);
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    while (m_pClip->getNumFrames() <= frame ||
+            TimeSource::get()->getCurrentMicrosecs()-startTime < PRELOAD_BUDGET_MICROSECS)
+    {
+        if (SyncVideoDecoder::getRenderedBmps(pBmps, -1) != FA_NEW_FRAME) {
+            return finishClip();
+        }
+        m_pClip->addFrame(pBmps);
+        if (m_pClip->getMemUsed() > m_MemAvailable) {
+            abandonClip(true);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PreloadedVideoDecoder::finishClip()
+{
+    VideoClipCache* pCache = VideoClipCache::get();
+    string sKey = VideoClipCache::getKey(m_sFilename, getPixelFormat());
+    VideoClipPtr pCachedClip = pCache->getClip(sKey);
+    if (pCachedClip) {
+        // Another decoder completed the same clip first.
+        m_pClip = pCachedClip;
+    } else if (m_pClip->getNumFrames() == 0 || !pCache->addClip(sKey, m_pClip)) {
+        abandonClip(true);
+        return false;
+    }
+    m_bClipComplete = true;
+    return true;
+}
+
+void PreloadedVideoDecoder::abandonClip(bool bFailed)
+{
+    if (bFailed) {
+        AVG_LOG_WARNING("Video " << m_sFilename <<
+                " couldn't be preloaded, decoding on the fly.");
+        m_bPreloadFailed = true;
+    }
+    m_pClip = VideoClipPtr();
+    m_bClipComplete = false;
+}
+
+int PreloadedVideoDecoder::getFrameForTime(float time) const
+{
+    // Frames are evenly spaced. A frame is current from half a frame before its time
+    // on, which matches the choice SyncVideoDecoder makes.
+    return max(int(time*getFPS()+0.5f), 0);
+}
+
+}
@@ -0,0 +1,84 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _PreloadedVideoDecoder_H_
+#define _PreloadedVideoDecoder_H_
+
+#include "../avgconfigwrapper.h"
+#include "SyncVideoDecoder.h"
+#include "VideoClipCache.h"
+
+namespace avg {
+
+// Keeps all frames of the video in memory, so playing, seeking and looping don't cost
+// any decoding time once the clip is complete. Meant for short clips. The clip is
+// built while the video plays: Every frame decodes at least the frames needed for
+// display and keeps decoding ahead for a short time after that, so the main thread
+// never stalls for the whole clip. Decoded clips are shared through the
+// VideoClipCache. If the clip doesn't fit into the cache, the decoder falls back to
+// decoding on the fly. The clip needs width*height*bytes per pixel*number of frames
+// bytes (1.5 bytes per pixel for YCbCr420p). Audio is not supported.
+class AVG_API PreloadedVideoDecoder: public SyncVideoDecoder
+{
+    public:
+        PreloadedVideoDecoder();
+        virtual ~PreloadedVideoDecoder();
+        virtual void open(const std::string& sFilename, bool bEnableSound);
+        virtual void startDecoding(bool bDeliverYCbCr, const AudioParams* pAP);
+        virtual void close();
+
+        virtual int getCurFrame() const;
+        virtual int getNumFramesQueued() const;
+        virtual float getCurTime() const;
+        virtual FrameAvailableCode getRenderedBmps(std::vector<BitmapPtr>& pBmps,
+                float timeWanted);
+        virtual void throwAwayFrame(float timeWanted);
+
+        virtual void seek(float destTime);
+        virtual void loop();
+        virtual bool isEOF() const;
+
+        // Empty if the clip isn't complete (yet).
+        VideoClipPtr getClip() const;
+
+    private:
+        void startClip();
+        bool decodeClipFrames(int frame, std::vector<BitmapPtr>& pBmps);
+        bool finishClip();
+        void abandonClip(bool bFailed);
+        int getFrameForTime(float time) const;
+
+        std::string m_sFilename;
+        // The clip that is played back. While m_bClipComplete is false, it is still
+        // being decoded and the SyncVideoDecoder is positioned after its last frame.
+        VideoClipPtr m_pClip;
+        bool m_bClipComplete;
+        long long m_MemAvailable;
+        bool m_bPreloadFailed;
+        int m_CurFrame;
+        int m_NextFrame;
+        bool m_bEOF;
+};
+
+typedef boost::shared_ptr<PreloadedVideoDecoder> PreloadedVideoDecoderPtr;
+
+}
+#endif
@@ -0,0 +1,136 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "SwsConverter.h"
+
+#include "../base/Exception.h"
+#include "../base/ThreadPool.h"
+#include "../graphics/Bitmap.h"
+
+#include <boost/bind.hpp>
+
+#if defined(__SSE2__) || defined(_WIN32)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace avg {
+
+static const int BAND_HEIGHT_STEP = 16;
+static const int MIN_BAND_HEIGHT = 64;
+
+SwsConverter::SwsConverter(const IntPoint& size, AVPixelFormat srcFmt,
+        AVPixelFormat destFmt, int numBands)
+    : m_Size(size),
+      m_SrcFmt(srcFmt)
+{
+    if (av_pix_fmt_desc_get(srcFmt)->log2_chroma_h != 0) {
+        numBands = 1;
+    } else if (numBands == 0) {
+        numBands = ThreadPool::get()->getNumThreads()+1;
+        numBands = max(1, min(numBands, size.y/MIN_BAND_HEIGHT));
+    }
+    m_BandHeight = (size.y+numBands-1)/numBands;
+    if (numBands > 1) {
+        m_BandHeight = ((m_BandHeight+BAND_HEIGHT_STEP-1)/BAND_HEIGHT_STEP)*
+                BAND_HEIGHT_STEP;
+    }
+    for (int y = 0; y < size.y; y += m_BandHeight) {
+        int bandHeight = min(m_BandHeight, size.y-y);
+        SwsContext* pContext = sws_getContext(size.x, bandHeight, srcFmt,
+                size.x, bandHeight, destFmt, SWS_BICUBIC, 0, 0, 0);
+        AVG_ASSERT(pContext);
+        m_pContexts.push_back(pContext);
+    }
+}
+
+SwsConverter::~SwsConverter()
+{
+    for (unsigned i = 0; i < m_pContexts.size(); ++i) {
+        sws_freeContext(m_pContexts[i]);
+    }
+}
+
+void SwsConverter::convert(AVFrame* pFrame, BitmapPtr pBmp)
+{
+    AVG_ASSERT(pBmp->getSize() == m_Size);
+    int numBands = getNumBands();
+    if (numBands == 1) {
+        convertBands(pFrame, pBmp, 0, 1);
+    } else {
+        ThreadPool::get()->parallelFor(numBands, boost::bind(
+                &SwsConverter::convertBands, this, pFrame, pBmp, _1, _2));
+    }
+}
+
+int SwsConverter::getNumBands() const
+{
+    return int(m_pContexts.size());
+}
+
+static void setOpaqueAlpha(unsigned char* pLine, int width)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(_WIN32)
+    __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+    for (; x < width-3; x += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(pLine+x*4));
+        _mm_storeu_si128((__m128i*)(pLine+x*4), _mm_or_si128(pixels, alphaMask));
+    }
+#endif
+    for (; x < width; ++x) {
+        pLine[x*4+3] = 0xFF;
+    }
+}
+
+void SwsConverter::convertBands(AVFrame* pFrame, BitmapPtr pBmp, int startBand,
+        int endBand)
+{
+    int numPlanes = av_pix_fmt_count_planes(m_SrcFmt);
+    bool bSetAlpha = (pBmp->getPixelFormat() == B8G8R8X8 || 
+            pBmp->getPixelFormat() == R8G8B8X8);
+    for (int band = startBand; band < endBand; ++band) {
+        int startY = band*m_BandHeight;
+        int bandHeight = min(m_BandHeight, m_Size.y-startY);
+        // Bands are only used without vertical chroma subsampling, so all planes
+        // start at the same line.
+        const uint8_t* pSrcData[AV_NUM_DATA_POINTERS];
+        for (int i = 0; i < AV_NUM_DATA_POINTERS; ++i) {
+            pSrcData[i] = pFrame->data[i];
+            if (i < numPlanes) {
+                pSrcData[i] += startY*pFrame->linesize[i];
+            }
+        }
+        uint8_t* pDestData[4] = {pBmp->getPixels()+startY*pBmp->getStride(), 0, 0, 0};
+        int destLinesize[4] = {pBmp->getStride(), 0, 0, 0};
+        sws_scale(m_pContexts[band], pSrcData, pFrame->linesize, 0, bandHeight,
+                pDestData, destLinesize);
+        if (bSetAlpha) {
+            // Make sure the alpha channel is white while the band is still in cache.
+            for (int y = startY; y < startY+bandHeight; ++y) {
+                setOpaqueAlpha(pBmp->getPixels()+y*pBmp->getStride(), m_Size.x);
+            }
+        }
+    }
+}
+
+}
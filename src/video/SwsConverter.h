@@ -0,0 +1,70 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _SwsConverter_H_
+#define _SwsConverter_H_
+
+#include "../avgconfigwrapper.h"
+
+#include "WrapFFMpeg.h"
+
+#include "../base/GLMHelper.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// Converts frames to bitmaps using sws_scale(). sws_scale() is single-threaded, so
+// frames are converted in horizontal bands that run in parallel, each with its own
+// context. Bands are only used if the source format has no vertical chroma
+// subsampling: Otherwise, the vertical chroma filter would see the band boundaries
+// as image edges and leave visible seams.
+class AVG_API SwsConverter
+{
+    public:
+        // If numBands is 0, the number of bands is chosen based on the number of
+        // cores.
+        SwsConverter(const IntPoint& size, AVPixelFormat srcFmt, AVPixelFormat destFmt,
+                int numBands=0);
+        virtual ~SwsConverter();
+
+        void convert(AVFrame* pFrame, BitmapPtr pBmp);
+        int getNumBands() const;
+
+    private:
+        void convertBands(AVFrame* pFrame, BitmapPtr pBmp, int startBand,
+                int endBand);
+
+        std::vector<SwsContext*> m_pContexts;
+        IntPoint m_Size;
+        AVPixelFormat m_SrcFmt;
+        int m_BandHeight;
+};
+
+typedef boost::shared_ptr<SwsConverter> SwsConverterPtr;
+
+}
+#endif
@@ -78,6 +78,7 @@ void SyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP)
     vector<int> streamIndexes;
     streamIndexes.push_back(getVStreamIndex());
     m_pDemuxer = new FFMpegDemuxer(getFormatContext(), streamIndexes);
+    m_pDemuxer->setKeyframeIndex(getKeyframeIndex());
 
     m_pFrameDecoder = FFMpegFrameDecoderPtr(new FFMpegFrameDecoder(getVideoStream()));
     m_pFrameDecoder->setFPS(m_FPS);
@@ -103,7 +104,7 @@ void SyncVideoDecoder::seek(float destTime)
     }
     m_pDemuxer->seek(destTime);
     m_bVideoSeekDone = true;
-    m_pFrameDecoder->handleSeek();
+    m_pFrameDecoder->handleSeek(destTime);
 }
 
 void SyncVideoDecoder::loop()
@@ -160,7 +161,10 @@ FrameAvailableCode SyncVideoDecoder::getRenderedBmps(vector<BitmapPtr>& pBmps,
     ScopeTimer timer(RenderToBmpProfilingZone);
     FrameAvailableCode frameAvailable;
     if (timeWanted == -1) {
-        readFrame(m_pFrame);
+        // After a seek, this is the first frame at the seek target.
+        do {
+            readFrame(m_pFrame);
+        } while (m_pFrameDecoder->isFrameBeforeSeekTarget() && !isEOF());
         frameAvailable = FA_NEW_FRAME;
     } else {
         frameAvailable = readFrameForTime(m_pFrame, timeWanted);
@@ -168,16 +172,31 @@ FrameAvailableCode SyncVideoDecoder::getRenderedBmps(vector<BitmapPtr>& pBmps,
     if (frameAvailable == FA_USE_LAST_FRAME || isEOF()) {
         return FA_USE_LAST_FRAME;
     } else {
-        allocFrameBmps(pBmps);
-        if (pixelFormatIsPlanar(getPixelFormat())) {
+        VideoFramePoolPtr pFramePool = getFramePool();
+        long long bytesCopied = 0;
+        vector<BitmapPtr> pPlaneBmps;
+        if (pixelFormatIsPlanar(getPixelFormat()) &&
+                pFramePool->getPlaneBmps(m_pFrame, getSize(), getPixelFormat(),
+                        pPlaneBmps))
+        {
+            for (unsigned i = 0; i < pBmps.size(); ++i) {
+                pBmps[i] = pPlaneBmps[i];
+            }
+        } else if (pixelFormatIsPlanar(getPixelFormat())) {
             ScopeTimer timer(CopyImageProfilingZone);
+            allocFrameBmps(pBmps);
             for (unsigned i = 0; i < pBmps.size(); ++i) {
                 m_pFrameDecoder->copyPlaneToBmp(pBmps[i], m_pFrame->data[i],
                         m_pFrame->linesize[i]);
+                bytesCopied += pBmps[i]->getSize().x*pBmps[i]->getSize().y;
             }
         } else {
+            allocFrameBmps(pBmps);
             m_pFrameDecoder->convertFrameToBmp(m_pFrame, pBmps[0]);
+            bytesCopied = pBmps[0]->getSize().x*pBmps[0]->getBytesPerPixel()*
+                    pBmps[0]->getSize().y;
         }
+        pFramePool->addFrame(bytesCopied);
         return FA_NEW_FRAME;
     }
 }
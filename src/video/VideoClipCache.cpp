@@ -0,0 +1,184 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "VideoClipCache.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+
+#include "../graphics/Bitmap.h"
+#include "../graphics/ImageCache.h"
+
+using namespace std;
+
+namespace avg {
+
+VideoClip::VideoClip(const IntPoint& size, PixelFormat pf)
+    : m_Size(size),
+      m_PF(pf),
+      m_MemUsed(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+VideoClip::~VideoClip()
+{
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+void VideoClip::addFrame(const vector<BitmapPtr>& pBmps)
+{
+    vector<BitmapPtr> pFrameBmps;
+    for (unsigned i = 0; i < pBmps.size(); ++i) {
+        // The decoder's bitmaps are recycled or reference decoder buffers.
+        BitmapPtr pBmp(new Bitmap(*pBmps[i]));
+        m_MemUsed += pBmp->getMemNeeded();
+        pFrameBmps.push_back(pBmp);
+    }
+    m_Frames.push_back(pFrameBmps);
+}
+
+int VideoClip::getNumFrames() const
+{
+    return int(m_Frames.size());
+}
+
+const vector<BitmapPtr>& VideoClip::getFrame(int i) const
+{
+    AVG_ASSERT(i >= 0 && i < int(m_Frames.size()));
+    return m_Frames[i];
+}
+
+IntPoint VideoClip::getSize() const
+{
+    return m_Size;
+}
+
+PixelFormat VideoClip::getPixelFormat() const
+{
+    return m_PF;
+}
+
+long long VideoClip::getMemUsed() const
+{
+    return m_MemUsed;
+}
+
+
+VideoClipCache* VideoClipCache::s_pInstance = 0;
+
+VideoClipCache* VideoClipCache::get()
+{
+    if (!s_pInstance) {
+        s_pInstance = new VideoClipCache();
+    }
+    return s_pInstance;
+}
+
+VideoClipCache::VideoClipCache()
+    : m_MemUsed(0)
+{
+}
+
+VideoClipCache::~VideoClipCache()
+{
+}
+
+string VideoClipCache::getKey(const string& sFilename, PixelFormat pf)
+{
+    return sFilename+"|"+getPixelFormatString(pf);
+}
+
+VideoClipPtr VideoClipCache::getClip(const string& sKey)
+{
+    for (ClipList::iterator it = m_Clips.begin(); it != m_Clips.end(); ++it) {
+        if (it->first == sKey) {
+            m_Clips.splice(m_Clips.begin(), m_Clips, it);
+            return m_Clips.front().second;
+        }
+    }
+    return VideoClipPtr();
+}
+
+long long VideoClipCache::getMemAvailable() const
+{
+    long long memAvailable = getImageMemAvailable() - m_MemUsed;
+    for (ClipList::const_iterator it = m_Clips.begin(); it != m_Clips.end(); ++it) {
+        if (it->second.unique()) {
+            memAvailable += it->second->getMemUsed();
+        }
+    }
+    return memAvailable;
+}
+
+bool VideoClipCache::addClip(const string& sKey, VideoClipPtr pClip)
+{
+    AVG_ASSERT(!getClip(sKey));
+    long long memNeeded = pClip->getMemUsed();
+    if (memNeeded > getMemAvailable()) {
+        return false;
+    }
+    unloadUnusedClips(memNeeded);
+    m_Clips.push_front(make_pair(sKey, pClip));
+    m_MemUsed += memNeeded;
+    ImageCache::get()->addExternalMemUsed(memNeeded);
+    return true;
+}
+
+int VideoClipCache::getNumClips() const
+{
+    return int(m_Clips.size());
+}
+
+long long VideoClipCache::getMemUsed() const
+{
+    return m_MemUsed;
+}
+
+void VideoClipCache::unloadUnusedClips(long long memNeeded)
+{
+    // Unloads least recently used clips until memNeeded fits next to the images in
+    // use. Unused images are evicted by the image cache afterwards if necessary.
+    ImageCache* pImageCache = ImageCache::get();
+    long long capacity = getImageMemAvailable();
+    ClipList::iterator it = m_Clips.end();
+    while (m_MemUsed+memNeeded > capacity && it != m_Clips.begin()) {
+        --it;
+        if (it->second.unique()) {
+            long long clipMem = it->second->getMemUsed();
+            m_MemUsed -= clipMem;
+            pImageCache->addExternalMemUsed(-clipMem);
+            it = m_Clips.erase(it);
+        }
+    }
+}
+
+long long VideoClipCache::getImageMemAvailable() const
+{
+    // Memory of unused images counts as available, since ImageCache unloads them to
+    // make room for external memory.
+    ImageCache* pImageCache = ImageCache::get();
+    return pImageCache->getCapacity(CachedImage::STORAGE_CPU) -
+            pImageCache->getMemUsed(CachedImage::STORAGE_CPU) +
+            pImageCache->getMemEvictable(CachedImage::STORAGE_CPU);
+}
+
+}
@@ -0,0 +1,102 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _VideoClipCache_H_
+#define _VideoClipCache_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../graphics/PixelFormat.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <list>
+#include <string>
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// All frames of a short video, decoded. Planar pixel formats are stored as planes,
+// so a YCbCr420p clip needs 1.5 bytes per pixel and frame.
+class AVG_API VideoClip
+{
+public:
+    VideoClip(const IntPoint& size, PixelFormat pf);
+    virtual ~VideoClip();
+
+    // Copies the bitmaps.
+    void addFrame(const std::vector<BitmapPtr>& pBmps);
+    int getNumFrames() const;
+    const std::vector<BitmapPtr>& getFrame(int i) const;
+    IntPoint getSize() const;
+    PixelFormat getPixelFormat() const;
+    long long getMemUsed() const;
+
+private:
+    std::vector<std::vector<BitmapPtr> > m_Frames;
+    IntPoint m_Size;
+    PixelFormat m_PF;
+    long long m_MemUsed;
+};
+
+typedef boost::shared_ptr<VideoClip> VideoClipPtr;
+
+// Keeps preloaded clips so videos that play the same file share the frames. Clips
+// count against the CPU memory budget of the ImageCache. Clips that aren't in use
+// are kept until the memory is needed. Must be used from the main thread only.
+class AVG_API VideoClipCache
+{
+public:
+    static VideoClipCache* get();
+    virtual ~VideoClipCache();
+
+    static std::string getKey(const std::string& sFilename, PixelFormat pf);
+    // Returns an empty pointer if the clip isn't cached.
+    VideoClipPtr getClip(const std::string& sKey);
+    // Memory that a new clip may use, including the memory of unused clips that
+    // can be unloaded.
+    long long getMemAvailable() const;
+    // Returns false if there isn't enough memory for the clip.
+    bool addClip(const std::string& sKey, VideoClipPtr pClip);
+
+    int getNumClips() const;
+    long long getMemUsed() const;
+
+private:
+    VideoClipCache();
+    void unloadUnusedClips(long long memNeeded);
+    long long getImageMemAvailable() const;
+
+    typedef std::list<std::pair<std::string, VideoClipPtr> > ClipList;
+    // Most recently used first.
+    ClipList m_Clips;
+    long long m_MemUsed;
+
+    static VideoClipCache* s_pInstance;
+};
+
+}
+
+#endif
@@ -47,6 +47,8 @@ boost::mutex VideoDecoder::s_OpenMutex;
 VideoDecoder::VideoDecoder()
     : m_State(CLOSED),
       m_pFormatContext(0),
+      m_pFramePool(new VideoFramePool()),
+      m_bKeyframeIndexEnabled(false),
       m_VStreamIndex(-1),
       m_pVStream(0),
       m_PF(NO_PIXELFORMAT),
@@ -133,6 +135,9 @@ void VideoDecoder::open(const string& sFilename, bool bEnableSound)
                     sFilename + ": unsupported video codec ("+szCodec+").");
         }
         m_PF = calcPixelFormat(true);
+        if (m_bKeyframeIndexEnabled) {
+            initKeyframeIndex();
+        }
     }
     // Enable audio stream demuxing.
     if (m_AStreamIndex >= 0) {
@@ -209,6 +214,7 @@ void VideoDecoder::close()
     if (m_pFormatContext) {
         avformat_close_input(&m_pFormatContext);
     }
+    m_pKeyframeIndex = KeyframeIndexPtr();
     
     m_State = CLOSED;
 }
@@ -292,19 +298,44 @@ AVCodecContext* VideoDecoder::getCodecContext()
     return m_pVStream->codec;
 }
 
+VideoFramePoolPtr VideoDecoder::getFramePool() const
+{
+    return m_pFramePool;
+}
+
+void VideoDecoder::setKeyframeIndexEnabled(bool bEnabled, const string& sCacheFilename)
+{
+    m_bKeyframeIndexEnabled = bEnabled;
+    m_sKeyframeIndexFilename = sCacheFilename;
+}
+
+KeyframeIndexPtr VideoDecoder::getKeyframeIndex() const
+{
+    return m_pKeyframeIndex;
+}
+
+float VideoDecoder::getKeyframeTime(float time) const
+{
+    if (m_pKeyframeIndex) {
+        return m_pKeyframeIndex->getKeyframeTime(time);
+    } else {
+        return time;
+    }
+}
+
 void VideoDecoder::allocFrameBmps(vector<BitmapPtr>& pBmps)
 {
     if (pixelFormatIsPlanar(getPixelFormat())) {
         IntPoint size = getSize();
-        pBmps[0] = BitmapPtr(new Bitmap(size, I8));
+        pBmps[0] = m_pFramePool->getBmp(size, I8);
         IntPoint halfSize(size.x/2, size.y/2);
-        pBmps[1] = BitmapPtr(new Bitmap(halfSize, I8));
-        pBmps[2] = BitmapPtr(new Bitmap(halfSize, I8));
+        pBmps[1] = m_pFramePool->getBmp(halfSize, I8);
+        pBmps[2] = m_pFramePool->getBmp(halfSize, I8);
         if (pixelFormatHasAlpha(getPixelFormat())) {
-            pBmps[3] = BitmapPtr(new Bitmap(size, I8));
+            pBmps[3] = m_pFramePool->getBmp(size, I8);
         }
     } else {
-        pBmps[0] = BitmapPtr(new Bitmap(getSize(), getPixelFormat()));
+        pBmps[0] = m_pFramePool->getBmp(getSize(), getPixelFormat());
     }
 }
 
@@ -350,6 +381,11 @@ int VideoDecoder::openCodec(int streamIndex)
     if (!pCodec) {
         return -1;
     }
+    if (pContext->codec_type == AVMEDIA_TYPE_VIDEO) {
+        // Decoded frames stay valid after the next decode call, so their planes can be
+        // passed on without copying (see VideoFramePool::getPlaneBmps()).
+        pContext->refcounted_frames = 1;
+    }
     int rc = avcodec_open2(pContext, pCodec, 0);
     if (rc < 0) {
         return -1;
@@ -357,6 +393,19 @@ int VideoDecoder::openCodec(int streamIndex)
     return 0;
 }
 
+void VideoDecoder::initKeyframeIndex()
+{
+    m_pKeyframeIndex = KeyframeIndexPtr(new KeyframeIndex(m_pVStream));
+    if (m_sKeyframeIndexFilename == "" ||
+            !m_pKeyframeIndex->load(m_sKeyframeIndexFilename, m_sFilename))
+    {
+        m_pKeyframeIndex->build(m_pFormatContext);
+        if (m_sKeyframeIndexFilename != "") {
+            m_pKeyframeIndex->save(m_sKeyframeIndexFilename, m_sFilename);
+        }
+    }
+}
+
 float VideoDecoder::getDuration(StreamSelect streamSelect) const
 {
     AVG_ASSERT(m_State != CLOSED);
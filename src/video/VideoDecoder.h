@@ -26,6 +26,8 @@
 #include "../avgconfigwrapper.h"
 
 #include "VideoInfo.h"
+#include "VideoFramePool.h"
+#include "KeyframeIndex.h"
 
 #include "../graphics/PixelFormat.h"
 
@@ -79,6 +81,18 @@ class AVG_API VideoDecoder
         virtual bool isEOF() const = 0;
         virtual void throwAwayFrame(float timeWanted) = 0;
 
+        // Source of the frame bitmaps. Also keeps the copy statistics.
+        VideoFramePoolPtr getFramePool() const;
+
+        // Takes effect on the next open(). If sCacheFilename isn't empty, the index is
+        // loaded from there if possible and written there after it has been built.
+        void setKeyframeIndexEnabled(bool bEnabled, const std::string& sCacheFilename);
+        // Empty if the index is disabled.
+        KeyframeIndexPtr getKeyframeIndex() const;
+        // Start time of the keyframe at or before time. Decoding from there doesn't
+        // need any frames before it. Without keyframe index, returns time.
+        float getKeyframeTime(float time) const;
+
         // Prevents different decoder instances from executing open/close simultaneously
         static boost::mutex s_OpenMutex;
 
@@ -97,13 +111,18 @@ class AVG_API VideoDecoder
     private:
         void initVideoSupport();
         int openCodec(int streamIndex);
+        void initKeyframeIndex();
         float getDuration(StreamSelect streamSelect) const;
         PixelFormat calcPixelFormat(bool bUseYCbCr);
         std::string getStreamPF() const;
 
         DecoderState m_State;
         AVFormatContext * m_pFormatContext;
+        VideoFramePoolPtr m_pFramePool;
         std::string m_sFilename;
+        bool m_bKeyframeIndexEnabled;
+        std::string m_sKeyframeIndexFilename;
+        KeyframeIndexPtr m_pKeyframeIndex;
 
         // Video
         int m_VStreamIndex;
@@ -0,0 +1,208 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "VideoDecoderPool.h"
+
+#include "../base/ConfigMgr.h"
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ThreadHelper.h"
+#include "../base/ThreadProfiler.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+// Idle threads check for ready tasks at least this often. Not every event that makes
+// a task ready (e.g. the audio thread consuming buffers) calls notify().
+static const int POLL_INTERVAL = 5;
+
+VideoDecoderPool* VideoDecoderPool::s_pInstance = 0;
+
+VideoDecoderPool* VideoDecoderPool::get()
+{
+    static boost::mutex initMutex;
+    static bool bInitialized = false;
+    lock_guard lock(initMutex);
+    if (!bInitialized) {
+        bInitialized = true;
+        int numThreads = ConfigMgr::get()->getIntOption("vid", "decoderthreads", -1);
+        if (numThreads < 0) {
+            numThreads = max(int(boost::thread::hardware_concurrency()), 2);
+        }
+        if (numThreads > 0) {
+            s_pInstance = new VideoDecoderPool(numThreads);
+        }
+    }
+    return s_pInstance;
+}
+
+VideoDecoderPool::VideoDecoderPool(int numThreads)
+    : m_NumThreads(numThreads),
+      m_NumSteps(0)
+{
+    AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
+            "Video decoder pool: " << m_NumThreads << " threads");
+    for (int i = 0; i < m_NumThreads; ++i) {
+        m_Threads.create_thread(boost::bind(&VideoDecoderPool::threadLoop, this));
+    }
+}
+
+VideoDecoderPool::~VideoDecoderPool()
+{
+}
+
+void VideoDecoderPool::addTask(PooledTaskPtr pTask)
+{
+    {
+        lock_guard lock(m_Mutex);
+        TaskEntry entry;
+        entry.m_pTask = pTask;
+        entry.m_bInitialized = false;
+        entry.m_bRunning = false;
+        entry.m_LastStep = -1;
+        m_Tasks.push_back(entry);
+    }
+    m_WorkCond.notify_one();
+}
+
+void VideoDecoderPool::waitForTask(PooledTaskPtr pTask)
+{
+    notify();
+    boost::unique_lock<boost::mutex> lock(m_Mutex);
+    while (true) {
+        bool bFound = false;
+        for (TaskIterator it = m_Tasks.begin(); it != m_Tasks.end(); ++it) {
+            if (it->m_pTask == pTask) {
+                bFound = true;
+                break;
+            }
+        }
+        if (!bFound) {
+            return;
+        }
+        m_DoneCond.wait(lock);
+    }
+}
+
+void VideoDecoderPool::notify()
+{
+    m_WorkCond.notify_all();
+}
+
+int VideoDecoderPool::getNumThreads() const
+{
+    return m_NumThreads;
+}
+
+int VideoDecoderPool::getNumTasks() const
+{
+    lock_guard lock(m_Mutex);
+    return int(m_Tasks.size());
+}
+
+void VideoDecoderPool::threadLoop()
+{
+    setAffinityMask(false);
+    ThreadProfiler* pProfiler = ThreadProfiler::get();
+    pProfiler->setName("Video Decoder Pool");
+    pProfiler->setLogCategory(Logger::category::PROFILE_VIDEO);
+    pProfiler->start();
+    while (true) {
+        TaskIterator it;
+        {
+            boost::unique_lock<boost::mutex> lock(m_Mutex);
+            it = findNextTask();
+            while (it == m_Tasks.end()) {
+                m_WorkCond.timed_wait(lock,
+                        boost::posix_time::milliseconds(POLL_INTERVAL));
+                it = findNextTask();
+            }
+            it->m_bRunning = true;
+        }
+
+        // The entry stays in the list while m_bRunning is set: only the thread
+        // running a task removes it.
+        PooledTask* pTask = it->m_pTask.get();
+        bool bRunning;
+        bool bInitialized = it->m_bInitialized;
+        try {
+            if (bInitialized) {
+                bRunning = pTask->step();
+            } else {
+                bRunning = pTask->init();
+                bInitialized = bRunning;
+            }
+            if (!bRunning && bInitialized) {
+                pTask->deinit();
+            }
+        } catch (const Exception& e) {
+            AVG_LOG_ERROR("Uncaught exception in video decoder pool: " << e.getStr());
+            bRunning = false;
+        }
+
+        {
+            lock_guard lock(m_Mutex);
+            if (bRunning) {
+                it->m_bInitialized = true;
+                it->m_bRunning = false;
+                it->m_LastStep = m_NumSteps++;
+            } else {
+                m_Tasks.erase(it);
+            }
+        }
+        if (!bRunning) {
+            m_DoneCond.notify_all();
+        }
+    }
+}
+
+VideoDecoderPool::TaskIterator VideoDecoderPool::findNextTask()
+{
+    // Must be called with m_Mutex held. Returns m_Tasks.end() if no task is ready.
+    TaskIterator bestIt = m_Tasks.end();
+    float bestDeadline = 0;
+    for (TaskIterator it = m_Tasks.begin(); it != m_Tasks.end(); ++it) {
+        if (it->m_bRunning) {
+            continue;
+        }
+        if (!it->m_bInitialized) {
+            return it;
+        }
+        if (!it->m_pTask->isReady()) {
+            continue;
+        }
+        float deadline = it->m_pTask->getDeadline();
+        if (bestIt == m_Tasks.end() || deadline < bestDeadline ||
+                (deadline == bestDeadline && it->m_LastStep < bestIt->m_LastStep))
+        {
+            bestIt = it;
+            bestDeadline = deadline;
+        }
+    }
+    return bestIt;
+}
+
+}
@@ -0,0 +1,147 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _VideoDecoderPool_H_
+#define _VideoDecoderPool_H_
+
+#include "../api.h"
+
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <list>
+
+namespace avg {
+
+// A unit of work that VideoDecoderPool steps through. All methods are called by pool
+// threads, never by two threads at once.
+class AVG_API PooledTask
+{
+public:
+    virtual ~PooledTask() {}
+
+    virtual bool init() = 0;
+    // True if step() would make progress without blocking.
+    virtual bool isReady() const = 0;
+    // Seconds until the task's output is needed. Ready tasks with the smallest
+    // deadline run first.
+    virtual float getDeadline() const = 0;
+    // Returns false when the task is done.
+    virtual bool step() = 0;
+    virtual void deinit() = 0;
+};
+
+typedef boost::shared_ptr<PooledTask> PooledTaskPtr;
+
+// Adapts a WorkerThread that implements canWork() and getDeadline() to the pool.
+template<class WORKER>
+class PooledWorker: public PooledTask
+{
+public:
+    PooledWorker(WORKER* pWorker)
+        : m_pWorker(pWorker)
+    {
+    }
+
+    virtual bool init()
+    {
+        return m_pWorker->poolInit();
+    }
+
+    virtual bool isReady() const
+    {
+        return m_pWorker->hasCmds() || m_pWorker->canWork();
+    }
+
+    virtual float getDeadline() const
+    {
+        return m_pWorker->getDeadline();
+    }
+
+    virtual bool step()
+    {
+        return m_pWorker->poolStep(m_pWorker->canWork());
+    }
+
+    virtual void deinit()
+    {
+        m_pWorker->poolDeinit();
+    }
+
+private:
+    boost::shared_ptr<WORKER> m_pWorker;
+};
+
+// Fixed set of threads that runs the demuxers and decoders of all threaded videos
+// so the number of threads doesn't grow with the number of videos. Each pool thread
+// repeatedly picks the ready task with the earliest deadline - ties go to the task
+// that has waited longest - and runs one step of it.
+class AVG_API VideoDecoderPool
+{
+public:
+    // Returns 0 if videos should use their own threads (vid/decoderthreads == 0).
+    static VideoDecoderPool* get();
+    virtual ~VideoDecoderPool();
+
+    template<class WORKER>
+    PooledTaskPtr addWorker(WORKER* pWorker)
+    {
+        PooledTaskPtr pTask(new PooledWorker<WORKER>(pWorker));
+        addTask(pTask);
+        return pTask;
+    }
+    void addTask(PooledTaskPtr pTask);
+    // Blocks until the task has finished and has been removed from the pool.
+    void waitForTask(PooledTaskPtr pTask);
+    // Wakes up idle threads after something happened that might make a task ready.
+    void notify();
+
+    int getNumThreads() const;
+    int getNumTasks() const;
+
+private:
+    struct TaskEntry {
+        PooledTaskPtr m_pTask;
+        bool m_bInitialized;
+        bool m_bRunning;
+        long long m_LastStep;
+    };
+
+    typedef std::list<TaskEntry>::iterator TaskIterator;
+
+    VideoDecoderPool(int numThreads);
+    void threadLoop();
+    TaskIterator findNextTask();
+
+    boost::thread_group m_Threads;
+    std::list<TaskEntry> m_Tasks;
+    mutable boost::mutex m_Mutex;
+    boost::condition_variable m_WorkCond;
+    boost::condition_variable m_DoneCond;
+    int m_NumThreads;
+    long long m_NumSteps;
+
+    static VideoDecoderPool* s_pInstance;
+};
+
+}
+
+#endif
@@ -36,13 +36,13 @@ using namespace std;
 namespace avg {
 
 VideoDecoderThread::VideoDecoderThread(CQueue& cmdQ, VideoMsgQueue& msgQ, 
-        VideoMsgQueue& packetQ, AVStream* pStream, const IntPoint& size, PixelFormat pf)
+        VideoMsgQueue& packetQ, AVStream* pStream, const IntPoint& size, PixelFormat pf,
+        VideoFramePoolPtr pFramePool)
     : WorkerThread<VideoDecoderThread>(string("Video Decoder"), cmdQ, 
             Logger::category::PROFILE_VIDEO),
       m_MsgQ(msgQ),
       m_PacketQ(packetQ),
-      m_pBmpQ(new BitmapQueue()),
-      m_pHalfBmpQ(new BitmapQueue()),
+      m_pFramePool(pFramePool),
       m_Size(size),
       m_PF(pf),
       m_bSeekDone(false),
@@ -105,21 +105,35 @@ bool VideoDecoderThread::work()
     return true;
 }
 
-void VideoDecoderThread::setFPS(float fps)
+bool VideoDecoderThread::canWork() const
 {
-    m_pFrameDecoder->setFPS(fps);
+    if (!m_bProcessingLastFrames) {
+        VideoMsgPtr pMsg = m_PacketQ.peek(false);
+        if (!pMsg) {
+            return false;
+        }
+        if (pMsg->getType() == VideoMsg::SEEK_DONE || pMsg->getType() == VideoMsg::CLOSED)
+        {
+            // These clear the message queue before pushing anything.
+            return true;
+        }
+    }
+    return m_MsgQ.size() < m_MsgQ.getMaxSize();
 }
 
-void VideoDecoderThread::returnFrame(VideoMsgPtr pMsg)
+float VideoDecoderThread::getDeadline() const
 {
-    m_pBmpQ->push(pMsg->getFrameBitmap(0));
-    if (pixelFormatIsPlanar(m_PF)) {
-        m_pHalfBmpQ->push(pMsg->getFrameBitmap(1));
-        m_pHalfBmpQ->push(pMsg->getFrameBitmap(2));
-        if (m_PF == YCbCrA420p) {
-            m_pBmpQ->push(pMsg->getFrameBitmap(3));
-        }
+    // Time until the main thread runs out of decoded frames if the video is playing.
+    float fps = m_pFrameDecoder->getFPS();
+    if (fps <= 0) {
+        return 0;
     }
+    return m_MsgQ.size()/fps;
+}
+
+void VideoDecoderThread::setFPS(float fps)
+{
+    m_pFrameDecoder->setFPS(fps);
 }
 
 void VideoDecoderThread::decodePacket(AVPacket* pPacket)
@@ -127,7 +141,9 @@ void VideoDecoderThread::decodePacket(AVPacket* pPacket)
     bool bGotPicture = m_pFrameDecoder->decodePacket(pPacket, m_pFrame, m_bSeekDone);
     if (bGotPicture) {
         m_bSeekDone = false;
-        sendFrame(m_pFrame);
+        if (!m_pFrameDecoder->isFrameBeforeSeekTarget()) {
+            sendFrame(m_pFrame);
+        }
     }
 }
 
@@ -135,10 +151,12 @@ void VideoDecoderThread::handleEOF()
 {
     bool bGotPicture = m_pFrameDecoder->decodeLastFrame(m_pFrame);
     if (bGotPicture) {
-        sendFrame(m_pFrame);
+        if (!m_pFrameDecoder->isFrameBeforeSeekTarget()) {
+            sendFrame(m_pFrame);
+        }
     } else {
         m_bProcessingLastFrames = false;
-        VideoMsgPtr pMsg(new VideoMsg());
+        VideoMsgPtr pMsg = VideoMsg::create();
         pMsg->setEOF();
         pushMsg(pMsg);
     }
@@ -146,7 +164,9 @@ void VideoDecoderThread::handleEOF()
 
 void VideoDecoderThread::handleSeekDone(VideoMsgPtr pMsg)
 {
-    m_pFrameDecoder->handleSeek();
+    // Frames before the seek target would be thrown away by the main thread anyway,
+    // so they aren't converted or sent.
+    m_pFrameDecoder->handleSeek(pMsg->getSeekTime());
     m_bSeekDone = true;
     m_MsgQ.clear();
     pushMsg(pMsg);
@@ -156,26 +176,37 @@ static ProfilingZoneID CopyImageProfilingZone("Copy image", true);
 
 void VideoDecoderThread::sendFrame(AVFrame* pFrame)
 {
-    VideoMsgPtr pMsg(new VideoMsg());
-    vector<BitmapPtr> pBmps;
+    VideoMsgPtr pMsg = VideoMsg::create();
+    // The vector is kept between frames to avoid reallocating it.
+    vector<BitmapPtr>& pBmps = m_pFrameBmps;
+    pBmps.clear();
+    long long bytesCopied = 0;
     if (pixelFormatIsPlanar(m_PF)) {
-        ScopeTimer timer(CopyImageProfilingZone);
-        IntPoint halfSize(m_Size.x/2, m_Size.y/2);
-        pBmps.push_back(getBmp(m_pBmpQ, m_Size, I8));
-        pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
-        pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
-        if (m_PF == YCbCrA420p) {
-            pBmps.push_back(getBmp(m_pBmpQ, m_Size, I8));
-        }
-        for (unsigned i = 0; i < pBmps.size(); ++i) {
-            m_pFrameDecoder->copyPlaneToBmp(pBmps[i], pFrame->data[i], 
-                    pFrame->linesize[i]);
+        // Reference counted frames are passed on without copying the planes.
+        if (!m_pFramePool->getPlaneBmps(pFrame, m_Size, m_PF, pBmps)) {
+            ScopeTimer timer(CopyImageProfilingZone);
+            IntPoint halfSize(m_Size.x/2, m_Size.y/2);
+            pBmps.push_back(m_pFramePool->getBmp(m_Size, I8));
+            pBmps.push_back(m_pFramePool->getBmp(halfSize, I8));
+            pBmps.push_back(m_pFramePool->getBmp(halfSize, I8));
+            if (m_PF == YCbCrA420p) {
+                pBmps.push_back(m_pFramePool->getBmp(m_Size, I8));
+            }
+            for (unsigned i = 0; i < pBmps.size(); ++i) {
+                m_pFrameDecoder->copyPlaneToBmp(pBmps[i], pFrame->data[i], 
+                        pFrame->linesize[i]);
+                bytesCopied += pBmps[i]->getSize().x*pBmps[i]->getSize().y;
+            }
         }
     } else {
-        pBmps.push_back(getBmp(m_pBmpQ, m_Size, m_PF));
+        pBmps.push_back(m_pFramePool->getBmp(m_Size, m_PF));
         m_pFrameDecoder->convertFrameToBmp(pFrame, pBmps[0]);
+        bytesCopied = pBmps[0]->getSize().x*pBmps[0]->getBytesPerPixel()*
+                pBmps[0]->getSize().y;
     }
+    m_pFramePool->addFrame(bytesCopied);
     pMsg->setFrame(pBmps, m_pFrameDecoder->getCurTime());
+    pBmps.clear();
     pushMsg(pMsg);
 }
 
@@ -185,18 +216,6 @@ void VideoDecoderThread::close()
     stop();
 }
 
-BitmapPtr VideoDecoderThread::getBmp(BitmapQueuePtr pBmpQ, const IntPoint& size, 
-        PixelFormat pf)
-{
-    BitmapPtr pBmp = pBmpQ->pop(false);
-    if (pBmp) {
-        AVG_ASSERT (pBmp->getSize() == size && pBmp->getPixelFormat() == pf);
-        return pBmp;
-    } else {
-        return BitmapPtr(new Bitmap(size, pf)); 
-    }
-}
-
 static ProfilingZoneID PushMsgProfilingZone("Push message", true);
 
 void VideoDecoderThread::pushMsg(VideoMsgPtr pMsg)
@@ -24,6 +24,7 @@
 
 #include "../api.h"
 #include "VideoMsg.h"
+#include "VideoFramePool.h"
 
 #include "../base/WorkerThread.h"
 #include "../base/Command.h"
@@ -38,23 +39,24 @@
 
 namespace avg {
 
-typedef Queue<Bitmap> BitmapQueue;
-typedef boost::shared_ptr<BitmapQueue> BitmapQueuePtr;
-
 class FFMpegFrameDecoder;
 typedef boost::shared_ptr<FFMpegFrameDecoder> FFMpegFrameDecoderPtr;
 
 class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
     public:
         VideoDecoderThread(CQueue& cmdQ, VideoMsgQueue& msgQ, VideoMsgQueue& packetQ, 
-                AVStream* pStream, const IntPoint& size, PixelFormat pf);
+                AVStream* pStream, const IntPoint& size, PixelFormat pf,
+                VideoFramePoolPtr pFramePool);
         virtual ~VideoDecoderThread();
         virtual bool init();
         virtual void deinit();
         
         bool work();
         void setFPS(float fps);
-        void returnFrame(VideoMsgPtr pMsg);
+
+        // Used by VideoDecoderPool.
+        bool canWork() const;
+        float getDeadline() const;
 
     private:
         void decodePacket(AVPacket* pPacket);
@@ -62,15 +64,13 @@ class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
         void handleSeekDone(VideoMsgPtr pMsg);
         void sendFrame(AVFrame* pFrame);
         void close();
-        BitmapPtr getBmp(BitmapQueuePtr pBmpQ, const IntPoint& size, PixelFormat pf);
         void pushMsg(VideoMsgPtr pMsg);
 
         VideoMsgQueue& m_MsgQ;
         FFMpegFrameDecoderPtr m_pFrameDecoder;
         VideoMsgQueue& m_PacketQ;
 
-        BitmapQueuePtr m_pBmpQ;
-        BitmapQueuePtr m_pHalfBmpQ;
+        VideoFramePoolPtr m_pFramePool;
         
         IntPoint m_Size;
         PixelFormat m_PF;
@@ -78,6 +78,7 @@ class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
         bool m_bSeekDone;
         bool m_bProcessingLastFrames;
         AVFrame* m_pFrame;
+        std::vector<BitmapPtr> m_pFrameBmps;
 };
 
 }
@@ -29,17 +29,25 @@ using namespace std;
 namespace avg {
 
 VideoDemuxerThread::VideoDemuxerThread(CQueue& cmdQ, AVFormatContext* pFormatContext,
-        const map<int, VideoMsgQueuePtr>& packetQs)
+        const map<int, VideoMsgQueuePtr>& packetQs, KeyframeIndexPtr pKeyframeIndex)
     : WorkerThread<VideoDemuxerThread>("VideoDemuxer", cmdQ),
       m_PacketQs(packetQs),
       m_bEOF(false),
       m_pFormatContext(pFormatContext),
-      m_pDemuxer()
+      m_pKeyframeIndex(pKeyframeIndex),
+      m_pDemuxer(),
+      m_PacketDuration(0.02f)
 {
     map<int, VideoMsgQueuePtr>::iterator it;
     for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
         int streamIndex = it->first;
         m_PacketQEOFMap[streamIndex] = false;
+        AVStream* pStream = m_pFormatContext->streams[streamIndex];
+        if (pStream->codec->codec_type == AVMEDIA_TYPE_VIDEO &&
+                pStream->avg_frame_rate.num != 0)
+        {
+            m_PacketDuration = float(1/av_q2d(pStream->avg_frame_rate));
+        }
     }
 }
 
@@ -55,6 +63,7 @@ bool VideoDemuxerThread::init()
         streamIndexes.push_back(it->first);
     }
     m_pDemuxer = FFMpegDemuxerPtr(new FFMpegDemuxer(m_pFormatContext, streamIndexes));
+    m_pDemuxer->setKeyframeIndex(m_pKeyframeIndex);
     return true;
 }
 
@@ -63,19 +72,7 @@ bool VideoDemuxerThread::work()
     if (m_bEOF) {
         waitForCommand();
     } else {
-        map<int, VideoMsgQueuePtr>::iterator it;
-        int shortestQ = -1;
-        int shortestLength = INT_MAX;
-        for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
-            if (it->second->size() < shortestLength && 
-                    it->second->size() < it->second->getMaxSize() &&
-                    !m_PacketQEOFMap[it->first])
-            {
-                shortestLength = it->second->size();
-                shortestQ = it->first;
-            }
-        }
-        
+        int shortestQ = getShortestQueue();
         if (shortestQ < 0) {
             // All queues are at their max capacity. Take a nap and try again later.
             // Note that we can't wait on the queue. If decoding is paused, the queues can
@@ -86,7 +83,7 @@ bool VideoDemuxerThread::work()
         }
 
         AVPacket * pPacket = m_pDemuxer->getPacket(shortestQ);
-        VideoMsgPtr pMsg(new VideoMsg);
+        VideoMsgPtr pMsg = VideoMsg::create();
         if (pPacket == 0) {
             onStreamEOF(shortestQ);
             pMsg->setEOF();
@@ -99,6 +96,21 @@ bool VideoDemuxerThread::work()
     return true;
 }
 
+bool VideoDemuxerThread::canWork() const
+{
+    return !m_bEOF && getShortestQueue() >= 0;
+}
+
+float VideoDemuxerThread::getDeadline() const
+{
+    int shortestQ = getShortestQueue();
+    if (shortestQ < 0) {
+        return 0;
+    }
+    // Approximate playing time of the packets left in the queue.
+    return m_PacketQs.find(shortestQ)->second->size()*m_PacketDuration;
+}
+
 void VideoDemuxerThread::seek(int seqNum, float destTime)
 {
     map<int, VideoMsgQueuePtr>::iterator it;
@@ -108,7 +120,7 @@ void VideoDemuxerThread::seek(int seqNum, float destTime)
         clearQueue(pPacketQ);
 
         // send SEEK_DONE
-        VideoMsgPtr pMsg(new VideoMsg);
+        VideoMsgPtr pMsg = VideoMsg::create();
         pMsg->setSeekDone(seqNum, destTime);
         pPacketQ->push(pMsg);
         m_PacketQEOFMap[it->first] = false;
@@ -123,7 +135,7 @@ void VideoDemuxerThread::close()
         VideoMsgQueuePtr pPacketQ = it->second;
         clearQueue(pPacketQ);
 
-        VideoMsgPtr pMsg(new VideoMsg);
+        VideoMsgPtr pMsg = VideoMsg::create();
         pMsg->setClosed();
         pPacketQ->push(pMsg);
         m_PacketQEOFMap[it->first] = false;
@@ -131,6 +143,25 @@ void VideoDemuxerThread::close()
     stop();
 }
         
+int VideoDemuxerThread::getShortestQueue() const
+{
+    // Returns the index of the shortest queue that isn't full or at EOF, -1 if there
+    // is none.
+    map<int, VideoMsgQueuePtr>::const_iterator it;
+    int shortestQ = -1;
+    int shortestLength = INT_MAX;
+    for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
+        if (it->second->size() < shortestLength &&
+                it->second->size() < it->second->getMaxSize() &&
+                !m_PacketQEOFMap.find(it->first)->second)
+        {
+            shortestLength = it->second->size();
+            shortestQ = it->first;
+        }
+    }
+    return shortestQ;
+}
+
 void VideoDemuxerThread::onStreamEOF(int streamIndex)
 {
     m_PacketQEOFMap[streamIndex] = true;
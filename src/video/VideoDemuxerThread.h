@@ -25,6 +25,7 @@
 #include "../api.h"
 #include "VideoMsg.h"
 #include "WrapFFMpeg.h"
+#include "KeyframeIndex.h"
 
 #include "../base/WorkerThread.h"
 #include "../base/Command.h"
@@ -39,15 +40,21 @@ typedef boost::shared_ptr<FFMpegDemuxer> FFMpegDemuxerPtr;
 class AVG_API VideoDemuxerThread: public WorkerThread<VideoDemuxerThread> {
     public:
         VideoDemuxerThread(CQueue& cmdQ, AVFormatContext* pFormatContext, 
-                const std::map<int, VideoMsgQueuePtr>& packetQs);
+                const std::map<int, VideoMsgQueuePtr>& packetQs,
+                KeyframeIndexPtr pKeyframeIndex);
         virtual ~VideoDemuxerThread();
         bool init();
         bool work();
 
+        // Used by VideoDecoderPool.
+        bool canWork() const;
+        float getDeadline() const;
+
         void seek(int seqNum, float DestTime);
         void close();
 
     private:
+        int getShortestQueue() const;
         void onStreamEOF(int streamIndex);
         void clearQueue(VideoMsgQueuePtr pPacketQ);
 
@@ -55,7 +62,9 @@ class AVG_API VideoDemuxerThread: public WorkerThread<VideoDemuxerThread> {
         std::map<int, bool> m_PacketQEOFMap;
         bool m_bEOF;
         AVFormatContext* m_pFormatContext;
+        KeyframeIndexPtr m_pKeyframeIndex;
         FFMpegDemuxerPtr m_pDemuxer;
+        float m_PacketDuration;
 };
 
 }
@@ -0,0 +1,131 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "VideoFramePool.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+#include "../base/ThreadHelper.h"
+
+#include "../graphics/Bitmap.h"
+
+using namespace std;
+
+namespace avg {
+
+// Enough for the frames in the decoder queue and the ones held by the main thread.
+static const unsigned MAX_FREE_BMPS = 16;
+
+static void freeFrame(AVFrame* pFrame)
+{
+    av_frame_free(&pFrame);
+}
+
+// Each plane bitmap holds a reference to the frame. The frame buffers go back to the
+// decoder when the deleter of the last plane is destroyed.
+class VideoFramePool::PlaneBmpDeleter
+{
+public:
+    PlaneBmpDeleter(const boost::shared_ptr<AVFrame>& pFrame)
+        : m_pFrame(pFrame)
+    {
+    }
+
+    void operator()(Bitmap* pBmp)
+    {
+        delete pBmp;
+    }
+
+private:
+    boost::shared_ptr<AVFrame> m_pFrame;
+};
+
+
+VideoFramePool::VideoFramePool()
+    : m_pBmpPool(new BitmapPool(MAX_FREE_BMPS, "VideoFrame")),
+      m_NumFrames(0),
+      m_NumBytesCopied(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+VideoFramePool::~VideoFramePool()
+{
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+BitmapPtr VideoFramePool::getBmp(const IntPoint& size, PixelFormat pf)
+{
+    return m_pBmpPool->getBmp(size, pf);
+}
+
+bool VideoFramePool::getPlaneBmps(AVFrame* pFrame, const IntPoint& size, PixelFormat pf,
+        vector<BitmapPtr>& pBmps)
+{
+    AVG_ASSERT(pixelFormatIsPlanar(pf));
+    if (!pFrame->buf[0]) {
+        // The decoder owns the buffers and will reuse them for the next frame.
+        return false;
+    }
+    boost::shared_ptr<AVFrame> pFrameRef(av_frame_clone(pFrame), freeFrame);
+    AVG_ASSERT(pFrameRef->data[0]);
+    IntPoint halfSize(size.x/2, size.y/2);
+    int numPlanes = pixelFormatHasAlpha(pf) ? 4 : 3;
+    for (int i = 0; i < numPlanes; ++i) {
+        IntPoint planeSize = (i == 1 || i == 2) ? halfSize : size;
+        pBmps.push_back(BitmapPtr(new Bitmap(planeSize, I8, pFrameRef->data[i],
+                pFrameRef->linesize[i], false, "VideoFrame"),
+                PlaneBmpDeleter(pFrameRef)));
+    }
+    return true;
+}
+
+void VideoFramePool::addFrame(long long bytesCopied)
+{
+    lock_guard lock(m_Mutex);
+    m_NumFrames++;
+    m_NumBytesCopied += bytesCopied;
+}
+
+long long VideoFramePool::getNumFrames() const
+{
+    lock_guard lock(m_Mutex);
+    return m_NumFrames;
+}
+
+long long VideoFramePool::getNumBytesCopied() const
+{
+    lock_guard lock(m_Mutex);
+    return m_NumBytesCopied;
+}
+
+long long VideoFramePool::getNumBmpsAllocated() const
+{
+    return m_pBmpPool->getNumBmpsAllocated();
+}
+
+int VideoFramePool::getNumFreeBmps() const
+{
+    return m_pBmpPool->getNumFreeBmps();
+}
+
+}
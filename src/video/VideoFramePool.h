@@ -0,0 +1,87 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2021 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _VideoFramePool_H_
+#define _VideoFramePool_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../graphics/PixelFormat.h"
+#include "../graphics/BitmapPool.h"
+
+#include "WrapFFMpeg.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// Supplies the bitmaps that decoded video frames are delivered in. Bitmaps handed out
+// by the pool return to it by themselves when the last reference is released, i.e.
+// after the frame has been uploaded to a texture or dropped. Can be used from the
+// decoder thread and the main thread concurrently.
+class AVG_API VideoFramePool
+{
+public:
+    VideoFramePool();
+    virtual ~VideoFramePool();
+
+    // Returns a recycled bitmap if one of the right size and format is available.
+    BitmapPtr getBmp(const IntPoint& size, PixelFormat pf);
+
+    // Appends one bitmap per plane of a planar frame. The bitmaps reference the planes
+    // of pFrame directly; the frame buffers are kept alive until the last of the
+    // bitmaps is released. Returns false if pFrame isn't reference counted. In this
+    // case, the planes need to be copied.
+    bool getPlaneBmps(AVFrame* pFrame, const IntPoint& size, PixelFormat pf,
+            std::vector<BitmapPtr>& pBmps);
+
+    // Called once per decoded frame with the number of pixel bytes the decoder
+    // wrote into frame bitmaps (plane copies and color conversion).
+    void addFrame(long long bytesCopied);
+
+    long long getNumFrames() const;
+    long long getNumBytesCopied() const;
+    long long getNumBmpsAllocated() const;
+    int getNumFreeBmps() const;
+
+private:
+    class PlaneBmpDeleter;
+
+    BitmapPoolPtr m_pBmpPool;
+
+    mutable boost::mutex m_Mutex;
+    long long m_NumFrames;
+    long long m_NumBytesCopied;
+};
+
+typedef boost::shared_ptr<VideoFramePool> VideoFramePoolPtr;
+
+}
+
+#endif
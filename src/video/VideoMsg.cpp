@@ -25,8 +25,12 @@
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
 
+#include <boost/make_shared.hpp>
+
 namespace avg {
 
+static BlockPoolPtr s_pVideoMsgPool(new BlockPool("VideoMsg"));
+
 VideoMsg::VideoMsg()
 {
 }
@@ -35,11 +39,23 @@ VideoMsg::~VideoMsg()
 {
 }
 
+VideoMsgPtr VideoMsg::create()
+{
+    return boost::allocate_shared<VideoMsg>(PoolAllocator<VideoMsg>(s_pVideoMsgPool));
+}
+
+const BlockPoolPtr& VideoMsg::getPool()
+{
+    return s_pVideoMsgPool;
+}
+
 void VideoMsg::setFrame(const std::vector<BitmapPtr>& pBmps, float frameTime)
 {
     AVG_ASSERT(pBmps.size() == 1 || pBmps.size() == 3 || pBmps.size() == 4);
     setType(FRAME);
-    m_pBmps = pBmps;
+    for (unsigned i = 0; i < pBmps.size(); ++i) {
+        m_pBmps[i] = pBmps[i];
+    }
     m_FrameTime = frameTime;
 }
 
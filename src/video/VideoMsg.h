@@ -40,6 +40,9 @@ typedef boost::shared_ptr<Bitmap> BitmapPtr;
 class AVG_API VideoMsg: public AudioMsg {
 public:
     VideoMsg();
+    static boost::shared_ptr<VideoMsg> create();
+    static const BlockPoolPtr& getPool();
+
     void setFrame(const std::vector<BitmapPtr>& pBmps, float frameTime);
     void setPacket(AVPacket* pPacket);
 
@@ -52,7 +55,8 @@ public:
 
 private:
     // FRAME
-    std::vector<BitmapPtr> m_pBmps;
+    // A fixed-size array so frame messages don't need an extra allocation.
+    BitmapPtr m_pBmps[4];
     float m_FrameTime;
 
     // PACKET
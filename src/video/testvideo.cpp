@@ -20,7 +20,9 @@
 //
 
 #include "AsyncVideoDecoder.h"
+#include "VideoDecoderPool.h"
 #include "SyncVideoDecoder.h"
+#include "SwsConverter.h"
 
 #include "../graphics/Filterfliprgba.h"
 #include "../graphics/Filterfliprgb.h"
@@ -34,10 +36,12 @@
 #include "../base/ThreadProfiler.h"
 #include "../base/Directory.h"
 #include "../base/DirEntry.h"
+#include "../base/FileHelper.h"
 
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <cstring>
 
 #include <glib-object.h>
 
@@ -158,7 +162,9 @@ class VideoDecoderTest: public DecoderTest {
         {
             basicFileTest("mpeg1-48x48.mov", 30);
             basicFileTest("mjpeg-48x48.avi", 202);
-            testSeeks("mjpeg-48x48.avi");
+            testSeeks("mjpeg-48x48.avi", false);
+            testSeeks("mjpeg-48x48.avi", true);
+            testKeyframeIndex("mpeg1-48x48.mov");
         }
 
     private:
@@ -198,12 +204,20 @@ class VideoDecoderTest: public DecoderTest {
             }
         }
 
-        void testSeeks(const string& sFilename)
+        void testSeeks(const string& sFilename, bool bKeyframeIndex)
         {
-            cerr << "    Testing " << sFilename << " (seek)" << endl;
+            cerr << "    Testing " << sFilename << " (seek, keyframe index: " 
+                    << bKeyframeIndex << ")" << endl;
 
             VideoDecoderPtr pDecoder = createDecoder();
+            pDecoder->setKeyframeIndexEnabled(bKeyframeIndex, "");
             pDecoder->open(getMediaLoc(sFilename), true);
+            if (bKeyframeIndex) {
+                // Every mjpeg frame is a keyframe.
+                TEST(pDecoder->getKeyframeIndex()->getNumKeyframes() == 202);
+            } else {
+                TEST(!pDecoder->getKeyframeIndex());
+            }
             pDecoder->startDecoding(false, getAudioParams());
 
             // Seek forward
@@ -225,6 +239,56 @@ class VideoDecoderTest: public DecoderTest {
 
         }
 
+        void testKeyframeIndex(const string& sFilename)
+        {
+            cerr << "    Testing " << sFilename << " (keyframe index)" << endl;
+
+            string sIndexFilename = "resultimages/"+sFilename+".keyframes";
+            unlink(sIndexFilename.c_str());
+            VideoDecoderPtr pDecoder = createDecoder();
+            pDecoder->setKeyframeIndexEnabled(true, sIndexFilename);
+            pDecoder->open(getMediaLoc(sFilename), false);
+            KeyframeIndexPtr pIndex = pDecoder->getKeyframeIndex();
+            int numKeyframes = pIndex->getNumKeyframes();
+            TEST(numKeyframes > 0);
+            TEST(fileExists(sIndexFilename));
+            TEST(pIndex->findKeyframe(0) == 0);
+            TEST(pIndex->findKeyframe(1000) == numKeyframes-1);
+            float lastTime = -1;
+            for (int i = 0; i < numKeyframes; ++i) {
+                const KeyframeIndex::Keyframe& keyframe = pIndex->getKeyframe(i);
+                TEST(keyframe.m_Time > lastTime);
+                TEST(pIndex->findKeyframe(keyframe.m_Time) == i);
+                float keyframeTime = pDecoder->getKeyframeTime(keyframe.m_Time+0.001f);
+                TEST(keyframeTime == keyframe.m_Time);
+                lastTime = keyframe.m_Time;
+            }
+            pDecoder->close();
+
+            // Second open uses the index file.
+            pDecoder->open(getMediaLoc(sFilename), false);
+            KeyframeIndexPtr pLoadedIndex = pDecoder->getKeyframeIndex();
+            TEST(pLoadedIndex->getNumKeyframes() == numKeyframes);
+            for (int i = 0; i < numKeyframes; ++i) {
+                TEST(pLoadedIndex->getKeyframe(i).m_Timestamp == 
+                        pIndex->getKeyframe(i).m_Timestamp);
+                TEST(pLoadedIndex->getKeyframe(i).m_Pos == pIndex->getKeyframe(i).m_Pos);
+            }
+            pDecoder->close();
+
+            // A corrupt keyframe count causes the index to be rebuilt.
+            string sIndex;
+            avg::readWholeFile(sIndexFilename, sIndex);
+            size_t countPos = sIndex.find_last_of(' ',
+                    sIndex.find('\n', sIndex.find('\n')+1));
+            sIndex = sIndex.substr(0, countPos)+" 2000000000"+
+                    sIndex.substr(sIndex.find('\n', countPos));
+            writeWholeFile(sIndexFilename, sIndex);
+            pDecoder->open(getMediaLoc(sFilename), false);
+            TEST(pDecoder->getKeyframeIndex()->getNumKeyframes() == numKeyframes);
+            pDecoder->close();
+        }
+
         void readWholeFile(const string& sFilename, float speedFactor, 
                 int expectedNumFrames)
         {
@@ -271,6 +335,119 @@ class VideoDecoderTest: public DecoderTest {
 
 };
 
+// Measures the time from seek() until the frame at the destination is available.
+class SeekLatencyTest: public DecoderTest {
+    public:
+        SeekLatencyTest(bool bThreaded)
+            : DecoderTest("SeekLatencyTest", bThreaded)
+        {}
+
+        void runTests()
+        {
+            runSeeks("mpeg1-48x48.mov", false);
+            runSeeks("mpeg1-48x48.mov", true);
+            runSeeks("mjpeg-48x48.avi", false);
+            runSeeks("mjpeg-48x48.avi", true);
+        }
+
+    private:
+        void runSeeks(const string& sFilename, bool bKeyframeIndex)
+        {
+            const int NUM_SEEKS = 100;
+            VideoDecoderPtr pDecoder = createDecoder();
+            pDecoder->setKeyframeIndexEnabled(bKeyframeIndex, "");
+            pDecoder->open(getMediaLoc(sFilename), false);
+            pDecoder->startDecoding(false, 0);
+            float fps = pDecoder->getStreamFPS();
+            int numFrames = pDecoder->getVideoInfo().m_NumFrames;
+            srand(42);
+            BitmapPtr pBmp;
+            long long startTime = TimeSource::get()->getCurrentMicrosecs();
+            for (int i = 0; i < NUM_SEEKS; ++i) {
+                // Stay away from the end so the destination frame always exists.
+                int frameNum = rand() % (numFrames*3/4);
+                float seekTime = frameNum/fps;
+                pDecoder->seek(seekTime);
+                pDecoder->getRenderedBmp(pBmp, -1);
+                TEST(pDecoder->getCurTime() > seekTime-0.5f/fps);
+            }
+            long long endTime = TimeSource::get()->getCurrentMicrosecs();
+            float activeTime = (endTime-startTime)/1000.f;
+            cerr << "    " << sFilename << ", keyframe index: " << bKeyframeIndex << ": "
+                    << activeTime/NUM_SEEKS << " ms per seek" << endl;
+            pDecoder->close();
+        }
+};
+
+// Decodes many videos at once through the shared decoder pool.
+class DecoderPoolTest: public DecoderTest {
+    public:
+        DecoderPoolTest()
+            : DecoderTest("DecoderPoolTest", true)
+        {}
+
+        void runTests()
+        {
+            if (!VideoDecoderPool::get()) {
+                cerr << "    Decoder pool disabled, skipping." << endl;
+                return;
+            }
+            readFiles("mpeg1-48x48.mov", 30, 16);
+            readFiles("mjpeg-48x48.avi", 202, 16);
+        }
+
+    private:
+        void readFiles(const string& sFilename, int expectedNumFrames, int numDecoders)
+        {
+            cerr << "    Testing " << numDecoders << " x " << sFilename << endl;
+            VideoDecoderPool* pPool = VideoDecoderPool::get();
+            vector<VideoDecoderPtr> pDecoders;
+            for (int i = 0; i < numDecoders; ++i) {
+                VideoDecoderPtr pDecoder = createDecoder();
+                pDecoder->open(getMediaLoc(sFilename), false);
+                pDecoder->startDecoding(false, 0);
+                pDecoders.push_back(pDecoder);
+            }
+            // One demuxer and one video decoder per video.
+            TEST(pPool->getNumTasks() == numDecoders*2);
+
+            float timePerFrame = 1.0f/pDecoders[0]->getFPS();
+            vector<int> numFrames(numDecoders, 0);
+            vector<float> curTimes(numDecoders, 0);
+            vector<BitmapPtr> pBmps(numDecoders);
+            long long startTime = TimeSource::get()->getCurrentMicrosecs();
+            bool bAllEOF = false;
+            while (!bAllEOF) {
+                bAllEOF = true;
+                for (int i = 0; i < numDecoders; ++i) {
+                    if (pDecoders[i]->isEOF()) {
+                        continue;
+                    }
+                    bAllEOF = false;
+                    FrameAvailableCode frameAvailable =
+                            pDecoders[i]->getRenderedBmp(pBmps[i], curTimes[i]);
+                    if (frameAvailable == FA_NEW_FRAME) {
+                        numFrames[i]++;
+                    }
+                    if (frameAvailable != FA_STILL_DECODING) {
+                        curTimes[i] += timePerFrame;
+                    }
+                }
+                msleep(0);
+            }
+            long long endTime = TimeSource::get()->getCurrentMicrosecs();
+            cerr << "      " << pPool->getNumThreads() << " threads: "
+                    << (endTime-startTime)/1000 << " ms" << endl;
+
+            for (int i = 0; i < numDecoders; ++i) {
+                TEST(numFrames[i] == expectedNumFrames);
+                testEqual(*pBmps[i], sFilename+"_end", B8G8R8X8);
+                pDecoders[i]->close();
+            }
+            TEST(pPool->getNumTasks() == 0);
+        }
+};
+
 class AudioDecoderTest: public DecoderTest {
     public:
         AudioDecoderTest()
@@ -449,6 +626,65 @@ class AVDecoderTest: public DecoderTest {
 };
 
 
+class SwsConverterTest: public GraphicsTest {
+    public:
+        SwsConverterTest()
+          : GraphicsTest("SwsConverterTest", 2)
+        {}
+
+        void runTests()
+        {
+            IntPoint size(64, 256);
+            // Chroma subsampled vertically would be interpolated across band
+            // boundaries, so these formats are never converted in bands.
+            SwsConverter converter(size, AV_PIX_FMT_YUV420P, AV_PIX_FMT_BGRA, 4);
+            TEST(converter.getNumBands() == 1);
+
+            testBands(size, AV_PIX_FMT_YUV422P, 1);
+            testBands(size, AV_PIX_FMT_YUV444P, 0);
+        }
+
+    private:
+        void testBands(const IntPoint& size, AVPixelFormat srcFmt, int chromaShiftX)
+        {
+            // Patterns that change from line to line, so vertical filtering at band
+            // boundaries would show.
+            IntPoint chromaSize(size.x >> chromaShiftX, size.y);
+            BitmapPtr pPlaneBmps[3];
+            pPlaneBmps[0] = createPlaneBmp(size, 3, 5);
+            pPlaneBmps[1] = createPlaneBmp(chromaSize, 7, 2);
+            pPlaneBmps[2] = createPlaneBmp(chromaSize, 1, 11);
+            AVFrame frame;
+            memset(&frame, 0, sizeof(frame));
+            for (int i = 0; i < 3; ++i) {
+                frame.data[i] = pPlaneBmps[i]->getPixels();
+                frame.linesize[i] = pPlaneBmps[i]->getStride();
+            }
+
+            BitmapPtr pUnbandedBmp(new Bitmap(size, B8G8R8X8));
+            SwsConverter unbandedConverter(size, srcFmt, AV_PIX_FMT_BGRA, 1);
+            unbandedConverter.convert(&frame, pUnbandedBmp);
+            BitmapPtr pBandedBmp(new Bitmap(size, B8G8R8X8));
+            SwsConverter bandedConverter(size, srcFmt, AV_PIX_FMT_BGRA, 4);
+            TEST(bandedConverter.getNumBands() == 4);
+            bandedConverter.convert(&frame, pBandedBmp);
+            TEST(*pBandedBmp == *pUnbandedBmp);
+        }
+
+        BitmapPtr createPlaneBmp(const IntPoint& size, int xFactor, int yFactor)
+        {
+            BitmapPtr pBmp(new Bitmap(size, I8));
+            for (int y = 0; y < size.y; ++y) {
+                unsigned char* pLine = pBmp->getPixels()+y*pBmp->getStride();
+                for (int x = 0; x < size.x; ++x) {
+                    pLine[x] = (unsigned char)(x*xFactor+y*yFactor);
+                }
+            }
+            return pBmp;
+        }
+};
+
+
 class VideoTestSuite: public TestSuite {
 public:
     VideoTestSuite() 
@@ -469,6 +705,10 @@ private:
     {
         addTest(TestPtr(new VideoDecoderTest(false)));
         addTest(TestPtr(new VideoDecoderTest(true)));
+        addTest(TestPtr(new SeekLatencyTest(false)));
+        addTest(TestPtr(new SeekLatencyTest(true)));
+        addTest(TestPtr(new DecoderPoolTest()));
+        addTest(TestPtr(new SwsConverterTest()));
 
         addTest(TestPtr(new AVDecoderTest()));
     }
@@ -29,7 +29,11 @@ void export_anim();
 #include "raw_constructor.hpp"
 
 #include "../base/OSHelper.h"
+#include "../graphics/GLContextManager.h"
 #include "../graphics/ImageCache.h"
+#include "../graphics/TextureAtlas.h"
+#include "../audio/AudioMsg.h"
+#include "../video/VideoMsg.h"
 #include "../player/Player.h"
 #include "../player/AVGNode.h"
 #include "../player/CameraNode.h"
@@ -42,6 +46,7 @@ void export_anim();
 #include "../player/VersionInfo.h"
 #include "../player/ExportedObject.h"
 #include "../player/TestHelper.h"
+#include "../player/BitmapManagerMsg.h"
 #include "../anim/Anim.h"
 
 #include <boost/version.hpp>
@@ -71,6 +76,113 @@ CanvasPtr createMainCanvas(const boost::python::tuple &args,
     return extract<Player&>(args[0])().createMainCanvas(params);
 }
 
+static bp::dict Canvas_GetVertexStats(Canvas* pCanvas)
+{
+    bp::dict statsDict;
+    statsDict["numChanged"] = pCanvas->getNumChangedVerts();
+    statsDict["numUnchanged"] = pCanvas->getNumUnchangedVerts();
+    statsDict["numBytesUploaded"] = pCanvas->getNumVertexBytesUploaded();
+    return statsDict;
+}
+
+static bp::dict Canvas_GetRenderStats(Canvas* pCanvas)
+{
+    const RenderStats& stats = pCanvas->getRenderStats();
+    bp::dict statsDict;
+    statsDict["drawCalls"] = stats.m_NumDrawCalls;
+    statsDict["stateChanges"] = stats.getNumStateChanges();
+    statsDict["textureBinds"] = stats.m_NumTextureBinds;
+    statsDict["blendModeChanges"] = stats.m_NumBlendModeChanges;
+    statsDict["shaderChanges"] = stats.m_NumShaderChanges;
+    statsDict["batches"] = stats.m_NumBatches;
+    statsDict["batchedNodes"] = stats.m_NumBatchedNodes;
+    return statsDict;
+}
+
+static bp::dict Player_GetTextureAtlasStats(Player* pPlayer)
+{
+    TextureAtlas* pAtlas = TextureAtlas::get();
+    bp::dict statsDict;
+    statsDict["numPages"] = pAtlas->getNumPages();
+    statsDict["numRegions"] = pAtlas->getNumRegions();
+    statsDict["usedPixels"] = pAtlas->getUsedPixels();
+    statsDict["totalPixels"] = pAtlas->getTotalPixels();
+    float occupancy = 0;
+    if (pAtlas->getTotalPixels() > 0) {
+        occupancy = float(pAtlas->getUsedPixels())/pAtlas->getTotalPixels();
+    }
+    statsDict["occupancy"] = occupancy;
+    return statsDict;
+}
+
+static void addMsgPoolStats(bp::dict& statsDict, const BlockPoolPtr& pPool)
+{
+    bp::dict poolDict;
+    poolDict["inUse"] = pPool->getNumBlocksInUse();
+    poolDict["highWaterMark"] = pPool->getHighWaterMark();
+    statsDict[pPool->getName()] = poolDict;
+}
+
+static bp::dict Player_GetMsgPoolStats(Player* pPlayer)
+{
+    bp::dict statsDict;
+    addMsgPoolStats(statsDict, AudioMsg::getPool());
+    addMsgPoolStats(statsDict, VideoMsg::getPool());
+    addMsgPoolStats(statsDict, BitmapManagerMsg::getPool());
+    return statsDict;
+}
+
+static bp::dict Player_GetTexUploadStats(Player* pPlayer)
+{
+    GLContextManager* pCM = GLContextManager::get();
+    bp::dict statsDict;
+    statsDict["lastFrameBytes"] = pCM->getLastFrameUploadBytes();
+    statsDict["numDeferred"] = pCM->getNumDeferredUploads();
+    statsDict["deferredBytes"] = pCM->getDeferredUploadBytes();
+    statsDict["numPartialUploads"] = pCM->getNumPartialUploads();
+    return statsDict;
+}
+
+static bp::dict Player_GetFrameStats(Player* pPlayer)
+{
+    const FrameStats& stats = pPlayer->getFrameStats();
+    bp::dict statsDict;
+    statsDict["numFrames"] = stats.getNumFrames();
+    statsDict["numRecords"] = stats.getNumRecords();
+    statsDict["missedDeadlines"] = stats.getNumMissedDeadlines();
+    statsDict["targetFrameTime"] = stats.getTargetInterval()/1000.f;
+    statsDict["p50"] = stats.getIntervalPercentile(50)/1000.f;
+    statsDict["p95"] = stats.getIntervalPercentile(95)/1000.f;
+    statsDict["p99"] = stats.getIntervalPercentile(99)/1000.f;
+    statsDict["max"] = stats.getMaxInterval()/1000.f;
+    return statsDict;
+}
+
+static bp::list Player_GetFrameRecords(Player* pPlayer)
+{
+    const FrameStats& stats = pPlayer->getFrameStats();
+    bp::list records;
+    for (unsigned i = 0; i < stats.getNumRecords(); ++i) {
+        const FrameStats::FrameRecord& record = stats.getRecord(i);
+        bp::dict recordDict;
+        recordDict["frame"] = record.m_FrameNum;
+        recordDict["endTime"] = record.m_EndTime/1000.f;
+        recordDict["frameTime"] = record.m_Interval/1000.f;
+        for (int j = 0; j < FrameStats::NUM_PHASES; ++j) {
+            FrameStats::Phase phase = FrameStats::Phase(j);
+            recordDict[FrameStats::getPhaseName(phase)] = record.m_PhaseTimes[j]/1000.f;
+        }
+        recordDict["missedDeadline"] = record.m_bMissedDeadline;
+        records.append(recordDict);
+    }
+    return records;
+}
+
+static void Player_DumpFrameStats(Player* pPlayer, const string& sFilename)
+{
+    pPlayer->getFrameStats().dump(sFilename);
+}
+
 boost::function<size_t (const bp::tuple& args, const bp::dict& kwargs )>
         playerGetMemoryUsage = boost::bind(getMemoryUsage);
 
@@ -170,10 +282,25 @@ BOOST_PYTHON_MODULE(avg)
             .def("setFakeFPS", &Player::setFakeFPS)
             .def("getFrameTime", &Player::getFrameTime)
             .def("getFrameDuration", &Player::getFrameDuration)
+            .def("getFrameStats", Player_GetFrameStats)
+            .def("getFrameRecords", Player_GetFrameRecords)
+            .def("dumpFrameStats", Player_DumpFrameStats)
+            .def("setFrameStatsFile", &Player::setFrameStatsFile)
+            .def("getFrameStatsFile", &Player::getFrameStatsFile,
+                    return_value_policy<copy_const_reference>())
             .def("createNode", &Player::createNodeFromXmlString)
             .def("createNode", &Player::createNode, Player_createNode_overloads())
             .def("getTouchUserBmp", &Player::getTouchUserBmp)
             .def("enableMouse", &Player::enableMouse)
+            .def("enableEventBatching", &Player::enableEventBatching)
+            .def("isEventBatchingEnabled", &Player::isEventBatchingEnabled)
+            .def("enableDrawBatching", &Player::enableDrawBatching)
+            .def("isDrawBatchingEnabled", &Player::isDrawBatchingEnabled)
+            .def("getTextureAtlasStats", Player_GetTextureAtlasStats)
+            .def("getMsgPoolStats", Player_GetMsgPoolStats)
+            .def("setTexUploadBudget", &Player::setTexUploadBudget)
+            .def("getTexUploadBudget", &Player::getTexUploadBudget)
+            .def("getTexUploadStats", Player_GetTexUploadStats)
             .def("setInterval", &Player::setInterval)
             .def("setTimeout", &Player::setTimeout)
             .def("callFromThread", &Player::callFromThread)
@@ -213,6 +340,8 @@ BOOST_PYTHON_MODULE(avg)
             .def("getRootNode", &Canvas::getRootNode)
             .def("getElementByID", &Canvas::getElementByID)
             .def("screenshot", &Canvas::screenshot)
+            .def("getVertexStats", Canvas_GetVertexStats)
+            .def("getRenderStats", Canvas_GetRenderStats)
         ;
 
         class_<OffscreenCanvas, bases<Canvas>, boost::noncopyable>
@@ -27,11 +27,16 @@
 #include "../graphics/Bitmap.h"
 #include "../graphics/BitmapLoader.h"
 #include "../graphics/FilterResizeBilinear.h"
+#include "../graphics/FilterResample.h"
 #include "../graphics/ImageCache.h"
 #include "../graphics/Color.h"
 
+#include "../player/Player.h"
+#include "../player/DivNode.h"
+
 #include "../base/CubicSpline.h"
 #include "../base/GeomHelper.h"
+#include "../base/OSHelper.h"
 
 #include "../thirdparty/glm/gtx/vector_angle.hpp"
 
@@ -156,6 +161,12 @@ BitmapPtr Bitmap_getResized(BitmapPtr This, const glm::vec2& size)
     return FilterResizeBilinear(IntPoint(size)).apply(This);
 }
 
+BitmapPtr Bitmap_getResampled(BitmapPtr This, const glm::vec2& size,
+        const string& sFilter)
+{
+    return FilterResample(IntPoint(size), string2ResampleFilter(sFilter)).apply(This);
+}
+
 glm::vec2* createPoint()
 {
     return new glm::vec2(0,0);
@@ -183,7 +194,23 @@ BitmapPtr createBitmapWithRect(BitmapPtr pBmp,
 }
 
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(loadBitmap_overloads, BitmapManager::loadBitmapPy, 
-        2, 3);
+        2, 4);
+
+static bp::dict BitmapManager_GetStats(BitmapManager* pMgr)
+{
+    BitmapRequestStats stats = pMgr->getStats();
+    bp::dict statsDict;
+    statsDict["queueDepth"] = stats.m_QueueDepth;
+    statsDict["numRequests"] = stats.m_NumRequests;
+    statsDict["numCoalesced"] = stats.m_NumCoalesced;
+    statsDict["numCancelled"] = stats.m_NumCancelled;
+    statsDict["numLoaded"] = stats.m_NumLoaded;
+    statsDict["totalWaitTime"] = stats.m_TotalWaitTime;
+    statsDict["maxWaitTime"] = stats.m_MaxWaitTime;
+    statsDict["totalDecodeTime"] = stats.m_TotalDecodeTime;
+    statsDict["maxDecodeTime"] = stats.m_MaxDecodeTime;
+    return statsDict;
+}
 
 static bp::object ImageCache_GetCapacity(ImageCache* pCache)
 {
@@ -209,6 +236,66 @@ static bp::object ImageCache_GetMemUsed(ImageCache* pCache)
             pCache->getMemUsed(CachedImage::STORAGE_GPU));
 }
 
+// Relative filenames are resolved the same way as ImageNode hrefs in pParent.
+static string ImageCache_GetCacheFilename(const string& sFilename,
+        const DivNodePtr& pParent)
+{
+    string sCacheFilename = sFilename;
+    Node::resolveFilename(sCacheFilename, pParent);
+    return convertUTF8ToFilename(sCacheFilename);
+}
+
+static void ImageCache_PinImage(ImageCache* pCache, const string& sFilename,
+        const string& sCompression, const glm::vec2& decodeSize,
+        const DivNodePtr& pParent)
+{
+    pCache->pinImage(ImageCache_GetCacheFilename(sFilename, pParent),
+            string2TexCompression(sCompression), IntPoint(decodeSize));
+}
+
+static void ImageCache_UnpinImage(ImageCache* pCache, const string& sFilename,
+        const string& sCompression, const glm::vec2& decodeSize,
+        const DivNodePtr& pParent)
+{
+    pCache->unpinImage(ImageCache_GetCacheFilename(sFilename, pParent),
+            string2TexCompression(sCompression), IntPoint(decodeSize));
+}
+
+static bool ImageCache_IsPinned(ImageCache* pCache, const string& sFilename,
+        const string& sCompression, const glm::vec2& decodeSize,
+        const DivNodePtr& pParent)
+{
+    return pCache->isPinned(ImageCache_GetCacheFilename(sFilename, pParent),
+            string2TexCompression(sCompression), IntPoint(decodeSize));
+}
+
+static bp::dict ImageCache_GetTierStats(ImageCache* pCache, CachedImage::StorageType st)
+{
+    bp::dict statsDict;
+    statsDict["hits"] = pCache->getNumHits(st);
+    statsDict["misses"] = pCache->getNumMisses(st);
+    statsDict["evictions"] = pCache->getNumEvictions(st);
+    return statsDict;
+}
+
+static bp::dict ImageCache_GetStats(ImageCache* pCache)
+{
+    bp::dict statsDict;
+    statsDict["cpu"] = ImageCache_GetTierStats(pCache, CachedImage::STORAGE_CPU);
+    statsDict["gpu"] = ImageCache_GetTierStats(pCache, CachedImage::STORAGE_GPU);
+    return statsDict;
+}
+
+static bp::object ImageCache_GetDiskCacheStats(ImageCache* pCache)
+{
+    ImageDiskCachePtr pDiskCache = pCache->getDiskCache();
+    if (pDiskCache) {
+        return bp::make_tuple(pDiskCache->getNumHits(), pDiskCache->getNumMisses());
+    } else {
+        return bp::make_tuple(0, 0);
+    }
+}
+
 vector<string> getSupportedPixelFormatsDeprecated()
 {
     avgDeprecationWarning("1.9.0", "avg.getSupportedPixelFormats",
@@ -297,6 +384,8 @@ void export_bitmap()
         .def("__init__", make_constructor(createBitmapFromFile))
         .def("blt", &Bitmap::blt)
         .def("getResized", &Bitmap_getResized)
+        .def("getResampled", &Bitmap_getResampled,
+                (bp::arg("newsize"), bp::arg("filter")="lanczos"))
         .def("save", &Bitmap::save)
         .def("getSize", &Bitmap_getSize)
         .def("getFormat", &Bitmap::getPixelFormat)
@@ -317,6 +406,28 @@ void export_bitmap()
         .add_property("capacity", ImageCache_GetCapacity, ImageCache_SetCapacity)
         .def("getNumImages", ImageCache_GetNumImages)
         .def("getMemUsed", ImageCache_GetMemUsed)
+        .add_property("diskCacheDir", &ImageCache::getDiskCacheDir,
+                &ImageCache::setDiskCacheDir)
+        .def("getDiskCacheStats", ImageCache_GetDiskCacheStats)
+        .def("getExternalMemUsed", &ImageCache::getExternalMemUsed)
+        .add_property("policy", &ImageCache::getPolicy, &ImageCache::setPolicy)
+        .def("pinImage", ImageCache_PinImage,
+                (bp::arg("filename"), bp::arg("texcompression")="none",
+                 bp::arg("decodesize")=glm::vec2(0,0), bp::arg("parent")=DivNodePtr()))
+        .def("unpinImage", ImageCache_UnpinImage,
+                (bp::arg("filename"), bp::arg("texcompression")="none",
+                 bp::arg("decodesize")=glm::vec2(0,0), bp::arg("parent")=DivNodePtr()))
+        .def("isPinned", ImageCache_IsPinned,
+                (bp::arg("filename"), bp::arg("texcompression")="none",
+                 bp::arg("decodesize")=glm::vec2(0,0), bp::arg("parent")=DivNodePtr()))
+        .def("getStats", ImageCache_GetStats)
+    ;
+
+    enum_<BitmapLoadPriority>("BitmapLoadPriority")
+        .value("LOADPRIORITY_VISIBLE", LOADPRIORITY_VISIBLE)
+        .value("LOADPRIORITY_PREFETCH", LOADPRIORITY_PREFETCH)
+        .value("LOADPRIORITY_BACKGROUND", LOADPRIORITY_BACKGROUND)
+        .export_values()
     ;
 
     class_<BitmapManager>("BitmapManager", no_init)
@@ -324,7 +435,11 @@ void export_bitmap()
                 return_value_policy<reference_existing_object>())
         .staticmethod("get")
         .def("loadBitmap", &BitmapManager::loadBitmapPy, loadBitmap_overloads())
+        .def("cancelRequest", &BitmapManager::cancelRequest)
+        .def("setRequestPriority", &BitmapManager::setRequestPriority)
         .def("setNumThreads", &BitmapManager::setNumThreads)
+        .def("getNumPendingRequests", &BitmapManager::getNumPendingRequests)
+        .def("getStats", BitmapManager_GetStats)
     ;
 
     class_<CubicSpline, boost::noncopyable>("CubicSpline", no_init)
@@ -29,6 +29,8 @@ using namespace boost::python;
 using namespace avg;
 using namespace std;
 
+namespace bp = boost::python;
+
 char cameraNodeName[] = "camera";
 char videoNodeName[] = "video";
 
@@ -38,6 +40,23 @@ long long getDurationDeprecated(VideoNode* pNode)
     return pNode->getDuration();
 }
 
+static dict VideoNode_GetDecoderStats(VideoNode* pNode)
+{
+    VideoFramePoolPtr pPool = pNode->getFramePool();
+    dict stats;
+    long long numFrames = pPool->getNumFrames();
+    long long bytesCopied = pPool->getNumBytesCopied();
+    stats["framesDecoded"] = numFrames;
+    stats["bytesCopied"] = bytesCopied;
+    if (numFrames > 0) {
+        stats["bytesCopiedPerFrame"] = float(bytesCopied)/numFrames;
+    } else {
+        stats["bytesCopiedPerFrame"] = 0.f;
+    }
+    stats["bitmapsAllocated"] = pPool->getNumBmpsAllocated();
+    return stats;
+}
+
 void export_raster2()
 {
     class_<CameraNode, bases<RasterNode> >("CameraNode", no_init)
@@ -48,6 +67,7 @@ void export_raster2()
                 return_value_policy<copy_const_reference>()))
         .add_property("framerate", &CameraNode::getFrameRate)
         .add_property("framenum", &CameraNode::getFrameNum)
+        .add_property("threaded", &CameraNode::isThreaded)
         .add_property("brightness", &CameraNode::getBrightness, 
                 &CameraNode::setBrightness)
         .add_property("sharpness", &CameraNode::getSharpness, &CameraNode::setSharpness)
@@ -111,8 +131,10 @@ void export_raster2()
         .def("pause", &VideoNode::pause)
         .def("getNumFrames", &VideoNode::getNumFrames)
         .def("getNumFramesQueued", &VideoNode::getNumFramesQueued)
+        .def("getDecoderStats", &VideoNode_GetDecoderStats)
         .def("getCurFrame", &VideoNode::getCurFrame)
-        .def("seekToFrame", &VideoNode::seekToFrame)
+        .def("seekToFrame", &VideoNode::seekToFrame,
+                (bp::arg("frame"), bp::arg("preview")=false))
         .def("getStreamPixelFormat", &VideoNode::getStreamPixelFormat)
         .def("getDuration", &getDurationDeprecated)
         .def("getVideoDuration", &VideoNode::getVideoDuration)
@@ -124,7 +146,8 @@ void export_raster2()
         .def("getAudioSampleRate", &VideoNode::getAudioSampleRate)
         .def("getNumAudioChannels", &VideoNode::getNumAudioChannels)
         .def("getCurTime", &VideoNode::getCurTime)
-        .def("seekToTime", &VideoNode::seekToTime)
+        .def("seekToTime", &VideoNode::seekToTime,
+                (bp::arg("time"), bp::arg("preview")=false))
         .def("isSeeking", &VideoNode::isSeeking)
         .def("hasAudio", &VideoNode::hasAudio)
         .def("hasAlpha", &VideoNode::hasAlpha)
@@ -138,6 +161,11 @@ void export_raster2()
         .add_property("loop", &VideoNode::getLoop)
         .add_property("volume", &VideoNode::getVolume, &VideoNode::setVolume)
         .add_property("threaded", &VideoNode::isThreaded)
+        .add_property("preload", &VideoNode::isPreloaded)
+        .add_property("keyframeindex", &VideoNode::getKeyframeIndex)
+        .add_property("keyframeindexfile", make_function(
+                &VideoNode::getKeyframeIndexFile,
+                return_value_policy<copy_const_reference>()))
         .add_property("duration", &VideoNode::getDuration)
     ;
 }
@@ -91,6 +91,16 @@ void export_raster()
                 &ImageNode::setHRef)
         .add_property("compression",
                 &ImageNode::getCompression)
+        .add_property("decodesize",
+                make_function(&ImageNode::getDecodeSize,
+                        return_value_policy<copy_const_reference>()),
+                &ImageNode::setDecodeSize)
+        .add_property("async", &ImageNode::getAsync)
+        .add_property("placeholder",
+                make_function(&ImageNode::getPlaceholder,
+                        return_value_policy<copy_const_reference>()),
+                &ImageNode::setPlaceholder)
+        .add_property("loading", &ImageNode::isLoading)
     ;
 
     class_<FontStyle, bases<ExportedObject> >("FontStyle", no_init)
@@ -177,6 +187,10 @@ void export_raster()
         .staticmethod("getFontVariants")
         .def("addFontDir", &WordsNode::addFontDir)
         .staticmethod("addFontDir")
+        .def("enableGlyphRendering", &WordsNode::enableGlyphRendering)
+        .staticmethod("enableGlyphRendering")
+        .def("isGlyphRenderingEnabled", &WordsNode::isGlyphRenderingEnabled)
+        .staticmethod("isGlyphRenderingEnabled")
     ;
 
     export_raster2();